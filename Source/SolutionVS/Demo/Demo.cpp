@@ -10,6 +10,7 @@
 #include "RayTracingSandboxApp.h"
 #include "HybridRenderingApp.h"
 #include "GPUWorkGraphsRealm.h"
+#include "IsosurfaceToolApp.h"
 
 int APIENTRY wWinMain(_In_ HINSTANCE hInstance,
                      _In_opt_ HINSTANCE hPrevInstance,
@@ -21,6 +22,7 @@ int APIENTRY wWinMain(_In_ HINSTANCE hInstance,
 	//D3D12SandboxApp demoApp;
 	//VulkanSandboxApp demoApp;
 	//RayTracingSandboxApp demoApp;
+	//IsosurfaceToolApp demoApp;
 	HybridRenderingApp demoApp;
 	return demoApp.Run();
 #else
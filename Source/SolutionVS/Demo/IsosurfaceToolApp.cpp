@@ -0,0 +1,1188 @@
+
+#include "stdafx.h"
+#include "IsosurfaceToolApp.h"
+
+#include "UnlimRealms.h"
+#include "Sys/Storage.h"
+#include "Sys/Log.h"
+#include "Core/Memory.h"
+#include "Isosurface/Isosurface.h"
+#include <random>
+#if defined(_MSC_VER)
+#pragma comment(lib, "UnlimRealms.lib")
+#endif
+using namespace UnlimRealms;
+
+// headless isosurface meshing tool:
+// benchmarks marching cubes kernels, extracts surface of the demo planet volume on CPU, reports throughput and writes the result as OBJ;
+// built as the standalone IsosurfaceTool console target (SolutionVS/IsosurfaceTool), results are written to the log,
+// checks failures are logged as warnings and reported by the exit code;
+// Windows only: Isosurface.h/.cpp depend on the Gfx/Graf (Vulkan) and ImGui renderers, there is no non-MSVC target
+
+int IsosurfaceToolApp::Run()
+{
+	// create realm
+	Realm realm;
+	realm.Initialize();
+	Log &log = realm.GetLog();
+	ur_uint checksFailed = 0;
+
+	// demo isosurface data
+	ur_float surfaceRadiusMin = 1000.0f;
+	ur_float surfaceRadiusMax = 1100.0f;
+	ur_float r = surfaceRadiusMax;
+	BoundingBox volumeBound(ur_float3(-r, -r, -r), ur_float3(r, r, r));
+	std::unique_ptr<Isosurface> isosurface(new Isosurface(realm));
+	{
+		Isosurface::ProceduralGenerator::SimplexNoiseParams generateParams;
+		generateParams.bound = volumeBound;
+		generateParams.radiusMin = surfaceRadiusMin;
+		generateParams.radiusMax = surfaceRadiusMax;
+		generateParams.octaves.assign({
+			{ 0.875f, 7.5f, -1.0f, 0.5f },
+			{ 0.345f, 30.0f, -0.5f, 0.1f },
+			{ 0.035f, 120.0f, -1.0f, 0.2f },
+			});
+
+		std::unique_ptr<Isosurface::ProceduralGenerator> dataVolume(new Isosurface::ProceduralGenerator(*isosurface.get(),
+			Isosurface::ProceduralGenerator::Algorithm::SimplexNoise, generateParams));
+
+		isosurface->Init(std::move(dataVolume));
+	}
+
+	// marching cubes kernels benchmark: a lattice block at the surface is polygonized repeatedly
+	{
+		const ur_uint3 blockResolution(Isosurface::MeshExtractor::BlockCells + 1);
+		const ur_uint latticeSize = blockResolution.x * blockResolution.y * blockResolution.z;
+		const ur_float3 blockCenter(0.0f, 0.0f, (surfaceRadiusMin + surfaceRadiusMax) * 0.5f);
+		const ur_float blockHalfSize = (surfaceRadiusMax - surfaceRadiusMin) * 0.5f;
+		const ur_float3 blockMin = blockCenter - blockHalfSize;
+		const ur_float3 blockMax = blockCenter + blockHalfSize;
+		const ur_float3 corners[8] = {
+			{ blockMin.x, blockMin.y, blockMin.z }, { blockMax.x, blockMin.y, blockMin.z },
+			{ blockMin.x, blockMax.y, blockMin.z }, { blockMax.x, blockMax.y, blockMin.z },
+			{ blockMin.x, blockMin.y, blockMax.z }, { blockMax.x, blockMin.y, blockMax.z },
+			{ blockMin.x, blockMax.y, blockMax.z }, { blockMax.x, blockMax.y, blockMax.z }
+		};
+		std::vector<ur_float3> lattice(latticeSize);
+		std::vector<Isosurface::DataVolume::ValueType> samples(latticeSize);
+		Isosurface::MeshExtractor::ComputeLattice(lattice.data(), corners, blockResolution);
+		isosurface->GetData()->Read(samples.data(), lattice.data(), latticeSize, BoundingBox(blockMin, blockMax));
+
+		static const ur_uint BenchmarkIterations = 256;
+		const ur_double cellsCount = ur_double(blockResolution.x - 1) * (blockResolution.y - 1) * (blockResolution.z - 1) * BenchmarkIterations;
+		const std::pair<Isosurface::MeshExtractor::Kernel, const char*> kernels[] = {
+			{ Isosurface::MeshExtractor::Kernel::Scalar, "Scalar" },
+			{ Isosurface::MeshExtractor::Kernel::Simd, "Simd" }
+		};
+		for (const auto &kernel : kernels)
+		{
+			if (!Isosurface::MeshExtractor::IsKernelSupported(kernel.first))
+				continue;
+			Isosurface::MeshExtractor::Mesh mesh;
+			ClockTime timeStart = Clock::now();
+			for (ur_uint i = 0; i < BenchmarkIterations; ++i)
+			{
+				mesh.vertices.clear();
+				mesh.indices.clear();
+				Isosurface::MeshExtractor::MarchCubes(mesh, lattice.data(), samples.data(), blockResolution, kernel.first);
+			}
+			auto timeMarch = ClockDeltaAs<std::chrono::microseconds>(Clock::now() - timeStart);
+			ur_double seconds = std::max(ur_double(timeMarch.count()) * 1.0e-6, 1.0e-6);
+			std::stringstream report;
+			report << "IsosurfaceToolApp: " << kernel.second << " kernel: " << cellsCount / seconds * 1.0e-6 << " Mcells/s (" <<
+				mesh.indices.size() / 3 << " triangles per block)";
+			log.WriteLine(report.str());
+		}
+	}
+
+	// marching cubes kernels: Simd must produce the same triangles as Scalar (up to vertex order within the mesh and
+	// interpolation precision) for a lattice whose resolution is not a multiple of the Simd width, so row tails are covered
+	if (Isosurface::MeshExtractor::IsKernelSupported(Isosurface::MeshExtractor::Kernel::Simd))
+	{
+		const ur_uint3 blockResolution(37, 29, 23);
+		const ur_uint latticeSize = blockResolution.x * blockResolution.y * blockResolution.z;
+		const ur_float3 blockCenter(0.0f, (surfaceRadiusMin + surfaceRadiusMax) * 0.5f, 0.0f);
+		const ur_float blockHalfSize = (surfaceRadiusMax - surfaceRadiusMin) * 0.5f;
+		const ur_float3 blockMin = blockCenter - blockHalfSize;
+		const ur_float3 blockMax = blockCenter + blockHalfSize;
+		const ur_float3 corners[8] = {
+			{ blockMin.x, blockMin.y, blockMin.z }, { blockMax.x, blockMin.y, blockMin.z },
+			{ blockMin.x, blockMax.y, blockMin.z }, { blockMax.x, blockMax.y, blockMin.z },
+			{ blockMin.x, blockMin.y, blockMax.z }, { blockMax.x, blockMin.y, blockMax.z },
+			{ blockMin.x, blockMax.y, blockMax.z }, { blockMax.x, blockMax.y, blockMax.z }
+		};
+		std::vector<ur_float3> lattice(latticeSize);
+		std::vector<Isosurface::DataVolume::ValueType> samples(latticeSize);
+		Isosurface::MeshExtractor::ComputeLattice(lattice.data(), corners, blockResolution);
+		isosurface->GetData()->Read(samples.data(), lattice.data(), latticeSize, BoundingBox(blockMin, blockMax));
+
+		Isosurface::MeshExtractor::Mesh meshes[2];
+		Result res = Isosurface::MeshExtractor::MarchCubes(meshes[0], lattice.data(), samples.data(), blockResolution, Isosurface::MeshExtractor::Kernel::Scalar);
+		res &= Isosurface::MeshExtractor::MarchCubes(meshes[1], lattice.data(), samples.data(), blockResolution, Isosurface::MeshExtractor::Kernel::Simd);
+
+		// triangles are matched by vertex positions (any rotation keeping the winding), candidates are searched by centroid
+		const ur_float epsilon = blockHalfSize * 2.0f / (blockResolution.x - 1) * 1.0e-3f;
+		struct Triangle
+		{
+			ur_float3 vertices[3];
+			ur_float3 centroid;
+			ur_bool matched;
+		};
+		std::vector<Triangle> triangles[2];
+		for (ur_uint imesh = 0; imesh < 2; ++imesh)
+		{
+			const Isosurface::MeshExtractor::Mesh &mesh = meshes[imesh];
+			triangles[imesh].resize(mesh.indices.size() / 3);
+			for (ur_size it = 0; it < triangles[imesh].size(); ++it)
+			{
+				Triangle &triangle = triangles[imesh][it];
+				for (ur_uint iv = 0; iv < 3; ++iv)
+				{
+					triangle.vertices[iv] = mesh.vertices[mesh.indices[it * 3 + iv]].pos;
+				}
+				triangle.centroid = (triangle.vertices[0] + triangle.vertices[1] + triangle.vertices[2]) / 3.0f;
+				triangle.matched = false;
+			}
+		}
+		std::sort(triangles[1].begin(), triangles[1].end(), [](const Triangle &a, const Triangle &b) -> bool {
+			return (a.centroid.x < b.centroid.x);
+		});
+		auto coincide = [epsilon](const ur_float3 &a, const ur_float3 &b) -> ur_bool {
+			return (fabs(a.x - b.x) <= epsilon && fabs(a.y - b.y) <= epsilon && fabs(a.z - b.z) <= epsilon);
+		};
+		ur_uint mismatchesCount = 0;
+		for (const Triangle &triangle : triangles[0])
+		{
+			ur_bool matched = false;
+			Triangle key;
+			key.centroid.x = triangle.centroid.x - epsilon;
+			auto it = std::lower_bound(triangles[1].begin(), triangles[1].end(), key, [](const Triangle &a, const Triangle &b) -> bool {
+				return (a.centroid.x < b.centroid.x);
+			});
+			for (; !matched && it != triangles[1].end() && it->centroid.x <= triangle.centroid.x + epsilon; ++it)
+			{
+				if (it->matched)
+					continue;
+				for (ur_uint rotation = 0; !matched && rotation < 3; ++rotation)
+				{
+					matched = (coincide(triangle.vertices[0], it->vertices[rotation]) &&
+						coincide(triangle.vertices[1], it->vertices[(rotation + 1) % 3]) &&
+						coincide(triangle.vertices[2], it->vertices[(rotation + 2) % 3]));
+				}
+				it->matched = matched;
+			}
+			mismatchesCount += (matched ? 0 : 1);
+		}
+		for (const Triangle &triangle : triangles[1])
+		{
+			mismatchesCount += (triangle.matched ? 0 : 1);
+		}
+		const ur_bool valid = (Succeeded(res) && !triangles[0].empty() && 0 == mismatchesCount);
+		std::stringstream report;
+		report << "IsosurfaceToolApp: Simd vs Scalar kernel (" << blockResolution.x << "x" << blockResolution.y << "x" << blockResolution.z <<
+			" lattice): " << triangles[0].size() << "/" << triangles[1].size() << " triangles, " << mismatchesCount << " mismatches";
+		checksFailed += (valid ? 0 : 1);
+		log.WriteLine(report.str(), (valid ? Log::Note : Log::Warning));
+	}
+
+	// single tetrahedron build latency: hexahedra and lattice slabs extracted serially vs in parallel
+	{
+		Isosurface::HybridCubes::Desc desc;
+		desc.CellSize = 1.0f;
+		desc.LatticeResolution = ur_uint3(65);
+		desc.DetailLevelDistance = 0.0f;
+		Isosurface::HybridCubes presentation(*isosurface.get(), desc);
+
+		const ur_float surfaceRadius = (surfaceRadiusMin + surfaceRadiusMax) * 0.5f;
+		const ur_float tetrahedronSize = surfaceRadiusMax - surfaceRadiusMin;
+		const ur_float3 tetrahedron[4] = {
+			{ 0.0f, 0.0f, surfaceRadius + tetrahedronSize },
+			{ -tetrahedronSize, -tetrahedronSize, surfaceRadius - tetrahedronSize },
+			{ tetrahedronSize, -tetrahedronSize, surfaceRadius - tetrahedronSize },
+			{ 0.0f, tetrahedronSize, surfaceRadius - tetrahedronSize }
+		};
+
+		static const ur_uint BenchmarkIterations = 8;
+		const std::pair<ur_bool, const char*> modes[] = {
+			{ false, "serial" },
+			{ true, "parallel" }
+		};
+		for (const auto &mode : modes)
+		{
+			Isosurface::MeshExtractor::Mesh mesh;
+			ClockTime timeStart = Clock::now();
+			for (ur_uint i = 0; i < BenchmarkIterations; ++i)
+			{
+				mesh.vertices.clear();
+				mesh.indices.clear();
+				presentation.ExtractTetrahedron(mesh, tetrahedron, 0, mode.first);
+			}
+			auto timeBuild = ClockDeltaAs<std::chrono::microseconds>(Clock::now() - timeStart);
+			std::stringstream report;
+			report << "IsosurfaceToolApp: tetrahedron build (" << mode.second << ", " << std::thread::hardware_concurrency() << " threads): " <<
+				ur_double(timeBuild.count()) * 1.0e-3 / BenchmarkIterations << " ms (" << mesh.indices.size() / 3 << " triangles)";
+			log.WriteLine(report.str());
+		}
+	}
+
+	// refinement queries: tree walk vs spatial index for growing refinement trees,
+	// the tree is refined around a surface point the same way HybridCubes refines it around the viewer
+	{
+		const ur_float3 refinementPoint(0.0f, 0.0f, surfaceRadiusMin);
+		std::function<void(EmptyOctree::Node*, ur_uint)> refine = [&](EmptyOctree::Node *node, ur_uint depth) -> void {
+			if (node->GetLevel() >= depth ||
+				node->GetBBox().Distance(refinementPoint) >= (node->GetBBox().Max - node->GetBBox().Min).Length() * 0.5f)
+				return;
+			node->Split();
+			for (ur_uint i = 0; i < EmptyOctree::Node::SubNodesCount; ++i)
+			{
+				refine(node->GetSubNode(i), depth);
+			}
+		};
+
+		// query boxes of tetrahedra sizes along the refinement path
+		static const ur_uint QueriesCount = 1 << 16;
+		std::vector<BoundingBox> queries(QueriesCount);
+		std::mt19937 rng(1);
+		std::uniform_real_distribution<ur_float> unitDistribution(0.0f, 1.0f);
+		for (auto &query : queries)
+		{
+			ur_float size = r * 2.0f * std::pow(0.5f, unitDistribution(rng) * 16.0f);
+			ur_float3 center = refinementPoint + ur_float3(unitDistribution(rng) - 0.5f, unitDistribution(rng) - 0.5f, unitDistribution(rng) - 0.5f) * size * 4.0f;
+			query = BoundingBox(center - size * 0.5f, center + size * 0.5f);
+		}
+
+		for (ur_uint depth : { 4u, 8u, 12u, 16u })
+		{
+			EmptyOctree refinementTree;
+			refinementTree.Init(volumeBound);
+			refine(refinementTree.GetRoot(), depth);
+
+			Isosurface::HybridCubes::RefinementIndex refinementIndex;
+			ClockTime timeStart = Clock::now();
+			refinementIndex.Build(refinementTree);
+			auto timeBuild = ClockDeltaAs<std::chrono::microseconds>(Clock::now() - timeStart);
+
+			ur_uint hitsTree = 0;
+			timeStart = Clock::now();
+			for (const auto &query : queries)
+			{
+				hitsTree += Isosurface::HybridCubes::RefinementIndex::CheckTree(query, refinementTree.GetRoot());
+			}
+			auto timeTree = ClockDeltaAs<std::chrono::microseconds>(Clock::now() - timeStart);
+
+			ur_uint hitsIndex = 0;
+			timeStart = Clock::now();
+			for (const auto &query : queries)
+			{
+				hitsIndex += refinementIndex.Check(query);
+			}
+			auto timeIndex = ClockDeltaAs<std::chrono::microseconds>(Clock::now() - timeStart);
+
+			std::stringstream report;
+			report << "IsosurfaceToolApp: refinement tree of " << refinementIndex.GetNodesCount() << " nodes: " << QueriesCount << " queries: " <<
+				"tree walk " << ur_double(timeTree.count()) * 1.0e-3 << " ms, index " << ur_double(timeIndex.count()) * 1.0e-3 << " ms " <<
+				"(+" << ur_double(timeBuild.count()) * 1.0e-3 << " ms build), hits " << hitsTree << "/" << hitsIndex;
+			checksFailed += (hitsTree != hitsIndex ? 1 : 0);
+			log.WriteLine(report.str(), (hitsTree != hitsIndex ? Log::Warning : Log::Note));
+		}
+	}
+
+	// hierarchy update: tetrahedra trees refined serially vs in parallel while the refinement point moves along the surface,
+	// detail level grows with smaller cell sizes; both modes must produce the same hierarchy (tetrahedra in tree order) and build order
+	{
+		static const ur_uint UpdateSteps = 16;
+		const ur_float surfaceRadius = (surfaceRadiusMin + surfaceRadiusMax) * 0.5f;
+		for (ur_float cellSize : { 2.0f, 0.5f, 0.125f })
+		{
+			Isosurface::HybridCubes::Desc desc;
+			desc.CellSize = cellSize;
+			desc.LatticeResolution = ur_uint3(9);
+			desc.DetailLevelDistance = 0.0f;
+
+			const std::pair<ur_bool, const char*> modes[] = {
+				{ false, "serial" },
+				{ true, "parallel" }
+			};
+			std::vector<ur_uint64> keys[2];
+			std::vector<ur_uint64> buildKeys;
+			std::vector<std::vector<ur_uint64>> buildOrders[2]; // per update step
+			std::stringstream report;
+			report << "IsosurfaceToolApp: hierarchy update (cell size " << cellSize << ", " << std::thread::hardware_concurrency() << " threads):";
+			for (ur_uint imode = 0; imode < 2; ++imode)
+			{
+				Isosurface::HybridCubes presentation(*isosurface.get(), desc);
+				ClockTime timeStart = Clock::now();
+				for (ur_uint i = 0; i <= UpdateSteps; ++i)
+				{
+					ur_float angle = ur_float(i) * 0.02f;
+					ur_float3 refinementPoint(sin(angle) * surfaceRadius, 0.0f, cos(angle) * surfaceRadius);
+					presentation.RefineHierarchy(refinementPoint, ur_float4x4::Identity, modes[imode].first, keys[imode], buildKeys);
+					buildOrders[imode].push_back(buildKeys);
+				}
+				auto timeUpdate = ClockDeltaAs<std::chrono::microseconds>(Clock::now() - timeStart);
+				report << " " << modes[imode].second << " " << ur_double(timeUpdate.count()) * 1.0e-3 / (UpdateSteps + 1) << " ms";
+			}
+			const ur_bool match = (keys[0] == keys[1] && buildOrders[0] == buildOrders[1]);
+			report << " per update (" << keys[0].size() << "/" << keys[1].size() << " tetrahedra), hierarchies " <<
+				(keys[0] == keys[1] ? "match" : "differ") << ", build orders " << (buildOrders[0] == buildOrders[1] ? "match" : "differ");
+			checksFailed += (match ? 0 : 1);
+			log.WriteLine(report.str(), (match ? Log::Note : Log::Warning));
+		}
+	}
+
+	// incremental refinement: LoD is re-evaluated only where the refinement tree has changed since the previous update,
+	// the hierarchy refined while the refinement point moves to the destination must match the one refined there at once
+	{
+		static const ur_uint MoveSteps = 32;
+		const ur_float surfaceRadius = (surfaceRadiusMin + surfaceRadiusMax) * 0.5f;
+		Isosurface::HybridCubes::Desc desc;
+		desc.CellSize = 0.5f;
+		desc.LatticeResolution = ur_uint3(9);
+		desc.DetailLevelDistance = 0.0f;
+		Isosurface::HybridCubes movedPresentation(*isosurface.get(), desc);
+		Isosurface::HybridCubes freshPresentation(*isosurface.get(), desc);
+		std::vector<ur_uint64> movedKeys;
+		std::vector<ur_uint64> freshKeys;
+		std::vector<ur_uint64> buildKeys;
+		ur_float3 refinementPoint;
+		for (ur_uint i = 0; i <= MoveSteps; ++i)
+		{
+			ur_float angle = ur_float(i) * 0.05f;
+			refinementPoint = ur_float3(sin(angle) * surfaceRadius, cos(angle) * surfaceRadius * 0.5f, cos(angle) * surfaceRadius * 0.866f);
+			movedPresentation.RefineHierarchy(refinementPoint, ur_float4x4::Identity, true, movedKeys, buildKeys);
+		}
+		freshPresentation.RefineHierarchy(refinementPoint, ur_float4x4::Identity, true, freshKeys, buildKeys);
+		std::stringstream report;
+		report << "IsosurfaceToolApp: incremental refinement: moved " << movedKeys.size() << " tetrahedra, fresh " << freshKeys.size() <<
+			" tetrahedra, hierarchies " << (movedKeys == freshKeys ? "match" : "differ");
+		checksFailed += (movedKeys != freshKeys ? 1 : 0);
+		log.WriteLine(report.str(), (movedKeys != freshKeys ? Log::Warning : Log::Note));
+	}
+
+	// implicit hierarchy addressing: face neighbours found by descending the hierarchy from the key's vertices must match
+	// the leaves found by testing all leaves of the refined hierarchy (tree walk) for the point just behind the face center
+	{
+		Isosurface::HybridCubes::Desc desc;
+		desc.CellSize = 0.5f;
+		desc.LatticeResolution = ur_uint3(9);
+		desc.DetailLevelDistance = 0.0f;
+		Isosurface::HybridCubes presentation(*isosurface.get(), desc);
+		std::vector<ur_uint64> keys;
+		std::vector<ur_uint64> buildKeys;
+		const ur_float surfaceRadius = (surfaceRadiusMin + surfaceRadiusMax) * 0.5f;
+		presentation.RefineHierarchy(ur_float3(0.0f, 0.0f, surfaceRadius), ur_float4x4::Identity, true, keys, buildKeys);
+
+		// a key's children are (key << 1) | childIdx
+		std::unordered_set<ur_uint64> keySet(keys.begin(), keys.end());
+		struct Leaf
+		{
+			ur_uint64 key;
+			ur_float3 vertices[4];
+		};
+		std::vector<Leaf> leaves;
+		ur_bool valid = true;
+		for (ur_uint64 key : keys)
+		{
+			if (keySet.count(key << 1) > 0)
+				continue;
+			Leaf leaf;
+			leaf.key = key;
+			valid &= presentation.GetKeyVertices(key, leaf.vertices);
+			leaves.push_back(leaf);
+		}
+		auto insideness = [](const ur_float3 (&v)[4], const ur_float3 &p) -> ur_double {
+			auto volume = [](const ur_float3 &v0, const ur_float3 &v1, const ur_float3 &v2, const ur_float3 &v3) -> ur_double {
+				ur_double3 e1(v1.x - v0.x, v1.y - v0.y, v1.z - v0.z), e2(v2.x - v0.x, v2.y - v0.y, v2.z - v0.z), e3(v3.x - v0.x, v3.y - v0.y, v3.z - v0.z);
+				return (e1.y * e2.z - e1.z * e2.y) * e3.x + (e1.z * e2.x - e1.x * e2.z) * e3.y + (e1.x * e2.y - e1.y * e2.x) * e3.z;
+			};
+			ur_double total = volume(v[0], v[1], v[2], v[3]);
+			return std::min(std::min(volume(p, v[1], v[2], v[3]) / total, volume(v[0], p, v[2], v[3]) / total),
+				std::min(volume(v[0], v[1], p, v[3]) / total, volume(v[0], v[1], v[2], p) / total));
+		};
+		static const ur_uint LeavesTested = 256;
+		static const ur_double InsidenessTolerance = 1.0e-6;
+		const ur_size leavesStep = std::max(leaves.size() / LeavesTested, ur_size(1));
+		ur_uint queriesCount = 0;
+		ur_uint mismatchesCount = 0;
+		for (ur_size il = 0; il < leaves.size(); il += leavesStep)
+		{
+			const Leaf &leaf = leaves[il];
+			for (ur_uint iv = 0; iv < 4; ++iv)
+			{
+				ur_float3 faceCenter(0.0f, 0.0f, 0.0f);
+				for (ur_uint jv = 0; jv < 4; ++jv)
+				{
+					if (jv != iv) faceCenter += leaf.vertices[jv] / 3.0f;
+				}
+				const ur_float3 point = faceCenter + (faceCenter - leaf.vertices[iv]) * 1.0e-3f;
+				ur_double maxInsideness = -std::numeric_limits<ur_double>::max();
+				for (const Leaf &other : leaves)
+				{
+					maxInsideness = std::max(maxInsideness, insideness(other.vertices, point));
+				}
+				const ur_uint64 neighbourKey = presentation.FindNeighbourKey(leaf.key, iv);
+				ur_bool match = false;
+				if (0 == neighbourKey)
+				{
+					match = (maxInsideness < -InsidenessTolerance);
+				}
+				else
+				{
+					ur_float3 vertices[4];
+					match = (neighbourKey != leaf.key && keySet.count(neighbourKey << 1) == 0 && keySet.count(neighbourKey) > 0 &&
+						presentation.GetKeyVertices(neighbourKey, vertices) && insideness(vertices, point) >= maxInsideness - InsidenessTolerance);
+				}
+				mismatchesCount += (match ? 0 : 1);
+				queriesCount += 1;
+			}
+		}
+		valid &= (queriesCount > 0 && 0 == mismatchesCount);
+		std::stringstream report;
+		report << "IsosurfaceToolApp: face neighbours: " << leaves.size() << " leaves, " << queriesCount << " neighbour queries, " <<
+			mismatchesCount << " mismatches against tree walk";
+		checksFailed += (valid ? 0 : 1);
+		log.WriteLine(report.str(), (valid ? Log::Note : Log::Warning));
+	}
+
+	// marching cubes vs surface nets:mesh size, extraction time and share of thin triangles (min angle below 10 degrees)
+	{
+		const ur_float surfaceRadius = (surfaceRadiusMin + surfaceRadiusMax) * 0.5f;
+		const ur_float tetrahedronSize = surfaceRadiusMax - surfaceRadiusMin;
+		const ur_float3 tetrahedron[4] = {
+			{ 0.0f, 0.0f, surfaceRadius + tetrahedronSize },
+			{ -tetrahedronSize, -tetrahedronSize, surfaceRadius - tetrahedronSize },
+			{ tetrahedronSize, -tetrahedronSize, surfaceRadius - tetrahedronSize },
+			{ 0.0f, tetrahedronSize, surfaceRadius - tetrahedronSize }
+		};
+
+		auto thinTrianglesShare = [](const Isosurface::MeshExtractor::Mesh &mesh) -> ur_double {
+			const ur_float minAngleCos = cos(10.0f * MathConst<ur_float>::Pi / 180.0f);
+			ur_size thinCount = 0;
+			for (ur_size it = 0; it + 2 < mesh.indices.size(); it += 3)
+			{
+				for (ur_uint iv = 0; iv < 3; ++iv)
+				{
+					const ur_float3 &p = mesh.vertices[mesh.indices[it + iv]].pos;
+					ur_float3 e0 = ur_float3::Normalize(mesh.vertices[mesh.indices[it + (iv + 1) % 3]].pos - p);
+					ur_float3 e1 = ur_float3::Normalize(mesh.vertices[mesh.indices[it + (iv + 2) % 3]].pos - p);
+					if (ur_float3::Dot(e0, e1) > minAngleCos)
+					{
+						++thinCount;
+						break;
+					}
+				}
+			}
+			return ur_double(thinCount) * 100.0 / std::max(mesh.indices.size() / 3, ur_size(1));
+		};
+
+		struct Config
+		{
+			const char *name;
+			bool surfaceNets;
+			ur_uint latticeResolution;
+		};
+		const Config configs[] = {
+			{ "MarchingCubes", false, 33 },
+			{ "SurfaceNets", true, 33 },
+			{ "SurfaceNets", true, 25 }
+		};
+		for (const auto &config : configs)
+		{
+			Isosurface::HybridCubes::Desc desc;
+			desc.CellSize = 1.0f;
+			desc.LatticeResolution = ur_uint3(config.latticeResolution);
+			desc.DetailLevelDistance = 0.0f;
+			std::unique_ptr<Isosurface::HybridCubes> presentation(config.surfaceNets ?
+				new Isosurface::SurfaceNets(*isosurface.get(), desc) :
+				new Isosurface::HybridCubes(*isosurface.get(), desc));
+
+			Isosurface::MeshExtractor::Mesh mesh;
+			ClockTime timeStart = Clock::now();
+			presentation->ExtractTetrahedron(mesh, tetrahedron, 0, false);
+			auto timeBuild = ClockDeltaAs<std::chrono::microseconds>(Clock::now() - timeStart);
+			std::stringstream report;
+			report << "IsosurfaceToolApp: " << config.name << " (lattice " << config.latticeResolution << "): " <<
+				mesh.indices.size() / 3 << " triangles, " << mesh.vertices.size() << " vertices, " <<
+				ur_double(timeBuild.count()) * 1.0e-3 << " ms, " << thinTrianglesShare(mesh) << "% thin triangles";
+			log.WriteLine(report.str());
+		}
+	}
+
+	// mesh simplification of a coarse level block: triangles count must drop, vertices on border and non manifold edges are locked
+	// and must be kept bitwise unchanged, so that adjacent meshes still line up
+	{
+		const ur_uint3 blockResolution(33);
+		const ur_uint latticeSize = blockResolution.x * blockResolution.y * blockResolution.z;
+		const ur_float3 blockCenter(0.0f, 0.0f, (surfaceRadiusMin + surfaceRadiusMax) * 0.5f);
+		const ur_float blockHalfSize = 128.0f;
+		const ur_float cellSize = blockHalfSize * 2.0f / (blockResolution.x - 1);
+		const ur_float3 blockMin = blockCenter - blockHalfSize;
+		const ur_float3 blockMax = blockCenter + blockHalfSize;
+		const ur_float3 corners[8] = {
+			{ blockMin.x, blockMin.y, blockMin.z }, { blockMax.x, blockMin.y, blockMin.z },
+			{ blockMin.x, blockMax.y, blockMin.z }, { blockMax.x, blockMax.y, blockMin.z },
+			{ blockMin.x, blockMin.y, blockMax.z }, { blockMax.x, blockMin.y, blockMax.z },
+			{ blockMin.x, blockMax.y, blockMax.z }, { blockMax.x, blockMax.y, blockMax.z }
+		};
+		std::vector<ur_float3> lattice(latticeSize);
+		std::vector<Isosurface::DataVolume::ValueType> samples(latticeSize);
+		Isosurface::MeshExtractor::ComputeLattice(lattice.data(), corners, blockResolution);
+		Result res = isosurface->GetData()->Read(samples.data(), lattice.data(), latticeSize, BoundingBox(blockMin, blockMax));
+		Isosurface::MeshExtractor::Mesh mesh;
+		if (Succeeded(res)) res = Isosurface::MeshExtractor::MarchCubes(mesh, lattice.data(), samples.data(), blockResolution);
+
+		// a fin triangle attached to an inner edge makes it non manifold
+		if (Succeeded(res) && mesh.indices.size() >= 3)
+		{
+			const ur_size it = (mesh.indices.size() / 6) * 3;
+			const Isosurface::Index v0 = mesh.indices[it];
+			const Isosurface::Index v1 = mesh.indices[it + 1];
+			Isosurface::Vertex fin = mesh.vertices[v0];
+			fin.pos = (mesh.vertices[v0].pos + mesh.vertices[v1].pos) * 0.5f + fin.norm * cellSize;
+			mesh.vertices.push_back(fin);
+			mesh.indices.insert(mesh.indices.end(), { v0, v1, Isosurface::Index(mesh.vertices.size() - 1) });
+		}
+
+		// vertices of edges not shared by exactly two triangles, compared by their bytes
+		std::map<std::pair<Isosurface::Index, Isosurface::Index>, ur_uint> edgeUses;
+		for (ur_size it = 0; it + 2 < mesh.indices.size(); it += 3)
+		{
+			for (ur_uint ie = 0; ie < 3; ++ie)
+			{
+				Isosurface::Index v0 = mesh.indices[it + ie];
+				Isosurface::Index v1 = mesh.indices[it + (ie + 1) % 3];
+				edgeUses[std::make_pair(std::min(v0, v1), std::max(v0, v1))] += 1;
+			}
+		}
+		auto vertexBytes = [](const Isosurface::Vertex &vertex) -> std::string {
+			return std::string((const char*)&vertex, sizeof(Isosurface::Vertex));
+		};
+		std::unordered_set<std::string> lockedVertices;
+		ur_uint nonManifoldEdgesCount = 0;
+		for (const auto &edge : edgeUses)
+		{
+			if (2 == edge.second)
+				continue;
+			nonManifoldEdgesCount += (edge.second > 2 ? 1 : 0);
+			lockedVertices.insert(vertexBytes(mesh.vertices[edge.first.first]));
+			lockedVertices.insert(vertexBytes(mesh.vertices[edge.first.second]));
+		}
+
+		const ur_size trianglesCount = mesh.indices.size() / 3;
+		Isosurface::MeshExtractor::Simplify(mesh, cellSize * 0.5f);
+		std::unordered_set<std::string> simplifiedVertices;
+		for (const auto &vertex : mesh.vertices)
+		{
+			simplifiedVertices.insert(vertexBytes(vertex));
+		}
+		ur_uint movedVerticesCount = 0;
+		for (const auto &vertex : lockedVertices)
+		{
+			movedVerticesCount += (simplifiedVertices.count(vertex) > 0 ? 0 : 1);
+		}
+		const ur_bool valid = (Succeeded(res) && nonManifoldEdgesCount > 0 && mesh.indices.size() / 3 < trianglesCount && 0 == movedVerticesCount);
+		std::stringstream report;
+		report << "IsosurfaceToolApp: simplification (cell size " << cellSize << "): " << trianglesCount << " -> " << mesh.indices.size() / 3 <<
+			" triangles, " << movedVerticesCount << "/" << lockedVertices.size() << " locked vertices changed (" <<
+			nonManifoldEdgesCount << " non manifold edges)";
+		checksFailed += (valid ? 0 : 1);
+		log.WriteLine(report.str(), (valid ? Log::Note : Log::Warning));
+	}
+
+	// skirts: a block is one of the hexahedra of a tetrahedron, two of its faces lie on tetrahedron faces, the others are inner;
+	// skirt quads must be added along every mesh border edge lying on a tetrahedron face and along no other edge
+	{
+		const ur_uint3 blockResolution(33);
+		const ur_uint latticeSize = blockResolution.x * blockResolution.y * blockResolution.z;
+		const ur_float3 blockCenter(0.0f, 0.0f, (surfaceRadiusMin + surfaceRadiusMax) * 0.5f);
+		const ur_float blockHalfSize = 128.0f;
+		const ur_float cellSize = blockHalfSize * 2.0f / (blockResolution.x - 1);
+		const ur_float3 blockMin = blockCenter - blockHalfSize;
+		const ur_float3 blockMax = blockCenter + blockHalfSize;
+		const ur_float3 corners[8] = {
+			{ blockMin.x, blockMin.y, blockMin.z }, { blockMax.x, blockMin.y, blockMin.z },
+			{ blockMin.x, blockMax.y, blockMin.z }, { blockMax.x, blockMax.y, blockMin.z },
+			{ blockMin.x, blockMin.y, blockMax.z }, { blockMax.x, blockMin.y, blockMax.z },
+			{ blockMin.x, blockMax.y, blockMax.z }, { blockMax.x, blockMax.y, blockMax.z }
+		};
+		std::vector<ur_float3> lattice(latticeSize);
+		std::vector<Isosurface::DataVolume::ValueType> samples(latticeSize);
+		Isosurface::MeshExtractor::ComputeLattice(lattice.data(), corners, blockResolution);
+		Result res = isosurface->GetData()->Read(samples.data(), lattice.data(), latticeSize, BoundingBox(blockMin, blockMax));
+		Isosurface::MeshExtractor::Mesh mesh;
+		if (Succeeded(res)) res = Isosurface::MeshExtractor::MarchCubes(mesh, lattice.data(), samples.data(), blockResolution);
+
+		// tetrahedron faces: block's min x and min y faces, an oblique face through the block center and one touching its max corner
+		const ur_float3 diagonal = ur_float3::Normalize(ur_float3(1.0f, 1.0f, 1.0f));
+		const ur_float4 planes[4] = {
+			{ 1.0f, 0.0f, 0.0f, -blockMin.x },
+			{ 0.0f, 1.0f, 0.0f, -blockMin.y },
+			{ diagonal.x, diagonal.y, diagonal.z, -ur_float3::Dot(diagonal, blockCenter) },
+			{ -diagonal.x, -diagonal.y, -diagonal.z, ur_float3::Dot(diagonal, blockMax) }
+		};
+		const ur_float skirtDepth = cellSize * 2.0f;
+		const ur_float tolerance = cellSize * 1.0e-3f;
+		auto onPlane = [&](const ur_float4 &plane, const ur_float3 &p) -> ur_bool {
+			return (std::fabs(plane.x * p.x + plane.y * p.y + plane.z * p.z + plane.w) <= tolerance);
+		};
+		auto onFace = [&](const ur_float3 &p0, const ur_float3 &p1) -> ur_bool {
+			for (const ur_float4 &plane : planes)
+			{
+				if (onPlane(plane, p0) && onPlane(plane, p1))
+					return true;
+			}
+			return false;
+		};
+
+		std::map<std::pair<Isosurface::Index, Isosurface::Index>, ur_uint> edgeUses;
+		for (ur_size it = 0; it + 2 < mesh.indices.size(); it += 3)
+		{
+			for (ur_uint ie = 0; ie < 3; ++ie)
+			{
+				Isosurface::Index v0 = mesh.indices[it + ie];
+				Isosurface::Index v1 = mesh.indices[it + (ie + 1) % 3];
+				edgeUses[std::make_pair(std::min(v0, v1), std::max(v0, v1))] += 1;
+			}
+		}
+		ur_uint borderEdgesCount = 0;
+		std::set<std::pair<Isosurface::Index, Isosurface::Index>> faceEdges;
+		for (const auto &edge : edgeUses)
+		{
+			if (edge.second != 1)
+				continue;
+			borderEdgesCount += 1;
+			if (onFace(mesh.vertices[edge.first.first].pos, mesh.vertices[edge.first.second].pos))
+				faceEdges.insert(edge.first);
+		}
+
+		// skirt quads are appended as { v1, v0, s0, v1, s0, s1 } where s0, s1 are new vertices extruded from v0, v1
+		const std::vector<Isosurface::Vertex> vertices = mesh.vertices;
+		const ur_size indicesCount = mesh.indices.size();
+		Isosurface::MeshExtractor::AddSkirts(mesh, planes, 4, skirtDepth, tolerance);
+		ur_uint mismatchesCount = ((mesh.indices.size() - indicesCount) % 6 == 0 ? 0 : 1);
+		std::set<std::pair<Isosurface::Index, Isosurface::Index>> skirtEdges;
+		for (ur_size i = indicesCount; i + 5 < mesh.indices.size(); i += 6)
+		{
+			const Isosurface::Index v1 = mesh.indices[i + 0];
+			const Isosurface::Index v0 = mesh.indices[i + 1];
+			const Isosurface::Index s0 = mesh.indices[i + 2];
+			const Isosurface::Index s1 = mesh.indices[i + 5];
+			const ur_bool match = (v0 < vertices.size() && v1 < vertices.size() && s0 >= vertices.size() && s1 >= vertices.size() &&
+				mesh.vertices[s0].pos == vertices[v0].pos - vertices[v0].norm * skirtDepth &&
+				mesh.vertices[s1].pos == vertices[v1].pos - vertices[v1].norm * skirtDepth &&
+				faceEdges.count(std::make_pair(std::min(v0, v1), std::max(v0, v1))) > 0);
+			mismatchesCount += (match ? 0 : 1);
+			skirtEdges.insert(std::make_pair(std::min(v0, v1), std::max(v0, v1)));
+		}
+		mismatchesCount += (skirtEdges == faceEdges ? 0 : 1);
+		const ur_bool valid = (Succeeded(res) && !faceEdges.empty() && borderEdgesCount > faceEdges.size() && 0 == mismatchesCount);
+		std::stringstream report;
+		report << "IsosurfaceToolApp: skirts: " << borderEdgesCount << " border edges, " << faceEdges.size() << " on tetrahedron faces, " <<
+			skirtEdges.size() << " skirted, " << mismatchesCount << " mismatches";
+		checksFailed += (valid ? 0 : 1);
+		log.WriteLine(report.str(), (valid ? Log::Note : Log::Warning));
+	}
+
+	// volume file round trip: demo volume is saved, opened by file and mapped volumes (block index is accessed in place by the latter),
+	// both must return the same samples for a lattice at every stored level; the most detailed level must match the source:
+	// trilinear samples are bound by the source values at the stored cell corners (constant tiles keep the sign only)
+	{
+		const std::string volumeFileName = "isosurface_volume.urv";
+		const ur_float fileCellSize = 32.0f;
+		Result fileRes = isosurface->GetData()->Save(volumeFileName, fileCellSize, ur_uint3(8));
+		Isosurface::FileVolume fileVolume(*isosurface.get());
+		Isosurface::MappedVolume mappedVolume(*isosurface.get());
+		if (Succeeded(fileRes)) fileRes = fileVolume.Open(volumeFileName);
+		if (Succeeded(fileRes)) fileRes = mappedVolume.Open(volumeFileName);
+		ur_float maxDiff = 0.0f;
+		ur_uint samplesCount = 0;
+		ur_uint sourceSamplesCount = 0;
+		ur_uint sourceMismatchesCount = 0;
+		const ur_uint3 latticeResolution(9);
+		std::vector<ur_float3> lattice(latticeResolution.x * latticeResolution.y * latticeResolution.z);
+		std::vector<Isosurface::DataVolume::ValueType> fileSamples(lattice.size());
+		std::vector<Isosurface::DataVolume::ValueType> mappedSamples(lattice.size());
+		for (ur_float latticeCellSize = fileCellSize; Succeeded(fileRes) && latticeCellSize < surfaceRadiusMax; latticeCellSize *= 2.0f)
+		{
+			const ur_float3 latticeMin(-latticeCellSize * 4.0f, -latticeCellSize * 4.0f, surfaceRadiusMin - latticeCellSize * 4.0f);
+			BoundingBox latticeBound(latticeMin, latticeMin + ur_float(latticeResolution.x - 1) * latticeCellSize);
+			const ur_float3 corners[8] = {
+				{ latticeBound.Min.x, latticeBound.Min.y, latticeBound.Min.z }, { latticeBound.Max.x, latticeBound.Min.y, latticeBound.Min.z },
+				{ latticeBound.Min.x, latticeBound.Max.y, latticeBound.Min.z }, { latticeBound.Max.x, latticeBound.Max.y, latticeBound.Min.z },
+				{ latticeBound.Min.x, latticeBound.Min.y, latticeBound.Max.z }, { latticeBound.Max.x, latticeBound.Min.y, latticeBound.Max.z },
+				{ latticeBound.Min.x, latticeBound.Max.y, latticeBound.Max.z }, { latticeBound.Max.x, latticeBound.Max.y, latticeBound.Max.z }
+			};
+			Isosurface::MeshExtractor::ComputeLattice(lattice.data(), corners, latticeResolution);
+			Result fileReadRes = fileVolume.ReadLattice(fileSamples.data(), lattice.data(), (ur_uint)lattice.size(), latticeBound, latticeCellSize);
+			Result mappedReadRes = mappedVolume.ReadLattice(mappedSamples.data(), lattice.data(), (ur_uint)lattice.size(), latticeBound, latticeCellSize);
+			if (fileReadRes.Code != mappedReadRes.Code)
+				fileRes = Result(Failure);
+			if (Failed(fileReadRes))
+				continue;
+			for (ur_size i = 0; i < lattice.size(); ++i)
+			{
+				maxDiff = std::max(maxDiff, std::fabs(fileSamples[i] - mappedSamples[i]));
+			}
+			samplesCount += (ur_uint)lattice.size();
+			if (latticeCellSize != fileCellSize)
+				continue;
+
+			// most detailed level vs source: stored cell size is the bound size evenly divided as DataVolume::Save does
+			const ur_float3 boundSize = volumeBound.Max - volumeBound.Min;
+			const ur_float3 levelCellSize(
+				boundSize.x / ceil(boundSize.x / fileCellSize),
+				boundSize.y / ceil(boundSize.y / fileCellSize),
+				boundSize.z / ceil(boundSize.z / fileCellSize));
+			std::vector<ur_float3> cellCorners(lattice.size() * 8);
+			std::vector<Isosurface::DataVolume::ValueType> cornerSamples(cellCorners.size());
+			for (ur_size i = 0; i < lattice.size(); ++i)
+			{
+				const ur_float3 f = (lattice[i] - volumeBound.Min) / levelCellSize;
+				const ur_float3 cellMin(floor(f.x), floor(f.y), floor(f.z));
+				for (ur_uint ic = 0; ic < 8; ++ic)
+				{
+					const ur_float3 corner = cellMin + ur_float3(ur_float(ic & 1), ur_float((ic >> 1) & 1), ur_float((ic >> 2) & 1));
+					cellCorners[i * 8 + ic] = volumeBound.Min + corner * levelCellSize;
+				}
+			}
+			if (Failed(isosurface->GetData()->Read(cornerSamples.data(), cellCorners.data(), (ur_uint)cellCorners.size(), volumeBound)))
+			{
+				fileRes = Result(Failure);
+				continue;
+			}
+			const ur_float constantDistance = std::max(std::max(levelCellSize.x, levelCellSize.y), levelCellSize.z);
+			for (ur_size i = 0; i < lattice.size(); ++i)
+			{
+				const Isosurface::DataVolume::ValueType *corners = cornerSamples.data() + i * 8;
+				const ur_float cornerMin = *std::min_element(corners, corners + 8);
+				const ur_float cornerMax = *std::max_element(corners, corners + 8);
+				const ur_float tolerance = std::max(std::fabs(cornerMin), std::fabs(cornerMax)) * 1.0e-4f + 1.0e-3f;
+				ur_bool match = (fileSamples[i] >= cornerMin - tolerance && fileSamples[i] <= cornerMax + tolerance);
+				if (!match && (cornerMin > constantDistance || cornerMax < -constantDistance))
+					match = ((fileSamples[i] > 0) == (cornerMin > 0));
+				sourceMismatchesCount += (match ? 0 : 1);
+			}
+			sourceSamplesCount += (ur_uint)lattice.size();
+		}
+		const ur_bool valid = (Succeeded(fileRes) && 0.0f == maxDiff && sourceSamplesCount > 0 && 0 == sourceMismatchesCount);
+		std::stringstream report;
+		report << "IsosurfaceToolApp: volume file round trip: " << (Succeeded(fileRes) ? "succeeded" : "failed") << ", " <<
+			samplesCount << " samples compared, max file/mapped difference " << maxDiff << ", " <<
+			sourceMismatchesCount << "/" << sourceSamplesCount << " most detailed level samples out of the source cell range";
+		checksFailed += (valid ? 0 : 1);
+		log.WriteLine(report.str(), (valid ? Log::Note : Log::Warning));
+	}
+
+	// sparse volume: built from a downscaled demo generator (same algorithm and octaves), samples read at voxels must match
+	// the source clamped to the narrow band within a quantization step, voxels far from the surface must read constant tiles
+	// of the source sign, and the early intersection test (no values) must report empty regions as not found
+	{
+		const ur_float radiusMin = 100.0f;
+		const ur_float radiusMax = 110.0f;
+		Isosurface::ProceduralGenerator::SimplexNoiseParams generateParams;
+		generateParams.bound = BoundingBox(ur_float3(-radiusMax), ur_float3(radiusMax));
+		generateParams.radiusMin = radiusMin;
+		generateParams.radiusMax = radiusMax;
+		generateParams.octaves.assign({
+			{ 0.875f, 7.5f, -1.0f, 0.5f },
+			{ 0.345f, 30.0f, -0.5f, 0.1f },
+			{ 0.035f, 120.0f, -1.0f, 0.2f },
+			});
+		Isosurface::ProceduralGenerator source(*isosurface.get(), Isosurface::ProceduralGenerator::Algorithm::SimplexNoise, generateParams);
+		const BoundingBox &sourceBound = source.GetBound();
+
+		static const ur_uint PointsCount = 65536;
+		static const ur_uint RegionsCount = 1024;
+		for (ur_uint quantizationBits : { 8, 16 })
+		{
+			Isosurface::SparseVolume::Desc desc;
+			desc.VoxelSize = 2.0f;
+			desc.NarrowBand = desc.VoxelSize * 4.0f;
+			desc.QuantizationBits = quantizationBits;
+			Isosurface::SparseVolume sparseVolume(*isosurface.get());
+			ClockTime timeStart = Clock::now();
+			Result res = sparseVolume.Build(source, desc);
+			auto timeBuild = ClockDeltaAs<std::chrono::microseconds>(Clock::now() - timeStart);
+
+			// random voxels: quantized leaves are within a step of the clamped source (leaf range never exceeds the band),
+			// voxels whose source value is beyond the band with a margin of the sampling slope must hold the band value of the source sign
+			// (tiles hold it exactly, leaves partially clamped to the band within a step)
+			const ur_float quantizationStep = desc.NarrowBand * 2.0f / ur_float((1 << quantizationBits) - 1);
+			const ur_float tileMargin = desc.VoxelSize * 4.0f;
+			const ur_int3 voxelsCount(
+				(ur_int)ceil((sourceBound.Max.x - sourceBound.Min.x) / desc.VoxelSize) + 1,
+				(ur_int)ceil((sourceBound.Max.y - sourceBound.Min.y) / desc.VoxelSize) + 1,
+				(ur_int)ceil((sourceBound.Max.z - sourceBound.Min.z) / desc.VoxelSize) + 1);
+			std::mt19937 rng(1);
+			std::vector<ur_float3> points(PointsCount);
+			for (auto &point : points)
+			{
+				ur_int3 voxel(ur_int(rng() % voxelsCount.x), ur_int(rng() % voxelsCount.y), ur_int(rng() % voxelsCount.z));
+				point = sourceBound.Min + ur_float3(ur_float(voxel.x), ur_float(voxel.y), ur_float(voxel.z)) * desc.VoxelSize;
+			}
+			std::vector<Isosurface::DataVolume::ValueType> sourceValues(PointsCount);
+			std::vector<Isosurface::DataVolume::ValueType> sparseValues(PointsCount);
+			if (Succeeded(res)) res = source.Read(sourceValues.data(), points.data(), PointsCount, sourceBound);
+			if (Succeeded(res)) res = sparseVolume.Read(sparseValues.data(), points.data(), PointsCount, sourceBound);
+			ur_float maxDiff = 0.0f;
+			ur_uint tileVoxelsCount = 0;
+			ur_uint tileMismatchesCount = 0;
+			for (ur_uint i = 0; Succeeded(res) && i < PointsCount; ++i)
+			{
+				const ur_float clamped = std::min(std::max(sourceValues[i], -desc.NarrowBand), desc.NarrowBand);
+				maxDiff = std::max(maxDiff, std::fabs(sparseValues[i] - clamped));
+				if (std::fabs(sourceValues[i]) > desc.NarrowBand + tileMargin)
+				{
+					tileVoxelsCount += 1;
+					tileMismatchesCount += (std::fabs(sparseValues[i] - (sourceValues[i] > 0 ? desc.NarrowBand : -desc.NarrowBand)) <= quantizationStep ? 0 : 1);
+				}
+			}
+
+			// random regions: the early test must report not found if no source sample within the region (and the band around it)
+			// crosses the surface, sign changes are searched on a lattice finer than the voxels
+			const ur_uint3 regionResolution(9);
+			const ur_uint regionSize = regionResolution.x * regionResolution.y * regionResolution.z;
+			std::vector<ur_float3> regionLattice(regionSize);
+			std::vector<Isosurface::DataVolume::ValueType> regionValues(regionSize);
+			ur_uint emptyRegionsCount = 0;
+			ur_uint emptyMismatchesCount = 0;
+			for (ur_uint ir = 0; Succeeded(res) && ir < RegionsCount; ++ir)
+			{
+				const ur_float regionHalfSize = desc.VoxelSize * ur_float(1 + rng() % 4);
+				const ur_float3 regionCenter(
+					sourceBound.Min.x + (sourceBound.Max.x - sourceBound.Min.x) * ur_float(rng() % 1024) / 1024.0f,
+					sourceBound.Min.y + (sourceBound.Max.y - sourceBound.Min.y) * ur_float(rng() % 1024) / 1024.0f,
+					sourceBound.Min.z + (sourceBound.Max.z - sourceBound.Min.z) * ur_float(rng() % 1024) / 1024.0f);
+				const BoundingBox region(regionCenter - regionHalfSize, regionCenter + regionHalfSize);
+				const BoundingBox bandRegion(region.Min - desc.NarrowBand - tileMargin, region.Max + desc.NarrowBand + tileMargin);
+				const ur_float3 corners[8] = {
+					{ bandRegion.Min.x, bandRegion.Min.y, bandRegion.Min.z }, { bandRegion.Max.x, bandRegion.Min.y, bandRegion.Min.z },
+					{ bandRegion.Min.x, bandRegion.Max.y, bandRegion.Min.z }, { bandRegion.Max.x, bandRegion.Max.y, bandRegion.Min.z },
+					{ bandRegion.Min.x, bandRegion.Min.y, bandRegion.Max.z }, { bandRegion.Max.x, bandRegion.Min.y, bandRegion.Max.z },
+					{ bandRegion.Min.x, bandRegion.Max.y, bandRegion.Max.z }, { bandRegion.Max.x, bandRegion.Max.y, bandRegion.Max.z }
+				};
+				Isosurface::MeshExtractor::ComputeLattice(regionLattice.data(), corners, regionResolution);
+				res = source.Read(regionValues.data(), regionLattice.data(), regionSize, bandRegion);
+				ur_bool farFromSurface = true;
+				for (ur_uint i = 0; i < regionSize; ++i)
+				{
+					farFromSurface &= (std::fabs(regionValues[i]) > desc.NarrowBand + tileMargin && (regionValues[i] > 0) == (regionValues[0] > 0));
+				}
+				if (!farFromSurface)
+					continue;
+				emptyRegionsCount += 1;
+				emptyMismatchesCount += (sparseVolume.Read(ur_null, ur_null, 0, region) == NotFound ? 0 : 1);
+			}
+
+			const Isosurface::SparseVolume::Stats &stats = sparseVolume.GetStats();
+			const ur_bool valid = (Succeeded(res) && stats.leavesCount > 0 && stats.tilesCount > 0 && maxDiff <= quantizationStep &&
+				tileVoxelsCount > 0 && 0 == tileMismatchesCount && emptyRegionsCount > 0 && 0 == emptyMismatchesCount);
+			std::stringstream report;
+			report << "IsosurfaceToolApp: sparse volume (" << quantizationBits << " bits): " << (Succeeded(res) ? "built" : "failed") << " in " <<
+				ur_double(timeBuild.count()) * 1.0e-3 << " ms, " << stats.leavesCount << " leaves, " << stats.tilesCount << " tiles, " <<
+				stats.memoryUsed / 1024 << " KB; max voxel difference " << maxDiff << " (step " << quantizationStep << "), " <<
+				tileMismatchesCount << "/" << tileVoxelsCount << " tile voxels mismatch, " <<
+				emptyMismatchesCount << "/" << emptyRegionsCount << " empty regions found intersected";
+			checksFailed += (valid ? 0 : 1);
+			log.WriteLine(report.str(), (valid ? Log::Note : Log::Warning));
+		}
+	}
+
+	// csg volume: values read through the BVH must match the brute force evaluation applying every primitive whose influence bound
+	// contains the point in the order of declaration (operations are not commutative); random spheres, boxes and capsules
+	// combined by all operations are read in random regions of different sizes
+	{
+		typedef Isosurface::CsgVolume::Primitive Primitive;
+		static const ur_uint PrimitivesCount = 4096;
+		static const ur_uint RegionsCount = 64;
+		const ur_float spaceSize = 1000.0f;
+		std::mt19937 rng(1);
+		auto random = [&rng](ur_float a, ur_float b) -> ur_float {
+			return a + (b - a) * ur_float(rng() % 65536) / 65535.0f;
+		};
+		std::vector<Primitive> primitives(PrimitivesCount);
+		for (auto &primitive : primitives)
+		{
+			primitive.shape = Primitive::Shape(rng() % 3);
+			primitive.operation = Primitive::Operation(rng() % 4);
+			primitive.center = ur_float3(random(0.0f, spaceSize), random(0.0f, spaceSize), random(0.0f, spaceSize));
+			primitive.extent = ur_float3(random(2.0f, 40.0f), random(2.0f, 40.0f), random(2.0f, 40.0f));
+			primitive.axis = ur_float3(random(-30.0f, 30.0f), random(-30.0f, 30.0f), random(-30.0f, 30.0f));
+			primitive.blend = random(0.0f, 16.0f);
+		}
+		Isosurface::CsgVolume::Desc desc;
+		desc.Margin = 8.0f;
+		desc.LeafSize = 4;
+		Isosurface::CsgVolume csgVolume(*isosurface.get());
+		Result res = csgVolume.Build(primitives, desc);
+
+		// reference: shapes and influence bounds as documented by CsgVolume::Primitive
+		auto evaluate = [](const Primitive &primitive, const ur_float3 &point) -> ur_float {
+			ur_float3 d = point - primitive.center;
+			switch (primitive.shape)
+			{
+			case Primitive::Shape::Sphere:
+				return primitive.extent.x - d.Length();
+			case Primitive::Shape::Box:
+			{
+				ur_float3 q(std::fabs(d.x) - primitive.extent.x, std::fabs(d.y) - primitive.extent.y, std::fabs(d.z) - primitive.extent.z);
+				ur_float3 qo(std::max(q.x, 0.0f), std::max(q.y, 0.0f), std::max(q.z, 0.0f));
+				return -(qo.Length() + std::min(std::max(std::max(q.x, q.y), q.z), 0.0f));
+			}
+			case Primitive::Shape::Capsule:
+			{
+				ur_float3 a = primitive.axis * 2.0f;
+				ur_float3 p = d + primitive.axis;
+				ur_float t = std::min(std::max(ur_float3::Dot(p, a) / ur_float3::Dot(a, a), 0.0f), 1.0f);
+				return primitive.extent.x - (p - a * t).Length();
+			}
+			}
+			return -std::numeric_limits<ur_float>::max();
+		};
+		std::vector<BoundingBox> influences(PrimitivesCount);
+		for (ur_uint ip = 0; ip < PrimitivesCount; ++ip)
+		{
+			const Primitive &primitive = primitives[ip];
+			ur_float3 halfSize = (Primitive::Shape::Sphere == primitive.shape ? ur_float3(primitive.extent.x) :
+				Primitive::Shape::Box == primitive.shape ? primitive.extent :
+				ur_float3(std::fabs(primitive.axis.x), std::fabs(primitive.axis.y), std::fabs(primitive.axis.z)) + primitive.extent.x);
+			const ur_bool smooth = (Primitive::Operation::SmoothUnion == primitive.operation || Primitive::Operation::SmoothSubtract == primitive.operation);
+			halfSize += desc.Margin + (smooth ? primitive.blend : 0.0f);
+			influences[ip] = BoundingBox(primitive.center - halfSize, primitive.center + halfSize);
+		}
+
+		static const ur_float Tolerance = 1.0e-4f;
+		const ur_uint3 regionResolution(9);
+		const ur_uint regionSize = regionResolution.x * regionResolution.y * regionResolution.z;
+		std::vector<ur_float3> lattice(regionSize);
+		std::vector<Isosurface::DataVolume::ValueType> values(regionSize);
+		ur_float maxDiff = 0.0f;
+		ur_uint samplesCount = 0;
+		ur_uint codeMismatchesCount = 0;
+		ur_uint smoothSamplesCount = 0;
+		for (ur_uint ir = 0; Succeeded(res) && ir < RegionsCount; ++ir)
+		{
+			const ur_float regionHalfSize = ur_float(4 << (ir % 6));
+			const ur_float3 regionCenter(random(0.0f, spaceSize), random(0.0f, spaceSize), random(0.0f, spaceSize));
+			const BoundingBox region(regionCenter - regionHalfSize, regionCenter + regionHalfSize);
+			const ur_float3 corners[8] = {
+				{ region.Min.x, region.Min.y, region.Min.z }, { region.Max.x, region.Min.y, region.Min.z },
+				{ region.Min.x, region.Max.y, region.Min.z }, { region.Max.x, region.Max.y, region.Min.z },
+				{ region.Min.x, region.Min.y, region.Max.z }, { region.Max.x, region.Min.y, region.Max.z },
+				{ region.Min.x, region.Max.y, region.Max.z }, { region.Max.x, region.Max.y, region.Max.z }
+			};
+			Isosurface::MeshExtractor::ComputeLattice(lattice.data(), corners, regionResolution);
+			Result readRes = csgVolume.Read(values.data(), lattice.data(), regionSize, region);
+			if (Failed(readRes) && readRes != NotFound)
+				res = readRes;
+
+			ur_bool additive = false;
+			for (ur_uint ip = 0; ip < PrimitivesCount; ++ip)
+			{
+				additive |= (influences[ip].Intersects(region) &&
+					(Primitive::Operation::Union == primitives[ip].operation || Primitive::Operation::SmoothUnion == primitives[ip].operation));
+			}
+			codeMismatchesCount += ((readRes == NotFound) == additive ? 1 : 0);
+			codeMismatchesCount += ((csgVolume.Read(ur_null, ur_null, 0, region) == NotFound) == additive ? 1 : 0);
+
+			for (ur_uint i = 0; i < regionSize; ++i)
+			{
+				const ur_float3 &point = lattice[i];
+				ur_float value = -desc.Margin;
+				ur_bool smooth = false;
+				for (ur_uint ip = 0; ip < PrimitivesCount; ++ip)
+				{
+					if (!influences[ip].Intersects(point))
+						continue;
+					const Primitive &primitive = primitives[ip];
+					const ur_float k = primitive.blend;
+					switch (primitive.operation)
+					{
+					case Primitive::Operation::Union:
+						value = std::max(value, evaluate(primitive, point));
+						break;
+					case Primitive::Operation::Subtract:
+						value = std::min(value, -evaluate(primitive, point));
+						break;
+					case Primitive::Operation::SmoothUnion:
+					{
+						ur_float s = evaluate(primitive, point);
+						ur_float h = (k > 0.0f ? std::max(k - std::fabs(value - s), 0.0f) / k : 0.0f);
+						value = std::max(value, s) + h * h * k * 0.25f;
+						smooth |= (h > 0.0f);
+					} break;
+					case Primitive::Operation::SmoothSubtract:
+					{
+						ur_float s = -evaluate(primitive, point);
+						ur_float h = (k > 0.0f ? std::max(k - std::fabs(value - s), 0.0f) / k : 0.0f);
+						value = std::min(value, s) - h * h * k * 0.25f;
+						smooth |= (h > 0.0f);
+					} break;
+					}
+				}
+				value = std::min(std::max(value, -desc.Margin), desc.Margin);
+				maxDiff = std::max(maxDiff, std::fabs(values[i] - value));
+				smoothSamplesCount += (smooth ? 1 : 0);
+			}
+			samplesCount += regionSize;
+		}
+		const ur_bool valid = (Succeeded(res) && samplesCount > 0 && smoothSamplesCount > 0 && maxDiff <= Tolerance && 0 == codeMismatchesCount);
+		std::stringstream report;
+		report << "IsosurfaceToolApp: csg volume: " << csgVolume.GetPrimitivesCount() << " primitives, " << csgVolume.GetNodesCount() << " BVH nodes, " <<
+			samplesCount << " samples (" << smoothSamplesCount << " blended), max BVH/brute force difference " << maxDiff << ", " <<
+			codeMismatchesCount << " intersection result mismatches";
+		checksFailed += (valid ? 0 : 1);
+		log.WriteLine(report.str(), (valid ? Log::Note : Log::Warning));
+	}
+
+	// free list allocator (mesh pool ranges): random allocations and frees, live ranges must be aligned, in bounds and disjoint,
+	// used size must match them; once everything is freed the space must be coalesced back into a single block
+	{
+		static const ur_uint Iterations = 1 << 16;
+		static const ur_size Size = (1 << 20);
+		static const ur_size Alignment = 16;
+		FreeListAllocator allocator;
+		allocator.Init(Size, Alignment);
+		std::map<ur_size, ur_size> liveRanges; // offset -> size
+		std::vector<Allocation> allocations;
+		std::mt19937 rng(1);
+		ur_size usedSize = 0;
+		ur_size failedAllocations = 0;
+		ur_bool valid = true;
+		for (ur_uint i = 0; i < Iterations && valid; ++i)
+		{
+			if (allocations.empty() || rng() % 8 < 5)
+			{
+				Allocation alloc = allocator.Allocate(1 + rng() % 4096);
+				if (0 == alloc.Size)
+				{
+					failedAllocations += 1;
+					continue;
+				}
+				auto next = liveRanges.lower_bound(alloc.Offset);
+				valid &= (alloc.Offset % Alignment == 0 && alloc.Offset + alloc.Size <= Size);
+				valid &= (next == liveRanges.end() || alloc.Offset + alloc.Size <= next->first);
+				valid &= (next == liveRanges.begin() || std::prev(next)->first + std::prev(next)->second <= alloc.Offset);
+				liveRanges.insert(std::make_pair(alloc.Offset, alloc.Size));
+				allocations.push_back(alloc);
+				usedSize += alloc.Size;
+			}
+			else
+			{
+				ur_size idx = rng() % allocations.size();
+				allocator.Free(allocations[idx]);
+				liveRanges.erase(allocations[idx].Offset);
+				usedSize -= allocations[idx].Size;
+				allocations[idx] = allocations.back();
+				allocations.pop_back();
+			}
+			valid &= (allocator.GetUsedSize() == usedSize);
+		}
+		for (const auto &alloc : allocations)
+		{
+			allocator.Free(alloc);
+		}
+		valid &= (0 == allocator.GetUsedSize() && 1 == allocator.GetFreeBlocksCount() && Size == allocator.GetLargestFreeBlock());
+		std::stringstream report;
+		report << "IsosurfaceToolApp: free list allocator: " << Iterations << " random operations, " << failedAllocations <<
+			" allocations out of space, " << (valid ? "consistent" : "inconsistent");
+		checksFailed += (valid ? 0 : 1);
+		log.WriteLine(report.str(), (valid ? Log::Note : Log::Warning));
+	}
+
+	// editable volume: random brushes written around a surface point into volumes baking bricks and keeping all brushes,
+	// baked samples are interpolated, so reads near the surface may differ by the baked lattice precision only
+	// (brushes are clipped by their influence bounds, the field is not continuous farther than a brick from the surface)
+	{
+		static const ur_uint BrushesCount = 512;
+		static const ur_uint SamplesCount = 1 << 16;
+		static const ur_float BrickSize = 8.0f;
+		static const ur_float EditRadius = 32.0f;
+		const ur_float3 editCenter(0.0f, 0.0f, (surfaceRadiusMin + surfaceRadiusMax) * 0.5f);
+		Isosurface::ProceduralGenerator::SphericalDistanceFieldParams sourceParams;
+		sourceParams.bound = volumeBound;
+		sourceParams.center = ur_float3(0.0f, 0.0f, 0.0f);
+		sourceParams.radius = editCenter.z;
+		std::unique_ptr<Isosurface::EditableVolume> editVolumes[2];
+		for (ur_uint iv = 0; iv < 2; ++iv)
+		{
+			editVolumes[iv].reset(new Isosurface::EditableVolume(*isosurface.get(), std::unique_ptr<Isosurface::DataVolume>(
+				new Isosurface::ProceduralGenerator(*isosurface.get(), Isosurface::ProceduralGenerator::Algorithm::SphericalDistanceField, sourceParams)),
+				BrickSize, (0 == iv ? 8 : 0)));
+		}
+		std::mt19937 rng(1);
+		std::uniform_real_distribution<ur_float> unitDistribution(-1.0f, 1.0f);
+		auto randomPoint = [&]() -> ur_float3 {
+			return editCenter + ur_float3(unitDistribution(rng), unitDistribution(rng), unitDistribution(rng)) * EditRadius;
+		};
+		Result editRes = Result(Success);
+		for (ur_uint i = 0; i < BrushesCount; ++i)
+		{
+			Isosurface::DataVolume::EditBrush brush;
+			brush.shape = (rng() % 2 ? Isosurface::DataVolume::EditBrush::Shape::Sphere : Isosurface::DataVolume::EditBrush::Shape::Box);
+			brush.operation = (rng() % 2 ? Isosurface::DataVolume::EditBrush::Operation::Add : Isosurface::DataVolume::EditBrush::Operation::Subtract);
+			brush.center = randomPoint();
+			brush.extent = ur_float3(2.0f, 2.0f, 2.0f) + ur_float3(std::fabs(unitDistribution(rng)), std::fabs(unitDistribution(rng)), std::fabs(unitDistribution(rng))) * 4.0f;
+			for (auto &editVolume : editVolumes)
+			{
+				editRes &= editVolume->Write(brush);
+			}
+		}
+		std::vector<ur_float3> points(SamplesCount);
+		for (auto &point : points)
+		{
+			point = randomPoint();
+		}
+		std::vector<Isosurface::DataVolume::ValueType> values[2];
+		const BoundingBox editBound(editCenter - ur_float3(EditRadius, EditRadius, EditRadius), editCenter + ur_float3(EditRadius, EditRadius, EditRadius));
+		for (ur_uint iv = 0; iv < 2; ++iv)
+		{
+			values[iv].resize(SamplesCount);
+			editRes &= editVolumes[iv]->Read(values[iv].data(), points.data(), SamplesCount, editBound);
+		}
+		ur_float maxDiff = 0.0f;
+		ur_uint samplesCompared = 0;
+		for (ur_uint i = 0; i < SamplesCount; ++i)
+		{
+			if (std::fabs(values[1][i]) >= BrickSize * 0.5f)
+				continue;
+			maxDiff = std::max(maxDiff, std::fabs(values[0][i] - values[1][i]));
+			samplesCompared += 1;
+		}
+		const ur_float tolerance = BrickSize / Isosurface::EditableVolume::BakeResolution * 1.75f; // baked cell diagonal
+		const ur_bool valid = (Succeeded(editRes) && maxDiff <= tolerance && editVolumes[0]->GetBrushesCount() < editVolumes[1]->GetBrushesCount());
+		std::stringstream report;
+		report << "IsosurfaceToolApp: editable volume: " << BrushesCount << " brushes written, " << editVolumes[0]->GetBakedBricksCount() <<
+			" bricks baked, " << editVolumes[0]->GetBrushesCount() << "/" << editVolumes[1]->GetBrushesCount() << " brushes kept, " << samplesCompared <<
+			" samples near the surface compared, max baked/exact difference " << maxDiff << " (tolerance " << tolerance << ")";
+		checksFailed += (valid ? 0 : 1);
+		log.WriteLine(report.str(), (valid ? Log::Note : Log::Warning));
+	}
+
+	// extract mesh
+	const ur_uint3 resolution(256);
+	Isosurface::MeshExtractor::Mesh mesh;
+	ClockTime timeStart = Clock::now();
+	Result res = Isosurface::MeshExtractor::Extract(mesh, *isosurface->GetData(), volumeBound, resolution);
+	auto timeExtract = ClockDeltaAs<std::chrono::microseconds>(Clock::now() - timeStart);
+
+	ur_size trianglesCount = mesh.indices.size() / 3;
+	ur_double seconds = std::max(ur_double(timeExtract.count()) * 1.0e-6, 1.0e-6);
+	std::stringstream report;
+	report << "IsosurfaceToolApp: extracted " << trianglesCount << " triangles, " << mesh.vertices.size() << " vertices in " <<
+		seconds * 1.0e3 << " ms (" << ur_double(trianglesCount) / seconds << " triangles/s)";
+	log.WriteLine(report.str(), Failed(res) ? Log::Error : Log::Note);
+
+	// save
+	if (Succeeded(res))
+	{
+		res = Isosurface::MeshExtractor::SaveObj(realm, mesh, "isosurface.obj");
+	}
+
+	isosurface.reset();
+	realm.Deinitialize();
+
+	return (Succeeded(res) && 0 == checksFailed ? 0 : -1);
+}
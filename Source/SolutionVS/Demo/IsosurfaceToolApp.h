@@ -0,0 +1,8 @@
+#pragma once
+
+class IsosurfaceToolApp
+{
+public:
+
+	int Run();
+};
@@ -0,0 +1,11 @@
+// IsosurfaceTool.cpp : Defines the entry point for the console application.
+// Runs IsosurfaceToolApp headless: meshing benchmarks and checks are reported to the log (unlim_log.txt) and the process exit code.
+
+#include "stdafx.h"
+#include "IsosurfaceToolApp.h"
+
+int main(int argc, char *argv[])
+{
+	IsosurfaceToolApp toolApp;
+	return toolApp.Run();
+}
@@ -58,6 +58,8 @@
 #include <set>
 #include <map>
 #include <unordered_map>
+#include <unordered_set>
+#include <queue>
 #include <list>
 #include <algorithm>
 #include <memory>
@@ -56,4 +56,113 @@ namespace UnlimRealms
 		return alloc;
 	}
 
+	FreeListAllocator::FreeListAllocator() :
+		size(0),
+		alignment(1),
+		usedSize(0)
+	{
+	}
+
+	FreeListAllocator::~FreeListAllocator()
+	{
+	}
+
+	void FreeListAllocator::Init(ur_size size, ur_size alignment)
+	{
+		this->alignment = std::max(alignment, ur_size(1));
+		this->size = (size / this->alignment) * this->alignment;
+		this->usedSize = 0;
+		this->freeBlocks.clear();
+		this->freeBlocksBySize.clear();
+		if (this->size > 0)
+		{
+			this->freeBlocks.insert({ 0, this->size });
+			this->freeBlocksBySize.insert({ this->size, 0 });
+		}
+	}
+
+	Allocation FreeListAllocator::Allocate(ur_size allocSize)
+	{
+		allocSize = ((allocSize + alignment - 1) / alignment) * alignment;
+
+		Allocation alloc = {};
+		if (0 == allocSize)
+			return alloc;
+
+		// smallest free block fitting requested size
+		auto sizeIter = this->freeBlocksBySize.lower_bound(allocSize);
+		if (sizeIter == this->freeBlocksBySize.end())
+			return alloc;
+
+		ur_size blockOffset = sizeIter->second;
+		ur_size blockSize = sizeIter->first;
+		this->freeBlocksBySize.erase(sizeIter);
+		this->freeBlocks.erase(blockOffset);
+
+		// return the remainder to the free list
+		if (blockSize > allocSize)
+		{
+			this->freeBlocks.insert({ blockOffset + allocSize, blockSize - allocSize });
+			this->freeBlocksBySize.insert({ blockSize - allocSize, blockOffset + allocSize });
+		}
+
+		alloc.Offset = blockOffset;
+		alloc.Size = allocSize;
+		this->usedSize += allocSize;
+
+		return alloc;
+	}
+
+	void FreeListAllocator::Free(const Allocation &alloc)
+	{
+		if (0 == alloc.Size)
+			return;
+
+		auto eraseBySize = [this](ur_size blockOffset, ur_size blockSize) {
+			auto range = this->freeBlocksBySize.equal_range(blockSize);
+			for (auto it = range.first; it != range.second; ++it)
+			{
+				if (it->second == blockOffset)
+				{
+					this->freeBlocksBySize.erase(it);
+					break;
+				}
+			}
+		};
+
+		ur_size blockOffset = alloc.Offset;
+		ur_size blockSize = alloc.Size;
+
+		// coalesce with following free block
+		auto nextIter = this->freeBlocks.lower_bound(blockOffset);
+		if (nextIter != this->freeBlocks.end() && nextIter->first == blockOffset + blockSize)
+		{
+			blockSize += nextIter->second;
+			eraseBySize(nextIter->first, nextIter->second);
+			nextIter = this->freeBlocks.erase(nextIter);
+		}
+
+		// coalesce with preceding free block
+		if (nextIter != this->freeBlocks.begin())
+		{
+			auto prevIter = std::prev(nextIter);
+			if (prevIter->first + prevIter->second == blockOffset)
+			{
+				blockOffset = prevIter->first;
+				blockSize += prevIter->second;
+				eraseBySize(prevIter->first, prevIter->second);
+				this->freeBlocks.erase(prevIter);
+			}
+		}
+
+		this->freeBlocks.insert({ blockOffset, blockSize });
+		this->freeBlocksBySize.insert({ blockSize, blockOffset });
+		this->usedSize -= alloc.Size;
+	}
+
+	ur_size FreeListAllocator::GetLargestFreeBlock() const
+	{
+		return (this->freeBlocksBySize.empty() ? 0 : this->freeBlocksBySize.rbegin()->first);
+	}
+
 } // end namespace UnlimRealms
\ No newline at end of file
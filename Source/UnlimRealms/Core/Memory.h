@@ -50,6 +50,45 @@ namespace UnlimRealms
 		ur_size offset;
 	};
 
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// Free List Allocator
+	// Sub allocates ranges of an abstract address space (bytes, elements etc.) and reuses freed ranges;
+	// adjacent free ranges are coalesced, allocation uses best fit strategy
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	class UR_DECL FreeListAllocator
+	{
+	public:
+
+		FreeListAllocator();
+
+		~FreeListAllocator();
+
+		void Init(ur_size size, ur_size alignment = 1);
+
+		// returns zero sized allocation if there is no free range large enough
+		Allocation Allocate(ur_size allocSize);
+
+		void Free(const Allocation &alloc);
+
+		ur_size GetLargestFreeBlock() const;
+
+		inline ur_size GetSize() const;
+
+		inline ur_size GetAlignment() const;
+
+		inline ur_size GetUsedSize() const;
+
+		inline ur_size GetFreeBlocksCount() const;
+
+	private:
+
+		ur_size size;
+		ur_size alignment;
+		ur_size usedSize;
+		std::map<ur_size, ur_size> freeBlocks; // offset -> size
+		std::multimap<ur_size, ur_size> freeBlocksBySize; // size -> offset
+	};
+
 	inline ur_size LinearAllocator::GetSize() const
 	{
 		return this->size;
@@ -65,4 +104,24 @@ namespace UnlimRealms
 		return this->offset;
 	}
 
+	inline ur_size FreeListAllocator::GetSize() const
+	{
+		return this->size;
+	}
+
+	inline ur_size FreeListAllocator::GetAlignment() const
+	{
+		return this->alignment;
+	}
+
+	inline ur_size FreeListAllocator::GetUsedSize() const
+	{
+		return this->usedSize;
+	}
+
+	inline ur_size FreeListAllocator::GetFreeBlocksCount() const
+	{
+		return this->freeBlocks.size();
+	}
+
 } // end namespace UnlimRealms
@@ -4477,8 +4477,8 @@ namespace UnlimRealms
 			{
 				const GrafVertexElementDesc& grafVertexElement = grafVertexInputDesc.Elements[ielem];
 				VkVertexInputAttributeDescription& vkVertexAttribute = vkVertexAttributes[vertexAttributesOffset + ielem];
-				vkVertexAttribute.location = (ur_uint32)ielem;
-				vkVertexAttribute.binding = (ur_uint32)ivb;
+				vkVertexAttribute.location = (ur_uint32)(vertexAttributesOffset + ielem); // locations are sequential across all bindings
+				vkVertexAttribute.binding = (ur_uint32)grafVertexInputDesc.BindingIdx;
 				vkVertexAttribute.format = GrafUtilsVulkan::GrafToVkFormat(grafVertexElement.Format);
 				vkVertexAttribute.offset = (ur_uint32)grafVertexElement.Offset;
 			}
@@ -18,6 +18,21 @@
 // temp
 #include "Graf/Vulkan/GrafSystemVulkan.h"
 
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define UR_ISOSURFACE_SSE
+#include <emmintrin.h>
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#if !defined(_WINDOWS)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 namespace UnlimRealms
 {
 
@@ -32,6 +47,54 @@ namespace UnlimRealms
 		LightType_Directional,	// Type
 	};
 
+	static inline ur_float3 ToFloat3(const ur_uint3 &v)
+	{
+		return ur_float3(ur_float(v.x), ur_float(v.y), ur_float(v.z));
+	}
+
+	static inline ur_uint FirstBitIdx(const ur_uint32 mask)
+	{
+	#if defined(_MSC_VER)
+		unsigned long idx;
+		_BitScanForward(&idx, mask);
+		return (ur_uint)idx;
+	#else
+		return (ur_uint)__builtin_ctz(mask);
+	#endif
+	}
+
+	static inline ur_uint LastBitIdx(const ur_uint64 mask)
+	{
+	#if defined(_MSC_VER)
+		unsigned long idx;
+		_BitScanReverse64(&idx, mask);
+		return (ur_uint)idx;
+	#else
+		return (ur_uint)(63 - __builtin_clzll(mask));
+	#endif
+	}
+
+	static inline ur_uint BitCount(ur_uint32 mask)
+	{
+		mask = mask - ((mask >> 1) & 0x55555555);
+		mask = (mask & 0x33333333) + ((mask >> 2) & 0x33333333);
+		return (((mask + (mask >> 4)) & 0x0f0f0f0f) * 0x01010101) >> 24;
+	}
+
+	// signed distances of shapes centered at the origin, positive inside; shared by brushes and CSG primitives
+
+	static inline ur_float SphereDistance(const ur_float3 &point, const ur_float radius)
+	{
+		return radius - point.Length();
+	}
+
+	static inline ur_float BoxDistance(const ur_float3 &point, const ur_float3 &halfSize)
+	{
+		ur_float3 q(std::fabs(point.x) - halfSize.x, std::fabs(point.y) - halfSize.y, std::fabs(point.z) - halfSize.z);
+		ur_float3 qo(std::max(q.x, 0.0f), std::max(q.y, 0.0f), std::max(q.z, 0.0f));
+		return -(qo.Length() + std::min(std::max(std::max(q.x, q.y), q.z), 0.0f));
+	}
+
 	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 	// Isosurface::AdaptiveVolume
 	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -308,179 +371,66 @@ namespace UnlimRealms
 		return Result(NotImplemented);
 	}
 
-	Result Isosurface::DataVolume::Save(const std::string &fileName)
+	Result Isosurface::DataVolume::ReadLattice(ValueType *values, const ur_float3 *points, const ur_uint count, const BoundingBox &bbox, const ur_float cellSize)
 	{
-		return Result(NotImplemented);
+		// single level volumes do not depend on the sampling interval
+		return this->Read(values, points, count, bbox);
 	}
 
-	Result Isosurface::DataVolume::Save(const std::string &fileName, ur_float cellSize, ur_uint3 blockResolution)
+	Result Isosurface::DataVolume::Write(const EditBrush &brush)
 	{
 		return Result(NotImplemented);
 	}
 
-	
-	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-	// Isosurface::ProceduralGenerator
-	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-
-	Isosurface::ProceduralGenerator::ProceduralGenerator(Isosurface &isosurface, const Algorithm &algorithm, const GenerateParams &generateParams) :
-		DataVolume(isosurface)
+	Result Isosurface::DataVolume::FetchDirtyRegions(std::vector<BoundingBox> &regions)
 	{
-		this->bound = generateParams.bound;
-		this->algorithm = algorithm;
-		switch (this->algorithm)
-		{
-		case Algorithm::SphericalDistanceField: this->generateParams.reset(new SphericalDistanceFieldParams((const SphericalDistanceFieldParams&)generateParams)); break;
-		case Algorithm::SimplexNoise: this->generateParams.reset(new SimplexNoiseParams((const SimplexNoiseParams&)generateParams)); break;
-		}
+		return Result(NotImplemented);
 	}
 
-	Isosurface::ProceduralGenerator::~ProceduralGenerator()
+	Result Isosurface::DataVolume::Prefetch(const BoundingBox &bbox)
 	{
-
+		return Result(NotImplemented);
 	}
 
-	Result Isosurface::ProceduralGenerator::Read(ValueType *values, const ur_float3 *points, const ur_uint count, const BoundingBox &bbox)
+	ur_uint64 Isosurface::DataVolume::GetContentHash() const
 	{
-		// todo: implement optimized sampling
-		// do early exit (return NotFound result) if we it is obious that isosurface does not intersect bbox
-
-		Result res = Result(Success);
-
-		// choose algorithm and generate a value
-		switch (this->algorithm)
-		{
-		case Algorithm::SphericalDistanceField:
-		{
-			res = this->GenerateSphericalDistanceField(values, points, count, bbox);
-		} break;
-		case Algorithm::SimplexNoise:
-		{
-			res = this->GenerateSimplexNoise(values, points, count, bbox);
-		} break;
-		default:
-		{
-			res = Result(NotImplemented);
-		}
-		}
-
-		return res;
+		return 0;
 	}
 
-	Result Isosurface::ProceduralGenerator::GenerateSphericalDistanceField(ValueType *values, const ur_float3 *points, const ur_uint count, const BoundingBox &bbox)
+	ur_bool Isosurface::DataVolume::HasLevels() const
 	{
-		const SphericalDistanceFieldParams &params = static_cast<const SphericalDistanceFieldParams&>(*this->generateParams.get());
-		ur_float radius = params.radius;
-		ur_float brad = (bbox.Max - bbox.Min).Length() * 0.5f;
-		ur_float dist = (bbox.Center() - params.center).Length();
-		if (dist + brad < radius ||
-			dist - brad > radius)
-			return Result(NotFound); // does not intersect isosurface
-
-		if (ur_null == values || ur_null == points || 0 == count)
-			return Result(InvalidArgs);
-
-		ValueType *p_value = values;
-		const ur_float3 *p_point = points;
-		for (ur_uint i = 0; i < count; ++i, ++p_value, ++p_point)
-		{
-			*p_value = params.radius - (*p_point - params.center).Length();
-		}
-
-		return Result(Success);
+		return false;
 	}
 
-	#define CAVE_TEST 1
-	Result Isosurface::ProceduralGenerator::GenerateSimplexNoise(ValueType *values, const ur_float3 *points, const ur_uint count, const BoundingBox &bbox)
+	Result Isosurface::DataVolume::Save(const std::string &fileName)
 	{
-		const SimplexNoiseParams &params = static_cast<const SimplexNoiseParams&>(*this->generateParams.get());
-		ur_float3 center = params.bound.Center();
-		ur_float brad = (bbox.Max - bbox.Min).Length() * 0.5f;
-		ur_float dist = (bbox.Center() - center).Length();
-		#if (!CAVE_TEST)
-		if (dist + brad < params.radiusMin ||
-			dist - brad > params.radiusMax)
-			return Result(NotFound); // does not intersect isosurface
-		#endif
-
-		if (ur_null == values || ur_null == points || 0 == count)
-			return Result(InvalidArgs);
-
-		// temp
-		#if (CAVE_TEST)
-		std::vector<SimplexNoiseParams::Octave> cave_octaves = {
-			{ 0.800f, 6.0f, -1.0f, 1.0f },
-			{ 0.400f, 16.0f, -0.5f, 0.1f },
-			{ 0.10f, 64.0f, -1.0f, 0.2f },
-		};
-		#endif
-
-		SimplexNoise noise;
-		ur_float radius = (params.radiusMax + params.radiusMin) * 0.5f;
-		ur_float distMax = params.radiusMax - radius;
-		ValueType *p_value = values;
-		const ur_float3 *p_point = points;
-		for (ur_uint i = 0; i < count; ++i, ++p_value, ++p_point)
-		{
-			*p_value = radius - (*p_point - center).Length();
-			for (auto &octave : params.octaves)
-			{
-				ur_float val = (ur_float)noise.Noise(
-					ur_double(p_point->x / radius * octave.freq),
-					ur_double(p_point->y / radius * octave.freq),
-					ur_double(p_point->z / radius * octave.freq));
-				val *= 2.0f;
-				val = std::max(octave.clamp_min, val);
-				val = std::min(octave.clamp_max, val);
-				val *= octave.scale * distMax;
-				*p_value += val;
-			}
-			
-			#if (CAVE_TEST)
-			// test: caves
-			ur_float cave_value = 0.0f;
-			for (auto &octave : cave_octaves)
-			{
-				ur_float val = (ur_float)noise.Noise(
-					ur_double(p_point->x / radius * octave.freq),
-					ur_double(p_point->y / radius * octave.freq),
-					ur_double(p_point->z / radius * octave.freq));
-				val *= 2.0f;
-				//val = (0.07f - fabs(val));
-				//val = val + 0.2f;
-				val = std::max(octave.clamp_min, val);
-				val = std::min(octave.clamp_max, val);
-				val *= octave.scale * distMax;
-				cave_value += val;
-			}
-			//cave_value *= -1.0f;
-			ur_float d = std::max(0.0f, params.radiusMin - (*p_point - center).Length());
-			cave_value += d;
-			*p_value = std::min(*p_value, cave_value);
-			#endif
-		}
-
-		return Result(Success);
+		static const ur_float DefaultVolumeResolution = 1024.0f;
+		static const ur_uint3 DefaultBlockResolution = ur_uint3(16);
+		return this->Save(fileName, this->GetBound().SizeMax() / DefaultVolumeResolution, DefaultBlockResolution);
 	}
 
-	Result Isosurface::ProceduralGenerator::Save(const std::string &fileName, ur_float cellSize, ur_uint3 blockResolution)
+	Result Isosurface::DataVolume::Save(const std::string &fileName, ur_float cellSize, ur_uint3 blockResolution)
 	{
+		Log &log = this->isosurface.GetRealm().GetLog();
+		BoundingBox bound = this->GetBound();
+		if (cellSize <= 0.0f || bound.IsInsideOut() ||
+			0 == blockResolution.x || 0 == blockResolution.y || 0 == blockResolution.z)
+			return LogResult(InvalidArgs, log, Log::Error, "Isosurface::DataVolume::Save: invalid arguments");
+
 		auto &storage = this->isosurface.GetRealm().GetStorage();
 		std::unique_ptr<File> file;
-		Result res = storage.Open(file, fileName, ur_uint(StorageAccess::Binary) | ur_uint(StorageAccess::Append));
+		Result res = storage.Open(file, fileName, ur_uint(StorageAccess::Binary) | ur_uint(StorageAccess::Write));
 		if (Failed(res))
-			return LogResult(Failure, isosurface.GetRealm().GetLog(), Log::Error,
-				"Isosurface::ProceduralGenerator::Save: failed to open " + fileName);
+			return LogResult(Failure, log, Log::Error, "Isosurface::DataVolume::Save: failed to open " + fileName);
+
+		// compute volume layout
 
-		// todo: generate and save to file: from coarse level to most refined, block by block
-		
-		BoundingBox bound = this->GetBound();
 		ur_float3 boundSize = bound.Max - bound.Min;
 
 		ur_uint3 volumeResolution(
-			(ur_uint)ceil(boundSize.x / cellSize),
-			(ur_uint)ceil(boundSize.y / cellSize),
-			(ur_uint)ceil(boundSize.z / cellSize));
+			std::max((ur_uint)ceil(boundSize.x / cellSize), ur_uint(1)),
+			std::max((ur_uint)ceil(boundSize.y / cellSize), ur_uint(1)),
+			std::max((ur_uint)ceil(boundSize.z / cellSize), ur_uint(1)));
 
 		ur_float3 volumeCellSize(
 			boundSize.x / volumeResolution.x,
@@ -492,978 +442,2165 @@ namespace UnlimRealms
 			(ur_uint)ceil(ur_float(volumeResolution.y) / blockResolution.y),
 			(ur_uint)ceil(ur_float(volumeResolution.z) / blockResolution.z));
 
-		ur_uint levels = (ur_uint)floor(log2(blocksCount.GetMaxValue()) + 1);
+		ur_uint levelsCount = (ur_uint)floor(log2(blocksCount.GetMaxValue()) + 1);
+
+		FileHeader header = {};
+		header.magic = FileMagic;
+		header.version = FileVersion;
+		header.boundMin = bound.Min;
+		header.boundMax = bound.Max;
+		header.blockResolution = blockResolution;
+		header.blockBorder = FileBlockBorder;
+		header.levelsCount = levelsCount;
+		header.blocksCount = 0;
+		header.indexOffset = 0;
+
+		// levels from the coarsest to the most detailed one
+		std::vector<FileLevel> levels(levelsCount);
+		for (ur_uint il = 0; il < levelsCount; ++il)
+		{
+			ur_uint scale = (1 << (levelsCount - il - 1));
+			FileLevel &level = levels[il];
+			level.cellSize = volumeCellSize * ur_float(scale);
+			level.blocksCount.x = std::max((ur_uint)ceil(ur_float(volumeResolution.x) / scale / blockResolution.x), ur_uint(1));
+			level.blocksCount.y = std::max((ur_uint)ceil(ur_float(volumeResolution.y) / scale / blockResolution.y), ur_uint(1));
+			level.blocksCount.z = std::max((ur_uint)ceil(ur_float(volumeResolution.z) / scale / blockResolution.z), ur_uint(1));
+			level.firstBlock = header.blocksCount;
+			header.blocksCount += level.blocksCount.x * level.blocksCount.y * level.blocksCount.z;
+		}
 
+		// write header placeholder and levels table
 
-		return res;
-	}
+		res &= file->Write(sizeof(FileHeader), (const ur_byte*)&header);
+		res &= file->Write(sizeof(FileLevel) * levels.size(), (const ur_byte*)levels.data());
+		if (Failed(res))
+			return LogResult(Failure, log, Log::Error, "Isosurface::DataVolume::Save: failed to write " + fileName);
+		ur_uint64 fileOffset = sizeof(FileHeader) + sizeof(FileLevel) * levels.size();
 
+		// generate blocks in parallel, batch by batch, and write them sequentially in the index order
 
-	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-	// Isosurface::Presentation
-	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		struct BlockJobData
+		{
+			DataVolume *volume;
+			BoundingBox volumeBound;
+			ur_float3 origin;
+			ur_float3 cellSize;
+			ur_uint3 blockSize;
+			FileBlock block;
+			std::vector<ValueType> samples;
+		};
 
-	Isosurface::Presentation::Presentation(Isosurface &isosurface) :
-		SubSystem(isosurface)
-	{
+		auto &jobSystem = this->isosurface.GetRealm().GetJobSystem();
+		static const ur_uint BatchSize = 64;
+		std::vector<BlockJobData> batchData(BatchSize);
+		std::vector<std::shared_ptr<Job>> batchJobs(BatchSize);
+		std::vector<FileBlock> blocks(header.blocksCount);
+		const ur_uint3 blockSize = GetFileBlockSize(header);
+		for (ur_uint il = 0; il < levelsCount && Succeeded(res); ++il)
+		{
+			const FileLevel &level = levels[il];
+			const ur_uint levelBlocksCount = level.blocksCount.x * level.blocksCount.y * level.blocksCount.z;
+			for (ur_uint batchFirst = 0; batchFirst < levelBlocksCount && Succeeded(res); batchFirst += BatchSize)
+			{
+				ur_uint batchCount = std::min(BatchSize, levelBlocksCount - batchFirst);
+				for (ur_uint ib = 0; ib < batchCount; ++ib)
+				{
+					ur_uint blockIdx = batchFirst + ib;
+					ur_uint3 blockPos(
+						blockIdx % level.blocksCount.x,
+						(blockIdx / level.blocksCount.x) % level.blocksCount.y,
+						blockIdx / (level.blocksCount.x * level.blocksCount.y));
+					BlockJobData &jobData = batchData[ib];
+					jobData.volume = this;
+					jobData.volumeBound = bound;
+					jobData.cellSize = level.cellSize;
+					jobData.blockSize = blockSize;
+					jobData.origin = bound.Min + (ToFloat3(blockPos * blockResolution) - ur_float(FileBlockBorder)) * level.cellSize;
+					batchJobs[ib] = jobSystem.Add(Job::DataPtr(&jobData), [](Job::Context& ctx) -> void {
+
+						BlockJobData *jobData = reinterpret_cast<BlockJobData*>(ctx.data);
+						const ur_uint3 &blockSize = jobData->blockSize;
+						const ur_uint samplesCount = blockSize.x * blockSize.y * blockSize.z;
+						FileBlock &block = jobData->block;
+						block.offset = 0;
+						block.flags = 0;
+						block.constValue = 0;
+						jobData->samples.clear();
+
+						BoundingBox bbox(jobData->origin, jobData->origin + ToFloat3(blockSize - 1) * jobData->cellSize);
+						const ur_float cellSizeMax = std::max(std::max(jobData->cellSize.x, jobData->cellSize.y), jobData->cellSize.z);
+						if (jobData->volume->ReadLattice(ur_null, ur_null, 0, bbox, cellSizeMax) == NotFound)
+						{
+							// does not intersect isosurface: evaluate single value to keep the sign of the tile
+							ur_float3 center = bbox.Center();
+							block.flags |= FileBlockConstant;
+							jobData->volume->Read(&block.constValue, &center, 1, jobData->volumeBound);
+							ctx.resultCode = Success;
+							return;
+						}
 
-	}
+						std::vector<ur_float3> points(samplesCount);
+						ur_float3 *p_point = points.data();
+						for (ur_uint iz = 0; iz < blockSize.z; ++iz)
+						{
+							for (ur_uint iy = 0; iy < blockSize.y; ++iy)
+							{
+								for (ur_uint ix = 0; ix < blockSize.x; ++ix, ++p_point)
+								{
+									*p_point = jobData->origin + ur_float3(ur_float(ix), ur_float(iy), ur_float(iz)) * jobData->cellSize;
+								}
+							}
+						}
+						jobData->samples.resize(samplesCount);
+						Result res = jobData->volume->ReadLattice(jobData->samples.data(), points.data(), samplesCount, bbox, cellSizeMax);
+						if (Failed(res))
+						{
+							ctx.resultCode = res.Code;
+							return;
+						}
 
-	Isosurface::Presentation::~Presentation()
-	{
+						// samples far enough from the surface are stored as a constant tile
+						ValueType valueMin = jobData->samples[0];
+						ur_bool constant = true;
+						for (const ValueType &value : jobData->samples)
+						{
+							constant = constant && (value > 0) == (valueMin > 0) && std::fabs(value) > cellSizeMax;
+							if (std::fabs(value) < std::fabs(valueMin)) valueMin = value;
+						}
+						if (constant)
+						{
+							block.flags |= FileBlockConstant;
+							block.constValue = valueMin;
+							jobData->samples.clear();
+						}
+
+						ctx.resultCode = Success;
+					});
+				}
+				for (ur_uint ib = 0; ib < batchCount; ++ib)
+				{
+					batchJobs[ib]->Wait();
+					BlockJobData &jobData = batchData[ib];
+					FileBlock &block = blocks[level.firstBlock + batchFirst + ib];
+					block = jobData.block;
+					if (!batchJobs[ib]->FinishedSuccessfully())
+					{
+						res = Result(Failure);
+						continue;
+					}
+					if (!jobData.samples.empty())
+					{
+						block.offset = fileOffset;
+						ur_size samplesSize = jobData.samples.size() * sizeof(ValueType);
+						res &= file->Write(samplesSize, (const ur_byte*)jobData.samples.data());
+						fileOffset += samplesSize;
+					}
+				}
+			}
+		}
+		if (Failed(res))
+			return LogResult(Failure, log, Log::Error, "Isosurface::DataVolume::Save: failed to generate " + fileName);
+
+		// write blocks index and finalize header
+		// index is padded to its alignment to be accessed in place by MappedVolume
+
+		const ur_uint64 indexPadding = (alignof(FileBlock) - fileOffset % alignof(FileBlock)) % alignof(FileBlock);
+		if (indexPadding > 0)
+		{
+			const ur_byte padding[alignof(FileBlock)] = {};
+			res &= file->Write((ur_size)indexPadding, padding);
+			fileOffset += indexPadding;
+		}
+		header.indexOffset = fileOffset;
+		res &= file->Write(sizeof(FileBlock) * blocks.size(), (const ur_byte*)blocks.data());
+		res &= file->Seek(0);
+		res &= file->Write(sizeof(FileHeader), (const ur_byte*)&header);
+		if (Failed(res))
+			return LogResult(Failure, log, Log::Error, "Isosurface::DataVolume::Save: failed to write " + fileName);
 
+		return res;
 	}
 
-	Result Isosurface::Presentation::Update(const ur_float3 &refinementPoint, const ur_float4x4 &viewProj)
+	ur_float Isosurface::DataVolume::EstimateSpacing(const BoundingBox &bbox, const ur_uint count)
 	{
-		return Result(NotImplemented);
+		return (count > 1 ? bbox.SizeMax() / std::max(std::cbrt(ur_float(count)) - 1.0f, 1.0f) : 0.0f);
 	}
 
-	Result Isosurface::Presentation::Render(GfxContext &gfxContext, const ur_float4x4 &viewProj)
+	ur_uint Isosurface::DataVolume::SelectFileLevel(const FileHeader &header, const FileLevel *levels, const ur_float spacing)
 	{
-		return Result(NotImplemented);
+		// choose the coarsest level fine enough to represent the sampling interval
+		for (ur_uint il = 0; il < header.levelsCount; ++il)
+		{
+			const ur_float3 &cellSize = levels[il].cellSize;
+			if (std::max(std::max(cellSize.x, cellSize.y), cellSize.z) <= spacing)
+				return il;
+		}
+		return (header.levelsCount > 0 ? header.levelsCount - 1 : 0);
 	}
 
-	Result Isosurface::Presentation::Render(GrafCommandList &grafCmdList, const ur_float4x4 &viewProj)
+	ur_uint3 Isosurface::DataVolume::GetFileBlockPos(const FileHeader &header, const FileLevel &level, const ur_float3 &point)
 	{
-		return Result(NotImplemented);
+		ur_float3 blockExtent = level.cellSize * ToFloat3(header.blockResolution);
+		ur_float3 bp = (point - header.boundMin) / blockExtent;
+		return ur_uint3(
+			(ur_uint)std::min(std::max(bp.x, 0.0f), ur_float(level.blocksCount.x - 1)),
+			(ur_uint)std::min(std::max(bp.y, 0.0f), ur_float(level.blocksCount.y - 1)),
+			(ur_uint)std::min(std::max(bp.z, 0.0f), ur_float(level.blocksCount.z - 1)));
 	}
 
-	void Isosurface::Presentation::DisplayImgui()
+	Result Isosurface::DataVolume::TestFileBlocks(const FileHeader &header, const FileLevel &level, const FileBlock *blocks, const BoundingBox &bbox)
 	{
-
+		// isosurface does not intersect bbox if all overlapped blocks are constant tiles of the same sign
+		ur_uint3 bpMin = GetFileBlockPos(header, level, bbox.Min);
+		ur_uint3 bpMax = GetFileBlockPos(header, level, bbox.Max);
+		ur_int sign = 0;
+		for (ur_uint iz = bpMin.z; iz <= bpMax.z; ++iz)
+		{
+			for (ur_uint iy = bpMin.y; iy <= bpMax.y; ++iy)
+			{
+				for (ur_uint ix = bpMin.x; ix <= bpMax.x; ++ix)
+				{
+					const FileBlock &block = blocks[GetFileBlockId(level, ur_uint3(ix, iy, iz))];
+					ur_int blockSign = (block.constValue > 0 ? 1 : -1);
+					if (!(block.flags & FileBlockConstant) || (sign != 0 && sign != blockSign))
+						return Result(Success);
+					sign = blockSign;
+				}
+			}
+		}
+		return Result(NotFound);
 	}
 
+	Isosurface::DataVolume::ValueType Isosurface::DataVolume::SampleFileBlock(const ValueType *samples, const ur_uint3 &blockSize, const ur_float3 &pos)
+	{
+		// trilinear interpolation, pos is given in samples space including border
+		ur_float3 p(
+			std::min(std::max(pos.x, 0.0f), ur_float(blockSize.x - 1)),
+			std::min(std::max(pos.y, 0.0f), ur_float(blockSize.y - 1)),
+			std::min(std::max(pos.z, 0.0f), ur_float(blockSize.z - 1)));
+		ur_uint3 i0(
+			std::min((ur_uint)p.x, blockSize.x - 2),
+			std::min((ur_uint)p.y, blockSize.y - 2),
+			std::min((ur_uint)p.z, blockSize.z - 2));
+		ur_float3 t(p.x - i0.x, p.y - i0.y, p.z - i0.z);
+		const ur_uint rowOfs = blockSize.x;
+		const ur_uint sliceOfs = blockSize.x * blockSize.y;
+		const ValueType *s = samples + i0.x + i0.y * rowOfs + i0.z * sliceOfs;
+		ValueType v00 = lerp(s[0], s[1], t.x);
+		ValueType v10 = lerp(s[rowOfs], s[rowOfs + 1], t.x);
+		ValueType v01 = lerp(s[sliceOfs], s[sliceOfs + 1], t.x);
+		ValueType v11 = lerp(s[sliceOfs + rowOfs], s[sliceOfs + rowOfs + 1], t.x);
+		return lerp(lerp(v00, v10, t.y), lerp(v01, v11, t.y), t.z);
+	}
 
+	
 	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-	// Isosurface::HybridCubes
+	// Isosurface::SparseVolume
 	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-	const Isosurface::HybridCubes::Edge Isosurface::HybridCubes::Tetrahedron::Edges[EdgesCount] = {
-		{ 0, 1 }, { 1, 2 }, { 2, 0 }, { 0, 3 }, { 1, 3 }, { 2, 3 }
-	};
+	template <class TChild, ur_uint TLog2Dim>
+	Isosurface::SparseVolume::InternalNode<TChild, TLog2Dim>::InternalNode(const ValueType tileValue)
+	{
+		memset(this->childMask, 0, sizeof(this->childMask));
+		std::fill(this->tiles, this->tiles + ChildrenCount, tileValue);
+	}
 
-	const ur_byte Isosurface::HybridCubes::Tetrahedron::EdgeOppositeId[EdgesCount] = {
-		5, 3, 4, 1, 2, 0
-	};
+	template <class TChild, ur_uint TLog2Dim>
+	void Isosurface::SparseVolume::InternalNode<TChild, TLog2Dim>::SetChild(const ur_uint idx, std::unique_ptr<TChild> child)
+	{
+		if (child != ur_null)
+			this->childMask[idx >> 6] |= (ur_uint64(1) << (idx & 63));
+		else
+			this->childMask[idx >> 6] &= ~(ur_uint64(1) << (idx & 63));
+		this->children[idx] = std::move(child);
+	}
 
-	const Isosurface::HybridCubes::Face Isosurface::HybridCubes::Tetrahedron::Faces[FacesCount] = {
-		{ { 0, 1, 2 }, { 0, 1, 2 } },
-		{ { 0, 3, 1 }, { 0, 3, 4 } },
-		{ { 1, 3, 2 }, { 1, 4, 5 } },
-		{ { 2, 3, 0 }, { 2, 5, 3 } }
-	};
+	Isosurface::SparseVolume::Accessor::Accessor(const SparseVolume &volume) :
+		volume(volume)
+	{
+		this->cachedOrigin = ur_int3(0);
+		this->cachedSize = 0;
+		this->cachedLeaf = ur_null;
+		this->cachedValue = 0;
+	}
 
-	const Isosurface::HybridCubes::Tetrahedron::SplitInfo Isosurface::HybridCubes::Tetrahedron::EdgeSplitInfo[EdgesCount] = {
-		{ { { 0, 0xff, 2, 3 }, { 0xff, 1, 2, 3 } } },
-		{ { { 0, 1, 0xff, 3 }, { 0, 0xff, 2, 3 } } },
-		{ { { 0, 1, 0xff, 3 }, { 0xff, 1, 2, 3 } } },
-		{ { { 0, 1, 2, 0xff }, { 0xff, 1, 2, 3 } } },
-		{ { { 0, 1, 2, 0xff }, { 0, 0xff, 2, 3 } } },
-		{ { { 0, 1, 2, 0xff }, { 0, 1, 0xff, 3 } } }
-	};
-
-	#if defined(UR_GRAF)
-	Isosurface::HybridCubes::GrafMesh::GrafMesh()
+	Isosurface::SparseVolume::ValueType Isosurface::SparseVolume::Accessor::GetValue(const ur_int3 &voxel)
 	{
-	}
-
-	Isosurface::HybridCubes::GrafMesh::~GrafMesh()
-	{	
-		// safely delete GRAF objects
-		if (this->VB != ur_null)
+		// cached leaf or tile region
+		if (voxel.x >= this->cachedOrigin.x && voxel.x < this->cachedOrigin.x + this->cachedSize &&
+			voxel.y >= this->cachedOrigin.y && voxel.y < this->cachedOrigin.y + this->cachedSize &&
+			voxel.z >= this->cachedOrigin.z && voxel.z < this->cachedOrigin.z + this->cachedSize)
 		{
-			GrafRenderer* grafRenderer = this->VB->GetRealm().GetComponent<GrafRenderer>();
-			grafRenderer->SafeDelete(this->VB.release());
+			if (ur_null == this->cachedLeaf)
+				return this->cachedValue;
+			return this->cachedLeaf->GetValue((voxel.x & (Leaf::Dim - 1)) |
+				((voxel.y & (Leaf::Dim - 1)) << Leaf::Log2Dim) |
+				((voxel.z & (Leaf::Dim - 1)) << (Leaf::Log2Dim * 2)));
 		}
-		if (this->IB != ur_null)
-		{
-			GrafRenderer* grafRenderer = this->IB->GetRealm().GetComponent<GrafRenderer>();
-			grafRenderer->SafeDelete(this->IB.release());
-		}	
+
+		// traverse the tree and cache the region containing voxel
+		auto cacheRegion = [&](ur_uint log2Size, const Leaf *leaf, ValueType value) -> ValueType {
+			ur_int mask = ~((1 << log2Size) - 1);
+			this->cachedOrigin = ur_int3(voxel.x & mask, voxel.y & mask, voxel.z & mask);
+			this->cachedSize = (1 << log2Size);
+			this->cachedLeaf = leaf;
+			this->cachedValue = value;
+			return this->GetValue(voxel);
+		};
+		auto it = this->volume.root.find(RootKey(voxel));
+		if (it == this->volume.root.end())
+			return cacheRegion(UpperNode::TotalLog2Dim, ur_null, this->volume.desc.NarrowBand);
+		const UpperNode &upper = *it->second;
+		ur_uint upperIdx = UpperNode::ChildIndex(voxel);
+		if (!upper.HasChild(upperIdx))
+			return cacheRegion(LowerNode::TotalLog2Dim, ur_null, upper.tiles[upperIdx]);
+		const LowerNode &lower = *upper.children[upperIdx];
+		ur_uint lowerIdx = LowerNode::ChildIndex(voxel);
+		if (!lower.HasChild(lowerIdx))
+			return cacheRegion(Leaf::TotalLog2Dim, ur_null, lower.tiles[lowerIdx]);
+		return cacheRegion(Leaf::TotalLog2Dim, lower.children[lowerIdx].get(), 0);
 	}
-	#endif
 
-	Isosurface::HybridCubes::Tetrahedron::Tetrahedron()
+	Isosurface::SparseVolume::SparseVolume(Isosurface &isosurface) :
+		DataVolume(isosurface)
 	{
-		this->initialized = false;
-		this->visible = true;
-		this->level = 0;
-		this->longestEdgeIdx = 0;
+		memset(&this->desc, 0, sizeof(this->desc));
+		memset(&this->stats, 0, sizeof(this->stats));
+		this->voxelsCount = ur_int3(0);
 	}
 
-	Isosurface::HybridCubes::Tetrahedron::~Tetrahedron()
+	Isosurface::SparseVolume::~SparseVolume()
 	{
+
 	}
 
-	void Isosurface::HybridCubes::Tetrahedron::Init(const Vertex &v0, const Vertex &v1, const Vertex &v2, const Vertex &v3)
+	BoundingBox Isosurface::SparseVolume::GetVoxelsBound(const ur_int3 &origin, const ur_int size) const
 	{
-		this->vertices[0] = v0;
-		this->vertices[1] = v1;
-		this->vertices[2] = v2;
-		this->vertices[3] = v3;
+		// voxels range including the next voxel used by trilinear sampling, expanded by narrow band
+		ur_float3 band(this->desc.NarrowBand);
+		return BoundingBox(
+			this->bound.Min + ur_float3(ur_float(origin.x), ur_float(origin.y), ur_float(origin.z)) * this->desc.VoxelSize - band,
+			this->bound.Min + ur_float3(ur_float(origin.x + size), ur_float(origin.y + size), ur_float(origin.z + size)) * this->desc.VoxelSize + band);
+	}
 
-		// compute the longest edge
-		
-		float maxLen = 0.0f;
-		for (ur_byte eidx = 0; eidx < EdgesCount; ++eidx)
+	Isosurface::SparseVolume::ValueType Isosurface::SparseVolume::ComputeTileValue(DataVolume &source, const BoundingBox &bbox) const
+	{
+		// region does not intersect isosurface: evaluate single value to keep the sign of the tile
+		ur_float3 center = bbox.Center();
+		ValueType value = 0;
+		source.Read(&value, &center, 1, source.GetBound());
+		return (value > 0 ? this->desc.NarrowBand : -this->desc.NarrowBand);
+	}
+
+	Result Isosurface::SparseVolume::BuildLowerNode(DataVolume &source, const ur_int3 &origin, std::unique_ptr<LowerNode> &node, ValueType &tileValue) const
+	{
+		const ValueType band = this->desc.NarrowBand;
+		const ur_uint bytesPerValue = this->desc.QuantizationBits / 8;
+		const ValueType quantMax = ValueType((1 << this->desc.QuantizationBits) - 1);
+		std::vector<ur_float3> points(Leaf::ValuesCount);
+		std::vector<ValueType> values(Leaf::ValuesCount);
+		node.reset(new LowerNode(band));
+		ur_uint leavesCount = 0;
+		for (ur_uint idx = 0; idx < LowerNode::ChildrenCount; ++idx)
 		{
-			const Edge &e = Edges[eidx];
-			float len = (this->vertices[e.vid[0]] - this->vertices[e.vid[1]]).Length();
-			if (len > maxLen)
+			ur_int3 leafOrigin(
+				origin.x + ur_int((idx & (LowerNode::Dim - 1)) << Leaf::Log2Dim),
+				origin.y + ur_int(((idx >> LowerNode::Log2Dim) & (LowerNode::Dim - 1)) << Leaf::Log2Dim),
+				origin.z + ur_int(((idx >> (LowerNode::Log2Dim * 2)) & (LowerNode::Dim - 1)) << Leaf::Log2Dim));
+			if (leafOrigin.x >= this->voxelsCount.x || leafOrigin.y >= this->voxelsCount.y || leafOrigin.z >= this->voxelsCount.z)
+				continue; // outside of the volume, never sampled
+
+			BoundingBox leafBBox = this->GetVoxelsBound(leafOrigin, Leaf::Dim);
+			if (source.ReadLattice(ur_null, ur_null, 0, leafBBox, this->desc.VoxelSize) == NotFound)
 			{
-				maxLen = len;
-				this->longestEdgeIdx = eidx;
+				node->tiles[idx] = this->ComputeTileValue(source, leafBBox);
+				continue;
+			}
+
+			// sample leaf voxels
+			ur_float3 *p_point = points.data();
+			for (ur_uint iz = 0; iz < Leaf::Dim; ++iz)
+			{
+				for (ur_uint iy = 0; iy < Leaf::Dim; ++iy)
+				{
+					for (ur_uint ix = 0; ix < Leaf::Dim; ++ix, ++p_point)
+					{
+						*p_point = this->bound.Min + ur_float3(
+							ur_float(leafOrigin.x + ix), ur_float(leafOrigin.y + iy), ur_float(leafOrigin.z + iz)) * this->desc.VoxelSize;
+					}
+				}
+			}
+			Result res = source.ReadLattice(values.data(), points.data(), Leaf::ValuesCount, leafBBox, this->desc.VoxelSize);
+			if (Failed(res))
+				return res;
+
+			// clamp to narrow band; leaves entirely outside of the band become tiles
+			ValueType valueMin = band;
+			ValueType valueMax = -band;
+			for (auto &value : values)
+			{
+				value = std::min(std::max(value, -band), band);
+				valueMin = std::min(valueMin, value);
+				valueMax = std::max(valueMax, value);
+			}
+			if (valueMin >= band || valueMax <= -band)
+			{
+				node->tiles[idx] = valueMin;
+				continue;
+			}
+
+			// quantize
+			std::unique_ptr<Leaf> leaf(new Leaf());
+			leaf->offset = valueMin;
+			leaf->scale = (valueMax - valueMin) / quantMax;
+			leaf->bytesPerValue = bytesPerValue;
+			leaf->data.reset(new ur_byte[Leaf::ValuesCount * bytesPerValue]);
+			ValueType quantScale = (leaf->scale > 0 ? 1.0f / leaf->scale : 0.0f);
+			for (ur_uint iv = 0; iv < Leaf::ValuesCount; ++iv)
+			{
+				ur_uint q = (ur_uint)std::min((values[iv] - valueMin) * quantScale + 0.5f, quantMax);
+				if (2 == bytesPerValue)
+					((ur_uint16*)leaf->data.get())[iv] = (ur_uint16)q;
+				else
+					leaf->data[iv] = (ur_byte)q;
 			}
+			node->SetChild(idx, std::move(leaf));
+			++leavesCount;
 		}
 
-		// compute bbox
+		// node without leaves is kept only if its tiles differ
+		if (0 == leavesCount && std::all_of(node->tiles, node->tiles + LowerNode::ChildrenCount,
+			[&](const ValueType &v) { return (v == node->tiles[0]); }))
+		{
+			tileValue = node->tiles[0];
+			node.reset();
+		}
 
-		this->bbox = BoundingBox();
-		this->bbox.Min.SetMin(v0); this->bbox.Min.SetMin(v1); this->bbox.Min.SetMin(v2); this->bbox.Min.SetMin(v3);
-		this->bbox.Max.SetMax(v0); this->bbox.Max.SetMax(v1); this->bbox.Max.SetMax(v2); this->bbox.Max.SetMax(v3);
+		return Result(Success);
+	}
+
+	Result Isosurface::SparseVolume::Build(DataVolume &source, const Desc &desc)
+	{
+		Log &log = this->isosurface.GetRealm().GetLog();
+		const BoundingBox &sourceBound = source.GetBound();
+		if (desc.VoxelSize <= 0.0f || desc.NarrowBand <= 0.0f || sourceBound.IsInsideOut() ||
+			(desc.QuantizationBits != 8 && desc.QuantizationBits != 16))
+			return LogResult(InvalidArgs, log, Log::Error, "Isosurface::SparseVolume::Build: invalid arguments");
 
-		// init sub hexahedra
+		this->root.clear();
+		memset(&this->stats, 0, sizeof(this->stats));
+		this->desc = desc;
+		this->bound = sourceBound;
+		ur_float3 boundSize = this->bound.Max - this->bound.Min;
+		this->voxelsCount = ur_int3(
+			std::max((ur_int)ceil(boundSize.x / desc.VoxelSize) + 1, 2),
+			std::max((ur_int)ceil(boundSize.y / desc.VoxelSize) + 1, 2),
+			std::max((ur_int)ceil(boundSize.z / desc.VoxelSize) + 1, 2));
 
-		Vertex ve[EdgesCount];
-		for (ur_uint i = 0; i < EdgesCount; ++i)
+		// create upper nodes and gather lower nodes intersecting isosurface
+
+		struct LowerJobData
 		{
-			ve[i] = (this->vertices[Edges[i].vid[0]] + this->vertices[Edges[i].vid[1]]) / 2.0f;
-		}
-		Vertex vf[FacesCount];
-		for (ur_uint i = 0; i < FacesCount; ++i)
+			const SparseVolume *volume;
+			DataVolume *source;
+			ur_int3 origin;
+			UpperNode *upper;
+			ur_uint childIdx;
+			std::unique_ptr<LowerNode> node;
+			ValueType tileValue;
+		};
+		std::list<LowerJobData> lowerJobsData;
+
+		const ur_int upperSize = (1 << UpperNode::TotalLog2Dim);
+		const ur_int lowerSize = (1 << LowerNode::TotalLog2Dim);
+		for (ur_int uz = 0; uz < this->voxelsCount.z; uz += upperSize)
 		{
-			vf[i] = (this->vertices[Faces[i].vid[0]] + this->vertices[Faces[i].vid[1]] + this->vertices[Faces[i].vid[2]]) / 3.0f;
+			for (ur_int uy = 0; uy < this->voxelsCount.y; uy += upperSize)
+			{
+				for (ur_int ux = 0; ux < this->voxelsCount.x; ux += upperSize)
+				{
+					ur_int3 upperOrigin(ux, uy, uz);
+					BoundingBox upperBBox = this->GetVoxelsBound(upperOrigin, upperSize);
+					std::unique_ptr<UpperNode> upper(new UpperNode(this->desc.NarrowBand));
+					if (source.Read(ur_null, ur_null, 0, upperBBox) == NotFound)
+					{
+						std::fill(upper->tiles, upper->tiles + UpperNode::ChildrenCount, this->ComputeTileValue(source, upperBBox));
+					}
+					else
+					{
+						for (ur_uint idx = 0; idx < UpperNode::ChildrenCount; ++idx)
+						{
+							ur_int3 lowerOrigin(
+								ux + ur_int((idx & (UpperNode::Dim - 1)) * lowerSize),
+								uy + ur_int(((idx >> UpperNode::Log2Dim) & (UpperNode::Dim - 1)) * lowerSize),
+								uz + ur_int(((idx >> (UpperNode::Log2Dim * 2)) & (UpperNode::Dim - 1)) * lowerSize));
+							if (lowerOrigin.x >= this->voxelsCount.x || lowerOrigin.y >= this->voxelsCount.y || lowerOrigin.z >= this->voxelsCount.z)
+								continue;
+							BoundingBox lowerBBox = this->GetVoxelsBound(lowerOrigin, lowerSize);
+							if (source.Read(ur_null, ur_null, 0, lowerBBox) == NotFound)
+							{
+								upper->tiles[idx] = this->ComputeTileValue(source, lowerBBox);
+								continue;
+							}
+							lowerJobsData.push_back({ this, &source, lowerOrigin, upper.get(), idx, ur_null, 0 });
+						}
+					}
+					this->root[RootKey(upperOrigin)] = std::move(upper);
+				}
+			}
 		}
-		Vertex vc = (v0 + v1 + v2 + v3) / 4;
 
+		// build lower nodes in parallel
+
+		auto &jobSystem = this->isosurface.GetRealm().GetJobSystem();
+		std::list<std::shared_ptr<Job>> lowerJobs;
+		for (auto &jobData : lowerJobsData)
 		{
-			Hexahedron &h = this->hexahedra[0];
-			h.vertices[0] = v0;
-			h.vertices[1] = ve[2];
-			h.vertices[2] = ve[0];
-			h.vertices[3] = vf[0];
-			h.vertices[4] = ve[3];
-			h.vertices[5] = vf[3];
-			h.vertices[6] = vf[1];
-			h.vertices[7] = vc;
+			lowerJobs.push_back(jobSystem.Add(Job::DataPtr(&jobData), [](Job::Context& ctx) -> void {
+				LowerJobData *jobData = reinterpret_cast<LowerJobData*>(ctx.data);
+				Result res = jobData->volume->BuildLowerNode(*jobData->source, jobData->origin, jobData->node, jobData->tileValue);
+				ctx.resultCode = res.Code;
+			}));
 		}
+		Result res(Success);
+		auto jobIt = lowerJobs.begin();
+		for (auto &jobData : lowerJobsData)
 		{
-			Hexahedron &h = this->hexahedra[1];
-			h.vertices[0] = ve[2];
-			h.vertices[1] = v2;
-			h.vertices[2] = vf[0];
-			h.vertices[3] = ve[1];
-			h.vertices[4] = vf[3];
-			h.vertices[5] = ve[5];
-			h.vertices[6] = vc;
-			h.vertices[7] = vf[2];
+			auto &job = *jobIt++;
+			job->Wait();
+			if (!job->FinishedSuccessfully())
+			{
+				res = Result(Failure);
+				continue;
+			}
+			if (jobData.node != ur_null)
+			{
+				jobData.upper->SetChild(jobData.childIdx, std::move(jobData.node));
+			}
+			else
+			{
+				jobData.upper->tiles[jobData.childIdx] = jobData.tileValue;
+			}
 		}
+		if (Failed(res))
+			return LogResult(Failure, log, Log::Error, "Isosurface::SparseVolume::Build: failed to sample source volume");
+
+		// gather stats
+
+		this->stats.memoryUsed = sizeof(SparseVolume);
+		for (auto &entry : this->root)
 		{
-			Hexahedron &h = this->hexahedra[2];
-			h.vertices[0] = ve[0];
-			h.vertices[1] = vf[0];
-			h.vertices[2] = v1;
-			h.vertices[3] = ve[1];
-			h.vertices[4] = vf[1];
-			h.vertices[5] = vc;
-			h.vertices[6] = ve[4];
-			h.vertices[7] = vf[2];
+			const UpperNode &upper = *entry.second;
+			this->stats.upperNodesCount += 1;
+			this->stats.memoryUsed += sizeof(UpperNode);
+			for (ur_uint iu = 0; iu < UpperNode::ChildrenCount; ++iu)
+			{
+				if (!upper.HasChild(iu))
+				{
+					this->stats.tilesCount += 1;
+					continue;
+				}
+				const LowerNode &lower = *upper.children[iu];
+				this->stats.lowerNodesCount += 1;
+				this->stats.memoryUsed += sizeof(LowerNode);
+				for (ur_uint il = 0; il < LowerNode::ChildrenCount; ++il)
+				{
+					if (!lower.HasChild(il))
+					{
+						this->stats.tilesCount += 1;
+						continue;
+					}
+					this->stats.leavesCount += 1;
+					this->stats.memoryUsed += sizeof(Leaf) + Leaf::ValuesCount * lower.children[il]->bytesPerValue;
+				}
+			}
 		}
+
+		return Result(Success);
+	}
+
+	Result Isosurface::SparseVolume::TestIntersection(const BoundingBox &bbox) const
+	{
+		// isosurface does not intersect bbox if all overlapped tiles and leaves are of the same sign
+		ur_float3 vMin = (bbox.Min - this->bound.Min) / this->desc.VoxelSize;
+		ur_float3 vMax = (bbox.Max - this->bound.Min) / this->desc.VoxelSize;
+		ur_int3 rangeMin(
+			std::min(std::max((ur_int)floor(vMin.x), 0), this->voxelsCount.x - 1),
+			std::min(std::max((ur_int)floor(vMin.y), 0), this->voxelsCount.y - 1),
+			std::min(std::max((ur_int)floor(vMin.z), 0), this->voxelsCount.z - 1));
+		ur_int3 rangeMax(
+			std::min(std::max((ur_int)ceil(vMax.x), 0), this->voxelsCount.x - 1),
+			std::min(std::max((ur_int)ceil(vMax.y), 0), this->voxelsCount.y - 1),
+			std::min(std::max((ur_int)ceil(vMax.z), 0), this->voxelsCount.z - 1));
+
+		ur_int sign = 0;
+		auto checkRange = [&](ValueType valueMin, ValueType valueMax) -> bool {
+			ur_int rangeSign = (valueMin > 0 ? 1 : (valueMax <= 0 ? -1 : 0));
+			if (0 == rangeSign || (sign != 0 && sign != rangeSign))
+				return true; // intersection found
+			sign = rangeSign;
+			return false;
+		};
+		auto forEachChild = [&](const ur_int3 &nodeOrigin, ur_uint log2Dim, ur_uint childLog2Size, const std::function<bool(ur_uint, const ur_int3&)> &func) -> bool {
+			ur_int childSize = (1 << childLog2Size);
+			ur_int dim = (1 << log2Dim);
+			ur_int3 cMin(
+				std::max((rangeMin.x - nodeOrigin.x) >> childLog2Size, 0),
+				std::max((rangeMin.y - nodeOrigin.y) >> childLog2Size, 0),
+				std::max((rangeMin.z - nodeOrigin.z) >> childLog2Size, 0));
+			ur_int3 cMax(
+				std::min((rangeMax.x - nodeOrigin.x) >> childLog2Size, dim - 1),
+				std::min((rangeMax.y - nodeOrigin.y) >> childLog2Size, dim - 1),
+				std::min((rangeMax.z - nodeOrigin.z) >> childLog2Size, dim - 1));
+			for (ur_int iz = cMin.z; iz <= cMax.z; ++iz)
+			{
+				for (ur_int iy = cMin.y; iy <= cMax.y; ++iy)
+				{
+					for (ur_int ix = cMin.x; ix <= cMax.x; ++ix)
+					{
+						ur_uint idx = ur_uint(ix | (iy << log2Dim) | (iz << (log2Dim * 2)));
+						ur_int3 childOrigin(nodeOrigin.x + ix * childSize, nodeOrigin.y + iy * childSize, nodeOrigin.z + iz * childSize);
+						if (func(idx, childOrigin))
+							return true;
+					}
+				}
+			}
+			return false;
+		};
+
+		const ur_int upperSize = (1 << UpperNode::TotalLog2Dim);
+		const ur_int upperMask = ~(upperSize - 1);
+		for (ur_int uz = (rangeMin.z & upperMask); uz <= rangeMax.z; uz += upperSize)
 		{
-			Hexahedron &h = this->hexahedra[3];
-			h.vertices[0] = vf[3];
-			h.vertices[1] = ve[5];
-			h.vertices[2] = vc;
-			h.vertices[3] = vf[2];
-			h.vertices[4] = ve[3];
-			h.vertices[5] = v3;
-			h.vertices[6] = vf[1];
-			h.vertices[7] = ve[4];
+			for (ur_int uy = (rangeMin.y & upperMask); uy <= rangeMax.y; uy += upperSize)
+			{
+				for (ur_int ux = (rangeMin.x & upperMask); ux <= rangeMax.x; ux += upperSize)
+				{
+					ur_int3 upperOrigin(ux, uy, uz);
+					auto it = this->root.find(RootKey(upperOrigin));
+					if (it == this->root.end())
+						continue;
+					const UpperNode &upper = *it->second;
+					bool found = forEachChild(upperOrigin, UpperNode::Log2Dim, LowerNode::TotalLog2Dim, [&](ur_uint upperIdx, const ur_int3 &lowerOrigin) -> bool {
+						if (!upper.HasChild(upperIdx))
+							return checkRange(upper.tiles[upperIdx], upper.tiles[upperIdx]);
+						const LowerNode &lower = *upper.children[upperIdx];
+						return forEachChild(lowerOrigin, LowerNode::Log2Dim, Leaf::TotalLog2Dim, [&](ur_uint lowerIdx, const ur_int3 &leafOrigin) -> bool {
+							if (!lower.HasChild(lowerIdx))
+								return checkRange(lower.tiles[lowerIdx], lower.tiles[lowerIdx]);
+							const Leaf &leaf = *lower.children[lowerIdx];
+							return checkRange(leaf.GetValueMin(), leaf.GetValueMax());
+						});
+					});
+					if (found)
+						return Result(Success);
+				}
+			}
 		}
+
+		return Result(NotFound);
 	}
 
-	void Isosurface::HybridCubes::Tetrahedron::Split(std::array<std::unique_ptr<Tetrahedron>, ChildrenCount> &subTetrahedra)
+	Result Isosurface::SparseVolume::Read(ValueType *values, const ur_float3 *points, const ur_uint count, const BoundingBox &bbox)
 	{
-		// create sub tetrahedra
-		const ur_byte *ev = this->Edges[this->longestEdgeIdx].vid;
-		Vector3 ecp = this->vertices[ev[0]] * 0.5f + this->vertices[ev[1]] * 0.5f;
-		const SplitInfo &splitInfo = EdgeSplitInfo[this->longestEdgeIdx];
-		for (ur_uint subIdx = 0; subIdx < ChildrenCount; ++subIdx)
+		if (this->root.empty())
+			return Result(NotInitialized);
+
+		// early isosurface intersection test
+		if (ur_null == values)
+			return this->TestIntersection(bbox);
+
+		if (ur_null == points || 0 == count)
+			return Result(InvalidArgs);
+
+		// trilinear sampling using cached accessor
+		Accessor accessor(*this);
+		const ur_float voxelSizeInv = 1.0f / this->desc.VoxelSize;
+		const ur_float3 fMax(ur_float(this->voxelsCount.x - 1), ur_float(this->voxelsCount.y - 1), ur_float(this->voxelsCount.z - 1));
+		for (ur_uint i = 0; i < count; ++i)
 		{
-			std::unique_ptr<Tetrahedron> subTetrahedron(new Tetrahedron());
-			subTetrahedron->level = this->level + 1;
-			const ur_byte *vid = splitInfo.subTetrahedra[subIdx];
-			subTetrahedron->Init(
-				(vid[0] != 0xff ? this->vertices[vid[0]] : ecp),
-				(vid[1] != 0xff ? this->vertices[vid[1]] : ecp),
-				(vid[2] != 0xff ? this->vertices[vid[2]] : ecp),
-				(vid[3] != 0xff ? this->vertices[vid[3]] : ecp));
-			subTetrahedra[subIdx] = std::move(subTetrahedron);
+			ur_float3 f = (points[i] - this->bound.Min) * voxelSizeInv;
+			f.x = std::min(std::max(f.x, 0.0f), fMax.x);
+			f.y = std::min(std::max(f.y, 0.0f), fMax.y);
+			f.z = std::min(std::max(f.z, 0.0f), fMax.z);
+			ur_int3 i0(
+				std::min((ur_int)f.x, this->voxelsCount.x - 2),
+				std::min((ur_int)f.y, this->voxelsCount.y - 2),
+				std::min((ur_int)f.z, this->voxelsCount.z - 2));
+			ur_float3 t(f.x - i0.x, f.y - i0.y, f.z - i0.z);
+			ValueType v000 = accessor.GetValue(ur_int3(i0.x + 0, i0.y + 0, i0.z + 0));
+			ValueType v100 = accessor.GetValue(ur_int3(i0.x + 1, i0.y + 0, i0.z + 0));
+			ValueType v010 = accessor.GetValue(ur_int3(i0.x + 0, i0.y + 1, i0.z + 0));
+			ValueType v110 = accessor.GetValue(ur_int3(i0.x + 1, i0.y + 1, i0.z + 0));
+			ValueType v001 = accessor.GetValue(ur_int3(i0.x + 0, i0.y + 0, i0.z + 1));
+			ValueType v101 = accessor.GetValue(ur_int3(i0.x + 1, i0.y + 0, i0.z + 1));
+			ValueType v011 = accessor.GetValue(ur_int3(i0.x + 0, i0.y + 1, i0.z + 1));
+			ValueType v111 = accessor.GetValue(ur_int3(i0.x + 1, i0.y + 1, i0.z + 1));
+			values[i] = lerp(
+				lerp(lerp(v000, v100, t.x), lerp(v010, v110, t.x), t.y),
+				lerp(lerp(v001, v101, t.x), lerp(v011, v111, t.x), t.y),
+				t.z);
 		}
+
+		return Result(Success);
 	}
 
-	Isosurface::HybridCubes::Node::Node()
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// Isosurface::EditableVolume
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	Isosurface::EditableVolume::EditableVolume(Isosurface &isosurface, std::unique_ptr<DataVolume> source, ur_float brickSize, ur_uint bakeBrushesMax) :
+		DataVolume(isosurface)
 	{
+		this->source = std::move(source);
+		this->brickSize = std::max(brickSize, std::numeric_limits<ur_float>::epsilon());
+		this->bakeBrushesMax = bakeBrushesMax;
+		this->bakedBricksCount = 0;
+		this->brushIdNext = 0;
+		if (this->source != ur_null)
+		{
+			this->bound = this->source->GetBound();
+		}
 	}
 
-	Isosurface::HybridCubes::Node::Node(std::unique_ptr<Tetrahedron> tetrahedron)
+	Isosurface::EditableVolume::~EditableVolume()
 	{
-		this->tetrahedron = std::move(tetrahedron);
+
 	}
 
-	Isosurface::HybridCubes::Node::~Node()
+	Isosurface::DataVolume::ValueType Isosurface::EditableVolume::EvaluateBrush(const EditBrush &brush, const ur_float3 &point)
+	{
+		// signed distance, positive inside
+		ur_float3 d = point - brush.center;
+		switch (brush.shape)
+		{
+		case EditBrush::Shape::Sphere:
+			return SphereDistance(d, brush.extent.x);
+		case EditBrush::Shape::Box:
+			return BoxDistance(d, brush.extent);
+		}
+		return -std::numeric_limits<ValueType>::max();
+	}
+
+	ur_int3 Isosurface::EditableVolume::GetBrickPos(const ur_float3 &point) const
 	{
+		ur_float3 p = point / this->brickSize;
+		return ur_int3((ur_int)floor(p.x), (ur_int)floor(p.y), (ur_int)floor(p.z));
 	}
 
-	void Isosurface::HybridCubes::Node::Split(Node *cachedNode)
+	Isosurface::DataVolume::ValueType Isosurface::EditableVolume::SampleBaked(const std::vector<ValueType> &baked, const ur_int3 &brickPos, const ur_float3 &point) const
 	{
-		if (this->HasChildren() ||
-			this->tetrahedron.get() == ur_null)
-			return;
+		const ur_float cellSize = this->brickSize / BakeResolution;
+		const ur_float fMax = ur_float(BakeResolution) - 1.0e-4f;
+		ur_float3 f(
+			std::min(std::max((point.x - brickPos.x * this->brickSize) / cellSize, 0.0f), fMax),
+			std::min(std::max((point.y - brickPos.y * this->brickSize) / cellSize, 0.0f), fMax),
+			std::min(std::max((point.z - brickPos.z * this->brickSize) / cellSize, 0.0f), fMax));
+		const ur_uint3 i0((ur_uint)f.x, (ur_uint)f.y, (ur_uint)f.z);
+		const ur_float3 t(f.x - i0.x, f.y - i0.y, f.z - i0.z);
+		const ur_uint rowSize = BakeResolution + 1;
+		const ur_uint sliceSize = rowSize * rowSize;
+		const ValueType *v = baked.data() + i0.x + i0.y * rowSize + i0.z * sliceSize;
+		auto lerp = [](ValueType a, ValueType b, ur_float t) -> ValueType { return a + (b - a) * t; };
+		return lerp(
+			lerp(lerp(v[0], v[1], t.x), lerp(v[rowSize], v[rowSize + 1], t.x), t.y),
+			lerp(lerp(v[sliceSize], v[sliceSize + 1], t.x), lerp(v[sliceSize + rowSize], v[sliceSize + rowSize + 1], t.x), t.y),
+			t.z);
+	}
 
-		// get cached sub tetrahedra or compute new ones
-		std::array<std::shared_ptr<Tetrahedron>, Tetrahedron::ChildrenCount> subTetrahedra;
-		if (cachedNode && cachedNode->HasChildren())
+	Result Isosurface::EditableVolume::BakeBrick(const ur_int3 &brickPos, Brick &brick)
+	{
+		// lattice covering the brick
+		const ur_float cellSize = this->brickSize / BakeResolution;
+		const ur_float3 origin(brickPos.x * this->brickSize, brickPos.y * this->brickSize, brickPos.z * this->brickSize);
+		std::vector<ur_float3> points(BakeLatticeSize);
+		ur_uint idx = 0;
+		for (ur_uint z = 0; z <= BakeResolution; ++z)
 		{
-			for (ur_uint subIdx = 0; subIdx < Tetrahedron::ChildrenCount; ++subIdx)
+			for (ur_uint y = 0; y <= BakeResolution; ++y)
 			{
-				subTetrahedra[subIdx] = cachedNode->children[subIdx]->tetrahedron;
+				for (ur_uint x = 0; x <= BakeResolution; ++x)
+				{
+					points[idx++] = origin + ur_float3(x * cellSize, y * cellSize, z * cellSize);
+				}
 			}
 		}
+
+		// previously baked samples or the source ones
+		std::shared_ptr<std::vector<ValueType>> baked(new std::vector<ValueType>(BakeLatticeSize));
+		if (brick.baked != ur_null)
+		{
+			*baked = *brick.baked;
+		}
 		else
 		{
-			std::array<std::unique_ptr<Tetrahedron>, Tetrahedron::ChildrenCount> newTetrahedra;
-			this->tetrahedron->Split(newTetrahedra);
-			for (ur_uint subIdx = 0; subIdx < Tetrahedron::ChildrenCount; ++subIdx)
+			const BoundingBox bbox(origin, origin + ur_float3(this->brickSize));
+			Result res = this->source->ReadLattice(baked->data(), points.data(), BakeLatticeSize, bbox, cellSize);
+			if (res == NotFound)
 			{
-				subTetrahedra[subIdx] = std::move(newTetrahedra[subIdx]);
+				res = this->source->ReadLattice(baked->data(), points.data(), BakeLatticeSize, this->source->GetBound(), cellSize);
 			}
+			if (Failed(res))
+				return res;
 		}
-		
-		// create sub nodes
-		for (ur_uint subIdx = 0; subIdx < Tetrahedron::ChildrenCount; ++subIdx)
+
+		for (const ur_uint &id : brick.brushIds)
 		{
-			std::unique_ptr<Node> subNode(new Node());
-			subNode->tetrahedron = std::move(subTetrahedra[subIdx]);
-			this->children[subIdx] = std::move(subNode);
+			const Brush &entry = this->brushes[id];
+			for (ur_uint i = 0; i < BakeLatticeSize; ++i)
+			{
+				if (!entry.bound.Intersects(points[i]))
+					continue;
+				ValueType &v = (*baked)[i];
+				ValueType s = EvaluateBrush(entry.brush, points[i]);
+				v = (EditBrush::Operation::Add == entry.brush.operation ? std::max(v, s) : std::min(v, -s));
+			}
 		}
-	}
-
-	void Isosurface::HybridCubes::Node::Merge()
-	{
-		if (!this->HasChildren())
-			return;
 
-		for (auto &child : this->children)
+		// release brushes no longer referenced
+		for (const ur_uint &id : brick.brushIds)
 		{
-			child = ur_null;
+			auto it = this->brushes.find(id);
+			if (--it->second.bricksCount == 0)
+				this->brushes.erase(it);
 		}
-	}
+		brick.brushIds.clear();
+		this->bakedBricksCount += (ur_null == brick.baked ? 1 : 0);
+		brick.baked = baked;
 
-	Isosurface::HybridCubes::HybridCubes(Isosurface &isosurface, const Desc &desc) :
-		Presentation(isosurface)
-	{
-		this->desc = desc;
-		this->freezeUpdate = false;
-		this->hideSurface = false;
-		this->drawTetrahedra = false;
-		this->hideEmptyTetrahedra = false;
-		this->drawHexahedra = false;
-		this->drawRefinementTree = false;
-		memset(&this->stats, 0, sizeof(this->stats));
-		this->jobBuildCounter = 0;
-		this->jobBuildRequested = 0;
+		return Result(Success);
 	}
 
-	Isosurface::HybridCubes::~HybridCubes()
+	Result Isosurface::EditableVolume::Read(ValueType *values, const ur_float3 *points, const ur_uint count, const BoundingBox &bbox)
 	{
-		if (this->jobUpdate != ur_null)
-		{
-			this->jobUpdate->Interrupt();
-			this->jobUpdate->Wait();
-		}
-		for (auto &job : this->jobBuild)
-		{
-			job->Interrupt();
-			job->Wait();
-		}
+		// keep the sampling interval of the requested region for the whole bound re-read below
+		return this->ReadLattice(values, points, count, bbox, EstimateSpacing(bbox, count));
 	}
 
-	Result Isosurface::HybridCubes::Update(const ur_float3 &refinementPoint, const ur_float4x4 &viewProj)
+	Result Isosurface::EditableVolume::ReadLattice(ValueType *values, const ur_float3 *points, const ur_uint count, const BoundingBox &bbox, const ur_float cellSize)
 	{
-		if (ur_null == this->isosurface.GetData())
+		if (ur_null == this->source)
 			return Result(NotInitialized);
 
-		// init roots
-		const BoundingBox &bbox = this->isosurface.GetData()->GetBound();
-		if (ur_null == this->root[0].get())
-		{
-			std::unique_ptr<Tetrahedron> th(new Tetrahedron());
-			th->Init(
-				{ bbox.Min.x, bbox.Min.y, bbox.Min.z },
-				{ bbox.Min.x, bbox.Max.y, bbox.Min.z },
-				{ bbox.Max.x, bbox.Max.y, bbox.Min.z },
-				{ bbox.Max.x, bbox.Max.y, bbox.Max.z }
-			);
-			this->root[0].reset(new Node(std::move(th)));
-		}
-		if (ur_null == this->root[1].get())
-		{
-			std::unique_ptr<Tetrahedron> th(new Tetrahedron());
-			th->Init(
-				{ bbox.Min.x, bbox.Min.y, bbox.Min.z },
-				{ bbox.Max.x, bbox.Max.y, bbox.Min.z },
-				{ bbox.Max.x, bbox.Min.y, bbox.Min.z },
-				{ bbox.Max.x, bbox.Max.y, bbox.Max.z }
-			);
-			this->root[1].reset(new Node(std::move(th)));
-		}
-		if (ur_null == this->root[2].get())
-		{
-			std::unique_ptr<Tetrahedron> th(new Tetrahedron());
-			th->Init(
-				{ bbox.Min.x, bbox.Min.y, bbox.Min.z },
-				{ bbox.Max.x, bbox.Min.y, bbox.Min.z },
-				{ bbox.Max.x, bbox.Min.y, bbox.Max.z },
-				{ bbox.Max.x, bbox.Max.y, bbox.Max.z }
-			);
-			this->root[2].reset(new Node(std::move(th)));
-		}
-		if (ur_null == this->root[3].get())
-		{
-			std::unique_ptr<Tetrahedron> th(new Tetrahedron());
-			th->Init(
-				{ bbox.Min.x, bbox.Min.y, bbox.Min.z },
-				{ bbox.Min.x, bbox.Max.y, bbox.Max.z },
-				{ bbox.Min.x, bbox.Max.y, bbox.Min.z },
-				{ bbox.Max.x, bbox.Max.y, bbox.Max.z }
-			);
-			this->root[3].reset(new Node(std::move(th)));
-		}
-		if (ur_null == this->root[4].get())
-		{
-			std::unique_ptr<Tetrahedron> th(new Tetrahedron());
-			th->Init(
-				{ bbox.Min.x, bbox.Min.y, bbox.Min.z },
-				{ bbox.Min.x, bbox.Min.y, bbox.Max.z },
-				{ bbox.Min.x, bbox.Max.y, bbox.Max.z },
-				{ bbox.Max.x, bbox.Max.y, bbox.Max.z }
-			);
-			this->root[4].reset(new Node(std::move(th)));
-		}
-		if (ur_null == this->root[5].get())
-		{
-			std::unique_ptr<Tetrahedron> th(new Tetrahedron());
-			th->Init(
-				{ bbox.Min.x, bbox.Min.y, bbox.Min.z },
-				{ bbox.Max.x, bbox.Min.y, bbox.Max.z },
-				{ bbox.Min.x, bbox.Min.y, bbox.Max.z },
-				{ bbox.Max.x, bbox.Max.y, bbox.Max.z }
-			);
-			this->root[5].reset(new Node(std::move(th)));
-		}
-		if (ur_null == this->refinementTree.GetRoot())
+		// gather bricks overlapping requested region: baked samples are shared, brushes are copied
+		struct LocalBrick
 		{
-			this->refinementTree.Init(bbox);
-			ur_float nodeSize = (bbox.Max - bbox.Min).Length();
-			ur_float cellSize = (nodeSize / (this->desc.LatticeResolution.GetMaxValue() * 2));
-			ur_uint levels = 0;
-			while (cellSize > this->desc.CellSize)
+			ur_int3 pos;
+			std::shared_ptr<const std::vector<ValueType>> baked;
+			std::vector<ur_uint> brushIdx; // local brushes
+		};
+		std::unordered_map<ur_uint64, LocalBrick> localBricks;
+		std::vector<EditBrush> localBrushes;
+		std::vector<BoundingBox> localBounds;
+		{
+			std::lock_guard<std::mutex> lock(this->mutex);
+			std::unordered_map<ur_uint, ur_uint> localIds;
+			auto addBrick = [&](ur_uint64 key, const Brick &brick) -> void {
+				LocalBrick &localBrick = localBricks[key];
+				localBrick.pos = brick.pos;
+				localBrick.baked = brick.baked;
+				localBrick.brushIdx.reserve(brick.brushIds.size());
+				for (const ur_uint &id : brick.brushIds)
+				{
+					auto it = localIds.find(id);
+					if (it == localIds.end())
+					{
+						const Brush &entry = this->brushes[id];
+						it = localIds.insert(std::make_pair(id, (ur_uint)localBrushes.size())).first;
+						localBrushes.push_back(entry.brush);
+						localBounds.push_back(entry.bound);
+					}
+					localBrick.brushIdx.push_back(it->second);
+				}
+			};
+			ur_int3 brickMin = this->GetBrickPos(bbox.Min);
+			ur_int3 brickMax = this->GetBrickPos(bbox.Max);
+			ur_uint64 bricksCount = ur_uint64(brickMax.x - brickMin.x + 1) * ur_uint64(brickMax.y - brickMin.y + 1) * ur_uint64(brickMax.z - brickMin.z + 1);
+			if (bricksCount > this->bricks.size())
 			{
-				cellSize *= 0.5;
-				++levels;
+				// large region: brute force test is cheaper than bricks lookup
+				for (const auto &entry : this->bricks)
+				{
+					const ur_int3 &pos = entry.second.pos;
+					if (pos.x >= brickMin.x && pos.y >= brickMin.y && pos.z >= brickMin.z &&
+						pos.x <= brickMax.x && pos.y <= brickMax.y && pos.z <= brickMax.z)
+						addBrick(entry.first, entry.second);
+				}
 			}
-			ur_float levelDistance = this->desc.DetailLevelDistance;
-			this->refinementDistance.resize(levels);
-			for (ur_uint i = levels; i > 0; --i)
+			else
 			{
-				this->refinementDistance[i - 1] = levelDistance;
-				levelDistance += levelDistance * 2.0f;
+				for (ur_int z = brickMin.z; z <= brickMax.z; ++z)
+				{
+					for (ur_int y = brickMin.y; y <= brickMax.y; ++y)
+					{
+						for (ur_int x = brickMin.x; x <= brickMax.x; ++x)
+						{
+							const ur_uint64 key = GetBrickKey(ur_int3(x, y, z));
+							auto it = this->bricks.find(key);
+							if (it != this->bricks.end())
+								addBrick(key, it->second);
+						}
+					}
+				}
 			}
 		}
 
-		if (this->freezeUpdate)
-			return Success;
-
-		Result res(Success);
-		bool updateSync = false;
-		if (updateSync)
+		if (ur_null == values)
 		{
-			memset(&this->stats, 0, sizeof(this->stats));
+			// intersection test: edited bricks are conservatively treated as intersecting
+			Result res = this->source->ReadLattice(values, points, count, bbox, cellSize);
+			if (res.Code != NotFound)
+				return res;
+			return Result(localBricks.empty() ? NotFound : Success);
+		}
 
-			// update refinement tree
-			this->UpdateRefinementTree(refinementPoint, this->refinementTree.GetRoot());
+		Result res = this->source->ReadLattice(values, points, count, bbox, cellSize);
+		if (res == NotFound)
+		{
+			if (localBricks.empty())
+				return res;
+			// source may skip writing values for empty regions, re-read using the whole bound to get valid samples
+			res = this->source->ReadLattice(values, points, count, this->source->GetBound(), cellSize);
+		}
+		if (Failed(res) || localBricks.empty())
+			return res;
 
-			// update hierarchy
-			for (auto &tetrahedron : this->root)
+		// a point takes baked samples of its brick and brushes written after the brick was baked
+		ur_uint64 brickKey = ~ur_uint64(0);
+		const LocalBrick *brick = ur_null;
+		for (ur_uint i = 0; i < count; ++i)
+		{
+			const ur_int3 brickPos = this->GetBrickPos(points[i]);
+			const ur_uint64 key = GetBrickKey(brickPos);
+			if (key != brickKey)
 			{
-				res &= this->Update(refinementPoint, tetrahedron.get(), ur_null, &this->stats);
+				auto it = localBricks.find(key);
+				brick = (it != localBricks.end() ? &it->second : ur_null);
+				brickKey = key;
 			}
-
-			// build meshes
-			for (auto &entry : this->buildQueue)
+			if (ur_null == brick)
+				continue;
+			ValueType &v = values[i];
+			if (brick->baked != ur_null)
 			{
-				res &= this->BuildMesh(entry.second, &this->stats);
+				v = this->SampleBaked(*brick->baked, brick->pos, points[i]);
+			}
+			for (const ur_uint &ib : brick->brushIdx)
+			{
+				if (!localBounds[ib].Intersects(points[i]))
+					continue;
+				const EditBrush &brush = localBrushes[ib];
+				ValueType s = EvaluateBrush(brush, points[i]);
+				v = (EditBrush::Operation::Add == brush.operation ? std::max(v, s) : std::min(v, -s));
 			}
-			this->buildQueue.clear();
 		}
-		else
-		{
-			auto &jobSystem = this->isosurface.GetRealm().GetJobSystem();
 
-			// do update/build job(s)
-			if ((this->jobUpdate == ur_null || this->jobUpdate->Finished()) &&
-				(this->jobBuildCounter >= this->jobBuildRequested))
-			{
-				// make visible new meshes
-				for (auto &jobCtx : this->jobBuildCtx)
-				{
-					jobCtx.second->visible = true;
-				}
+		return Result(Success);
+	}
 
-				// reset previous build job(s) data
-				this->jobBuildCounter = 0;
-				this->jobBuildRequested = 0;
-				this->jobBuild.clear();
-				this->jobBuildCtx.clear();
+	Result Isosurface::EditableVolume::Write(const EditBrush &brush)
+	{
+		if (brush.extent.x <= 0.0f ||
+			(EditBrush::Shape::Box == brush.shape && (brush.extent.y <= 0.0f || brush.extent.z <= 0.0f)))
+		{
+			Log &log = this->isosurface.GetRealm().GetLog();
+			return LogResult(InvalidArgs, log, Log::Error, "Isosurface::EditableVolume::Write: invalid brush extent");
+		}
 
-				// swap back and front data
-				if (this->jobUpdate != ur_null &&
-					this->jobUpdate->FinishedSuccessfully())
-				{
-					for (ur_uint ir = 0; ir < HybridCubes::RootsCount; ++ir)
-					{
-						this->root[ir].swap(this->rootBack[ir]);
-					}
-					memcpy(&this->stats, &this->statsBack, sizeof(this->stats));
-				}
-				
-				// prepare update context
-				this->updatePoint = refinementPoint;
+		// brush influence region: shape bound expanded by a brick to keep the surface gradient continuous around the edit
+		ur_float3 halfSize = (EditBrush::Shape::Sphere == brush.shape ? ur_float3(brush.extent.x) : brush.extent);
+		halfSize += ur_float3(this->brickSize);
+		BoundingBox influence(brush.center - halfSize, brush.center + halfSize);
 
-				// start a new update
-				this->jobUpdate = jobSystem.Add(JobPriority::Low, Job::DataPtr(this), [](Job::Context& ctx) -> void {
+		std::lock_guard<std::mutex> lock(this->mutex);
 
-					Result result = Success;
+		ur_uint id = this->brushIdNext++;
+		Brush &entry = this->brushes[id];
+		entry.brush = brush;
+		entry.bound = influence;
+		entry.bricksCount = 0;
 
-					// reinterpret data ptr
-					HybridCubes *presentation = reinterpret_cast<HybridCubes*>(ctx.data);
-					auto &jobSystem = presentation->isosurface.GetRealm().GetJobSystem();
-					
-					// reset presentation
-					presentation->buildQueue.clear();
-					memset(&presentation->statsBack, 0, sizeof(presentation->statsBack));
+		std::vector<ur_int3> bakeQueue;
+		ur_int3 brickMin = this->GetBrickPos(influence.Min);
+		ur_int3 brickMax = this->GetBrickPos(influence.Max);
+		for (ur_int z = brickMin.z; z <= brickMax.z; ++z)
+		{
+			for (ur_int y = brickMin.y; y <= brickMax.y; ++y)
+			{
+				for (ur_int x = brickMin.x; x <= brickMax.x; ++x)
+				{
+					Brick &brick = this->bricks[GetBrickKey(ur_int3(x, y, z))];
+					brick.pos = ur_int3(x, y, z);
+					brick.brushIds.push_back(id);
+					entry.bricksCount += 1;
+					if (this->bakeBrushesMax > 0 && brick.brushIds.size() >= this->bakeBrushesMax)
+						bakeQueue.push_back(brick.pos);
+				}
+			}
+		}
 
-					// update refinement tree
-					presentation->UpdateRefinementTree(presentation->updatePoint, presentation->refinementTree.GetRoot());
+		this->dirtyRegions.push_back(influence);
 
-					// update hierarchy
-					for (ur_uint i = 0; i < HybridCubes::RootsCount; ++i)
-					{
-						result &= presentation->Update(
-							presentation->updatePoint, presentation->rootBack[i].get(), presentation->root[i].get(),
-							&presentation->statsBack);
-					}
+		// baked samples are interpolated, the whole brick is modified
+		Result res = Result(Success);
+		for (const ur_int3 &pos : bakeQueue)
+		{
+			res &= this->BakeBrick(pos, this->bricks[GetBrickKey(pos)]);
+			const ur_float3 origin(pos.x * this->brickSize, pos.y * this->brickSize, pos.z * this->brickSize);
+			this->dirtyRegions.push_back(BoundingBox(origin, origin + ur_float3(this->brickSize)));
+		}
 
-					// build meshes
-					if (!presentation->buildQueue.empty())
-					{
-						ur_uint level = presentation->buildQueue.begin()->second->level;
-						for (auto &entry : presentation->buildQueue)
-						{
-							if (entry.first != level)
-								break; // one level per update iteration (to avoid seams)
+		return res;
+	}
 
-							presentation->jobBuildRequested += 1;
-							presentation->jobBuildCtx.push_back(std::pair<HybridCubes*, Tetrahedron*>(presentation, entry.second));
-							auto &buildCtx = presentation->jobBuildCtx.back();
+	Result Isosurface::EditableVolume::FetchDirtyRegions(std::vector<BoundingBox> &regions)
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		regions.insert(regions.end(), this->dirtyRegions.begin(), this->dirtyRegions.end());
+		this->dirtyRegions.clear();
+		return Result(Success);
+	}
 
-							// mesh building job
-							presentation->jobBuild.push_back(jobSystem.Add(Job::DataPtr(&buildCtx), [](Job::Context& ctx) -> void {
+	ur_bool Isosurface::EditableVolume::HasLevels() const
+	{
+		return (this->source != ur_null && this->source->HasLevels());
+	}
 
-								Result result = Success;
+	Result Isosurface::EditableVolume::Prefetch(const BoundingBox &bbox)
+	{
+		if (ur_null == this->source)
+			return Result(NotInitialized);
 
-								std::pair<HybridCubes*, Tetrahedron*> *jobData = reinterpret_cast<decltype(jobData)>(ctx.data);
-								HybridCubes *presentation = jobData->first;
-								Tetrahedron *tetrahedron = jobData->second;
-								tetrahedron->visible = false;
+		return this->source->Prefetch(bbox);
+	}
 
-								result &= presentation->BuildMesh(tetrahedron, &presentation->statsBack);
 
-								ctx.resultCode = result.Code;
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// Isosurface::CsgVolume
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-								presentation->jobBuildCounter += 1;
-							}));
-						}
-						presentation->buildQueue.clear();
-						presentation->statsBack.buildQueue = presentation->jobBuildRequested;
-					}
+	Isosurface::CsgVolume::CsgVolume(Isosurface &isosurface) :
+		DataVolume(isosurface)
+	{
+		memset(&this->desc, 0, sizeof(this->desc));
+	}
 
-					ctx.resultCode = result.Code;
-				});
-			}
-		}
+	Isosurface::CsgVolume::~CsgVolume()
+	{
 
-		return res;
 	}
 
-	void Isosurface::HybridCubes::UpdateRefinementTree(const ur_float3 &refinementPoint, EmptyOctree::Node *node)
+	Isosurface::DataVolume::ValueType Isosurface::CsgVolume::EvaluatePrimitive(const Primitive &primitive, const ur_float3 &point)
 	{
-		if (ur_null == node)
-			return;
-
-#if 1
-		ur_float nodeSize = (node->GetBBox().Max - node->GetBBox().Min).Length();
-		bool doSplit = (nodeSize / (this->desc.LatticeResolution.GetMaxValue() * 2) > this->desc.CellSize);
-		if (doSplit)
-		{
-			ur_float refinementDistance = (node->GetBBox().Max - node->GetBBox().Min).Length() * 0.5f;
-			doSplit = (node->GetBBox().Distance(refinementPoint) < refinementDistance);
-			doSplit |= node->GetLevel() < 2; // TEMP: always split to minimal refinement level
-		}
-#else
-		bool doSplit = (node->GetLevel() < this->refinementDistance.size());
-		if (doSplit)
+		// signed distance, positive inside
+		ur_float3 d = point - primitive.center;
+		switch (primitive.shape)
 		{
-			doSplit = (node->GetBBox().Distance(refinementPoint) < this->refinementDistance[node->GetLevel()]);
-		}
-#endif
-
-		if (doSplit)
+		case Primitive::Shape::Sphere:
+			return SphereDistance(d, primitive.extent.x);
+		case Primitive::Shape::Box:
+			return BoxDistance(d, primitive.extent);
+		case Primitive::Shape::Capsule:
 		{
-			node->Split();
-			if (node->HasSubNodes())
-			{
-				for (ur_uint i = 0; i < EmptyOctree::Node::SubNodesCount; ++i)
-				{
-					this->UpdateRefinementTree(refinementPoint, node->GetSubNode(i));
-				}
-			}
+			ur_float3 a = primitive.axis * 2.0f;
+			ur_float3 p = d + primitive.axis;
+			ur_float aa = ur_float3::Dot(a, a);
+			ur_float t = (aa > 0.0f ? std::min(std::max(ur_float3::Dot(p, a) / aa, 0.0f), 1.0f) : 0.0f);
+			return primitive.extent.x - (p - a * t).Length();
 		}
-		else
-		{
-			node->Merge();
 		}
+		return -std::numeric_limits<ValueType>::max();
 	}
 
-	bool Isosurface::HybridCubes::CheckRefinementTree(const BoundingBox &bbox, EmptyOctree::Node *node)
+	BoundingBox Isosurface::CsgVolume::GetInfluenceBound(const Primitive &primitive) const
 	{
-		if (ur_null == node || !bbox.Intersects(node->GetBBox()))
-			return false;
-
-		ur_float nodeSize = node->GetBBox().SizeMin();
-		ur_float bboxSize = bbox.SizeMax();
-		if (bboxSize > nodeSize)
-			return true;
-
-		//RectF r0, r1, ri;
-		//{ // test XY
-		//	r0.Min.x = bbox.Min.x; r0.Min.y = bbox.Min.y;
-		//	r0.Max.x = bbox.Max.x; r0.Max.y = bbox.Max.y;
-		//	r1.Min.x = node->GetBBox().Min.x; r1.Min.y = node->GetBBox().Min.y;
-		//	r1.Max.x = node->GetBBox().Max.x; r1.Max.y = node->GetBBox().Max.y;
-		//	if (r0.Intersection(r1, ri) && ri.Area() > std::numeric_limits<ur_float>::epsilon() &&
-		//		(ri.Width() < r0.Width() || ri.Height() < r0.Height()))
-		//		return true;
-		//}
-		//{ // test XZ
-		//	r0.Min.x = bbox.Min.x; r0.Min.y = bbox.Min.z;
-		//	r0.Max.x = bbox.Max.x; r0.Max.y = bbox.Max.z;
-		//	r1.Min.x = node->GetBBox().Min.x; r1.Min.y = node->GetBBox().Min.z;
-		//	r1.Max.x = node->GetBBox().Max.x; r1.Max.y = node->GetBBox().Max.z;
-		//	if (r0.Intersection(r1, ri) && ri.Area() > std::numeric_limits<ur_float>::epsilon() &&
-		//		(ri.Width() < r0.Width() || ri.Height() < r0.Height()))
-		//		return true;
-		//}
-		//{ // test YZ
-		//	r0.Min.x = bbox.Min.z; r0.Min.y = bbox.Min.y;
-		//	r0.Max.x = bbox.Max.z; r0.Max.y = bbox.Max.y;
-		//	r1.Min.x = node->GetBBox().Min.z; r1.Min.y = node->GetBBox().Min.y;
-		//	r1.Max.x = node->GetBBox().Max.z; r1.Max.y = node->GetBBox().Max.y;
-		//	if (r0.Intersection(r1, ri) && ri.Area() > std::numeric_limits<ur_float>::epsilon() &&
-		//		(ri.Width() < r0.Width() || ri.Height() < r0.Height()))
-		//		return true;
-		//}
-		
-		for (ur_uint i = 0; i < EmptyOctree::Node::SubNodesCount; ++i)
+		ur_float3 halfSize;
+		switch (primitive.shape)
 		{
-			if (this->CheckRefinementTree(bbox, node->GetSubNode(i)))
-				return true;
+		case Primitive::Shape::Sphere:
+			halfSize = ur_float3(primitive.extent.x);
+			break;
+		case Primitive::Shape::Box:
+			halfSize = primitive.extent;
+			break;
+		case Primitive::Shape::Capsule:
+			halfSize = ur_float3(std::fabs(primitive.axis.x), std::fabs(primitive.axis.y), std::fabs(primitive.axis.z)) + ur_float3(primitive.extent.x);
+			break;
 		}
-			
-		return false;
+
+		// values beyond the margin are clamped, smooth operations additionally affect blending distance
+		ur_float expand = this->desc.Margin;
+		if (Primitive::Operation::SmoothUnion == primitive.operation ||
+			Primitive::Operation::SmoothSubtract == primitive.operation)
+			expand += std::max(primitive.blend, 0.0f);
+		halfSize += ur_float3(expand);
+
+		return BoundingBox(primitive.center - halfSize, primitive.center + halfSize);
 	}
 
-	Result Isosurface::HybridCubes::Update(const ur_float3 &refinementPoint, Node *node, Node *cachedNode, Stats *stats)
+	Result Isosurface::CsgVolume::Build(const std::vector<Primitive> &primitives, const Desc &desc)
 	{
-		Result res(Success);
-		if (ur_null == node ||
-			ur_null == node->tetrahedron)
-			return res;
+		Log &log = this->isosurface.GetRealm().GetLog();
+		if (desc.Margin <= 0.0f || 0 == desc.LeafSize)
+			return LogResult(InvalidArgs, log, Log::Error, "Isosurface::CsgVolume::Build: invalid description");
 
-		res &= this->UpdateLoD(refinementPoint, node, cachedNode);
+		this->desc = desc;
+		this->primitives = primitives;
+		this->primitiveBounds.resize(primitives.size());
+		this->primitiveRefs.resize(primitives.size());
+		this->nodes.clear();
+		this->bound = BoundingBox(ur_float3(0.0f), ur_float3(0.0f));
+		if (primitives.empty())
+			return Result(Success);
 
-		if (!node->tetrahedron->initialized)
+		std::vector<ur_float3> centers(primitives.size());
+		BoundingBox totalBound;
+		for (ur_uint i = 0; i < (ur_uint)primitives.size(); ++i)
 		{
-			this->buildQueue.insert(std::pair<ur_uint, Tetrahedron*>(node->tetrahedron->level, node->tetrahedron.get()));
+			BoundingBox &bb = this->primitiveBounds[i];
+			bb = this->GetInfluenceBound(primitives[i]);
+			centers[i] = bb.Center();
+			this->primitiveRefs[i] = i;
+			totalBound.Expand(bb.Min);
+			totalBound.Expand(bb.Max);
 		}
+		this->bound = totalBound;
 
-		if (node->HasChildren())
+		// build BVH in depth first order, so that left child always follows its parent;
+		// node is split at the median of primitive centers along the largest axis
+		struct BuildEntry
 		{
-			for (ur_uint subIdx = 0; subIdx < Tetrahedron::ChildrenCount; ++subIdx)
+			ur_uint parent;
+			ur_uint begin;
+			ur_uint end;
+		};
+		static const ur_uint NoParent = ur_uint(-1);
+		std::vector<BuildEntry> stack;
+		stack.push_back({ NoParent, 0, (ur_uint)primitives.size() });
+		this->nodes.reserve(primitives.size() * 2 / desc.LeafSize + 1);
+		while (!stack.empty())
+		{
+			BuildEntry entry = stack.back();
+			stack.pop_back();
+
+			ur_uint nodeIdx = (ur_uint)this->nodes.size();
+			if (entry.parent != NoParent)
 			{
-				res &= this->Update(refinementPoint, node->children[subIdx].get(),
-					(cachedNode ? cachedNode->children[subIdx].get() : ur_null), stats);
+				this->nodes[entry.parent].first = nodeIdx; // right child
 			}
+			this->nodes.push_back(Node());
+			Node &node = this->nodes.back();
+			BoundingBox centersBound;
+			for (ur_uint i = entry.begin; i < entry.end; ++i)
+			{
+				const ur_uint id = this->primitiveRefs[i];
+				node.bbox.Expand(this->primitiveBounds[id].Min);
+				node.bbox.Expand(this->primitiveBounds[id].Max);
+				centersBound.Expand(centers[id]);
+			}
+
+			const ur_uint count = entry.end - entry.begin;
+			if (count <= desc.LeafSize)
+			{
+				node.first = entry.begin;
+				node.count = count;
+				continue;
+			}
+			node.first = 0;
+			node.count = 0;
+
+			ur_float3 centersSize = centersBound.Size();
+			ur_uint axis = (centersSize.x >= centersSize.y && centersSize.x >= centersSize.z ? 0 : (centersSize.y >= centersSize.z ? 1 : 2));
+			ur_uint middle = entry.begin + count / 2;
+			std::nth_element(this->primitiveRefs.begin() + entry.begin, this->primitiveRefs.begin() + middle, this->primitiveRefs.begin() + entry.end,
+				[&centers, axis](const ur_uint a, const ur_uint b) {
+					return (0 == axis ? centers[a].x < centers[b].x : (1 == axis ? centers[a].y < centers[b].y : centers[a].z < centers[b].z));
+				});
+
+			// right child is pushed first to be processed after the whole left subtree
+			stack.push_back({ nodeIdx, middle, entry.end });
+			stack.push_back({ NoParent, entry.begin, middle });
 		}
 
-		// update stats
-		if (stats != ur_null)
+		return Result(Success);
+	}
+
+	void Isosurface::CsgVolume::Query(const BoundingBox &bbox, std::vector<ur_uint> &primitiveIds) const
+	{
+		primitiveIds.clear();
+		if (this->nodes.empty())
+			return;
+
+		// depth is not bounded for degenerate primitive distributions
+		std::vector<ur_uint> stack;
+		stack.reserve(64);
+		stack.push_back(0);
+		while (!stack.empty())
 		{
-			stats->tetrahedraCount += 1;
-			stats->treeMemory += sizeof(Tetrahedron);
-			stats->treeMemory += sizeof(node->tetrahedron->hexahedra);
-			if (node->tetrahedron->initialized)
+			const ur_uint nodeIdx = stack.back();
+			stack.pop_back();
+			const Node &node = this->nodes[nodeIdx];
+			if (!node.bbox.Intersects(bbox))
+				continue;
+			if (node.count > 0)
 			{
-				for (const auto &h : node->tetrahedron->hexahedra)
+				for (ur_uint i = node.first; i < node.first + node.count; ++i)
 				{
-					#if defined(UR_GRAF)
-					if (h.grafMesh.VB) stats->meshVideoMemory += (ur_uint)h.grafMesh.VB->GetDesc().SizeInBytes;
-					if (h.grafMesh.IB) stats->meshVideoMemory += (ur_uint)h.grafMesh.IB->GetDesc().SizeInBytes;
-					#else
-					if (h.gfxMesh.VB) stats->meshVideoMemory += h.gfxMesh.VB->GetDesc().Size;
-					if (h.gfxMesh.IB) stats->meshVideoMemory += h.gfxMesh.IB->GetDesc().Size;
-					#endif
+					const ur_uint id = this->primitiveRefs[i];
+					if (this->primitiveBounds[id].Intersects(bbox))
+						primitiveIds.push_back(id);
 				}
 			}
+			else
+			{
+				stack.push_back(node.first);
+				stack.push_back(nodeIdx + 1);
+			}
 		}
 
-		return res;
+		// operations are not commutative, primitives must be applied in the order of declaration
+		std::sort(primitiveIds.begin(), primitiveIds.end());
 	}
 
-	Result Isosurface::HybridCubes::UpdateLoD(const ur_float3 &refinementPoint, Node *node, Node *cachedNode)
+	Result Isosurface::CsgVolume::Read(ValueType *values, const ur_float3 *points, const ur_uint count, const BoundingBox &bbox)
 	{
-		Result res(Success);
-		if (ur_null == node ||
-			ur_null == node->tetrahedron)
-			return res;
+		std::vector<ur_uint> primitiveIds;
+		this->Query(bbox, primitiveIds);
 
-		// update LoD by traversing refinement octree
-		// current approach produces seamless partition, but due to it's conservative nature, the resulting mesh is overdetailed
-		// todo: try doing proper LEB implementation, based on "dimonds" hierarchy or "terminal edge" bisection
-#if 1
-		bool doSplit = this->CheckRefinementTree(node->tetrahedron->bbox, this->refinementTree.GetRoot());
-#else
-		bool doSplit = false;
-		const ur_float3 &ev0 = node->tetrahedron->vertices[Tetrahedron::Edges[node->tetrahedron->longestEdgeIdx].vid[0]];
-		const ur_float3 &ev1 = node->tetrahedron->vertices[Tetrahedron::Edges[node->tetrahedron->longestEdgeIdx].vid[1]];
-		ur_float edgeLen = (ev0 - ev1).Length();
-		doSplit = (edgeLen / (this->desc.LatticeResolution.GetMaxValue() * 2) > this->desc.CellSize);
-		if (doSplit)
+		// surface can only be produced by additive primitives
+		bool additive = false;
+		for (const ur_uint &id : primitiveIds)
 		{
-			ur_float3 evc = (ev0 + ev1) * 0.5f;
-			doSplit = (evc - refinementPoint).Length() < edgeLen;
+			const Primitive::Operation &op = this->primitives[id].operation;
+			additive |= (Primitive::Operation::Union == op || Primitive::Operation::SmoothUnion == op);
 		}
-#endif
 
-		if (doSplit)
+		if (ur_null == values)
+			return Result(additive ? Success : NotFound);
+
+		if (ur_null == points && count > 0)
+			return Result(InvalidArgs);
+
+		// evaluate primitives in batches over all requested points
+		const ValueType margin = this->desc.Margin;
+		std::fill(values, values + count, -margin);
+		for (const ur_uint &id : primitiveIds)
 		{
-			node->Split(cachedNode);
+			const Primitive &primitive = this->primitives[id];
+			const BoundingBox &influence = this->primitiveBounds[id];
+			const ValueType k = std::max(primitive.blend, 0.0f);
+			const ValueType kInv = (k > 0.0f ? 1.0f / k : 0.0f);
+			switch (primitive.operation)
+			{
+			case Primitive::Operation::Union:
+				for (ur_uint i = 0; i < count; ++i)
+				{
+					if (influence.Intersects(points[i]))
+						values[i] = std::max(values[i], EvaluatePrimitive(primitive, points[i]));
+				}
+				break;
+			case Primitive::Operation::Subtract:
+				for (ur_uint i = 0; i < count; ++i)
+				{
+					if (influence.Intersects(points[i]))
+						values[i] = std::min(values[i], -EvaluatePrimitive(primitive, points[i]));
+				}
+				break;
+			case Primitive::Operation::SmoothUnion:
+				for (ur_uint i = 0; i < count; ++i)
+				{
+					if (!influence.Intersects(points[i]))
+						continue;
+					ValueType s = EvaluatePrimitive(primitive, points[i]);
+					ValueType h = std::max(k - std::fabs(values[i] - s), 0.0f) * kInv;
+					values[i] = std::max(values[i], s) + h * h * k * 0.25f;
+				}
+				break;
+			case Primitive::Operation::SmoothSubtract:
+				for (ur_uint i = 0; i < count; ++i)
+				{
+					if (!influence.Intersects(points[i]))
+						continue;
+					ValueType s = -EvaluatePrimitive(primitive, points[i]);
+					ValueType h = std::max(k - std::fabs(values[i] - s), 0.0f) * kInv;
+					values[i] = std::min(values[i], s) - h * h * k * 0.25f;
+				}
+				break;
+			}
 		}
-		else
+		for (ur_uint i = 0; i < count; ++i)
 		{
-			node->Merge();
+			values[i] = std::min(std::max(values[i], -margin), margin);
 		}
 
-		return res;
+		return Result(additive ? Success : NotFound);
 	}
 
-	Result Isosurface::HybridCubes::BuildMesh(Tetrahedron *tetrahedron, Stats *stats)
-	{
-		Result res = Result(Success);
-		if (ur_null == tetrahedron)
-			return res;
 
-		for (auto &hexahedron : tetrahedron->hexahedra)
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// Isosurface::ProceduralGenerator
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	Isosurface::ProceduralGenerator::ProceduralGenerator(Isosurface &isosurface, const Algorithm &algorithm, const GenerateParams &generateParams) :
+		DataVolume(isosurface)
+	{
+		this->bound = generateParams.bound;
+		this->algorithm = algorithm;
+		switch (this->algorithm)
 		{
-			res &= this->MarchCubes(hexahedron);
+		case Algorithm::SphericalDistanceField: this->generateParams.reset(new SphericalDistanceFieldParams((const SphericalDistanceFieldParams&)generateParams)); break;
+		case Algorithm::SimplexNoise: this->generateParams.reset(new SimplexNoiseParams((const SimplexNoiseParams&)generateParams)); break;
 		}
+	}
 
-		tetrahedron->initialized = Succeeded(res);
+	Isosurface::ProceduralGenerator::~ProceduralGenerator()
+	{
 
-		// update stats
-		if (stats != ur_null && tetrahedron->initialized)
+	}
+
+	ur_uint64 Isosurface::ProceduralGenerator::GetContentHash() const
+	{
+		// generated content is fully defined by the algorithm and its parameters
+		std::vector<ur_byte> data;
+		auto append = [&data](const void *ptr, ur_size size) {
+			data.insert(data.end(), (const ur_byte*)ptr, (const ur_byte*)ptr + size);
+		};
+		append(&this->algorithm, sizeof(this->algorithm));
+		append(&this->generateParams->bound, sizeof(BoundingBox));
+		switch (this->algorithm)
 		{
-			for (const auto &h : tetrahedron->hexahedra)
-			{
-				#if defined(UR_GRAF)
-				if (h.grafMesh.VB) stats->meshVideoMemory += (ur_uint)h.grafMesh.VB->GetDesc().SizeInBytes;
-				if (h.grafMesh.IB) stats->meshVideoMemory += (ur_uint)h.grafMesh.IB->GetDesc().SizeInBytes;
-				#else
-				if (h.gfxMesh.VB) stats->meshVideoMemory += h.gfxMesh.VB->GetDesc().Size;
-				if (h.gfxMesh.IB) stats->meshVideoMemory += h.gfxMesh.IB->GetDesc().Size;
-				#endif
-			}
+		case Algorithm::SphericalDistanceField:
+		{
+			const SphericalDistanceFieldParams &params = (const SphericalDistanceFieldParams&)*this->generateParams;
+			append(&params.center, sizeof(params.center));
+			append(&params.radius, sizeof(params.radius));
+		} break;
+		case Algorithm::SimplexNoise:
+		{
+			const SimplexNoiseParams &params = (const SimplexNoiseParams&)*this->generateParams;
+			append(&params.radiusMin, sizeof(params.radiusMin));
+			append(&params.radiusMax, sizeof(params.radiusMax));
+			append(params.octaves.data(), params.octaves.size() * sizeof(SimplexNoiseParams::Octave));
+		} break;
 		}
-
-		return res;
+		return ur_uint64(ComputeHash(data.data(), data.size()));
 	}
 
-	// Marching cubes lookup tables
+	Result Isosurface::ProceduralGenerator::Read(ValueType *values, const ur_float3 *points, const ur_uint count, const BoundingBox &bbox)
+	{
+		// todo: implement optimized sampling
+		// do early exit (return NotFound result) if we it is obious that isosurface does not intersect bbox
 
-	static const ur_uint MCEdgeVertices[12][2] = {
-		{ 0, 1 }, { 1, 2 }, { 2, 3 }, { 3, 0 },
-		{ 4, 5 }, { 5, 6 }, { 6, 7 }, { 7, 4 },
-		{ 0, 4 }, { 1, 5 }, { 2, 6 }, { 3, 7 }
-	};
+		Result res = Result(Success);
 
-	static const ur_uint MCEdgeTable[256] =
-	{
-		0x000, 0x109, 0x203, 0x30a, 0x406, 0x50f, 0x605, 0x70c, 0x80c, 0x905, 0xa0f, 0xb06, 0xc0a, 0xd03, 0xe09, 0xf00,
-		0x190, 0x099, 0x393, 0x29a, 0x596, 0x49f, 0x795, 0x69c, 0x99c, 0x895, 0xb9f, 0xa96, 0xd9a, 0xc93, 0xf99, 0xe90,
-		0x230, 0x339, 0x033, 0x13a, 0x636, 0x73f, 0x435, 0x53c, 0xa3c, 0xb35, 0x83f, 0x936, 0xe3a, 0xf33, 0xc39, 0xd30,
-		0x3a0, 0x2a9, 0x1a3, 0x0aa, 0x7a6, 0x6af, 0x5a5, 0x4ac, 0xbac, 0xaa5, 0x9af, 0x8a6, 0xfaa, 0xea3, 0xda9, 0xca0,
-		0x460, 0x569, 0x663, 0x76a, 0x066, 0x16f, 0x265, 0x36c, 0xc6c, 0xd65, 0xe6f, 0xf66, 0x86a, 0x963, 0xa69, 0xb60,
-		0x5f0, 0x4f9, 0x7f3, 0x6fa, 0x1f6, 0x0ff, 0x3f5, 0x2fc, 0xdfc, 0xcf5, 0xfff, 0xef6, 0x9fa, 0x8f3, 0xbf9, 0xaf0,
-		0x650, 0x759, 0x453, 0x55a, 0x256, 0x35f, 0x055, 0x15c, 0xe5c, 0xf55, 0xc5f, 0xd56, 0xa5a, 0xb53, 0x859, 0x950,
-		0x7c0, 0x6c9, 0x5c3, 0x4ca, 0x3c6, 0x2cf, 0x1c5, 0x0cc, 0xfcc, 0xec5, 0xdcf, 0xcc6, 0xbca, 0xac3, 0x9c9, 0x8c0,
-		0x8c0, 0x9c9, 0xac3, 0xbca, 0xcc6, 0xdcf, 0xec5, 0xfcc, 0x0cc, 0x1c5, 0x2cf, 0x3c6, 0x4ca, 0x5c3, 0x6c9, 0x7c0,
-		0x950, 0x859, 0xb53, 0xa5a, 0xd56, 0xc5f, 0xf55, 0xe5c, 0x15c, 0x055, 0x35f, 0x256, 0x55a, 0x453, 0x759, 0x650,
-		0xaf0, 0xbf9, 0x8f3, 0x9fa, 0xef6, 0xfff, 0xcf5, 0xdfc, 0x2fc, 0x3f5, 0x0ff, 0x1f6, 0x6fa, 0x7f3, 0x4f9, 0x5f0,
-		0xb60, 0xa69, 0x963, 0x86a, 0xf66, 0xe6f, 0xd65, 0xc6c, 0x36c, 0x265, 0x16f, 0x066, 0x76a, 0x663, 0x569, 0x460,
-		0xca0, 0xda9, 0xea3, 0xfaa, 0x8a6, 0x9af, 0xaa5, 0xbac, 0x4ac, 0x5a5, 0x6af, 0x7a6, 0x0aa, 0x1a3, 0x2a9, 0x3a0,
-		0xd30, 0xc39, 0xf33, 0xe3a, 0x936, 0x83f, 0xb35, 0xa3c, 0x53c, 0x435, 0x73f, 0x636, 0x13a, 0x033, 0x339, 0x230,
-		0xe90, 0xf99, 0xc93, 0xd9a, 0xa96, 0xb9f, 0x895, 0x99c, 0x69c, 0x795, 0x49f, 0x596, 0x29a, 0x393, 0x099, 0x190,
-		0xf00, 0xe09, 0xd03, 0xc0a, 0xb06, 0xa0f, 0x905, 0x80c, 0x70c, 0x605, 0x50f, 0x406, 0x30a, 0x203, 0x109, 0x000
-	};
+		// choose algorithm and generate a value
+		switch (this->algorithm)
+		{
+		case Algorithm::SphericalDistanceField:
+		{
+			res = this->GenerateSphericalDistanceField(values, points, count, bbox);
+		} break;
+		case Algorithm::SimplexNoise:
+		{
+			res = this->GenerateSimplexNoise(values, points, count, bbox);
+		} break;
+		default:
+		{
+			res = Result(NotImplemented);
+		}
+		}
 
-	static const ur_int MCTriangleTable[256][16] =
+		return res;
+	}
+
+	Result Isosurface::ProceduralGenerator::GenerateSphericalDistanceField(ValueType *values, const ur_float3 *points, const ur_uint count, const BoundingBox &bbox)
 	{
-		{ -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 0, 8, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 0, 1, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 1, 8, 3, 9, 8, 1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 1, 2, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 0, 8, 3, 1, 2, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 9, 2, 10, 0, 2, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 2, 8, 3, 2, 10, 8, 10, 9, 8, -1, -1, -1, -1, -1, -1, -1 },
-		{ 3, 11, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 0, 11, 2, 8, 11, 0, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 1, 9, 0, 2, 3, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 1, 11, 2, 1, 9, 11, 9, 8, 11, -1, -1, -1, -1, -1, -1, -1 },
-		{ 3, 10, 1, 11, 10, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 0, 10, 1, 0, 8, 10, 8, 11, 10, -1, -1, -1, -1, -1, -1, -1 },
-		{ 3, 9, 0, 3, 11, 9, 11, 10, 9, -1, -1, -1, -1, -1, -1, -1 },
-		{ 9, 8, 10, 10, 8, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 4, 7, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 4, 3, 0, 7, 3, 4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 0, 1, 9, 8, 4, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 4, 1, 9, 4, 7, 1, 7, 3, 1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 1, 2, 10, 8, 4, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 3, 4, 7, 3, 0, 4, 1, 2, 10, -1, -1, -1, -1, -1, -1, -1 },
-		{ 9, 2, 10, 9, 0, 2, 8, 4, 7, -1, -1, -1, -1, -1, -1, -1 },
-		{ 2, 10, 9, 2, 9, 7, 2, 7, 3, 7, 9, 4, -1, -1, -1, -1 },
-		{ 8, 4, 7, 3, 11, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 11, 4, 7, 11, 2, 4, 2, 0, 4, -1, -1, -1, -1, -1, -1, -1 },
-		{ 9, 0, 1, 8, 4, 7, 2, 3, 11, -1, -1, -1, -1, -1, -1, -1 },
-		{ 4, 7, 11, 9, 4, 11, 9, 11, 2, 9, 2, 1, -1, -1, -1, -1 },
-		{ 3, 10, 1, 3, 11, 10, 7, 8, 4, -1, -1, -1, -1, -1, -1, -1 },
-		{ 1, 11, 10, 1, 4, 11, 1, 0, 4, 7, 11, 4, -1, -1, -1, -1 },
-		{ 4, 7, 8, 9, 0, 11, 9, 11, 10, 11, 0, 3, -1, -1, -1, -1 },
-		{ 4, 7, 11, 4, 11, 9, 9, 11, 10, -1, -1, -1, -1, -1, -1, -1 },
-		{ 9, 5, 4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 9, 5, 4, 0, 8, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 0, 5, 4, 1, 5, 0, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 8, 5, 4, 8, 3, 5, 3, 1, 5, -1, -1, -1, -1, -1, -1, -1 },
-		{ 1, 2, 10, 9, 5, 4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 3, 0, 8, 1, 2, 10, 4, 9, 5, -1, -1, -1, -1, -1, -1, -1 },
-		{ 5, 2, 10, 5, 4, 2, 4, 0, 2, -1, -1, -1, -1, -1, -1, -1 },
-		{ 2, 10, 5, 3, 2, 5, 3, 5, 4, 3, 4, 8, -1, -1, -1, -1 },
-		{ 9, 5, 4, 2, 3, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 0, 11, 2, 0, 8, 11, 4, 9, 5, -1, -1, -1, -1, -1, -1, -1 },
-		{ 0, 5, 4, 0, 1, 5, 2, 3, 11, -1, -1, -1, -1, -1, -1, -1 },
-		{ 2, 1, 5, 2, 5, 8, 2, 8, 11, 4, 8, 5, -1, -1, -1, -1 },
-		{ 10, 3, 11, 10, 1, 3, 9, 5, 4, -1, -1, -1, -1, -1, -1, -1 },
-		{ 4, 9, 5, 0, 8, 1, 8, 10, 1, 8, 11, 10, -1, -1, -1, -1 },
-		{ 5, 4, 0, 5, 0, 11, 5, 11, 10, 11, 0, 3, -1, -1, -1, -1 },
-		{ 5, 4, 8, 5, 8, 10, 10, 8, 11, -1, -1, -1, -1, -1, -1, -1 },
-		{ 9, 7, 8, 5, 7, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 9, 3, 0, 9, 5, 3, 5, 7, 3, -1, -1, -1, -1, -1, -1, -1 },
-		{ 0, 7, 8, 0, 1, 7, 1, 5, 7, -1, -1, -1, -1, -1, -1, -1 },
-		{ 1, 5, 3, 3, 5, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 9, 7, 8, 9, 5, 7, 10, 1, 2, -1, -1, -1, -1, -1, -1, -1 },
-		{ 10, 1, 2, 9, 5, 0, 5, 3, 0, 5, 7, 3, -1, -1, -1, -1 },
-		{ 8, 0, 2, 8, 2, 5, 8, 5, 7, 10, 5, 2, -1, -1, -1, -1 },
-		{ 2, 10, 5, 2, 5, 3, 3, 5, 7, -1, -1, -1, -1, -1, -1, -1 },
-		{ 7, 9, 5, 7, 8, 9, 3, 11, 2, -1, -1, -1, -1, -1, -1, -1 },
-		{ 9, 5, 7, 9, 7, 2, 9, 2, 0, 2, 7, 11, -1, -1, -1, -1 },
-		{ 2, 3, 11, 0, 1, 8, 1, 7, 8, 1, 5, 7, -1, -1, -1, -1 },
-		{ 11, 2, 1, 11, 1, 7, 7, 1, 5, -1, -1, -1, -1, -1, -1, -1 },
-		{ 9, 5, 8, 8, 5, 7, 10, 1, 3, 10, 3, 11, -1, -1, -1, -1 },
-		{ 5, 7, 0, 5, 0, 9, 7, 11, 0, 1, 0, 10, 11, 10, 0, -1 },
-		{ 11, 10, 0, 11, 0, 3, 10, 5, 0, 8, 0, 7, 5, 7, 0, -1 },
-		{ 11, 10, 5, 7, 11, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 10, 6, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 0, 8, 3, 5, 10, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 9, 0, 1, 5, 10, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 1, 8, 3, 1, 9, 8, 5, 10, 6, -1, -1, -1, -1, -1, -1, -1 },
-		{ 1, 6, 5, 2, 6, 1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 1, 6, 5, 1, 2, 6, 3, 0, 8, -1, -1, -1, -1, -1, -1, -1 },
-		{ 9, 6, 5, 9, 0, 6, 0, 2, 6, -1, -1, -1, -1, -1, -1, -1 },
-		{ 5, 9, 8, 5, 8, 2, 5, 2, 6, 3, 2, 8, -1, -1, -1, -1 },
-		{ 2, 3, 11, 10, 6, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 11, 0, 8, 11, 2, 0, 10, 6, 5, -1, -1, -1, -1, -1, -1, -1 },
-		{ 0, 1, 9, 2, 3, 11, 5, 10, 6, -1, -1, -1, -1, -1, -1, -1 },
-		{ 5, 10, 6, 1, 9, 2, 9, 11, 2, 9, 8, 11, -1, -1, -1, -1 },
-		{ 6, 3, 11, 6, 5, 3, 5, 1, 3, -1, -1, -1, -1, -1, -1, -1 },
-		{ 0, 8, 11, 0, 11, 5, 0, 5, 1, 5, 11, 6, -1, -1, -1, -1 },
-		{ 3, 11, 6, 0, 3, 6, 0, 6, 5, 0, 5, 9, -1, -1, -1, -1 },
-		{ 6, 5, 9, 6, 9, 11, 11, 9, 8, -1, -1, -1, -1, -1, -1, -1 },
-		{ 5, 10, 6, 4, 7, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 4, 3, 0, 4, 7, 3, 6, 5, 10, -1, -1, -1, -1, -1, -1, -1 },
-		{ 1, 9, 0, 5, 10, 6, 8, 4, 7, -1, -1, -1, -1, -1, -1, -1 },
-		{ 10, 6, 5, 1, 9, 7, 1, 7, 3, 7, 9, 4, -1, -1, -1, -1 },
-		{ 6, 1, 2, 6, 5, 1, 4, 7, 8, -1, -1, -1, -1, -1, -1, -1 },
-		{ 1, 2, 5, 5, 2, 6, 3, 0, 4, 3, 4, 7, -1, -1, -1, -1 },
-		{ 8, 4, 7, 9, 0, 5, 0, 6, 5, 0, 2, 6, -1, -1, -1, -1 },
-		{ 7, 3, 9, 7, 9, 4, 3, 2, 9, 5, 9, 6, 2, 6, 9, -1 },
-		{ 3, 11, 2, 7, 8, 4, 10, 6, 5, -1, -1, -1, -1, -1, -1, -1 },
-		{ 5, 10, 6, 4, 7, 2, 4, 2, 0, 2, 7, 11, -1, -1, -1, -1 },
-		{ 0, 1, 9, 4, 7, 8, 2, 3, 11, 5, 10, 6, -1, -1, -1, -1 },
-		{ 9, 2, 1, 9, 11, 2, 9, 4, 11, 7, 11, 4, 5, 10, 6, -1 },
-		{ 8, 4, 7, 3, 11, 5, 3, 5, 1, 5, 11, 6, -1, -1, -1, -1 },
-		{ 5, 1, 11, 5, 11, 6, 1, 0, 11, 7, 11, 4, 0, 4, 11, -1 },
-		{ 0, 5, 9, 0, 6, 5, 0, 3, 6, 11, 6, 3, 8, 4, 7, -1 },
-		{ 6, 5, 9, 6, 9, 11, 4, 7, 9, 7, 11, 9, -1, -1, -1, -1 },
-		{ 10, 4, 9, 6, 4, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 4, 10, 6, 4, 9, 10, 0, 8, 3, -1, -1, -1, -1, -1, -1, -1 },
-		{ 10, 0, 1, 10, 6, 0, 6, 4, 0, -1, -1, -1, -1, -1, -1, -1 },
-		{ 8, 3, 1, 8, 1, 6, 8, 6, 4, 6, 1, 10, -1, -1, -1, -1 },
-		{ 1, 4, 9, 1, 2, 4, 2, 6, 4, -1, -1, -1, -1, -1, -1, -1 },
-		{ 3, 0, 8, 1, 2, 9, 2, 4, 9, 2, 6, 4, -1, -1, -1, -1 },
-		{ 0, 2, 4, 4, 2, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 8, 3, 2, 8, 2, 4, 4, 2, 6, -1, -1, -1, -1, -1, -1, -1 },
-		{ 10, 4, 9, 10, 6, 4, 11, 2, 3, -1, -1, -1, -1, -1, -1, -1 },
-		{ 0, 8, 2, 2, 8, 11, 4, 9, 10, 4, 10, 6, -1, -1, -1, -1 },
-		{ 3, 11, 2, 0, 1, 6, 0, 6, 4, 6, 1, 10, -1, -1, -1, -1 },
-		{ 6, 4, 1, 6, 1, 10, 4, 8, 1, 2, 1, 11, 8, 11, 1, -1 },
-		{ 9, 6, 4, 9, 3, 6, 9, 1, 3, 11, 6, 3, -1, -1, -1, -1 },
-		{ 8, 11, 1, 8, 1, 0, 11, 6, 1, 9, 1, 4, 6, 4, 1, -1 },
-		{ 3, 11, 6, 3, 6, 0, 0, 6, 4, -1, -1, -1, -1, -1, -1, -1 },
-		{ 6, 4, 8, 11, 6, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 7, 10, 6, 7, 8, 10, 8, 9, 10, -1, -1, -1, -1, -1, -1, -1 },
-		{ 0, 7, 3, 0, 10, 7, 0, 9, 10, 6, 7, 10, -1, -1, -1, -1 },
-		{ 10, 6, 7, 1, 10, 7, 1, 7, 8, 1, 8, 0, -1, -1, -1, -1 },
-		{ 10, 6, 7, 10, 7, 1, 1, 7, 3, -1, -1, -1, -1, -1, -1, -1 },
-		{ 1, 2, 6, 1, 6, 8, 1, 8, 9, 8, 6, 7, -1, -1, -1, -1 },
-		{ 2, 6, 9, 2, 9, 1, 6, 7, 9, 0, 9, 3, 7, 3, 9, -1 },
-		{ 7, 8, 0, 7, 0, 6, 6, 0, 2, -1, -1, -1, -1, -1, -1, -1 },
-		{ 7, 3, 2, 6, 7, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 2, 3, 11, 10, 6, 8, 10, 8, 9, 8, 6, 7, -1, -1, -1, -1 },
-		{ 2, 0, 7, 2, 7, 11, 0, 9, 7, 6, 7, 10, 9, 10, 7, -1 },
-		{ 1, 8, 0, 1, 7, 8, 1, 10, 7, 6, 7, 10, 2, 3, 11, -1 },
-		{ 11, 2, 1, 11, 1, 7, 10, 6, 1, 6, 7, 1, -1, -1, -1, -1 },
-		{ 8, 9, 6, 8, 6, 7, 9, 1, 6, 11, 6, 3, 1, 3, 6, -1 },
-		{ 0, 9, 1, 11, 6, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 7, 8, 0, 7, 0, 6, 3, 11, 0, 11, 6, 0, -1, -1, -1, -1 },
-		{ 7, 11, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 7, 6, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 3, 0, 8, 11, 7, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 0, 1, 9, 11, 7, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 8, 1, 9, 8, 3, 1, 11, 7, 6, -1, -1, -1, -1, -1, -1, -1 },
-		{ 10, 1, 2, 6, 11, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 1, 2, 10, 3, 0, 8, 6, 11, 7, -1, -1, -1, -1, -1, -1, -1 },
-		{ 2, 9, 0, 2, 10, 9, 6, 11, 7, -1, -1, -1, -1, -1, -1, -1 },
-		{ 6, 11, 7, 2, 10, 3, 10, 8, 3, 10, 9, 8, -1, -1, -1, -1 },
-		{ 7, 2, 3, 6, 2, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 7, 0, 8, 7, 6, 0, 6, 2, 0, -1, -1, -1, -1, -1, -1, -1 },
-		{ 2, 7, 6, 2, 3, 7, 0, 1, 9, -1, -1, -1, -1, -1, -1, -1 },
-		{ 1, 6, 2, 1, 8, 6, 1, 9, 8, 8, 7, 6, -1, -1, -1, -1 },
-		{ 10, 7, 6, 10, 1, 7, 1, 3, 7, -1, -1, -1, -1, -1, -1, -1 },
-		{ 10, 7, 6, 1, 7, 10, 1, 8, 7, 1, 0, 8, -1, -1, -1, -1 },
-		{ 0, 3, 7, 0, 7, 10, 0, 10, 9, 6, 10, 7, -1, -1, -1, -1 },
-		{ 7, 6, 10, 7, 10, 8, 8, 10, 9, -1, -1, -1, -1, -1, -1, -1 },
-		{ 6, 8, 4, 11, 8, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 3, 6, 11, 3, 0, 6, 0, 4, 6, -1, -1, -1, -1, -1, -1, -1 },
-		{ 8, 6, 11, 8, 4, 6, 9, 0, 1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 9, 4, 6, 9, 6, 3, 9, 3, 1, 11, 3, 6, -1, -1, -1, -1 },
-		{ 6, 8, 4, 6, 11, 8, 2, 10, 1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 1, 2, 10, 3, 0, 11, 0, 6, 11, 0, 4, 6, -1, -1, -1, -1 },
-		{ 4, 11, 8, 4, 6, 11, 0, 2, 9, 2, 10, 9, -1, -1, -1, -1 },
-		{ 10, 9, 3, 10, 3, 2, 9, 4, 3, 11, 3, 6, 4, 6, 3, -1 },
-		{ 8, 2, 3, 8, 4, 2, 4, 6, 2, -1, -1, -1, -1, -1, -1, -1 },
-		{ 0, 4, 2, 4, 6, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 1, 9, 0, 2, 3, 4, 2, 4, 6, 4, 3, 8, -1, -1, -1, -1 },
-		{ 1, 9, 4, 1, 4, 2, 2, 4, 6, -1, -1, -1, -1, -1, -1, -1 },
-		{ 8, 1, 3, 8, 6, 1, 8, 4, 6, 6, 10, 1, -1, -1, -1, -1 },
-		{ 10, 1, 0, 10, 0, 6, 6, 0, 4, -1, -1, -1, -1, -1, -1, -1 },
-		{ 4, 6, 3, 4, 3, 8, 6, 10, 3, 0, 3, 9, 10, 9, 3, -1 },
-		{ 10, 9, 4, 6, 10, 4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 4, 9, 5, 7, 6, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 0, 8, 3, 4, 9, 5, 11, 7, 6, -1, -1, -1, -1, -1, -1, -1 },
-		{ 5, 0, 1, 5, 4, 0, 7, 6, 11, -1, -1, -1, -1, -1, -1, -1 },
-		{ 11, 7, 6, 8, 3, 4, 3, 5, 4, 3, 1, 5, -1, -1, -1, -1 },
-		{ 9, 5, 4, 10, 1, 2, 7, 6, 11, -1, -1, -1, -1, -1, -1, -1 },
-		{ 6, 11, 7, 1, 2, 10, 0, 8, 3, 4, 9, 5, -1, -1, -1, -1 },
-		{ 7, 6, 11, 5, 4, 10, 4, 2, 10, 4, 0, 2, -1, -1, -1, -1 },
-		{ 3, 4, 8, 3, 5, 4, 3, 2, 5, 10, 5, 2, 11, 7, 6, -1 },
-		{ 7, 2, 3, 7, 6, 2, 5, 4, 9, -1, -1, -1, -1, -1, -1, -1 },
-		{ 9, 5, 4, 0, 8, 6, 0, 6, 2, 6, 8, 7, -1, -1, -1, -1 },
-		{ 3, 6, 2, 3, 7, 6, 1, 5, 0, 5, 4, 0, -1, -1, -1, -1 },
-		{ 6, 2, 8, 6, 8, 7, 2, 1, 8, 4, 8, 5, 1, 5, 8, -1 },
-		{ 9, 5, 4, 10, 1, 6, 1, 7, 6, 1, 3, 7, -1, -1, -1, -1 },
-		{ 1, 6, 10, 1, 7, 6, 1, 0, 7, 8, 7, 0, 9, 5, 4, -1 },
-		{ 4, 0, 10, 4, 10, 5, 0, 3, 10, 6, 10, 7, 3, 7, 10, -1 },
-		{ 7, 6, 10, 7, 10, 8, 5, 4, 10, 4, 8, 10, -1, -1, -1, -1 },
-		{ 6, 9, 5, 6, 11, 9, 11, 8, 9, -1, -1, -1, -1, -1, -1, -1 },
-		{ 3, 6, 11, 0, 6, 3, 0, 5, 6, 0, 9, 5, -1, -1, -1, -1 },
-		{ 0, 11, 8, 0, 5, 11, 0, 1, 5, 5, 6, 11, -1, -1, -1, -1 },
-		{ 6, 11, 3, 6, 3, 5, 5, 3, 1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 1, 2, 10, 9, 5, 11, 9, 11, 8, 11, 5, 6, -1, -1, -1, -1 },
-		{ 0, 11, 3, 0, 6, 11, 0, 9, 6, 5, 6, 9, 1, 2, 10, -1 },
-		{ 11, 8, 5, 11, 5, 6, 8, 0, 5, 10, 5, 2, 0, 2, 5, -1 },
-		{ 6, 11, 3, 6, 3, 5, 2, 10, 3, 10, 5, 3, -1, -1, -1, -1 },
-		{ 5, 8, 9, 5, 2, 8, 5, 6, 2, 3, 8, 2, -1, -1, -1, -1 },
-		{ 9, 5, 6, 9, 6, 0, 0, 6, 2, -1, -1, -1, -1, -1, -1, -1 },
-		{ 1, 5, 8, 1, 8, 0, 5, 6, 8, 3, 8, 2, 6, 2, 8, -1 },
-		{ 1, 5, 6, 2, 1, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 1, 3, 6, 1, 6, 10, 3, 8, 6, 5, 6, 9, 8, 9, 6, -1 },
-		{ 10, 1, 0, 10, 0, 6, 9, 5, 0, 5, 6, 0, -1, -1, -1, -1 },
-		{ 0, 3, 8, 5, 6, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 10, 5, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 11, 5, 10, 7, 5, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 11, 5, 10, 11, 7, 5, 8, 3, 0, -1, -1, -1, -1, -1, -1, -1 },
-		{ 5, 11, 7, 5, 10, 11, 1, 9, 0, -1, -1, -1, -1, -1, -1, -1 },
-		{ 10, 7, 5, 10, 11, 7, 9, 8, 1, 8, 3, 1, -1, -1, -1, -1 },
-		{ 11, 1, 2, 11, 7, 1, 7, 5, 1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 0, 8, 3, 1, 2, 7, 1, 7, 5, 7, 2, 11, -1, -1, -1, -1 },
-		{ 9, 7, 5, 9, 2, 7, 9, 0, 2, 2, 11, 7, -1, -1, -1, -1 },
-		{ 7, 5, 2, 7, 2, 11, 5, 9, 2, 3, 2, 8, 9, 8, 2, -1 },
-		{ 2, 5, 10, 2, 3, 5, 3, 7, 5, -1, -1, -1, -1, -1, -1, -1 },
-		{ 8, 2, 0, 8, 5, 2, 8, 7, 5, 10, 2, 5, -1, -1, -1, -1 },
-		{ 9, 0, 1, 5, 10, 3, 5, 3, 7, 3, 10, 2, -1, -1, -1, -1 },
-		{ 9, 8, 2, 9, 2, 1, 8, 7, 2, 10, 2, 5, 7, 5, 2, -1 },
-		{ 1, 3, 5, 3, 7, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 0, 8, 7, 0, 7, 1, 1, 7, 5, -1, -1, -1, -1, -1, -1, -1 },
-		{ 9, 0, 3, 9, 3, 5, 5, 3, 7, -1, -1, -1, -1, -1, -1, -1 },
-		{ 9, 8, 7, 5, 9, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 5, 8, 4, 5, 10, 8, 10, 11, 8, -1, -1, -1, -1, -1, -1, -1 },
-		{ 5, 0, 4, 5, 11, 0, 5, 10, 11, 11, 3, 0, -1, -1, -1, -1 },
-		{ 0, 1, 9, 8, 4, 10, 8, 10, 11, 10, 4, 5, -1, -1, -1, -1 },
-		{ 10, 11, 4, 10, 4, 5, 11, 3, 4, 9, 4, 1, 3, 1, 4, -1 },
-		{ 2, 5, 1, 2, 8, 5, 2, 11, 8, 4, 5, 8, -1, -1, -1, -1 },
-		{ 0, 4, 11, 0, 11, 3, 4, 5, 11, 2, 11, 1, 5, 1, 11, -1 },
-		{ 0, 2, 5, 0, 5, 9, 2, 11, 5, 4, 5, 8, 11, 8, 5, -1 },
-		{ 9, 4, 5, 2, 11, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 2, 5, 10, 3, 5, 2, 3, 4, 5, 3, 8, 4, -1, -1, -1, -1 },
-		{ 5, 10, 2, 5, 2, 4, 4, 2, 0, -1, -1, -1, -1, -1, -1, -1 },
-		{ 3, 10, 2, 3, 5, 10, 3, 8, 5, 4, 5, 8, 0, 1, 9, -1 },
-		{ 5, 10, 2, 5, 2, 4, 1, 9, 2, 9, 4, 2, -1, -1, -1, -1 },
-		{ 8, 4, 5, 8, 5, 3, 3, 5, 1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 0, 4, 5, 1, 0, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-		{ 8, 4, 5, 8, 5, 3, 9, 0, 5, 0, 3, 5, -1, -1, -1, -1 },
-		{ 9, 4, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		const SphericalDistanceFieldParams &params = static_cast<const SphericalDistanceFieldParams&>(*this->generateParams.get());
+		ur_float radius = params.radius;
+		ur_float brad = (bbox.Max - bbox.Min).Length() * 0.5f;
+		ur_float dist = (bbox.Center() - params.center).Length();
+		if (dist + brad < radius ||
+			dist - brad > radius)
+			return Result(NotFound); // does not intersect isosurface
+
+		if (ur_null == values || ur_null == points || 0 == count)
+			return Result(InvalidArgs);
+
+		ValueType *p_value = values;
+		const ur_float3 *p_point = points;
+		for (ur_uint i = 0; i < count; ++i, ++p_value, ++p_point)
+		{
+			*p_value = params.radius - (*p_point - params.center).Length();
+		}
+
+		return Result(Success);
+	}
+
+	#define CAVE_TEST 1
+	Result Isosurface::ProceduralGenerator::GenerateSimplexNoise(ValueType *values, const ur_float3 *points, const ur_uint count, const BoundingBox &bbox)
+	{
+		const SimplexNoiseParams &params = static_cast<const SimplexNoiseParams&>(*this->generateParams.get());
+		ur_float3 center = params.bound.Center();
+		ur_float brad = (bbox.Max - bbox.Min).Length() * 0.5f;
+		ur_float dist = (bbox.Center() - center).Length();
+		#if (!CAVE_TEST)
+		if (dist + brad < params.radiusMin ||
+			dist - brad > params.radiusMax)
+			return Result(NotFound); // does not intersect isosurface
+		#endif
+
+		if (ur_null == values || ur_null == points || 0 == count)
+			return Result(InvalidArgs);
+
+		// temp
+		#if (CAVE_TEST)
+		std::vector<SimplexNoiseParams::Octave> cave_octaves = {
+			{ 0.800f, 6.0f, -1.0f, 1.0f },
+			{ 0.400f, 16.0f, -0.5f, 0.1f },
+			{ 0.10f, 64.0f, -1.0f, 0.2f },
+		};
+		#endif
+
+		SimplexNoise noise;
+		ur_float radius = (params.radiusMax + params.radiusMin) * 0.5f;
+		ur_float distMax = params.radiusMax - radius;
+		ValueType *p_value = values;
+		const ur_float3 *p_point = points;
+		for (ur_uint i = 0; i < count; ++i, ++p_value, ++p_point)
+		{
+			*p_value = radius - (*p_point - center).Length();
+			for (auto &octave : params.octaves)
+			{
+				ur_float val = (ur_float)noise.Noise(
+					ur_double(p_point->x / radius * octave.freq),
+					ur_double(p_point->y / radius * octave.freq),
+					ur_double(p_point->z / radius * octave.freq));
+				val *= 2.0f;
+				val = std::max(octave.clamp_min, val);
+				val = std::min(octave.clamp_max, val);
+				val *= octave.scale * distMax;
+				*p_value += val;
+			}
+			
+			#if (CAVE_TEST)
+			// test: caves
+			ur_float cave_value = 0.0f;
+			for (auto &octave : cave_octaves)
+			{
+				ur_float val = (ur_float)noise.Noise(
+					ur_double(p_point->x / radius * octave.freq),
+					ur_double(p_point->y / radius * octave.freq),
+					ur_double(p_point->z / radius * octave.freq));
+				val *= 2.0f;
+				//val = (0.07f - fabs(val));
+				//val = val + 0.2f;
+				val = std::max(octave.clamp_min, val);
+				val = std::min(octave.clamp_max, val);
+				val *= octave.scale * distMax;
+				cave_value += val;
+			}
+			//cave_value *= -1.0f;
+			ur_float d = std::max(0.0f, params.radiusMin - (*p_point - center).Length());
+			cave_value += d;
+			*p_value = std::min(*p_value, cave_value);
+			#endif
+		}
+
+		return Result(Success);
+	}
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// Isosurface::FileVolume
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	Isosurface::FileVolume::FileVolume(Isosurface &isosurface) :
+		DataVolume(isosurface)
+	{
+		this->header = FileHeader();
+	}
+
+	Isosurface::FileVolume::~FileVolume()
+	{
+
+	}
+
+	Result Isosurface::FileVolume::Open(const std::string &fileName)
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+
+		this->file.reset();
+		this->levels.clear();
+		this->blocks.clear();
+		this->blockCache.clear();
+		this->blockCacheOrder.clear();
+
+		Log &log = this->isosurface.GetRealm().GetLog();
+		auto &storage = this->isosurface.GetRealm().GetStorage();
+		std::unique_ptr<File> newFile;
+		Result res = storage.Open(newFile, fileName, ur_uint(StorageAccess::Binary) | ur_uint(StorageAccess::Read));
+		if (Failed(res))
+			return LogResult(Failure, log, Log::Error, "Isosurface::FileVolume::Open: failed to open " + fileName);
+
+		ur_size fileSize = newFile->GetSize();
+		res = newFile->Read(sizeof(FileHeader), (ur_byte*)&this->header);
+		if (Failed(res) ||
+			this->header.magic != FileMagic ||
+			this->header.version != FileVersion ||
+			0 == this->header.levelsCount ||
+			this->header.indexOffset + sizeof(FileBlock) * this->header.blocksCount > fileSize)
+			return LogResult(Failure, log, Log::Error, "Isosurface::FileVolume::Open: invalid file format " + fileName);
+
+		this->levels.resize(this->header.levelsCount);
+		res &= newFile->Read(sizeof(FileLevel) * this->levels.size(), (ur_byte*)this->levels.data());
+		this->blocks.resize(this->header.blocksCount);
+		res &= newFile->Seek((ur_size)this->header.indexOffset);
+		res &= newFile->Read(sizeof(FileBlock) * this->blocks.size(), (ur_byte*)this->blocks.data());
+		if (Failed(res))
+			return LogResult(Failure, log, Log::Error, "Isosurface::FileVolume::Open: failed to read " + fileName);
+
+		this->file = std::move(newFile);
+		this->bound = BoundingBox(this->header.boundMin, this->header.boundMax);
+
+		return Result(Success);
+	}
+
+	Result Isosurface::FileVolume::FetchBlock(std::shared_ptr<std::vector<ValueType>> &samples, const ur_uint blockId)
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+
+		auto it = this->blockCache.find(blockId);
+		if (it != this->blockCache.end())
+		{
+			samples = it->second;
+			return Result(Success);
+		}
+
+		if (ur_null == this->file)
+			return Result(NotInitialized);
+
+		const ur_uint3 blockSize = GetFileBlockSize(this->header);
+		std::shared_ptr<std::vector<ValueType>> blockSamples(new std::vector<ValueType>(blockSize.x * blockSize.y * blockSize.z));
+		Result res = this->file->Seek((ur_size)this->blocks[blockId].offset);
+		res &= this->file->Read(blockSamples->size() * sizeof(ValueType), (ur_byte*)blockSamples->data());
+		if (Failed(res))
+			return Result(Failure);
+
+		// evict the oldest block if cache is full
+		if (this->blockCacheOrder.size() >= BlockCacheSize)
+		{
+			this->blockCache.erase(this->blockCacheOrder.front());
+			this->blockCacheOrder.pop_front();
+		}
+		this->blockCache[blockId] = blockSamples;
+		this->blockCacheOrder.push_back(blockId);
+		samples = blockSamples;
+
+		return Result(Success);
+	}
+
+	ur_bool Isosurface::FileVolume::HasLevels() const
+	{
+		return (this->levels.size() > 1);
+	}
+
+	Result Isosurface::FileVolume::Read(ValueType *values, const ur_float3 *points, const ur_uint count, const BoundingBox &bbox)
+	{
+		return this->ReadLattice(values, points, count, bbox, 0.0f);
+	}
+
+	Result Isosurface::FileVolume::ReadLattice(ValueType *values, const ur_float3 *points, const ur_uint count, const BoundingBox &bbox, const ur_float cellSize)
+	{
+		if (this->levels.empty())
+			return Result(NotInitialized);
+
+		ur_float spacing = (cellSize > 0.0f ? cellSize : EstimateSpacing(bbox, count));
+		if (spacing <= 0.0f)
+			spacing = bbox.SizeMax() / std::max(std::max(this->header.blockResolution.x, this->header.blockResolution.y), this->header.blockResolution.z);
+		const ur_uint levelIdx = SelectFileLevel(this->header, this->levels.data(), spacing);
+		const FileLevel &level = this->levels[levelIdx];
+		const ur_uint3 blockSize = GetFileBlockSize(this->header);
+
+		// early isosurface intersection test
+		if (ur_null == values)
+			return TestFileBlocks(this->header, level, this->blocks.data(), bbox);
+
+		if (ur_null == points || 0 == count)
+			return Result(InvalidArgs);
+
+		Result res(Success);
+		ur_uint cachedBlockId = ur_uint(-1);
+		std::shared_ptr<std::vector<ValueType>> cachedSamples;
+		for (ur_uint i = 0; i < count; ++i)
+		{
+			ur_uint3 bp = GetFileBlockPos(this->header, level, points[i]);
+			ur_uint blockId = GetFileBlockId(level, bp);
+			const FileBlock &block = this->blocks[blockId];
+			if (block.flags & FileBlockConstant)
+			{
+				values[i] = block.constValue;
+				continue;
+			}
+			if (blockId != cachedBlockId)
+			{
+				res = this->FetchBlock(cachedSamples, blockId);
+				if (Failed(res))
+					return res;
+				cachedBlockId = blockId;
+			}
+			ur_float3 pos = (points[i] - this->header.boundMin) / level.cellSize - ToFloat3(bp * this->header.blockResolution) + ur_float(this->header.blockBorder);
+			values[i] = SampleFileBlock(cachedSamples->data(), blockSize, pos);
+		}
+
+		return res;
+	}
+
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// Isosurface::MappedVolume
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	Isosurface::MappedVolume::MappedVolume(Isosurface &isosurface) :
+		DataVolume(isosurface)
+	{
+		#if defined(_WINDOWS)
+		this->fileHandle = INVALID_HANDLE_VALUE;
+		this->mappingHandle = ur_null;
+		SYSTEM_INFO systemInfo;
+		GetSystemInfo(&systemInfo);
+		this->pageSize = (ur_size)systemInfo.dwPageSize;
+		#else
+		this->fileDesc = -1;
+		this->pageSize = (ur_size)sysconf(_SC_PAGESIZE);
+		#endif
+		this->mappedData = ur_null;
+		this->mappedSize = 0;
+		this->header = ur_null;
+		this->levels = ur_null;
+		this->blocks = ur_null;
+	}
+
+	Isosurface::MappedVolume::~MappedVolume()
+	{
+		this->Close();
+	}
+
+	Result Isosurface::MappedVolume::Open(const std::string &fileName)
+	{
+		this->Close();
+
+		std::lock_guard<std::mutex> lock(this->mutex);
+		Log &log = this->isosurface.GetRealm().GetLog();
+
+		// map the whole file into address space
+
+		#if defined(_WINDOWS)
+		this->fileHandle = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, ur_null, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, ur_null);
+		if (INVALID_HANDLE_VALUE == this->fileHandle)
+			return LogResult(Failure, log, Log::Error, "Isosurface::MappedVolume::Open: failed to open " + fileName);
+		LARGE_INTEGER fileSize;
+		if (!GetFileSizeEx(this->fileHandle, &fileSize))
+			return LogResult(Failure, log, Log::Error, "Isosurface::MappedVolume::Open: failed to get size of " + fileName);
+		this->mappedSize = (ur_size)fileSize.QuadPart;
+		this->mappingHandle = CreateFileMappingA(this->fileHandle, ur_null, PAGE_READONLY, 0, 0, ur_null);
+		if (ur_null == this->mappingHandle)
+			return LogResult(Failure, log, Log::Error, "Isosurface::MappedVolume::Open: failed to create mapping of " + fileName);
+		this->mappedData = (const ur_byte*)MapViewOfFile(this->mappingHandle, FILE_MAP_READ, 0, 0, 0);
+		if (ur_null == this->mappedData)
+			return LogResult(Failure, log, Log::Error, "Isosurface::MappedVolume::Open: failed to map " + fileName);
+		#else
+		this->fileDesc = open(fileName.c_str(), O_RDONLY);
+		if (this->fileDesc < 0)
+			return LogResult(Failure, log, Log::Error, "Isosurface::MappedVolume::Open: failed to open " + fileName);
+		struct stat fileStat;
+		if (fstat(this->fileDesc, &fileStat) != 0)
+			return LogResult(Failure, log, Log::Error, "Isosurface::MappedVolume::Open: failed to get size of " + fileName);
+		this->mappedSize = (ur_size)fileStat.st_size;
+		void *mappedPtr = mmap(ur_null, this->mappedSize, PROT_READ, MAP_SHARED, this->fileDesc, 0);
+		if (MAP_FAILED == mappedPtr)
+			return LogResult(Failure, log, Log::Error, "Isosurface::MappedVolume::Open: failed to map " + fileName);
+		this->mappedData = (const ur_byte*)mappedPtr;
+		madvise(mappedPtr, this->mappedSize, MADV_RANDOM);
+		#endif
+
+		// validate layout
+
+		const FileHeader *fileHeader = (const FileHeader*)this->mappedData;
+		if (this->mappedSize < sizeof(FileHeader) ||
+			fileHeader->magic != FileMagic ||
+			fileHeader->version != FileVersion ||
+			0 == fileHeader->levelsCount ||
+			sizeof(FileHeader) + sizeof(FileLevel) * fileHeader->levelsCount > this->mappedSize ||
+			fileHeader->indexOffset + sizeof(FileBlock) * fileHeader->blocksCount > this->mappedSize)
+			return LogResult(Failure, log, Log::Error, "Isosurface::MappedVolume::Open: invalid file format " + fileName);
+		if (fileHeader->indexOffset % alignof(FileBlock) != 0)
+			return LogResult(Failure, log, Log::Error, "Isosurface::MappedVolume::Open: misaligned block index, file must be saved again " + fileName);
+
+		const ur_uint3 blockSize = GetFileBlockSize(*fileHeader);
+		const ur_size blockDataSize = sizeof(ValueType) * blockSize.x * blockSize.y * blockSize.z;
+		const FileBlock *fileBlocks = (const FileBlock*)(this->mappedData + fileHeader->indexOffset);
+		for (ur_uint ib = 0; ib < fileHeader->blocksCount; ++ib)
+		{
+			if (!(fileBlocks[ib].flags & FileBlockConstant) &&
+				fileBlocks[ib].offset + blockDataSize > fileHeader->indexOffset)
+				return LogResult(Failure, log, Log::Error, "Isosurface::MappedVolume::Open: invalid block index in " + fileName);
+		}
+
+		this->header = fileHeader;
+		this->levels = (const FileLevel*)(this->mappedData + sizeof(FileHeader));
+		this->blocks = fileBlocks;
+		this->bound = BoundingBox(this->header->boundMin, this->header->boundMax);
+
+		return Result(Success);
+	}
+
+	Result Isosurface::MappedVolume::Close()
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+
+		this->residentOrder.clear();
+		this->residentBlocks.clear();
+		this->header = ur_null;
+		this->levels = ur_null;
+		this->blocks = ur_null;
+
+		#if defined(_WINDOWS)
+		if (this->mappedData != ur_null)
+		{
+			UnmapViewOfFile(this->mappedData);
+		}
+		if (this->mappingHandle != ur_null)
+		{
+			CloseHandle(this->mappingHandle);
+			this->mappingHandle = ur_null;
+		}
+		if (this->fileHandle != INVALID_HANDLE_VALUE)
+		{
+			CloseHandle(this->fileHandle);
+			this->fileHandle = INVALID_HANDLE_VALUE;
+		}
+		#else
+		if (this->mappedData != ur_null)
+		{
+			munmap((void*)this->mappedData, this->mappedSize);
+		}
+		if (this->fileDesc >= 0)
+		{
+			close(this->fileDesc);
+			this->fileDesc = -1;
+		}
+		#endif
+		this->mappedData = ur_null;
+		this->mappedSize = 0;
+
+		return Result(Success);
+	}
+
+	void Isosurface::MappedVolume::AdviseBlock(const FileBlock &block, bool willNeed)
+	{
+		const ur_uint3 blockSize = GetFileBlockSize(*this->header);
+		ur_size rangeBegin = (ur_size)block.offset;
+		ur_size rangeEnd = rangeBegin + sizeof(ValueType) * blockSize.x * blockSize.y * blockSize.z;
+		rangeBegin -= rangeBegin % this->pageSize;
+		#if defined(_WINDOWS)
+		if (willNeed)
+		{
+			WIN32_MEMORY_RANGE_ENTRY range;
+			range.VirtualAddress = (PVOID)(this->mappedData + rangeBegin);
+			range.NumberOfBytes = (SIZE_T)(rangeEnd - rangeBegin);
+			PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+		}
+		// note: released pages are trimmed from the working set by the OS
+		#else
+		// released range is shrunk to whole pages owned by the block to keep neighbours resident
+		if (!willNeed)
+		{
+			rangeBegin = (ur_size)block.offset + this->pageSize - 1;
+			rangeBegin -= rangeBegin % this->pageSize;
+			rangeEnd -= rangeEnd % this->pageSize;
+			if (rangeEnd <= rangeBegin)
+				return;
+		}
+		madvise((void*)(this->mappedData + rangeBegin), rangeEnd - rangeBegin, (willNeed ? MADV_WILLNEED : MADV_DONTNEED));
+		#endif
+	}
+
+	void Isosurface::MappedVolume::TouchBlock(const ur_uint blockId)
+	{
+		// must be called under lock
+		auto it = this->residentBlocks.find(blockId);
+		if (it != this->residentBlocks.end())
+		{
+			this->residentOrder.splice(this->residentOrder.end(), this->residentOrder, it->second);
+			return;
+		}
+
+		this->AdviseBlock(this->blocks[blockId], true);
+		this->residentOrder.push_back(blockId);
+		this->residentBlocks[blockId] = std::prev(this->residentOrder.end());
+
+		// release least recently used block
+		if (this->residentOrder.size() > ResidentBlocksMax)
+		{
+			ur_uint releasedId = this->residentOrder.front();
+			this->residentOrder.pop_front();
+			this->residentBlocks.erase(releasedId);
+			this->AdviseBlock(this->blocks[releasedId], false);
+		}
+	}
+
+	Result Isosurface::MappedVolume::Prefetch(const BoundingBox &bbox)
+	{
+		if (ur_null == this->header)
+			return Result(NotInitialized);
+
+		// most detailed level blocks are prefetched in the given region,
+		// coarser levels cover proportionally larger regions (same blocks count per level)
+		std::lock_guard<std::mutex> lock(this->mutex);
+		ur_float3 center = bbox.Center();
+		ur_float3 halfSize = (bbox.Max - bbox.Min) * 0.5f;
+		ur_uint prefetchBudget = ResidentBlocksMax / 2;
+		for (ur_uint il = this->header->levelsCount; il > 0 && prefetchBudget > 0; --il)
+		{
+			const FileLevel &level = this->levels[il - 1];
+			ur_float3 levelHalfSize = halfSize * ur_float(1 << (this->header->levelsCount - il));
+			ur_uint3 bpMin = GetFileBlockPos(*this->header, level, center - levelHalfSize);
+			ur_uint3 bpMax = GetFileBlockPos(*this->header, level, center + levelHalfSize);
+			for (ur_uint iz = bpMin.z; iz <= bpMax.z && prefetchBudget > 0; ++iz)
+			{
+				for (ur_uint iy = bpMin.y; iy <= bpMax.y && prefetchBudget > 0; ++iy)
+				{
+					for (ur_uint ix = bpMin.x; ix <= bpMax.x && prefetchBudget > 0; ++ix)
+					{
+						ur_uint blockId = GetFileBlockId(level, ur_uint3(ix, iy, iz));
+						if (this->blocks[blockId].flags & FileBlockConstant)
+							continue;
+						this->TouchBlock(blockId);
+						--prefetchBudget;
+					}
+				}
+			}
+		}
+
+		return Result(Success);
+	}
+
+	ur_bool Isosurface::MappedVolume::HasLevels() const
+	{
+		return (this->header != ur_null && this->header->levelsCount > 1);
+	}
+
+	Result Isosurface::MappedVolume::Read(ValueType *values, const ur_float3 *points, const ur_uint count, const BoundingBox &bbox)
+	{
+		return this->ReadLattice(values, points, count, bbox, 0.0f);
+	}
+
+	Result Isosurface::MappedVolume::ReadLattice(ValueType *values, const ur_float3 *points, const ur_uint count, const BoundingBox &bbox, const ur_float cellSize)
+	{
+		if (ur_null == this->header)
+			return Result(NotInitialized);
+
+		ur_float spacing = (cellSize > 0.0f ? cellSize : EstimateSpacing(bbox, count));
+		if (spacing <= 0.0f)
+			spacing = bbox.SizeMax() / std::max(std::max(this->header->blockResolution.x, this->header->blockResolution.y), this->header->blockResolution.z);
+		const ur_uint levelIdx = SelectFileLevel(*this->header, this->levels, spacing);
+		const FileLevel &level = this->levels[levelIdx];
+		const ur_uint3 blockSize = GetFileBlockSize(*this->header);
+
+		// early isosurface intersection test
+		if (ur_null == values)
+			return TestFileBlocks(*this->header, level, this->blocks, bbox);
+
+		if (ur_null == points || 0 == count)
+			return Result(InvalidArgs);
+
+		ur_uint cachedBlockId = ur_uint(-1);
+		const ValueType *cachedSamples = ur_null;
+		for (ur_uint i = 0; i < count; ++i)
+		{
+			ur_uint3 bp = GetFileBlockPos(*this->header, level, points[i]);
+			ur_uint blockId = GetFileBlockId(level, bp);
+			const FileBlock &block = this->blocks[blockId];
+			if (block.flags & FileBlockConstant)
+			{
+				values[i] = block.constValue;
+				continue;
+			}
+			if (blockId != cachedBlockId)
+			{
+				{
+					std::lock_guard<std::mutex> lock(this->mutex);
+					this->TouchBlock(blockId);
+				}
+				cachedSamples = this->GetBlockSamples(block);
+				cachedBlockId = blockId;
+			}
+			ur_float3 pos = (points[i] - this->header->boundMin) / level.cellSize - ToFloat3(bp * this->header->blockResolution) + ur_float(this->header->blockBorder);
+			values[i] = SampleFileBlock(cachedSamples, blockSize, pos);
+		}
+
+		return Result(Success);
+	}
+
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// Isosurface::MeshExtractor
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	// Marching cubes lookup tables
+
+	static const ur_uint MCEdgeVertices[12][2] = {
+		{ 0, 1 }, { 1, 2 }, { 2, 3 }, { 3, 0 },
+		{ 4, 5 }, { 5, 6 }, { 6, 7 }, { 7, 4 },
+		{ 0, 4 }, { 1, 5 }, { 2, 6 }, { 3, 7 }
+	};
+
+	static const ur_uint MCEdgeTable[256] =
+	{
+		0x000, 0x109, 0x203, 0x30a, 0x406, 0x50f, 0x605, 0x70c, 0x80c, 0x905, 0xa0f, 0xb06, 0xc0a, 0xd03, 0xe09, 0xf00,
+		0x190, 0x099, 0x393, 0x29a, 0x596, 0x49f, 0x795, 0x69c, 0x99c, 0x895, 0xb9f, 0xa96, 0xd9a, 0xc93, 0xf99, 0xe90,
+		0x230, 0x339, 0x033, 0x13a, 0x636, 0x73f, 0x435, 0x53c, 0xa3c, 0xb35, 0x83f, 0x936, 0xe3a, 0xf33, 0xc39, 0xd30,
+		0x3a0, 0x2a9, 0x1a3, 0x0aa, 0x7a6, 0x6af, 0x5a5, 0x4ac, 0xbac, 0xaa5, 0x9af, 0x8a6, 0xfaa, 0xea3, 0xda9, 0xca0,
+		0x460, 0x569, 0x663, 0x76a, 0x066, 0x16f, 0x265, 0x36c, 0xc6c, 0xd65, 0xe6f, 0xf66, 0x86a, 0x963, 0xa69, 0xb60,
+		0x5f0, 0x4f9, 0x7f3, 0x6fa, 0x1f6, 0x0ff, 0x3f5, 0x2fc, 0xdfc, 0xcf5, 0xfff, 0xef6, 0x9fa, 0x8f3, 0xbf9, 0xaf0,
+		0x650, 0x759, 0x453, 0x55a, 0x256, 0x35f, 0x055, 0x15c, 0xe5c, 0xf55, 0xc5f, 0xd56, 0xa5a, 0xb53, 0x859, 0x950,
+		0x7c0, 0x6c9, 0x5c3, 0x4ca, 0x3c6, 0x2cf, 0x1c5, 0x0cc, 0xfcc, 0xec5, 0xdcf, 0xcc6, 0xbca, 0xac3, 0x9c9, 0x8c0,
+		0x8c0, 0x9c9, 0xac3, 0xbca, 0xcc6, 0xdcf, 0xec5, 0xfcc, 0x0cc, 0x1c5, 0x2cf, 0x3c6, 0x4ca, 0x5c3, 0x6c9, 0x7c0,
+		0x950, 0x859, 0xb53, 0xa5a, 0xd56, 0xc5f, 0xf55, 0xe5c, 0x15c, 0x055, 0x35f, 0x256, 0x55a, 0x453, 0x759, 0x650,
+		0xaf0, 0xbf9, 0x8f3, 0x9fa, 0xef6, 0xfff, 0xcf5, 0xdfc, 0x2fc, 0x3f5, 0x0ff, 0x1f6, 0x6fa, 0x7f3, 0x4f9, 0x5f0,
+		0xb60, 0xa69, 0x963, 0x86a, 0xf66, 0xe6f, 0xd65, 0xc6c, 0x36c, 0x265, 0x16f, 0x066, 0x76a, 0x663, 0x569, 0x460,
+		0xca0, 0xda9, 0xea3, 0xfaa, 0x8a6, 0x9af, 0xaa5, 0xbac, 0x4ac, 0x5a5, 0x6af, 0x7a6, 0x0aa, 0x1a3, 0x2a9, 0x3a0,
+		0xd30, 0xc39, 0xf33, 0xe3a, 0x936, 0x83f, 0xb35, 0xa3c, 0x53c, 0x435, 0x73f, 0x636, 0x13a, 0x033, 0x339, 0x230,
+		0xe90, 0xf99, 0xc93, 0xd9a, 0xa96, 0xb9f, 0x895, 0x99c, 0x69c, 0x795, 0x49f, 0x596, 0x29a, 0x393, 0x099, 0x190,
+		0xf00, 0xe09, 0xd03, 0xc0a, 0xb06, 0xa0f, 0x905, 0x80c, 0x70c, 0x605, 0x50f, 0x406, 0x30a, 0x203, 0x109, 0x000
+	};
+
+	static const ur_int MCTriangleTable[256][16] =
+	{
+		{ -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 8, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 1, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 1, 8, 3, 9, 8, 1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 1, 2, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 8, 3, 1, 2, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 9, 2, 10, 0, 2, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 2, 8, 3, 2, 10, 8, 10, 9, 8, -1, -1, -1, -1, -1, -1, -1 },
+		{ 3, 11, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 11, 2, 8, 11, 0, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 1, 9, 0, 2, 3, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 1, 11, 2, 1, 9, 11, 9, 8, 11, -1, -1, -1, -1, -1, -1, -1 },
+		{ 3, 10, 1, 11, 10, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 10, 1, 0, 8, 10, 8, 11, 10, -1, -1, -1, -1, -1, -1, -1 },
+		{ 3, 9, 0, 3, 11, 9, 11, 10, 9, -1, -1, -1, -1, -1, -1, -1 },
+		{ 9, 8, 10, 10, 8, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 4, 7, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 4, 3, 0, 7, 3, 4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 1, 9, 8, 4, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 4, 1, 9, 4, 7, 1, 7, 3, 1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 1, 2, 10, 8, 4, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 3, 4, 7, 3, 0, 4, 1, 2, 10, -1, -1, -1, -1, -1, -1, -1 },
+		{ 9, 2, 10, 9, 0, 2, 8, 4, 7, -1, -1, -1, -1, -1, -1, -1 },
+		{ 2, 10, 9, 2, 9, 7, 2, 7, 3, 7, 9, 4, -1, -1, -1, -1 },
+		{ 8, 4, 7, 3, 11, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 11, 4, 7, 11, 2, 4, 2, 0, 4, -1, -1, -1, -1, -1, -1, -1 },
+		{ 9, 0, 1, 8, 4, 7, 2, 3, 11, -1, -1, -1, -1, -1, -1, -1 },
+		{ 4, 7, 11, 9, 4, 11, 9, 11, 2, 9, 2, 1, -1, -1, -1, -1 },
+		{ 3, 10, 1, 3, 11, 10, 7, 8, 4, -1, -1, -1, -1, -1, -1, -1 },
+		{ 1, 11, 10, 1, 4, 11, 1, 0, 4, 7, 11, 4, -1, -1, -1, -1 },
+		{ 4, 7, 8, 9, 0, 11, 9, 11, 10, 11, 0, 3, -1, -1, -1, -1 },
+		{ 4, 7, 11, 4, 11, 9, 9, 11, 10, -1, -1, -1, -1, -1, -1, -1 },
+		{ 9, 5, 4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 9, 5, 4, 0, 8, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 5, 4, 1, 5, 0, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 8, 5, 4, 8, 3, 5, 3, 1, 5, -1, -1, -1, -1, -1, -1, -1 },
+		{ 1, 2, 10, 9, 5, 4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 3, 0, 8, 1, 2, 10, 4, 9, 5, -1, -1, -1, -1, -1, -1, -1 },
+		{ 5, 2, 10, 5, 4, 2, 4, 0, 2, -1, -1, -1, -1, -1, -1, -1 },
+		{ 2, 10, 5, 3, 2, 5, 3, 5, 4, 3, 4, 8, -1, -1, -1, -1 },
+		{ 9, 5, 4, 2, 3, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 11, 2, 0, 8, 11, 4, 9, 5, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 5, 4, 0, 1, 5, 2, 3, 11, -1, -1, -1, -1, -1, -1, -1 },
+		{ 2, 1, 5, 2, 5, 8, 2, 8, 11, 4, 8, 5, -1, -1, -1, -1 },
+		{ 10, 3, 11, 10, 1, 3, 9, 5, 4, -1, -1, -1, -1, -1, -1, -1 },
+		{ 4, 9, 5, 0, 8, 1, 8, 10, 1, 8, 11, 10, -1, -1, -1, -1 },
+		{ 5, 4, 0, 5, 0, 11, 5, 11, 10, 11, 0, 3, -1, -1, -1, -1 },
+		{ 5, 4, 8, 5, 8, 10, 10, 8, 11, -1, -1, -1, -1, -1, -1, -1 },
+		{ 9, 7, 8, 5, 7, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 9, 3, 0, 9, 5, 3, 5, 7, 3, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 7, 8, 0, 1, 7, 1, 5, 7, -1, -1, -1, -1, -1, -1, -1 },
+		{ 1, 5, 3, 3, 5, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 9, 7, 8, 9, 5, 7, 10, 1, 2, -1, -1, -1, -1, -1, -1, -1 },
+		{ 10, 1, 2, 9, 5, 0, 5, 3, 0, 5, 7, 3, -1, -1, -1, -1 },
+		{ 8, 0, 2, 8, 2, 5, 8, 5, 7, 10, 5, 2, -1, -1, -1, -1 },
+		{ 2, 10, 5, 2, 5, 3, 3, 5, 7, -1, -1, -1, -1, -1, -1, -1 },
+		{ 7, 9, 5, 7, 8, 9, 3, 11, 2, -1, -1, -1, -1, -1, -1, -1 },
+		{ 9, 5, 7, 9, 7, 2, 9, 2, 0, 2, 7, 11, -1, -1, -1, -1 },
+		{ 2, 3, 11, 0, 1, 8, 1, 7, 8, 1, 5, 7, -1, -1, -1, -1 },
+		{ 11, 2, 1, 11, 1, 7, 7, 1, 5, -1, -1, -1, -1, -1, -1, -1 },
+		{ 9, 5, 8, 8, 5, 7, 10, 1, 3, 10, 3, 11, -1, -1, -1, -1 },
+		{ 5, 7, 0, 5, 0, 9, 7, 11, 0, 1, 0, 10, 11, 10, 0, -1 },
+		{ 11, 10, 0, 11, 0, 3, 10, 5, 0, 8, 0, 7, 5, 7, 0, -1 },
+		{ 11, 10, 5, 7, 11, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 10, 6, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 8, 3, 5, 10, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 9, 0, 1, 5, 10, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 1, 8, 3, 1, 9, 8, 5, 10, 6, -1, -1, -1, -1, -1, -1, -1 },
+		{ 1, 6, 5, 2, 6, 1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 1, 6, 5, 1, 2, 6, 3, 0, 8, -1, -1, -1, -1, -1, -1, -1 },
+		{ 9, 6, 5, 9, 0, 6, 0, 2, 6, -1, -1, -1, -1, -1, -1, -1 },
+		{ 5, 9, 8, 5, 8, 2, 5, 2, 6, 3, 2, 8, -1, -1, -1, -1 },
+		{ 2, 3, 11, 10, 6, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 11, 0, 8, 11, 2, 0, 10, 6, 5, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 1, 9, 2, 3, 11, 5, 10, 6, -1, -1, -1, -1, -1, -1, -1 },
+		{ 5, 10, 6, 1, 9, 2, 9, 11, 2, 9, 8, 11, -1, -1, -1, -1 },
+		{ 6, 3, 11, 6, 5, 3, 5, 1, 3, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 8, 11, 0, 11, 5, 0, 5, 1, 5, 11, 6, -1, -1, -1, -1 },
+		{ 3, 11, 6, 0, 3, 6, 0, 6, 5, 0, 5, 9, -1, -1, -1, -1 },
+		{ 6, 5, 9, 6, 9, 11, 11, 9, 8, -1, -1, -1, -1, -1, -1, -1 },
+		{ 5, 10, 6, 4, 7, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 4, 3, 0, 4, 7, 3, 6, 5, 10, -1, -1, -1, -1, -1, -1, -1 },
+		{ 1, 9, 0, 5, 10, 6, 8, 4, 7, -1, -1, -1, -1, -1, -1, -1 },
+		{ 10, 6, 5, 1, 9, 7, 1, 7, 3, 7, 9, 4, -1, -1, -1, -1 },
+		{ 6, 1, 2, 6, 5, 1, 4, 7, 8, -1, -1, -1, -1, -1, -1, -1 },
+		{ 1, 2, 5, 5, 2, 6, 3, 0, 4, 3, 4, 7, -1, -1, -1, -1 },
+		{ 8, 4, 7, 9, 0, 5, 0, 6, 5, 0, 2, 6, -1, -1, -1, -1 },
+		{ 7, 3, 9, 7, 9, 4, 3, 2, 9, 5, 9, 6, 2, 6, 9, -1 },
+		{ 3, 11, 2, 7, 8, 4, 10, 6, 5, -1, -1, -1, -1, -1, -1, -1 },
+		{ 5, 10, 6, 4, 7, 2, 4, 2, 0, 2, 7, 11, -1, -1, -1, -1 },
+		{ 0, 1, 9, 4, 7, 8, 2, 3, 11, 5, 10, 6, -1, -1, -1, -1 },
+		{ 9, 2, 1, 9, 11, 2, 9, 4, 11, 7, 11, 4, 5, 10, 6, -1 },
+		{ 8, 4, 7, 3, 11, 5, 3, 5, 1, 5, 11, 6, -1, -1, -1, -1 },
+		{ 5, 1, 11, 5, 11, 6, 1, 0, 11, 7, 11, 4, 0, 4, 11, -1 },
+		{ 0, 5, 9, 0, 6, 5, 0, 3, 6, 11, 6, 3, 8, 4, 7, -1 },
+		{ 6, 5, 9, 6, 9, 11, 4, 7, 9, 7, 11, 9, -1, -1, -1, -1 },
+		{ 10, 4, 9, 6, 4, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 4, 10, 6, 4, 9, 10, 0, 8, 3, -1, -1, -1, -1, -1, -1, -1 },
+		{ 10, 0, 1, 10, 6, 0, 6, 4, 0, -1, -1, -1, -1, -1, -1, -1 },
+		{ 8, 3, 1, 8, 1, 6, 8, 6, 4, 6, 1, 10, -1, -1, -1, -1 },
+		{ 1, 4, 9, 1, 2, 4, 2, 6, 4, -1, -1, -1, -1, -1, -1, -1 },
+		{ 3, 0, 8, 1, 2, 9, 2, 4, 9, 2, 6, 4, -1, -1, -1, -1 },
+		{ 0, 2, 4, 4, 2, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 8, 3, 2, 8, 2, 4, 4, 2, 6, -1, -1, -1, -1, -1, -1, -1 },
+		{ 10, 4, 9, 10, 6, 4, 11, 2, 3, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 8, 2, 2, 8, 11, 4, 9, 10, 4, 10, 6, -1, -1, -1, -1 },
+		{ 3, 11, 2, 0, 1, 6, 0, 6, 4, 6, 1, 10, -1, -1, -1, -1 },
+		{ 6, 4, 1, 6, 1, 10, 4, 8, 1, 2, 1, 11, 8, 11, 1, -1 },
+		{ 9, 6, 4, 9, 3, 6, 9, 1, 3, 11, 6, 3, -1, -1, -1, -1 },
+		{ 8, 11, 1, 8, 1, 0, 11, 6, 1, 9, 1, 4, 6, 4, 1, -1 },
+		{ 3, 11, 6, 3, 6, 0, 0, 6, 4, -1, -1, -1, -1, -1, -1, -1 },
+		{ 6, 4, 8, 11, 6, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 7, 10, 6, 7, 8, 10, 8, 9, 10, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 7, 3, 0, 10, 7, 0, 9, 10, 6, 7, 10, -1, -1, -1, -1 },
+		{ 10, 6, 7, 1, 10, 7, 1, 7, 8, 1, 8, 0, -1, -1, -1, -1 },
+		{ 10, 6, 7, 10, 7, 1, 1, 7, 3, -1, -1, -1, -1, -1, -1, -1 },
+		{ 1, 2, 6, 1, 6, 8, 1, 8, 9, 8, 6, 7, -1, -1, -1, -1 },
+		{ 2, 6, 9, 2, 9, 1, 6, 7, 9, 0, 9, 3, 7, 3, 9, -1 },
+		{ 7, 8, 0, 7, 0, 6, 6, 0, 2, -1, -1, -1, -1, -1, -1, -1 },
+		{ 7, 3, 2, 6, 7, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 2, 3, 11, 10, 6, 8, 10, 8, 9, 8, 6, 7, -1, -1, -1, -1 },
+		{ 2, 0, 7, 2, 7, 11, 0, 9, 7, 6, 7, 10, 9, 10, 7, -1 },
+		{ 1, 8, 0, 1, 7, 8, 1, 10, 7, 6, 7, 10, 2, 3, 11, -1 },
+		{ 11, 2, 1, 11, 1, 7, 10, 6, 1, 6, 7, 1, -1, -1, -1, -1 },
+		{ 8, 9, 6, 8, 6, 7, 9, 1, 6, 11, 6, 3, 1, 3, 6, -1 },
+		{ 0, 9, 1, 11, 6, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 7, 8, 0, 7, 0, 6, 3, 11, 0, 11, 6, 0, -1, -1, -1, -1 },
+		{ 7, 11, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 7, 6, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 3, 0, 8, 11, 7, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 1, 9, 11, 7, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 8, 1, 9, 8, 3, 1, 11, 7, 6, -1, -1, -1, -1, -1, -1, -1 },
+		{ 10, 1, 2, 6, 11, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 1, 2, 10, 3, 0, 8, 6, 11, 7, -1, -1, -1, -1, -1, -1, -1 },
+		{ 2, 9, 0, 2, 10, 9, 6, 11, 7, -1, -1, -1, -1, -1, -1, -1 },
+		{ 6, 11, 7, 2, 10, 3, 10, 8, 3, 10, 9, 8, -1, -1, -1, -1 },
+		{ 7, 2, 3, 6, 2, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 7, 0, 8, 7, 6, 0, 6, 2, 0, -1, -1, -1, -1, -1, -1, -1 },
+		{ 2, 7, 6, 2, 3, 7, 0, 1, 9, -1, -1, -1, -1, -1, -1, -1 },
+		{ 1, 6, 2, 1, 8, 6, 1, 9, 8, 8, 7, 6, -1, -1, -1, -1 },
+		{ 10, 7, 6, 10, 1, 7, 1, 3, 7, -1, -1, -1, -1, -1, -1, -1 },
+		{ 10, 7, 6, 1, 7, 10, 1, 8, 7, 1, 0, 8, -1, -1, -1, -1 },
+		{ 0, 3, 7, 0, 7, 10, 0, 10, 9, 6, 10, 7, -1, -1, -1, -1 },
+		{ 7, 6, 10, 7, 10, 8, 8, 10, 9, -1, -1, -1, -1, -1, -1, -1 },
+		{ 6, 8, 4, 11, 8, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 3, 6, 11, 3, 0, 6, 0, 4, 6, -1, -1, -1, -1, -1, -1, -1 },
+		{ 8, 6, 11, 8, 4, 6, 9, 0, 1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 9, 4, 6, 9, 6, 3, 9, 3, 1, 11, 3, 6, -1, -1, -1, -1 },
+		{ 6, 8, 4, 6, 11, 8, 2, 10, 1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 1, 2, 10, 3, 0, 11, 0, 6, 11, 0, 4, 6, -1, -1, -1, -1 },
+		{ 4, 11, 8, 4, 6, 11, 0, 2, 9, 2, 10, 9, -1, -1, -1, -1 },
+		{ 10, 9, 3, 10, 3, 2, 9, 4, 3, 11, 3, 6, 4, 6, 3, -1 },
+		{ 8, 2, 3, 8, 4, 2, 4, 6, 2, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 4, 2, 4, 6, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 1, 9, 0, 2, 3, 4, 2, 4, 6, 4, 3, 8, -1, -1, -1, -1 },
+		{ 1, 9, 4, 1, 4, 2, 2, 4, 6, -1, -1, -1, -1, -1, -1, -1 },
+		{ 8, 1, 3, 8, 6, 1, 8, 4, 6, 6, 10, 1, -1, -1, -1, -1 },
+		{ 10, 1, 0, 10, 0, 6, 6, 0, 4, -1, -1, -1, -1, -1, -1, -1 },
+		{ 4, 6, 3, 4, 3, 8, 6, 10, 3, 0, 3, 9, 10, 9, 3, -1 },
+		{ 10, 9, 4, 6, 10, 4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 4, 9, 5, 7, 6, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 8, 3, 4, 9, 5, 11, 7, 6, -1, -1, -1, -1, -1, -1, -1 },
+		{ 5, 0, 1, 5, 4, 0, 7, 6, 11, -1, -1, -1, -1, -1, -1, -1 },
+		{ 11, 7, 6, 8, 3, 4, 3, 5, 4, 3, 1, 5, -1, -1, -1, -1 },
+		{ 9, 5, 4, 10, 1, 2, 7, 6, 11, -1, -1, -1, -1, -1, -1, -1 },
+		{ 6, 11, 7, 1, 2, 10, 0, 8, 3, 4, 9, 5, -1, -1, -1, -1 },
+		{ 7, 6, 11, 5, 4, 10, 4, 2, 10, 4, 0, 2, -1, -1, -1, -1 },
+		{ 3, 4, 8, 3, 5, 4, 3, 2, 5, 10, 5, 2, 11, 7, 6, -1 },
+		{ 7, 2, 3, 7, 6, 2, 5, 4, 9, -1, -1, -1, -1, -1, -1, -1 },
+		{ 9, 5, 4, 0, 8, 6, 0, 6, 2, 6, 8, 7, -1, -1, -1, -1 },
+		{ 3, 6, 2, 3, 7, 6, 1, 5, 0, 5, 4, 0, -1, -1, -1, -1 },
+		{ 6, 2, 8, 6, 8, 7, 2, 1, 8, 4, 8, 5, 1, 5, 8, -1 },
+		{ 9, 5, 4, 10, 1, 6, 1, 7, 6, 1, 3, 7, -1, -1, -1, -1 },
+		{ 1, 6, 10, 1, 7, 6, 1, 0, 7, 8, 7, 0, 9, 5, 4, -1 },
+		{ 4, 0, 10, 4, 10, 5, 0, 3, 10, 6, 10, 7, 3, 7, 10, -1 },
+		{ 7, 6, 10, 7, 10, 8, 5, 4, 10, 4, 8, 10, -1, -1, -1, -1 },
+		{ 6, 9, 5, 6, 11, 9, 11, 8, 9, -1, -1, -1, -1, -1, -1, -1 },
+		{ 3, 6, 11, 0, 6, 3, 0, 5, 6, 0, 9, 5, -1, -1, -1, -1 },
+		{ 0, 11, 8, 0, 5, 11, 0, 1, 5, 5, 6, 11, -1, -1, -1, -1 },
+		{ 6, 11, 3, 6, 3, 5, 5, 3, 1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 1, 2, 10, 9, 5, 11, 9, 11, 8, 11, 5, 6, -1, -1, -1, -1 },
+		{ 0, 11, 3, 0, 6, 11, 0, 9, 6, 5, 6, 9, 1, 2, 10, -1 },
+		{ 11, 8, 5, 11, 5, 6, 8, 0, 5, 10, 5, 2, 0, 2, 5, -1 },
+		{ 6, 11, 3, 6, 3, 5, 2, 10, 3, 10, 5, 3, -1, -1, -1, -1 },
+		{ 5, 8, 9, 5, 2, 8, 5, 6, 2, 3, 8, 2, -1, -1, -1, -1 },
+		{ 9, 5, 6, 9, 6, 0, 0, 6, 2, -1, -1, -1, -1, -1, -1, -1 },
+		{ 1, 5, 8, 1, 8, 0, 5, 6, 8, 3, 8, 2, 6, 2, 8, -1 },
+		{ 1, 5, 6, 2, 1, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 1, 3, 6, 1, 6, 10, 3, 8, 6, 5, 6, 9, 8, 9, 6, -1 },
+		{ 10, 1, 0, 10, 0, 6, 9, 5, 0, 5, 6, 0, -1, -1, -1, -1 },
+		{ 0, 3, 8, 5, 6, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 10, 5, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 11, 5, 10, 7, 5, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 11, 5, 10, 11, 7, 5, 8, 3, 0, -1, -1, -1, -1, -1, -1, -1 },
+		{ 5, 11, 7, 5, 10, 11, 1, 9, 0, -1, -1, -1, -1, -1, -1, -1 },
+		{ 10, 7, 5, 10, 11, 7, 9, 8, 1, 8, 3, 1, -1, -1, -1, -1 },
+		{ 11, 1, 2, 11, 7, 1, 7, 5, 1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 8, 3, 1, 2, 7, 1, 7, 5, 7, 2, 11, -1, -1, -1, -1 },
+		{ 9, 7, 5, 9, 2, 7, 9, 0, 2, 2, 11, 7, -1, -1, -1, -1 },
+		{ 7, 5, 2, 7, 2, 11, 5, 9, 2, 3, 2, 8, 9, 8, 2, -1 },
+		{ 2, 5, 10, 2, 3, 5, 3, 7, 5, -1, -1, -1, -1, -1, -1, -1 },
+		{ 8, 2, 0, 8, 5, 2, 8, 7, 5, 10, 2, 5, -1, -1, -1, -1 },
+		{ 9, 0, 1, 5, 10, 3, 5, 3, 7, 3, 10, 2, -1, -1, -1, -1 },
+		{ 9, 8, 2, 9, 2, 1, 8, 7, 2, 10, 2, 5, 7, 5, 2, -1 },
+		{ 1, 3, 5, 3, 7, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 8, 7, 0, 7, 1, 1, 7, 5, -1, -1, -1, -1, -1, -1, -1 },
+		{ 9, 0, 3, 9, 3, 5, 5, 3, 7, -1, -1, -1, -1, -1, -1, -1 },
+		{ 9, 8, 7, 5, 9, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 5, 8, 4, 5, 10, 8, 10, 11, 8, -1, -1, -1, -1, -1, -1, -1 },
+		{ 5, 0, 4, 5, 11, 0, 5, 10, 11, 11, 3, 0, -1, -1, -1, -1 },
+		{ 0, 1, 9, 8, 4, 10, 8, 10, 11, 10, 4, 5, -1, -1, -1, -1 },
+		{ 10, 11, 4, 10, 4, 5, 11, 3, 4, 9, 4, 1, 3, 1, 4, -1 },
+		{ 2, 5, 1, 2, 8, 5, 2, 11, 8, 4, 5, 8, -1, -1, -1, -1 },
+		{ 0, 4, 11, 0, 11, 3, 4, 5, 11, 2, 11, 1, 5, 1, 11, -1 },
+		{ 0, 2, 5, 0, 5, 9, 2, 11, 5, 4, 5, 8, 11, 8, 5, -1 },
+		{ 9, 4, 5, 2, 11, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 2, 5, 10, 3, 5, 2, 3, 4, 5, 3, 8, 4, -1, -1, -1, -1 },
+		{ 5, 10, 2, 5, 2, 4, 4, 2, 0, -1, -1, -1, -1, -1, -1, -1 },
+		{ 3, 10, 2, 3, 5, 10, 3, 8, 5, 4, 5, 8, 0, 1, 9, -1 },
+		{ 5, 10, 2, 5, 2, 4, 1, 9, 2, 9, 4, 2, -1, -1, -1, -1 },
+		{ 8, 4, 5, 8, 5, 3, 3, 5, 1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 4, 5, 1, 0, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 8, 4, 5, 8, 5, 3, 9, 0, 5, 0, 3, 5, -1, -1, -1, -1 },
+		{ 9, 4, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
 		{ 4, 11, 7, 4, 9, 11, 9, 10, 11, -1, -1, -1, -1, -1, -1, -1 },
 		{ 0, 8, 3, 4, 9, 7, 9, 11, 7, 9, 10, 11, -1, -1, -1, -1 },
 		{ 1, 10, 11, 1, 11, 4, 1, 4, 0, 7, 4, 11, -1, -1, -1, -1 },
@@ -1498,7 +2635,3734 @@ namespace UnlimRealms
 		{ -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 }
 	};
 
-	Result Isosurface::HybridCubes::MarchCubes(Hexahedron &hexahedron)
+	void Isosurface::MeshExtractor::ComputeLattice(ur_float3 *points, const ur_float3 (&corners)[8], const ur_uint3 &resolution)
+	{
+		auto computeLinePoints = [](ur_float3 *points, const ur_uint count, const ur_uint step, const ur_float3 &p0, const ur_float3 &p1) {
+			ur_float s = ur_float(count - 1);
+			for (ur_uint i = 0; i < count; ++i)
+			{
+				ur_float3::Lerp(*points, p0, p1, ur_float(i) / s);
+				points += step;
+			}
+		};
+
+		ur_uint rowOfs = resolution.x;
+		ur_uint lastRowOfs = rowOfs * (resolution.y - 1);
+		ur_uint sliceOfs = rowOfs * resolution.y;
+		ur_uint lastSliceOfs = sliceOfs * (resolution.z - 1);
+
+		computeLinePoints(points, resolution.x, 1, corners[0], corners[1]);
+		computeLinePoints(points + lastRowOfs, resolution.x, 1, corners[2], corners[3]);
+		computeLinePoints(points + lastSliceOfs, resolution.x, 1, corners[4], corners[5]);
+		computeLinePoints(points + lastRowOfs + lastSliceOfs, resolution.x, 1, corners[6], corners[7]);
+		ur_float3 *p_col0 = points;
+		ur_float3 *p_col1 = points + lastSliceOfs;
+		for (ur_uint ix = 0; ix < resolution.x; ++ix, ++p_col0, ++p_col1)
+		{
+			computeLinePoints(p_col0, resolution.y, rowOfs, *p_col0, *(p_col0 + lastRowOfs));
+			computeLinePoints(p_col1, resolution.y, rowOfs, *p_col1, *(p_col1 + lastRowOfs));
+		}
+
+		ur_float3 *p_row0 = points;
+		ur_float3 *p_row1 = points + lastSliceOfs;
+		for (ur_uint iy = 0; iy < resolution.y; ++iy)
+		{
+			p_col0 = p_row0;
+			p_col1 = p_row1;
+			for (ur_uint ix = 0; ix < resolution.x; ++ix, ++p_col0, ++p_col1)
+			{
+				computeLinePoints(p_col0, resolution.z, sliceOfs, *p_col0, *p_col1);
+			}
+			p_row0 += rowOfs;
+			p_row1 += rowOfs;
+		}
+	}
+
+	bool Isosurface::MeshExtractor::IsKernelSupported(Kernel kernel)
+	{
+		switch (kernel)
+		{
+		case Kernel::Scalar: return true;
+		#if defined(UR_ISOSURFACE_SSE)
+		case Kernel::Simd: return true;
+		#endif
+		default: return false;
+		}
+	}
+
+	Result Isosurface::MeshExtractor::MarchCubes(Mesh &mesh, const ur_float3 *points, const DataVolume::ValueType *samples, const ur_uint3 &resolution,
+		Kernel kernel)
+	{
+		if (ur_null == points || ur_null == samples ||
+			resolution.x < 2 || resolution.y < 2 || resolution.z < 2)
+			return Result(InvalidArgs);
+
+		if (Kernel::Simd == kernel && IsKernelSupported(kernel))
+			return MarchCubesSimd(mesh, points, samples, resolution);
+
+		return MarchCubesScalar(mesh, points, samples, resolution);
+	}
+
+	ur_float3 Isosurface::MeshExtractor::ComputeNormal(const ur_float3 *points, const DataVolume::ValueType *samples, const ur_uint3 &resolution,
+		const ur_uint i0, const ur_uint i1, const ur_float lfactor)
+	{
+		const ur_uint axisOfs[3] = { 1, resolution.x, resolution.x * resolution.y };
+
+		auto computeGradient = [&](const ur_uint idx) -> ur_float3
+		{
+			const ur_uint3 pos(idx % resolution.x, (idx / axisOfs[1]) % resolution.y, idx / axisOfs[2]);
+
+			// differences along lattice axes, one sided at the lattice border
+			ur_float3 d;
+			ur_float3 e[3];
+			for (ur_uint axis = 0; axis < 3; ++axis)
+			{
+				const ur_uint ia = (pos[axis] > 0 ? idx - axisOfs[axis] : idx);
+				const ur_uint ib = (pos[axis] + 1 < resolution[axis] ? idx + axisOfs[axis] : idx);
+				d[axis] = ur_float(samples[ib] - samples[ia]);
+				e[axis] = points[ib] - points[ia];
+			}
+
+			// lattice is not necessarily axis aligned: solve dot(gradient, e[axis]) = d[axis]
+			const ur_float3 c0 = ur_float3::Cross(e[1], e[2]);
+			const ur_float3 c1 = ur_float3::Cross(e[2], e[0]);
+			const ur_float3 c2 = ur_float3::Cross(e[0], e[1]);
+			const ur_float det = ur_float3::Dot(e[0], c0);
+			if (0.0f == det)
+				return ur_float3(0.0f);
+			return (c0 * d.x + c1 * d.y + c2 * d.z) / det;
+		};
+
+		// field is positive inside, so the outward normal is opposite to the gradient
+		ur_float3 gradient = ur_float3::Lerp(computeGradient(i0), computeGradient(i1), lfactor);
+		return ur_float3::Normalize(gradient * -1.0f);
+	}
+
+	Result Isosurface::MeshExtractor::MarchCubesScalar(Mesh &mesh, const ur_float3 *points, const DataVolume::ValueType *samples, const ur_uint3 &resolution)
+	{
+		static const DataVolume::ValueType ScalarFieldSurfaceValue = DataVolume::ValueType(0);
+		static const int NoVertexId = -1;
+		ur_uint rowOfs = resolution.x;
+		ur_uint sliceOfs = rowOfs * resolution.y;
+		ur_uint latticeSize = sliceOfs * resolution.z;
+		ur_uint vertexBase = (ur_uint)mesh.vertices.size();
+		std::vector<Isosurface::Vertex> &vertexBuffer = mesh.vertices;
+		std::vector<Isosurface::Index> &indexBuffer = mesh.indices;
+		std::vector<ur_int3> edgeVertices(latticeSize, NoVertexId);
+		ur_int *cellEdges[12];
+		const ur_float3 *cellPoints[8];
+		const DataVolume::ValueType *cellValues[8];
+		ur_uint3 cellsCount = resolution - 1;
+		const ur_float3 *p_slice = points;
+		const DataVolume::ValueType *p_sample_slice = samples;
+		for (ur_uint iz = 0; iz < cellsCount.z; ++iz)
+		{
+			const ur_float3 *p_row = p_slice;
+			const DataVolume::ValueType *p_sample_row = p_sample_slice;
+			for (ur_uint iy = 0; iy < cellsCount.y; ++iy)
+			{
+				const ur_float3 *p_cell = p_row;
+				const DataVolume::ValueType *p_sample = p_sample_row;
+				for (ur_uint ix = 0; ix < cellsCount.x; ++ix, ++p_cell, ++p_sample)
+				{
+					// cell corner vertices
+					cellPoints[0] = &p_cell[0];
+					cellPoints[1] = &p_cell[1];
+					cellPoints[2] = &p_cell[rowOfs + 1];
+					cellPoints[3] = &p_cell[rowOfs];
+					cellPoints[4] = &p_cell[sliceOfs];
+					cellPoints[5] = &p_cell[sliceOfs + 1];
+					cellPoints[6] = &p_cell[sliceOfs + rowOfs + 1];
+					cellPoints[7] = &p_cell[sliceOfs + rowOfs];
+
+					// cell corner samples
+					cellValues[0] = &p_sample[0];
+					cellValues[1] = &p_sample[1];
+					cellValues[2] = &p_sample[rowOfs + 1];
+					cellValues[3] = &p_sample[rowOfs];
+					cellValues[4] = &p_sample[sliceOfs];
+					cellValues[5] = &p_sample[sliceOfs + 1];
+					cellValues[6] = &p_sample[sliceOfs + rowOfs + 1];
+					cellValues[7] = &p_sample[sliceOfs + rowOfs];
+					
+					// lookup intersected edges
+					ur_uint flagIdx = 0;
+					for (ur_uint iv = 0; iv < 8; ++iv)
+					{
+						if (*cellValues[iv] <= ScalarFieldSurfaceValue) flagIdx |= (1 << iv);
+					}
+					const ur_uint &edgeFlags = MCEdgeTable[flagIdx];
+					if (edgeFlags == 0)
+						continue; // surface does not intersect any edge
+
+					// init cell vertices refs
+					ur_int3 *p_cellEdges = edgeVertices.data() + ix + iy * rowOfs + iz * sliceOfs;
+					cellEdges[0] = &p_cellEdges[0].x;
+					cellEdges[1] = &p_cellEdges[1].y;
+					cellEdges[2] = &p_cellEdges[rowOfs].x;
+					cellEdges[3] = &p_cellEdges[0].y;
+					cellEdges[4] = &p_cellEdges[sliceOfs].x;
+					cellEdges[5] = &p_cellEdges[sliceOfs + 1].y;
+					cellEdges[6] = &p_cellEdges[sliceOfs + rowOfs].x;
+					cellEdges[7] = &p_cellEdges[sliceOfs].y;
+					cellEdges[8] = &p_cellEdges[0].z;
+					cellEdges[9] = &p_cellEdges[1].z;
+					cellEdges[10] = &p_cellEdges[rowOfs + 1].z;
+					cellEdges[11] = &p_cellEdges[rowOfs].z;
+
+					// compute intersection points
+					for (ur_uint ie = 0; ie < 12; ++ie)
+					{
+						if ((edgeFlags & (1 << ie)) &&
+							(NoVertexId == *cellEdges[ie]))
+						{
+							// compute new vertex
+							const DataVolume::ValueType &cv0 = *cellValues[MCEdgeVertices[ie][0]];
+							const DataVolume::ValueType &cv1 = *cellValues[MCEdgeVertices[ie][1]];
+							ur_float lfactor = (ur_float)(ScalarFieldSurfaceValue - cv0) / (cv1 - cv0);
+							const ur_float3 &p0 = *cellPoints[MCEdgeVertices[ie][0]];
+							const ur_float3 &p1 = *cellPoints[MCEdgeVertices[ie][1]];
+							ur_float3 p = ur_float3::Lerp(p0, p1, lfactor);
+							ur_float3 n = ComputeNormal(points, samples, resolution,
+								ur_uint(cellValues[MCEdgeVertices[ie][0]] - samples), ur_uint(cellValues[MCEdgeVertices[ie][1]] - samples), lfactor);
+							*cellEdges[ie] = (ur_int)(vertexBuffer.size() - vertexBase);
+							vertexBuffer.push_back({ p, n, 0xffffffff });
+						}
+					}
+
+					// add triangles
+					for (ur_uint itri = 0; itri < 5; ++itri)
+					{
+						if (MCTriangleTable[flagIdx][itri * 3] < 0)
+							break;
+
+						const ur_int &vi0 = MCTriangleTable[flagIdx][itri * 3 + 0];
+						const ur_int &vi1 = MCTriangleTable[flagIdx][itri * 3 + 1];
+						const ur_int &vi2 = MCTriangleTable[flagIdx][itri * 3 + 2];
+						indexBuffer.push_back(vertexBase + *cellEdges[vi0]);
+						indexBuffer.push_back(vertexBase + *cellEdges[vi1]);
+						indexBuffer.push_back(vertexBase + *cellEdges[vi2]);
+					}
+				}
+				p_row += rowOfs;
+				p_sample_row += rowOfs;
+			}
+			p_slice += sliceOfs;
+			p_sample_slice += sliceOfs;
+		}
+
+		return Result(Success);
+	}
+
+	Result Isosurface::MeshExtractor::MarchCubesSimd(Mesh &mesh, const ur_float3 *points, const DataVolume::ValueType *samples, const ur_uint3 &resolution)
+	{
+	#if defined(UR_ISOSURFACE_SSE)
+		static_assert(sizeof(DataVolume::ValueType) == sizeof(float), "MarchCubesSimd: unsupported value type");
+		static const ur_uint Width = 16; // cells processed at once
+		const ur_uint rowOfs = resolution.x;
+		const ur_uint sliceOfs = rowOfs * resolution.y;
+		const ur_uint latticeSize = sliceOfs * resolution.z;
+		const ur_uint3 cellsCount = resolution - 1;
+
+		// classify lattice points: 0xff for inside (value <= surface value), 0 otherwise;
+		// arrays are padded to allow full width loads and stores at the end of the lattice
+
+		std::vector<ur_byte> inside(latticeSize + Width * 2, 0);
+		{
+			const __m128 surfaceValue = _mm_setzero_ps();
+			ur_uint i = 0;
+			for (; i + Width <= latticeSize; i += Width)
+			{
+				__m128i m0 = _mm_castps_si128(_mm_cmple_ps(_mm_loadu_ps(samples + i + 0), surfaceValue));
+				__m128i m1 = _mm_castps_si128(_mm_cmple_ps(_mm_loadu_ps(samples + i + 4), surfaceValue));
+				__m128i m2 = _mm_castps_si128(_mm_cmple_ps(_mm_loadu_ps(samples + i + 8), surfaceValue));
+				__m128i m3 = _mm_castps_si128(_mm_cmple_ps(_mm_loadu_ps(samples + i + 12), surfaceValue));
+				_mm_storeu_si128((__m128i*)(inside.data() + i), _mm_packs_epi16(_mm_packs_epi32(m0, m1), _mm_packs_epi32(m2, m3)));
+			}
+			for (; i < latticeSize; ++i)
+			{
+				inside[i] = (samples[i] <= 0.0f ? 0xff : 0);
+			}
+		}
+
+		// compute cube indices for a row of cells at once (stored at the cell's base lattice point)
+		// and count active cells per row
+
+		const ur_uint cornerOfs[8] = { 0, 1, rowOfs + 1, rowOfs, sliceOfs, sliceOfs + 1, sliceOfs + rowOfs + 1, sliceOfs + rowOfs };
+		const ur_uint rowsCount = cellsCount.y * cellsCount.z;
+		const ur_uint chunksPerRow = (cellsCount.x + Width - 1) / Width;
+		std::vector<ur_byte> cubeIndices(latticeSize + Width * 2, 0);
+		std::vector<ur_uint32> activeMasks(rowsCount * chunksPerRow);
+		std::vector<ur_uint> activeOffsets(rowsCount + 1);
+		{
+			const __m128i zero = _mm_setzero_si128();
+			const __m128i full = _mm_set1_epi8((char)0xff);
+			ur_uint *p_offset = activeOffsets.data();
+			ur_uint32 *p_mask = activeMasks.data();
+			for (ur_uint iz = 0; iz < cellsCount.z; ++iz)
+			{
+				for (ur_uint iy = 0; iy < cellsCount.y; ++iy, ++p_offset)
+				{
+					ur_uint rowBase = iy * rowOfs + iz * sliceOfs;
+					ur_uint rowActive = 0;
+					for (ur_uint ix = 0; ix < cellsCount.x; ix += Width, ++p_mask)
+					{
+						const ur_byte *p_inside = inside.data() + rowBase + ix;
+						__m128i cubeIdx = zero;
+						for (ur_uint ic = 0; ic < 8; ++ic)
+						{
+							__m128i corner = _mm_loadu_si128((const __m128i*)(p_inside + cornerOfs[ic]));
+							cubeIdx = _mm_or_si128(cubeIdx, _mm_and_si128(corner, _mm_set1_epi8((char)(1 << ic))));
+						}
+						_mm_storeu_si128((__m128i*)(cubeIndices.data() + rowBase + ix), cubeIdx);
+
+						// cells with all corners inside or outside produce no geometry
+						__m128i empty = _mm_or_si128(_mm_cmpeq_epi8(cubeIdx, zero), _mm_cmpeq_epi8(cubeIdx, full));
+						ur_uint32 validMask = (cellsCount.x - ix >= Width ? 0xffff : ((1u << (cellsCount.x - ix)) - 1));
+						ur_uint32 activeMask = ~(ur_uint32)_mm_movemask_epi8(empty) & validMask;
+						*p_mask = activeMask;
+						rowActive += BitCount(activeMask);
+					}
+					*p_offset = rowActive;
+				}
+			}
+		}
+
+		// compact active cells: exclusive prefix sum of per row counts gives each row's output range
+
+		ur_uint activeCount = 0;
+		for (ur_uint ir = 0; ir <= rowsCount; ++ir)
+		{
+			ur_uint rowActive = (ir < rowsCount ? activeOffsets[ir] : 0);
+			activeOffsets[ir] = activeCount;
+			activeCount += rowActive;
+		}
+		if (0 == activeCount)
+			return Result(Success);
+
+		std::vector<ur_uint> activeCells(activeCount);
+		for (ur_uint ir = 0; ir < rowsCount; ++ir)
+		{
+			ur_uint rowBase = (ir % cellsCount.y) * rowOfs + (ir / cellsCount.y) * sliceOfs;
+			ur_uint *p_cell = activeCells.data() + activeOffsets[ir];
+			for (ur_uint ic = 0; ic < chunksPerRow; ++ic)
+			{
+				ur_uint32 mask = activeMasks[ir * chunksPerRow + ic];
+				while (mask != 0)
+				{
+					*p_cell++ = rowBase + ic * Width + FirstBitIdx(mask);
+					mask &= mask - 1;
+				}
+			}
+		}
+
+		// find all lattice edges crossing the surface: each one yields exactly one vertex shared by adjacent cells
+
+		const ur_uint axisOfs[3] = { 1, rowOfs, sliceOfs };
+		std::vector<ur_uint> crossings;
+		crossings.reserve(activeCount * 3);
+		for (ur_uint axis = 0; axis < 3; ++axis)
+		{
+			const ur_uint3 edgesCount(
+				resolution.x - (0 == axis ? 1 : 0),
+				resolution.y - (1 == axis ? 1 : 0),
+				resolution.z - (2 == axis ? 1 : 0));
+			for (ur_uint iz = 0; iz < edgesCount.z; ++iz)
+			{
+				for (ur_uint iy = 0; iy < edgesCount.y; ++iy)
+				{
+					ur_uint rowBase = iy * rowOfs + iz * sliceOfs;
+					for (ur_uint ix = 0; ix < edgesCount.x; ix += Width)
+					{
+						const ur_byte *p_inside = inside.data() + rowBase + ix;
+						__m128i change = _mm_xor_si128(
+							_mm_loadu_si128((const __m128i*)p_inside),
+							_mm_loadu_si128((const __m128i*)(p_inside + axisOfs[axis])));
+						ur_uint32 validMask = (edgesCount.x - ix >= Width ? 0xffff : ((1u << (edgesCount.x - ix)) - 1));
+						ur_uint32 mask = (ur_uint32)_mm_movemask_epi8(change) & validMask;
+						while (mask != 0)
+						{
+							crossings.push_back((rowBase + ix + FirstBitIdx(mask)) * 3 + axis);
+							mask &= mask - 1;
+						}
+					}
+				}
+			}
+		}
+
+		// interpolate edge crossings in bulk
+
+		const ur_uint vertexBase = (ur_uint)mesh.vertices.size();
+		const ur_uint crossingsCount = (ur_uint)crossings.size();
+		std::vector<ur_int3> edgeVertices(latticeSize);
+		ur_int *edgeVertexIds = &edgeVertices.data()->x;
+		mesh.vertices.resize(vertexBase + crossingsCount);
+		Isosurface::Vertex *p_vertex = mesh.vertices.data() + vertexBase;
+		for (ur_uint ie = 0; ie < crossingsCount; ++ie, ++p_vertex)
+		{
+			const ur_uint edge = crossings[ie];
+			const ur_uint i0 = edge / 3;
+			const ur_uint i1 = i0 + axisOfs[edge - i0 * 3];
+			const ur_float lfactor = (ur_float)(0.0f - samples[i0]) / (samples[i1] - samples[i0]);
+			p_vertex->pos = ur_float3::Lerp(points[i0], points[i1], lfactor);
+			p_vertex->norm = ComputeNormal(points, samples, resolution, i0, i1, lfactor);
+			p_vertex->col = 0xffffffff;
+			edgeVertexIds[edge] = (ur_int)(vertexBase + ie);
+		}
+
+		// emit triangles of active cells
+
+		const ur_uint cellEdgeRefs[12] = {
+			0 * 3 + 0, 1 * 3 + 1, rowOfs * 3 + 0, 0 * 3 + 1,
+			sliceOfs * 3 + 0, (sliceOfs + 1) * 3 + 1, (sliceOfs + rowOfs) * 3 + 0, sliceOfs * 3 + 1,
+			0 * 3 + 2, 1 * 3 + 2, (rowOfs + 1) * 3 + 2, rowOfs * 3 + 2 };
+		mesh.indices.reserve(mesh.indices.size() + activeCount * 6);
+		for (const ur_uint &cell : activeCells)
+		{
+			const ur_int *triangles = MCTriangleTable[cubeIndices[cell]];
+			const ur_int *cellEdgeVertexIds = edgeVertexIds + cell * 3;
+			for (ur_uint it = 0; it < 15 && triangles[it] >= 0; ++it)
+			{
+				mesh.indices.push_back((Isosurface::Index)cellEdgeVertexIds[cellEdgeRefs[triangles[it]]]);
+			}
+		}
+
+		return Result(Success);
+	#else
+		return MarchCubesScalar(mesh, points, samples, resolution);
+	#endif
+	}
+
+	Result Isosurface::MeshExtractor::SurfaceNets(Mesh &mesh, const ur_float3 *points, const DataVolume::ValueType *samples, const ur_uint3 &resolution)
+	{
+		if (ur_null == points || ur_null == samples ||
+			resolution.x < 2 || resolution.y < 2 || resolution.z < 2)
+			return Result(InvalidArgs);
+
+		static const DataVolume::ValueType ScalarFieldSurfaceValue = DataVolume::ValueType(0);
+		static const Index NoVertexId = Index(-1);
+		const ur_uint axisOfs[3] = { 1, resolution.x, resolution.x * resolution.y };
+		const ur_int3 cells(ur_int(resolution.x - 1), ur_int(resolution.y - 1), ur_int(resolution.z - 1));
+
+		// dual cells: regular cells in [0, cells) plus a layer collapsed onto the lattice border at -1 and cells
+		const ur_uint3 dualRes(cells.x + 2, cells.y + 2, cells.z + 2);
+		std::vector<Index> dualVertices(dualRes.x * dualRes.y * dualRes.z, NoVertexId);
+
+		auto isOutside = [](const DataVolume::ValueType &value) -> bool {
+			return (value <= ScalarFieldSurfaceValue);
+		};
+
+		// dual vertex is placed at the mean of surface crossings found on the cell edges
+		auto dualVertex = [&](const ur_int3 &cell) -> Index {
+			Index &vertexId = dualVertices[(cell.x + 1) + (cell.y + 1) * dualRes.x + (cell.z + 1) * dualRes.x * dualRes.y];
+			if (vertexId != NoVertexId)
+				return vertexId;
+			ur_uint3 pmin, pmax;
+			for (ur_uint axis = 0; axis < 3; ++axis)
+			{
+				pmin[axis] = ur_uint(std::max(cell[axis], 0));
+				pmax[axis] = ur_uint(std::min(cell[axis] + 1, cells[axis]));
+			}
+			ur_float3 pos(0.0f);
+			ur_float3 norm(0.0f);
+			ur_uint crossingsCount = 0;
+			for (ur_uint iz = pmin.z; iz <= pmax.z; ++iz)
+			{
+				for (ur_uint iy = pmin.y; iy <= pmax.y; ++iy)
+				{
+					for (ur_uint ix = pmin.x; ix <= pmax.x; ++ix)
+					{
+						const ur_uint3 p(ix, iy, iz);
+						const ur_uint i0 = ix + iy * axisOfs[1] + iz * axisOfs[2];
+						for (ur_uint axis = 0; axis < 3; ++axis)
+						{
+							if (p[axis] == pmax[axis])
+								continue;
+							const ur_uint i1 = i0 + axisOfs[axis];
+							if (isOutside(samples[i0]) == isOutside(samples[i1]))
+								continue;
+							ur_float lfactor = (ur_float)(ScalarFieldSurfaceValue - samples[i0]) / (samples[i1] - samples[i0]);
+							pos += ur_float3::Lerp(points[i0], points[i1], lfactor);
+							norm += ComputeNormal(points, samples, resolution, i0, i1, lfactor);
+							++crossingsCount;
+						}
+					}
+				}
+			}
+			vertexId = (Index)mesh.vertices.size();
+			mesh.vertices.push_back({ pos / ur_float(std::max(crossingsCount, ur_uint(1))), ur_float3::Normalize(norm), 0xffffffff });
+			return vertexId;
+		};
+
+		// a quad connecting dual vertices of the four cells around each crossed lattice edge,
+		// split along the shorter diagonal
+
+		for (ur_uint iz = 0; iz < resolution.z; ++iz)
+		{
+			for (ur_uint iy = 0; iy < resolution.y; ++iy)
+			{
+				for (ur_uint ix = 0; ix < resolution.x; ++ix)
+				{
+					const ur_int3 p((ur_int)ix, (ur_int)iy, (ur_int)iz);
+					const ur_uint i0 = ix + iy * axisOfs[1] + iz * axisOfs[2];
+					for (ur_uint axis = 0; axis < 3; ++axis)
+					{
+						if (p[axis] == cells[axis])
+							continue;
+						const ur_uint i1 = i0 + axisOfs[axis];
+						const bool outside0 = isOutside(samples[i0]);
+						if (outside0 == isOutside(samples[i1]))
+							continue;
+						const ur_uint axisU = (axis + 1) % 3;
+						const ur_uint axisV = (axis + 2) % 3;
+						ur_int3 cell[4] = { p, p, p, p };
+						cell[0][axisU] -= 1; cell[0][axisV] -= 1;
+						cell[1][axisV] -= 1;
+						cell[3][axisU] -= 1;
+						Index quad[4];
+						for (ur_uint iv = 0; iv < 4; ++iv)
+						{
+							quad[iv] = dualVertex(cell[iv]);
+						}
+						if (outside0)
+						{
+							std::swap(quad[1], quad[3]); // keep winding consistent with marching cubes
+						}
+						const ur_float diag02 = (mesh.vertices[quad[2]].pos - mesh.vertices[quad[0]].pos).LengthSquared();
+						const ur_float diag13 = (mesh.vertices[quad[3]].pos - mesh.vertices[quad[1]].pos).LengthSquared();
+						if (diag02 <= diag13)
+						{
+							mesh.indices.insert(mesh.indices.end(), { quad[0], quad[1], quad[2], quad[0], quad[2], quad[3] });
+						}
+						else
+						{
+							mesh.indices.insert(mesh.indices.end(), { quad[1], quad[2], quad[3], quad[1], quad[3], quad[0] });
+						}
+					}
+				}
+			}
+		}
+
+		return Result(Success);
+	}
+
+	Result Isosurface::MeshExtractor::Extract(Mesh &mesh, DataVolume &volume, const BoundingBox &bbox, const ur_uint3 &resolution,
+		Kernel kernel)
+	{
+		if (0 == resolution.x || 0 == resolution.y || 0 == resolution.z || bbox.IsInsideOut())
+			return Result(InvalidArgs);
+
+		Result res(Success);
+		ur_float3 cellSize(bbox.SizeX() / resolution.x, bbox.SizeY() / resolution.y, bbox.SizeZ() / resolution.z);
+		const ur_float cellSizeMax = std::max(std::max(cellSize.x, cellSize.y), cellSize.z);
+		std::vector<ur_float3> lattice;
+		std::vector<DataVolume::ValueType> samples;
+		for (ur_uint bz = 0; bz < resolution.z; bz += BlockCells)
+		{
+			for (ur_uint by = 0; by < resolution.y; by += BlockCells)
+			{
+				for (ur_uint bx = 0; bx < resolution.x; bx += BlockCells)
+				{
+					ur_uint3 blockCells(
+						std::min(BlockCells, resolution.x - bx),
+						std::min(BlockCells, resolution.y - by),
+						std::min(BlockCells, resolution.z - bz));
+					BoundingBox blockBBox;
+					blockBBox.Min = bbox.Min + ur_float3(cellSize.x * bx, cellSize.y * by, cellSize.z * bz);
+					blockBBox.Max = blockBBox.Min + ur_float3(cellSize.x * blockCells.x, cellSize.y * blockCells.y, cellSize.z * blockCells.z);
+
+					if (volume.ReadLattice(ur_null, ur_null, 0, blockBBox, cellSizeMax) == NotFound)
+						continue; // does not intersect isosurface
+
+					const ur_float3 corners[8] = {
+						{ blockBBox.Min.x, blockBBox.Min.y, blockBBox.Min.z },
+						{ blockBBox.Max.x, blockBBox.Min.y, blockBBox.Min.z },
+						{ blockBBox.Min.x, blockBBox.Max.y, blockBBox.Min.z },
+						{ blockBBox.Max.x, blockBBox.Max.y, blockBBox.Min.z },
+						{ blockBBox.Min.x, blockBBox.Min.y, blockBBox.Max.z },
+						{ blockBBox.Max.x, blockBBox.Min.y, blockBBox.Max.z },
+						{ blockBBox.Min.x, blockBBox.Max.y, blockBBox.Max.z },
+						{ blockBBox.Max.x, blockBBox.Max.y, blockBBox.Max.z }
+					};
+					ur_uint3 blockResolution = blockCells + 1;
+					ur_uint latticeSize = blockResolution.x * blockResolution.y * blockResolution.z;
+					lattice.resize(latticeSize);
+					samples.resize(latticeSize);
+					ComputeLattice(lattice.data(), corners, blockResolution);
+
+					Result readRes = volume.ReadLattice(samples.data(), lattice.data(), latticeSize, blockBBox, cellSizeMax);
+					if (readRes == NotFound)
+						continue;
+					if (Failed(readRes))
+					{
+						res = readRes;
+						continue;
+					}
+
+					res &= MarchCubes(mesh, lattice.data(), samples.data(), blockResolution, kernel);
+				}
+			}
+		}
+
+		return res;
+	}
+
+	Result Isosurface::MeshExtractor::SaveObj(Realm &realm, const Mesh &mesh, const std::string &fileName)
+	{
+		std::unique_ptr<File> file;
+		Result res = realm.GetStorage().Open(file, fileName, ur_uint(StorageAccess::Write));
+		if (Failed(res))
+			return LogResult(Failure, realm.GetLog(), Log::Error, "Isosurface::MeshExtractor::SaveObj: failed to open " + fileName);
+
+		// text is written in chunks to keep memory bounded for large meshes
+		static const ur_size ChunkSize = 1 << 20;
+		std::string text;
+		text.reserve(ChunkSize + 256);
+		char line[256];
+		auto flush = [&](bool force) -> bool {
+			if (text.size() < ChunkSize && !force)
+				return true;
+			bool ok = Succeeded(file->Write(text));
+			text.clear();
+			return ok;
+		};
+
+		bool ok = true;
+		for (const auto &v : mesh.vertices)
+		{
+			snprintf(line, sizeof(line), "v %f %f %f\nvn %f %f %f\n", v.pos.x, v.pos.y, v.pos.z, v.norm.x, v.norm.y, v.norm.z);
+			text += line;
+			ok &= flush(false);
+		}
+		for (ur_size i = 0; i + 2 < mesh.indices.size(); i += 3)
+		{
+			// obj indices are one based, normals share vertex indices
+			const ur_uint i0 = mesh.indices[i] + 1, i1 = mesh.indices[i + 1] + 1, i2 = mesh.indices[i + 2] + 1;
+			snprintf(line, sizeof(line), "f %u//%u %u//%u %u//%u\n", i0, i0, i1, i1, i2, i2);
+			text += line;
+			ok &= flush(false);
+		}
+		ok &= flush(true);
+		file->Close();
+
+		if (!ok)
+			return LogResult(Failure, realm.GetLog(), Log::Error, "Isosurface::MeshExtractor::SaveObj: failed to write " + fileName);
+
+		return Result(Success);
+	}
+
+	void Isosurface::MeshExtractor::Merge(Mesh &mesh, const Mesh &part)
+	{
+		const Index vertexBase = (Index)mesh.vertices.size();
+		mesh.vertices.insert(mesh.vertices.end(), part.vertices.begin(), part.vertices.end());
+		mesh.indices.reserve(mesh.indices.size() + part.indices.size());
+		for (const Index &idx : part.indices)
+		{
+			mesh.indices.push_back(vertexBase + idx);
+		}
+	}
+
+	void Isosurface::MeshExtractor::AddSkirts(Mesh &mesh, const ur_float4 *planes, const ur_uint planesCount, const ur_float depth, const ur_float tolerance)
+	{
+		// border edges are referenced by a single triangle
+
+		struct TriangleEdge
+		{
+			ur_uint64 key;
+			Index v0, v1;
+		};
+		std::vector<TriangleEdge> edges;
+		edges.reserve(mesh.indices.size());
+		for (ur_size it = 0; it + 2 < mesh.indices.size(); it += 3)
+		{
+			for (ur_uint ie = 0; ie < 3; ++ie)
+			{
+				Index v0 = mesh.indices[it + ie];
+				Index v1 = mesh.indices[it + (ie + 1) % 3];
+				ur_uint64 key = (ur_uint64(std::min(v0, v1)) << 32) | ur_uint64(std::max(v0, v1));
+				edges.push_back({ key, v0, v1 });
+			}
+		}
+		std::sort(edges.begin(), edges.end(), [](const TriangleEdge &a, const TriangleEdge &b) -> bool {
+			return (a.key < b.key);
+		});
+
+		auto onPlane = [&mesh, tolerance](const ur_float4 &plane, Index v) -> bool {
+			const ur_float3 &p = mesh.vertices[v].pos;
+			return (fabs(plane.x * p.x + plane.y * p.y + plane.z * p.z + plane.w) <= tolerance);
+		};
+
+		// border edges lying on one of the planes are extruded against vertex normals,
+		// skirt triangles continue the winding of the border triangle
+
+		static const Index NoSkirtVertex = Index(-1);
+		std::vector<Index> skirtVertices(mesh.vertices.size(), NoSkirtVertex);
+		auto skirtVertex = [&mesh, &skirtVertices, depth](Index v) -> Index {
+			if (NoSkirtVertex == skirtVertices[v])
+			{
+				Vertex vertex = mesh.vertices[v];
+				vertex.pos = vertex.pos - vertex.norm * depth;
+				skirtVertices[v] = (Index)mesh.vertices.size();
+				mesh.vertices.push_back(vertex);
+			}
+			return skirtVertices[v];
+		};
+
+		for (ur_size ie = 0; ie < edges.size(); )
+		{
+			ur_size groupEnd = ie + 1;
+			while (groupEnd < edges.size() && edges[groupEnd].key == edges[ie].key) ++groupEnd;
+			if (groupEnd - ie == 1)
+			{
+				const TriangleEdge &edge = edges[ie];
+				for (ur_uint ip = 0; ip < planesCount; ++ip)
+				{
+					if (!onPlane(planes[ip], edge.v0) || !onPlane(planes[ip], edge.v1))
+						continue;
+					Index s0 = skirtVertex(edge.v0);
+					Index s1 = skirtVertex(edge.v1);
+					mesh.indices.insert(mesh.indices.end(), { edge.v1, edge.v0, s0, edge.v1, s0, s1 });
+					break;
+				}
+			}
+			ie = groupEnd;
+		}
+	}
+
+	void Isosurface::MeshExtractor::Simplify(Mesh &mesh, const ur_float maxError)
+	{
+		const ur_size vertexCount = mesh.vertices.size();
+		const ur_size trianglesCount = mesh.indices.size() / 3;
+		if (maxError <= 0.0f || 0 == trianglesCount)
+			return;
+
+		// symmetric 4x4 matrix of summed squared distances to triangles planes
+
+		struct Quadric
+		{
+			ur_double m[10];
+
+			void Add(const Quadric &q)
+			{
+				for (ur_uint i = 0; i < 10; ++i) this->m[i] += q.m[i];
+			}
+
+			void AddPlane(const ur_float3 &n, const ur_float d)
+			{
+				const ur_double a = n.x, b = n.y, c = n.z;
+				this->m[0] += a * a; this->m[1] += a * b; this->m[2] += a * c; this->m[3] += a * d;
+				this->m[4] += b * b; this->m[5] += b * c; this->m[6] += b * d;
+				this->m[7] += c * c; this->m[8] += c * d;
+				this->m[9] += ur_double(d) * d;
+			}
+
+			ur_double Error(const ur_float3 &p) const
+			{
+				const ur_double x = p.x, y = p.y, z = p.z;
+				return this->m[0] * x * x + 2.0 * this->m[1] * x * y + 2.0 * this->m[2] * x * z + 2.0 * this->m[3] * x +
+					this->m[4] * y * y + 2.0 * this->m[5] * y * z + 2.0 * this->m[6] * y +
+					this->m[7] * z * z + 2.0 * this->m[8] * z + this->m[9];
+			}
+		};
+
+		std::vector<Quadric> quadrics(vertexCount);
+		memset(quadrics.data(), 0, quadrics.size() * sizeof(Quadric));
+		std::vector<std::vector<ur_uint>> vertexTriangles(vertexCount);
+		for (ur_uint it = 0; it < trianglesCount; ++it)
+		{
+			const Index *tri = &mesh.indices[it * 3];
+			const ur_float3 &p0 = mesh.vertices[tri[0]].pos;
+			ur_float3 n = ur_float3::Normalize(ur_float3::Cross(mesh.vertices[tri[1]].pos - p0, mesh.vertices[tri[2]].pos - p0));
+			for (ur_uint iv = 0; iv < 3; ++iv)
+			{
+				quadrics[tri[iv]].AddPlane(n, -ur_float3::Dot(n, p0));
+				vertexTriangles[tri[iv]].push_back(it);
+			}
+		}
+
+		// vertices on mesh borders (and non manifold edges) are locked, so that adjacent meshes still line up
+
+		std::vector<ur_uint64> edges;
+		edges.reserve(trianglesCount * 3);
+		for (ur_size it = 0; it < trianglesCount * 3; it += 3)
+		{
+			for (ur_uint ie = 0; ie < 3; ++ie)
+			{
+				Index v0 = mesh.indices[it + ie];
+				Index v1 = mesh.indices[it + (ie + 1) % 3];
+				edges.push_back((ur_uint64(std::min(v0, v1)) << 32) | ur_uint64(std::max(v0, v1)));
+			}
+		}
+		std::sort(edges.begin(), edges.end());
+		std::vector<bool> locked(vertexCount, false);
+		for (ur_size ie = 0; ie < edges.size(); )
+		{
+			ur_size groupEnd = ie + 1;
+			while (groupEnd < edges.size() && edges[groupEnd] == edges[ie]) ++groupEnd;
+			if (groupEnd - ie != 2)
+			{
+				locked[Index(edges[ie] >> 32)] = true;
+				locked[Index(edges[ie] & 0xffffffff)] = true;
+			}
+			ie = groupEnd;
+		}
+		edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+		// greedy edge collapses ordered by quadric error; queue entries are invalidated by vertex versions
+
+		struct Collapse
+		{
+			ur_double error;
+			Index keep;
+			Index remove;
+			ur_uint keepVersion;
+			ur_uint removeVersion;
+			Vertex target;
+			bool operator> (const Collapse &c) const { return (this->error > c.error); }
+		};
+		std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>> queue;
+		std::vector<ur_uint> versions(vertexCount, 0);
+		std::vector<bool> triangleRemoved(trianglesCount, false);
+		const ur_double maxQuadricError = ur_double(maxError) * maxError;
+
+		auto evaluate = [&](Index v0, Index v1) -> void {
+			if (locked[v0] && locked[v1])
+				return;
+			if (locked[v1]) std::swap(v0, v1); // locked vertex is kept in place
+			Quadric q = quadrics[v0];
+			q.Add(quadrics[v1]);
+			Collapse collapse;
+			collapse.keep = v0;
+			collapse.remove = v1;
+			collapse.keepVersion = versions[v0];
+			collapse.removeVersion = versions[v1];
+			collapse.target = mesh.vertices[v0];
+			collapse.error = q.Error(collapse.target.pos);
+			if (!locked[v0])
+			{
+				ur_double error = q.Error(mesh.vertices[v1].pos);
+				if (error < collapse.error)
+				{
+					collapse.error = error;
+					collapse.target = mesh.vertices[v1];
+				}
+				Vertex middle = mesh.vertices[v0];
+				middle.pos = (mesh.vertices[v0].pos + mesh.vertices[v1].pos) * 0.5f;
+				middle.norm = ur_float3::Normalize(mesh.vertices[v0].norm + mesh.vertices[v1].norm);
+				error = q.Error(middle.pos);
+				if (error < collapse.error)
+				{
+					collapse.error = error;
+					collapse.target = middle;
+				}
+			}
+			if (collapse.error <= maxQuadricError)
+			{
+				queue.push(collapse);
+			}
+		};
+
+		auto gatherNeighbours = [&](Index v, std::vector<Index> &neighbours) -> void {
+			neighbours.clear();
+			for (ur_uint it : vertexTriangles[v])
+			{
+				for (ur_uint iv = 0; iv < 3; ++iv)
+				{
+					Index n = mesh.indices[it * 3 + iv];
+					if (n != v) neighbours.push_back(n);
+				}
+			}
+			std::sort(neighbours.begin(), neighbours.end());
+			neighbours.erase(std::unique(neighbours.begin(), neighbours.end()), neighbours.end());
+		};
+
+		// collapse must keep the surface manifold and must not flip or degenerate remaining triangles
+		std::vector<Index> neighbours0, neighbours1, sharedNeighbours;
+		auto isValid = [&](const Collapse &collapse) -> bool {
+			gatherNeighbours(collapse.keep, neighbours0);
+			gatherNeighbours(collapse.remove, neighbours1);
+			sharedNeighbours.clear();
+			std::set_intersection(neighbours0.begin(), neighbours0.end(), neighbours1.begin(), neighbours1.end(), std::back_inserter(sharedNeighbours));
+			if (sharedNeighbours.size() != 2)
+				return false;
+			for (Index v : { collapse.keep, collapse.remove })
+			{
+				for (ur_uint it : vertexTriangles[v])
+				{
+					const Index *tri = &mesh.indices[it * 3];
+					if ((tri[0] == collapse.keep || tri[1] == collapse.keep || tri[2] == collapse.keep) &&
+						(tri[0] == collapse.remove || tri[1] == collapse.remove || tri[2] == collapse.remove))
+						continue; // removed by collapse
+					ur_float3 p[3], pc[3];
+					for (ur_uint iv = 0; iv < 3; ++iv)
+					{
+						p[iv] = mesh.vertices[tri[iv]].pos;
+						pc[iv] = (tri[iv] == v ? collapse.target.pos : p[iv]);
+					}
+					ur_float3 n = ur_float3::Cross(p[1] - p[0], p[2] - p[0]);
+					ur_float3 nc = ur_float3::Cross(pc[1] - pc[0], pc[2] - pc[0]);
+					if (ur_float3::Dot(n, nc) <= 0.2f * n.Length() * nc.Length())
+						return false;
+				}
+			}
+			return true;
+		};
+
+		for (ur_uint64 edge : edges)
+		{
+			evaluate(Index(edge >> 32), Index(edge & 0xffffffff));
+		}
+		while (!queue.empty())
+		{
+			Collapse collapse = queue.top();
+			queue.pop();
+			if (collapse.keepVersion != versions[collapse.keep] ||
+				collapse.removeVersion != versions[collapse.remove] ||
+				!isValid(collapse))
+				continue;
+
+			// move triangles of the removed vertex to the kept one
+			for (ur_uint it : vertexTriangles[collapse.remove])
+			{
+				Index *tri = &mesh.indices[it * 3];
+				if (tri[0] == collapse.keep || tri[1] == collapse.keep || tri[2] == collapse.keep)
+				{
+					triangleRemoved[it] = true;
+					continue;
+				}
+				for (ur_uint iv = 0; iv < 3; ++iv)
+				{
+					if (tri[iv] == collapse.remove) tri[iv] = collapse.keep;
+				}
+				vertexTriangles[collapse.keep].push_back(it);
+			}
+			vertexTriangles[collapse.remove].clear();
+			for (Index n : sharedNeighbours)
+			{
+				auto &triangles = vertexTriangles[n];
+				triangles.erase(std::remove_if(triangles.begin(), triangles.end(), [&](ur_uint it) { return triangleRemoved[it]; }), triangles.end());
+			}
+			auto &keepTriangles = vertexTriangles[collapse.keep];
+			keepTriangles.erase(std::remove_if(keepTriangles.begin(), keepTriangles.end(), [&](ur_uint it) { return triangleRemoved[it]; }), keepTriangles.end());
+
+			quadrics[collapse.keep].Add(quadrics[collapse.remove]);
+			mesh.vertices[collapse.keep] = collapse.target;
+			versions[collapse.keep] += 1;
+			versions[collapse.remove] += 1;
+
+			gatherNeighbours(collapse.keep, neighbours0);
+			for (Index n : neighbours0)
+			{
+				evaluate(collapse.keep, n);
+			}
+		}
+
+		// compact
+
+		std::vector<Index> vertexRemap(vertexCount, Index(-1));
+		std::vector<Vertex> vertices;
+		std::vector<Index> indices;
+		for (ur_uint it = 0; it < trianglesCount; ++it)
+		{
+			if (triangleRemoved[it])
+				continue;
+			for (ur_uint iv = 0; iv < 3; ++iv)
+			{
+				Index &idx = vertexRemap[mesh.indices[it * 3 + iv]];
+				if (Index(-1) == idx)
+				{
+					idx = (Index)vertices.size();
+					vertices.push_back(mesh.vertices[mesh.indices[it * 3 + iv]]);
+				}
+				indices.push_back(idx);
+			}
+		}
+		mesh.vertices.swap(vertices);
+		mesh.indices.swap(indices);
+	}
+
+	void Isosurface::MeshExtractor::PackVertices(std::vector<VertexCompact> &packed, VertexCompactTransform &transform,
+		const std::vector<Vertex> &vertices, const BoundingBox &bbox)
+	{
+		static const ur_float PosMax = ur_float(0xffff);
+		static const ur_float NormMax = 32767.0f;
+
+		const ur_float3 bboxSize = bbox.Max - bbox.Min;
+		transform.offset = ur_float4(bbox.Min.x, bbox.Min.y, bbox.Min.z, 0.0f);
+		transform.scale = ur_float4(bboxSize.x, bboxSize.y, bboxSize.z, 0.0f);
+		const ur_float3 posFactor(
+			bboxSize.x > 0.0f ? PosMax / bboxSize.x : 0.0f,
+			bboxSize.y > 0.0f ? PosMax / bboxSize.y : 0.0f,
+			bboxSize.z > 0.0f ? PosMax / bboxSize.z : 0.0f);
+
+		packed.resize(vertices.size());
+		VertexCompact *p_packed = packed.data();
+		for (const Vertex &v : vertices)
+		{
+			// position
+			for (ur_uint axis = 0; axis < 3; ++axis)
+			{
+				ur_float q = (v.pos[axis] - bbox.Min[axis]) * posFactor[axis] + 0.5f;
+				p_packed->pos[axis] = (ur_uint16)std::max(0.0f, std::min(q, PosMax));
+			}
+			p_packed->pos[3] = 0;
+
+			// octahedral normal: project to the octahedron, fold lower hemisphere over the diagonals
+			ur_float2 oct(0.0f);
+			ur_float l1 = std::fabs(v.norm.x) + std::fabs(v.norm.y) + std::fabs(v.norm.z);
+			if (l1 > 0.0f)
+			{
+				oct.x = v.norm.x / l1;
+				oct.y = v.norm.y / l1;
+				if (v.norm.z < 0.0f)
+				{
+					ur_float ox = oct.x;
+					oct.x = (1.0f - std::fabs(oct.y)) * (ox >= 0.0f ? 1.0f : -1.0f);
+					oct.y = (1.0f - std::fabs(ox)) * (oct.y >= 0.0f ? 1.0f : -1.0f);
+				}
+			}
+			p_packed->norm[0] = (ur_int16)std::floor(oct.x * NormMax + 0.5f);
+			p_packed->norm[1] = (ur_int16)std::floor(oct.y * NormMax + 0.5f);
+
+			p_packed->col = v.col;
+			++p_packed;
+		}
+	}
+
+	Result Isosurface::MeshExtractor::PackIndices(std::vector<ur_uint16> &packed, const std::vector<Index> &indices)
+	{
+		packed.resize(indices.size());
+		ur_uint16 *p_packed = packed.data();
+		for (const Index &idx : indices)
+		{
+			if (idx > 0xffff)
+			{
+				packed.clear();
+				return Result(InvalidArgs);
+			}
+			*p_packed++ = (ur_uint16)idx;
+		}
+		return Result(Success);
+	}
+
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// Isosurface::Presentation
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	Isosurface::Presentation::Presentation(Isosurface &isosurface) :
+		SubSystem(isosurface)
+	{
+
+	}
+
+	Isosurface::Presentation::~Presentation()
+	{
+
+	}
+
+	Result Isosurface::Presentation::Update(const ur_float3 &refinementPoint, const ur_float4x4 &viewProj)
+	{
+		return Result(NotImplemented);
+	}
+
+	Result Isosurface::Presentation::Render(GfxContext &gfxContext, const ur_float4x4 &viewProj)
+	{
+		return Result(NotImplemented);
+	}
+
+	Result Isosurface::Presentation::Render(GrafCommandList &grafCmdList, const ur_float4x4 &viewProj)
+	{
+		return Result(NotImplemented);
+	}
+
+	void Isosurface::Presentation::DisplayImgui()
+	{
+
+	}
+
+	Isosurface::VertexFormat Isosurface::Presentation::GetVertexFormat() const
+	{
+		return VertexFormat::Full;
+	}
+
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// Isosurface::HybridCubes
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	// sample cache key quantum relative to the desired cell size
+	static const ur_float SampleCachePrecision = 1.0f / 64.0f;
+	static const ur_float SampleCacheQuantumMax = 1.0f / 8.0f;
+
+	// skirt depth in lattice cells
+	static const ur_float SkirtDepthCells = 2.0f;
+	static const ur_float SkirtToleranceUlps = 16.0f; // border vertices on-plane test precision relative to coordinates magnitude
+
+	// weight of the latest refinement point velocity sample in its smoothed estimate
+	static const ur_float PrefetchVelocitySmoothing = 0.25f;
+
+	Isosurface::HybridCubes::RefinementIndex::RefinementIndex() :
+		root(ur_null),
+		rootSize(0.0f),
+		nodesCount(0)
+	{
+	}
+
+	Isosurface::HybridCubes::RefinementIndex::~RefinementIndex()
+	{
+	}
+
+	ur_uint64 Isosurface::HybridCubes::RefinementIndex::MortonKey(ur_uint x, ur_uint y, ur_uint z)
+	{
+		auto spreadBits = [](ur_uint64 v) -> ur_uint64 {
+			v &= 0x1fffff;
+			v = (v | (v << 32)) & 0x1f00000000ffff;
+			v = (v | (v << 16)) & 0x1f0000ff0000ff;
+			v = (v | (v << 8)) & 0x100f00f00f00f00f;
+			v = (v | (v << 4)) & 0x10c30c30c30c30c3;
+			v = (v | (v << 2)) & 0x1249249249249249;
+			return v;
+		};
+		return (spreadBits(x) | (spreadBits(y) << 1) | (spreadBits(z) << 2));
+	}
+
+	ur_uint64 Isosurface::HybridCubes::RefinementIndex::NodeKey(const EmptyOctree::Node *node) const
+	{
+		const ur_float levelScale = ur_float(1u << node->GetLevel());
+		const ur_float3 cellPos = (node->GetBBox().Min - this->root->GetBBox().Min) / this->rootSize * levelScale;
+		return MortonKey(ur_uint(cellPos.x + 0.5f), ur_uint(cellPos.y + 0.5f), ur_uint(cellPos.z + 0.5f));
+	}
+
+	void Isosurface::HybridCubes::RefinementIndex::Build(const EmptyOctree &tree)
+	{
+		for (auto &level : this->levels)
+		{
+			level.clear();
+		}
+		this->nodesCount = 0;
+		this->root = ur_null;
+		if (tree.GetRoot() != ur_null)
+		{
+			this->AddSubtree(tree.GetRoot());
+		}
+	}
+
+	void Isosurface::HybridCubes::RefinementIndex::AddSubtree(const EmptyOctree::Node *node)
+	{
+		this->AddNode(node);
+		if (node->HasSubNodes())
+		{
+			for (ur_uint i = 0; i < EmptyOctree::Node::SubNodesCount; ++i)
+			{
+				this->AddSubtree(node->GetSubNode(i));
+			}
+		}
+	}
+
+	void Isosurface::HybridCubes::RefinementIndex::AddNode(const EmptyOctree::Node *node)
+	{
+		if (ur_null == node->GetParent())
+		{
+			this->root = node;
+			const BoundingBox &rootBBox = node->GetBBox();
+			this->rootSize = rootBBox.Max - rootBBox.Min;
+		}
+		if (ur_null == this->root)
+			return;
+
+		this->nodesCount += 1;
+		const ur_uint level = node->GetLevel();
+		if (level <= MaxLevels)
+		{
+			if (level >= this->levels.size())
+			{
+				this->levels.resize(level + 1);
+			}
+			this->levels[level][this->NodeKey(node)] = node;
+		}
+	}
+
+	void Isosurface::HybridCubes::RefinementIndex::RemoveNode(const EmptyOctree::Node *node)
+	{
+		if (ur_null == this->root)
+			return;
+
+		this->nodesCount -= 1;
+		const ur_uint level = node->GetLevel();
+		if (level < this->levels.size())
+		{
+			this->levels[level].erase(this->NodeKey(node));
+		}
+		if (node == this->root)
+		{
+			this->root = ur_null;
+			this->nodesCount = 0;
+		}
+	}
+
+	bool Isosurface::HybridCubes::RefinementIndex::Check(const BoundingBox &bbox) const
+	{
+		if (ur_null == this->root || !bbox.Intersects(this->root->GetBBox()))
+			return false;
+
+		// nodes of one level are of equal size; find the first level with nodes smaller than bbox,
+		// any node of this level intersecting bbox is also the ancestor of all deeper intersecting ones
+
+		const ur_float bboxSize = bbox.SizeMax();
+		ur_float nodeSize = this->root->GetBBox().SizeMin();
+		ur_uint level = 0;
+		while (nodeSize >= bboxSize)
+		{
+			nodeSize *= 0.5f;
+			++level;
+		}
+		if (level > MaxLevels)
+			return CheckTree(bbox, this->root);
+		if (level >= this->levels.size())
+			return false; // tree is not that deep
+
+		// bbox is not bigger than two cells of the level, so just a few cells are looked up;
+		// cells range is widened by a rounding margin, found nodes are tested against bbox exactly
+
+		static const ur_float CellMargin = 1.0e-3f;
+		const std::unordered_map<ur_uint64, const EmptyOctree::Node*> &levelNodes = this->levels[level];
+		const ur_float levelScale = ur_float(1u << level);
+		const ur_int cellLast = ur_int(1u << level) - 1;
+		const ur_float3 cellMinPos = (bbox.Min - this->root->GetBBox().Min) / this->rootSize * levelScale;
+		const ur_float3 cellMaxPos = (bbox.Max - this->root->GetBBox().Min) / this->rootSize * levelScale;
+		ur_int3 cellFrom, cellTo;
+		for (ur_uint axis = 0; axis < 3; ++axis)
+		{
+			cellFrom[axis] = std::max(ur_int(std::floor(cellMinPos[axis] - CellMargin)), 0);
+			cellTo[axis] = std::min(ur_int(std::floor(cellMaxPos[axis] + CellMargin)), cellLast);
+		}
+		for (ur_int iz = cellFrom.z; iz <= cellTo.z; ++iz)
+		{
+			for (ur_int iy = cellFrom.y; iy <= cellTo.y; ++iy)
+			{
+				for (ur_int ix = cellFrom.x; ix <= cellTo.x; ++ix)
+				{
+					auto it = levelNodes.find(MortonKey(ur_uint(ix), ur_uint(iy), ur_uint(iz)));
+					if (it != levelNodes.end() && bbox.Intersects(it->second->GetBBox()))
+						return true;
+				}
+			}
+		}
+
+		return false;
+	}
+
+	bool Isosurface::HybridCubes::RefinementIndex::CheckTree(const BoundingBox &bbox, const EmptyOctree::Node *node)
+	{
+		if (ur_null == node || !bbox.Intersects(node->GetBBox()))
+			return false;
+
+		ur_float nodeSize = node->GetBBox().SizeMin();
+		ur_float bboxSize = bbox.SizeMax();
+		if (bboxSize > nodeSize)
+			return true;
+
+		for (ur_uint i = 0; i < EmptyOctree::Node::SubNodesCount; ++i)
+		{
+			if (CheckTree(bbox, node->GetSubNode(i)))
+				return true;
+		}
+
+		return false;
+	}
+
+	const Isosurface::HybridCubes::Edge Isosurface::HybridCubes::Tetrahedron::Edges[EdgesCount] = {
+		{ 0, 1 }, { 1, 2 }, { 2, 0 }, { 0, 3 }, { 1, 3 }, { 2, 3 }
+	};
+
+	const ur_byte Isosurface::HybridCubes::Tetrahedron::EdgeOppositeId[EdgesCount] = {
+		5, 3, 4, 1, 2, 0
+	};
+
+	const Isosurface::HybridCubes::Face Isosurface::HybridCubes::Tetrahedron::Faces[FacesCount] = {
+		{ { 0, 1, 2 }, { 0, 1, 2 } },
+		{ { 0, 3, 1 }, { 0, 3, 4 } },
+		{ { 1, 3, 2 }, { 1, 4, 5 } },
+		{ { 2, 3, 0 }, { 2, 5, 3 } }
+	};
+
+	const Isosurface::HybridCubes::Tetrahedron::SplitInfo Isosurface::HybridCubes::Tetrahedron::EdgeSplitInfo[EdgesCount] = {
+		{ { { 0, 0xff, 2, 3 }, { 0xff, 1, 2, 3 } } },
+		{ { { 0, 1, 0xff, 3 }, { 0, 0xff, 2, 3 } } },
+		{ { { 0, 1, 0xff, 3 }, { 0xff, 1, 2, 3 } } },
+		{ { { 0, 1, 2, 0xff }, { 0xff, 1, 2, 3 } } },
+		{ { { 0, 1, 2, 0xff }, { 0, 0xff, 2, 3 } } },
+		{ { { 0, 1, 2, 0xff }, { 0, 1, 0xff, 3 } } }
+	};
+
+	#if defined(UR_GRAF)
+	Isosurface::HybridCubes::MeshPool::MeshPool(GrafRenderer &grafRenderer, ur_size vertexStride, ur_size vertexAlignment, ur_size pageVertices, ur_size pageIndices) :
+		grafRenderer(grafRenderer),
+		vertexStride(vertexStride),
+		vertexAlignment(vertexAlignment),
+		pageVertices(pageVertices),
+		pageIndices(pageIndices)
+	{
+	}
+
+	Isosurface::HybridCubes::MeshPool::~MeshPool()
+	{
+		// safely delete GRAF objects
+		for (auto &page : this->pages)
+		{
+			if (page->VB != ur_null) this->grafRenderer.SafeDelete(page->VB.release());
+			if (page->IB != ur_null) this->grafRenderer.SafeDelete(page->IB.release());
+		}
+	}
+
+	Result Isosurface::HybridCubes::MeshPool::AddPage(ur_size vertexCount, ur_size indexCount)
+	{
+		GrafSystem *grafSystem = this->grafRenderer.GetGrafSystem();
+		GrafDevice *grafDevice = this->grafRenderer.GetGrafDevice();
+
+		std::unique_ptr<Page> page(new Page());
+		Result res = grafSystem->CreateBuffer(page->VB);
+		if (Succeeded(res))
+		{
+			GrafBufferDesc bufferDesc = {};
+			bufferDesc.Usage = (ur_uint)GrafBufferUsageFlag::VertexBuffer | (ur_uint)GrafBufferUsageFlag::TransferDst;
+			bufferDesc.MemoryType = (ur_uint)GrafDeviceMemoryFlag::GpuLocal;
+			bufferDesc.SizeInBytes = vertexCount * this->vertexStride;
+			bufferDesc.ElementSize = this->vertexStride;
+			res = page->VB->Initialize(grafDevice, { bufferDesc });
+		}
+		if (Failed(res))
+			return Result(Failure);
+
+		res = grafSystem->CreateBuffer(page->IB);
+		if (Succeeded(res))
+		{
+			GrafBufferDesc bufferDesc = {};
+			bufferDesc.Usage = (ur_uint)GrafBufferUsageFlag::IndexBuffer | (ur_uint)GrafBufferUsageFlag::TransferDst;
+			bufferDesc.MemoryType = (ur_uint)GrafDeviceMemoryFlag::GpuLocal;
+			bufferDesc.SizeInBytes = indexCount * IndexUnitSize;
+			bufferDesc.ElementSize = IndexUnitSize;
+			res = page->IB->Initialize(grafDevice, { bufferDesc });
+		}
+		if (Failed(res))
+			return Result(Failure);
+
+		page->vertexAllocator.Init(vertexCount, this->vertexAlignment);
+		page->indexAllocator.Init(indexCount);
+		this->pages.push_back(std::move(page));
+
+		return Result(Success);
+	}
+
+	Result Isosurface::HybridCubes::MeshPool::Allocate(Range &range, const ur_byte *vertexData, ur_size vertexDataSize, const ur_byte *indexData, ur_size indexDataSize)
+	{
+		if (ur_null == vertexData || ur_null == indexData || 0 == vertexDataSize || 0 == indexDataSize)
+			return Result(InvalidArgs);
+
+		const ur_size vertexCount = vertexDataSize / this->vertexStride;
+		const ur_size indexUnits = (indexDataSize + IndexUnitSize - 1) / IndexUnitSize;
+		GrafBuffer *VB = ur_null;
+		GrafBuffer *IB = ur_null;
+		{
+			std::lock_guard<std::mutex> lock(this->mutex);
+
+			// find a page both vertex and index ranges fit in, add new page otherwise
+			bool allocated = false;
+			for (ur_uint ipage = 0; ipage < (ur_uint)this->pages.size() && !allocated; ++ipage)
+			{
+				Page &page = *this->pages[ipage];
+				if (page.vertexAllocator.GetLargestFreeBlock() < vertexCount ||
+					page.indexAllocator.GetLargestFreeBlock() < indexUnits)
+					continue;
+				range.page = ipage;
+				range.vertices = page.vertexAllocator.Allocate(vertexCount);
+				range.indices = page.indexAllocator.Allocate(indexUnits);
+				allocated = true;
+			}
+			if (!allocated)
+			{
+				Result res = this->AddPage(std::max(this->pageVertices, vertexCount), std::max(this->pageIndices, indexUnits));
+				if (Failed(res))
+					return res;
+				Page &page = *this->pages.back();
+				range.page = (ur_uint)this->pages.size() - 1;
+				range.vertices = page.vertexAllocator.Allocate(vertexCount);
+				range.indices = page.indexAllocator.Allocate(indexUnits);
+			}
+			VB = this->pages[range.page]->VB.get();
+			IB = this->pages[range.page]->IB.get();
+		}
+
+		Result res = this->grafRenderer.Upload((ur_byte*)vertexData, VB, vertexDataSize, range.vertices.Offset * this->vertexStride);
+		if (Succeeded(res))
+		{
+			res = this->grafRenderer.Upload((ur_byte*)indexData, IB, indexDataSize, range.indices.Offset * IndexUnitSize);
+		}
+		if (Failed(res))
+		{
+			std::lock_guard<std::mutex> lock(this->mutex);
+			this->pendingFrees.push_back(range);
+			return res;
+		}
+
+		return Result(Success);
+	}
+
+	void Isosurface::HybridCubes::MeshPool::Free(const Range &range)
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		this->pendingFrees.push_back(range);
+	}
+
+	void Isosurface::HybridCubes::MeshPool::Update()
+	{
+		std::shared_ptr<std::vector<Range>> retiredRanges(new std::vector<Range>());
+		{
+			std::lock_guard<std::mutex> lock(this->mutex);
+			if (this->pendingFrees.empty())
+				return;
+			retiredRanges->swap(this->pendingFrees);
+		}
+
+		// record empty list (we are interested in submission fence only)
+		GrafCommandList *syncCmdList = this->grafRenderer.GetTransientCommandList();
+		syncCmdList->Begin();
+		syncCmdList->End();
+		this->grafRenderer.GetGrafDevice()->Record(syncCmdList);
+
+		// release ranges when fence is signaled, pool may be destroyed by then
+		std::weak_ptr<MeshPool> poolRef = this->shared_from_this();
+		this->grafRenderer.AddCommandListCallback(syncCmdList, {}, [poolRef, retiredRanges](GrafCallbackContext& ctx) -> Result
+		{
+			std::shared_ptr<MeshPool> pool = poolRef.lock();
+			if (pool != ur_null)
+			{
+				pool->Release(*retiredRanges);
+			}
+			return Result(Success);
+		});
+	}
+
+	void Isosurface::HybridCubes::MeshPool::Release(const std::vector<Range> &ranges)
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		for (const Range &range : ranges)
+		{
+			Page &page = *this->pages[range.page];
+			page.vertexAllocator.Free(range.vertices);
+			page.indexAllocator.Free(range.indices);
+		}
+	}
+
+	GrafBuffer* Isosurface::HybridCubes::MeshPool::GetVertexBuffer(ur_uint page) const
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		return (page < this->pages.size() ? this->pages[page]->VB.get() : ur_null);
+	}
+
+	GrafBuffer* Isosurface::HybridCubes::MeshPool::GetIndexBuffer(ur_uint page) const
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		return (page < this->pages.size() ? this->pages[page]->IB.get() : ur_null);
+	}
+
+	ur_uint Isosurface::HybridCubes::MeshPool::GetPagesCount() const
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		return (ur_uint)this->pages.size();
+	}
+
+	void Isosurface::HybridCubes::MeshPool::GetMemoryStats(ur_size &usedSize, ur_size &totalSize) const
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		usedSize = 0;
+		totalSize = 0;
+		for (const auto &page : this->pages)
+		{
+			usedSize += page->vertexAllocator.GetUsedSize() * this->vertexStride + page->indexAllocator.GetUsedSize() * IndexUnitSize;
+			totalSize += page->vertexAllocator.GetSize() * this->vertexStride + page->indexAllocator.GetSize() * IndexUnitSize;
+		}
+	}
+
+	Isosurface::HybridCubes::GrafMesh::GrafMesh() :
+		range({}),
+		indexCount(0),
+		indexType(GrafIndexType::UINT32)
+	{
+	}
+
+	Isosurface::HybridCubes::GrafMesh::~GrafMesh()
+	{
+		// return range to the pool, it is reused once GPU is done with it
+		if (this->pool != ur_null && this->indexCount > 0)
+		{
+			this->pool->Free(this->range);
+		}
+	}
+	#endif
+
+	Isosurface::HybridCubes::Tetrahedron::Tetrahedron()
+	{
+		this->initialized = false;
+		this->visible = true;
+		this->level = 0;
+		this->dataVersion = 0;
+		this->longestEdgeIdx = 0;
+		this->key = 0;
+	}
+
+	Isosurface::HybridCubes::Tetrahedron::~Tetrahedron()
+	{
+	}
+
+	void Isosurface::HybridCubes::Tetrahedron::Init(const Vertex &v0, const Vertex &v1, const Vertex &v2, const Vertex &v3)
+	{
+		this->vertices[0] = v0;
+		this->vertices[1] = v1;
+		this->vertices[2] = v2;
+		this->vertices[3] = v3;
+
+		// compute the longest edge
+
+		this->longestEdgeIdx = LongestEdge(this->vertices);
+
+		// compute bbox
+
+		this->bbox = BoundingBox();
+		this->bbox.Min.SetMin(v0); this->bbox.Min.SetMin(v1); this->bbox.Min.SetMin(v2); this->bbox.Min.SetMin(v3);
+		this->bbox.Max.SetMax(v0); this->bbox.Max.SetMax(v1); this->bbox.Max.SetMax(v2); this->bbox.Max.SetMax(v3);
+	}
+
+	void Isosurface::HybridCubes::Tetrahedron::Split(std::array<std::unique_ptr<Tetrahedron>, ChildrenCount> &subTetrahedra)
+	{
+		// create sub tetrahedra
+		for (ur_uint subIdx = 0; subIdx < ChildrenCount; ++subIdx)
+		{
+			Vertex subVertices[VerticesCount];
+			ChildVertices(this->vertices, subIdx, subVertices);
+			std::unique_ptr<Tetrahedron> subTetrahedron(new Tetrahedron());
+			subTetrahedron->level = this->level + 1;
+			subTetrahedron->key = ChildKey(this->key, subIdx);
+			subTetrahedron->Init(subVertices[0], subVertices[1], subVertices[2], subVertices[3]);
+			subTetrahedra[subIdx] = std::move(subTetrahedron);
+		}
+	}
+
+	ur_uint Isosurface::HybridCubes::Tetrahedron::KeyLevel(ur_uint64 key)
+	{
+		ur_uint bitsCount = (0 == key ? 0 : LastBitIdx(key) + 1);
+		return (bitsCount > KeyRootBits ? bitsCount - KeyRootBits - 1 : 0);
+	}
+
+	ur_byte Isosurface::HybridCubes::Tetrahedron::LongestEdge(const Vertex (&vertices)[VerticesCount])
+	{
+		ur_byte longestEdgeIdx = 0;
+		float maxLen = 0.0f;
+		for (ur_byte eidx = 0; eidx < EdgesCount; ++eidx)
+		{
+			const Edge &e = Edges[eidx];
+			float len = (vertices[e.vid[0]] - vertices[e.vid[1]]).Length();
+			if (len > maxLen)
+			{
+				maxLen = len;
+				longestEdgeIdx = eidx;
+			}
+		}
+		return longestEdgeIdx;
+	}
+
+	void Isosurface::HybridCubes::Tetrahedron::ChildVertices(const Vertex (&vertices)[VerticesCount], ur_uint childIdx, Vertex (&childVertices)[VerticesCount])
+	{
+		// bisection of the longest edge
+		const ur_byte longestEdgeIdx = LongestEdge(vertices);
+		const ur_byte *ev = Edges[longestEdgeIdx].vid;
+		Vertex ecp = vertices[ev[0]] * 0.5f + vertices[ev[1]] * 0.5f;
+		const ur_byte *vid = EdgeSplitInfo[longestEdgeIdx].subTetrahedra[childIdx];
+		for (ur_uint i = 0; i < VerticesCount; ++i)
+		{
+			childVertices[i] = (vid[i] != 0xff ? vertices[vid[i]] : ecp);
+		}
+	}
+
+	void Isosurface::HybridCubes::Tetrahedron::HexahedronVertices(const Vertex (&vertices)[VerticesCount], ur_uint hexahedronIdx,
+		Vertex (&hexahedronVertices)[Hexahedron::VerticesCount])
+	{
+		// hexahedron corners: a tetrahedron vertex, adjacent edges centers, adjacent faces centers and tetrahedron center;
+		// corner ids: 0-3 vertices, 4-9 edges, 10-13 faces, 14 center
+		static const ur_byte HexahedraCorners[HexahedraCount][Hexahedron::VerticesCount] = {
+			{ 0, 6, 4, 10, 7, 13, 11, 14 },
+			{ 6, 2, 10, 5, 13, 9, 14, 12 },
+			{ 4, 10, 1, 5, 11, 14, 8, 12 },
+			{ 13, 9, 14, 12, 7, 3, 11, 8 }
+		};
+		for (ur_uint i = 0; i < Hexahedron::VerticesCount; ++i)
+		{
+			const ur_byte cid = HexahedraCorners[hexahedronIdx][i];
+			if (cid < VerticesCount)
+			{
+				hexahedronVertices[i] = vertices[cid];
+			}
+			else if (cid < VerticesCount + EdgesCount)
+			{
+				const Edge &e = Edges[cid - VerticesCount];
+				hexahedronVertices[i] = (vertices[e.vid[0]] + vertices[e.vid[1]]) / 2.0f;
+			}
+			else if (cid < VerticesCount + EdgesCount + FacesCount)
+			{
+				const Face &f = Faces[cid - VerticesCount - EdgesCount];
+				hexahedronVertices[i] = (vertices[f.vid[0]] + vertices[f.vid[1]] + vertices[f.vid[2]]) / 3.0f;
+			}
+			else
+			{
+				hexahedronVertices[i] = (vertices[0] + vertices[1] + vertices[2] + vertices[3]) / 4;
+			}
+		}
+	}
+
+	Isosurface::HybridCubes::Node::Node()
+	{
+		memset(&this->aggregates, 0, sizeof(this->aggregates));
+	}
+
+	Isosurface::HybridCubes::Node::Node(std::unique_ptr<Tetrahedron> tetrahedron)
+	{
+		this->tetrahedron = std::move(tetrahedron);
+		memset(&this->aggregates, 0, sizeof(this->aggregates));
+	}
+
+	Isosurface::HybridCubes::Node::~Node()
+	{
+	}
+
+	void Isosurface::HybridCubes::Node::Split()
+	{
+		if (this->HasChildren() ||
+			this->tetrahedron.get() == ur_null)
+			return;
+
+		// create sub nodes
+		std::array<std::unique_ptr<Tetrahedron>, Tetrahedron::ChildrenCount> subTetrahedra;
+		this->tetrahedron->Split(subTetrahedra);
+		for (ur_uint subIdx = 0; subIdx < Tetrahedron::ChildrenCount; ++subIdx)
+		{
+			this->children[subIdx].reset(new Node(std::move(subTetrahedra[subIdx])));
+		}
+	}
+
+	void Isosurface::HybridCubes::Node::Merge()
+	{
+		if (!this->HasChildren())
+			return;
+
+		for (auto &child : this->children)
+		{
+			child = ur_null;
+		}
+	}
+
+	Isosurface::HybridCubes::SampleCache::SampleCache()
+	{
+		this->quantumInv = 0.0f;
+		this->requestsCount = 0;
+		this->hitsCount = 0;
+	}
+
+	Isosurface::HybridCubes::SampleCache::~SampleCache()
+	{
+	}
+
+	Result Isosurface::HybridCubes::SampleCache::Init(const BoundingBox &bound, ur_float precision, ur_float quantumMax)
+	{
+		for (auto &shard : this->shards)
+		{
+			std::lock_guard<std::mutex> lock(shard.mutex);
+			shard.samples.clear();
+			shard.samplesPrev.clear();
+		}
+		this->bound = bound;
+
+		// coarser quantization is tolerated for large bounds until different lattice points start to share keys
+		ur_float quantum = std::max(precision, bound.SizeMax() / ur_float(KeyAxisMask));
+		if (quantum > quantumMax)
+		{
+			this->quantumInv = 0.0f;
+			return Result(InvalidArgs);
+		}
+		this->quantumInv = (quantum > 0.0f ? 1.0f / quantum : 0.0f);
+
+		return Result(Success);
+	}
+
+	void Isosurface::HybridCubes::SampleCache::NextPass()
+	{
+		// samples of the previous pass are still valid for coincident points of split tetrahedra,
+		// older ones are discarded to keep memory bounded
+		for (auto &shard : this->shards)
+		{
+			std::lock_guard<std::mutex> lock(shard.mutex);
+			shard.samplesPrev.swap(shard.samples);
+			shard.samples.clear();
+		}
+	}
+
+	void Isosurface::HybridCubes::SampleCache::ResetCounters()
+	{
+		this->requestsCount = 0;
+		this->hitsCount = 0;
+	}
+
+	ur_uint64 Isosurface::HybridCubes::SampleCache::ComputeKey(const ur_float3 &point, const ur_uint level) const
+	{
+		ur_float3 p = (point - this->bound.Min) * this->quantumInv;
+		ur_uint64 qx = (ur_uint64)std::min(std::max(p.x + 0.5f, 0.0f), ur_float(KeyAxisMask));
+		ur_uint64 qy = (ur_uint64)std::min(std::max(p.y + 0.5f, 0.0f), ur_float(KeyAxisMask));
+		ur_uint64 qz = (ur_uint64)std::min(std::max(p.z + 0.5f, 0.0f), ur_float(KeyAxisMask));
+		return (qx | (qy << KeyAxisBits) | (qz << (KeyAxisBits * 2)) | (ur_uint64(level) << KeyLevelOfs));
+	}
+
+	void Isosurface::HybridCubes::SampleCache::SortByShard(std::vector<ur_uint> &sortedIds, ur_uint (&shardFirst)[ShardsCount + 1],
+		const ur_uint64 *keys, const ur_uint *ids, const ur_uint count)
+	{
+		memset(shardFirst, 0, sizeof(shardFirst));
+		for (ur_uint i = 0; i < count; ++i)
+		{
+			++shardFirst[ShardIdx(keys[ur_null == ids ? i : ids[i]]) + 1];
+		}
+		for (ur_uint is = 0; is < ShardsCount; ++is)
+		{
+			shardFirst[is + 1] += shardFirst[is];
+		}
+		ur_uint shardNext[ShardsCount];
+		memcpy(shardNext, shardFirst, sizeof(shardNext));
+		sortedIds.resize(count);
+		for (ur_uint i = 0; i < count; ++i)
+		{
+			const ur_uint id = (ur_null == ids ? i : ids[i]);
+			sortedIds[shardNext[ShardIdx(keys[id])]++] = id;
+		}
+	}
+
+	void Isosurface::HybridCubes::SampleCache::Fetch(DataVolume::ValueType *values, ur_uint64 *keys, const ur_float3 *points, const ur_uint count, const ur_uint level,
+		const ur_bool parentLevel, std::vector<ur_uint> &missedIds)
+	{
+		missedIds.clear();
+		if (0 == count)
+			return;
+
+		for (ur_uint i = 0; i < count; ++i)
+		{
+			keys[i] = this->ComputeKey(points[i], level);
+		}
+
+		// each shard is locked once for all points it holds
+		std::vector<ur_uint> sortedIds;
+		ur_uint shardFirst[ShardsCount + 1];
+		SortByShard(sortedIds, shardFirst, keys, ur_null, count);
+		std::vector<ur_byte> missed(count, 0);
+		ur_uint hits = 0;
+		for (ur_uint is = 0; is < ShardsCount; ++is)
+		{
+			if (shardFirst[is] == shardFirst[is + 1])
+				continue;
+			Shard &shard = this->shards[is];
+			std::lock_guard<std::mutex> lock(shard.mutex);
+			for (ur_uint si = shardFirst[is]; si < shardFirst[is + 1]; ++si)
+			{
+				// same level sample from current or previous pass,
+				// otherwise parent level sample at coincident point if it is the same for all levels
+				const ur_uint i = sortedIds[si];
+				const DataVolume::ValueType *cachedValue = ur_null;
+				const ur_uint64 parentKey = (keys[i] & KeyPositionMask) | (ur_uint64(level > 0 ? level - 1 : 0) << KeyLevelOfs);
+				const ur_uint64 lookupKeys[2] = { keys[i], parentKey };
+				for (ur_uint ik = 0; ik < (parentLevel && level > 0 ? 2u : 1u) && ur_null == cachedValue; ++ik)
+				{
+					auto it = shard.samples.find(lookupKeys[ik]);
+					if (it != shard.samples.end())
+					{
+						cachedValue = &it->second;
+						break;
+					}
+					it = shard.samplesPrev.find(lookupKeys[ik]);
+					if (it != shard.samplesPrev.end())
+					{
+						cachedValue = &it->second;
+					}
+				}
+				if (cachedValue != ur_null)
+				{
+					values[i] = *cachedValue;
+					++hits;
+				}
+				else
+				{
+					missed[i] = 1;
+				}
+			}
+		}
+		for (ur_uint i = 0; i < count; ++i)
+		{
+			if (missed[i]) missedIds.push_back(i);
+		}
+		this->requestsCount += count;
+		this->hitsCount += hits;
+	}
+
+	void Isosurface::HybridCubes::SampleCache::Store(const DataVolume::ValueType *values, const ur_uint64 *keys, const std::vector<ur_uint> &ids)
+	{
+		if (ids.empty())
+			return;
+
+		std::vector<ur_uint> sortedIds;
+		ur_uint shardFirst[ShardsCount + 1];
+		SortByShard(sortedIds, shardFirst, keys, ids.data(), (ur_uint)ids.size());
+		for (ur_uint is = 0; is < ShardsCount; ++is)
+		{
+			if (shardFirst[is] == shardFirst[is + 1])
+				continue;
+			Shard &shard = this->shards[is];
+			std::lock_guard<std::mutex> lock(shard.mutex);
+			for (ur_uint si = shardFirst[is]; si < shardFirst[is + 1] && shard.samples.size() < ShardSamplesMax; ++si)
+			{
+				const ur_uint i = sortedIds[si];
+				shard.samples.emplace(keys[i], values[i]);
+			}
+		}
+	}
+
+	void Isosurface::HybridCubes::SampleCache::Invalidate(const std::vector<BoundingBox> &regions)
+	{
+		if (regions.empty() || 0.0f == this->quantumInv)
+			return;
+
+		const ur_float quantum = 1.0f / this->quantumInv;
+		auto isInvalid = [&](const ur_uint64 key) -> bool {
+			ur_float3 point(
+				this->bound.Min.x + ur_float(key & KeyAxisMask) * quantum,
+				this->bound.Min.y + ur_float((key >> KeyAxisBits) & KeyAxisMask) * quantum,
+				this->bound.Min.z + ur_float((key >> (KeyAxisBits * 2)) & KeyAxisMask) * quantum);
+			for (const auto &region : regions)
+			{
+				if (region.Intersects(point))
+					return true;
+			}
+			return false;
+		};
+
+		for (auto &shard : this->shards)
+		{
+			std::lock_guard<std::mutex> lock(shard.mutex);
+			for (auto *samplesMap : { &shard.samples, &shard.samplesPrev })
+			{
+				for (auto it = samplesMap->begin(); it != samplesMap->end(); )
+				{
+					if (isInvalid(it->first))
+						it = samplesMap->erase(it);
+					else
+						++it;
+				}
+			}
+		}
+	}
+
+	Isosurface::HybridCubes::MeshCache::MeshCache()
+	{
+		this->budget = 0;
+		this->size = 0;
+		this->requestsCount = 0;
+		this->hitsCount = 0;
+	}
+
+	Isosurface::HybridCubes::MeshCache::~MeshCache()
+	{
+	}
+
+	void Isosurface::HybridCubes::MeshCache::Init(ur_size budget)
+	{
+		this->budget = budget;
+		this->entries.clear();
+		this->entriesMap.clear();
+		this->size = 0;
+	}
+
+	void Isosurface::HybridCubes::MeshCache::Put(const std::shared_ptr<Tetrahedron> &tetrahedron, ur_size size)
+	{
+		if (ur_null == tetrahedron || 0 == tetrahedron->key || size > this->budget)
+			return;
+
+		std::lock_guard<std::mutex> lock(this->mutex);
+
+		// replace an entry of the same tree path (a merged tetrahedron can be cached again before it is taken)
+		auto it = this->entriesMap.find(tetrahedron->key);
+		if (it != this->entriesMap.end())
+		{
+			this->Evict(it->second);
+		}
+
+		this->entries.push_front({ tetrahedron, size });
+		this->entriesMap[tetrahedron->key] = this->entries.begin();
+		this->size += size;
+
+		// evict least recently used entries
+		while (this->size > this->budget)
+		{
+			this->Evict(std::prev(this->entries.end()));
+		}
+	}
+
+	std::shared_ptr<Isosurface::HybridCubes::Tetrahedron> Isosurface::HybridCubes::MeshCache::Take(ur_uint64 key)
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		this->requestsCount += 1;
+		auto it = this->entriesMap.find(key);
+		if (it == this->entriesMap.end())
+			return ur_null;
+
+		std::shared_ptr<Tetrahedron> tetrahedron = it->second->tetrahedron;
+		this->Evict(it->second);
+		this->hitsCount += 1;
+		return tetrahedron;
+	}
+
+	void Isosurface::HybridCubes::MeshCache::Invalidate(const std::vector<BoundingBox> &regions)
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		for (auto it = this->entries.begin(); it != this->entries.end(); )
+		{
+			auto entryIt = it++;
+			for (const auto &region : regions)
+			{
+				if (region.Intersects(entryIt->tetrahedron->bbox))
+				{
+					this->Evict(entryIt);
+					break;
+				}
+			}
+		}
+	}
+
+	void Isosurface::HybridCubes::MeshCache::ResetCounters()
+	{
+		this->requestsCount = 0;
+		this->hitsCount = 0;
+	}
+
+	void Isosurface::HybridCubes::MeshCache::Evict(std::list<Entry>::iterator it)
+	{
+		this->size -= it->size;
+		this->entriesMap.erase(it->tetrahedron->key);
+		this->entries.erase(it);
+	}
+
+	Isosurface::HybridCubes::HybridCubes(Isosurface &isosurface, const Desc &desc) :
+		Presentation(isosurface),
+		refinementTree(EmptyOctree::DefaultDepth, [this](EmptyOctree::Node *node, EmptyOctree::Event e) -> void {
+			if (EmptyOctree::Event::NodeAdded == e)
+				this->refinementIndex.AddNode(node);
+			else
+				this->refinementIndex.RemoveNode(node);
+		})
+	{
+		this->desc = desc;
+		this->freezeUpdate = false;
+		this->hideSurface = false;
+		this->drawTetrahedra = false;
+		this->hideEmptyTetrahedra = false;
+		this->drawHexahedra = false;
+		this->drawRefinementTree = false;
+		this->parallelBuild = true;
+		this->parallelUpdate = true;
+		this->refinementPointPrev = 0.0f;
+		this->refinementView.projectionScale = 0.0f;
+		this->refinementView.viewDirection = 0.0f;
+		for (auto &plane : this->refinementView.frustumPlanes) plane = ur_float4(0.0f, 0.0f, 0.0f, 0.0f);
+		this->refinementViewPrev = this->refinementView;
+		this->refinementViewChanged = false;
+		for (auto &vertices : this->rootVertices)
+		{
+			for (auto &v : vertices) v = 0.0f;
+		}
+		this->updateViewProj = ur_float4x4::Identity;
+		this->refinementTreeFullUpdate = true;
+		memset(&this->stats, 0, sizeof(this->stats));
+		memset(&this->statsBack, 0, sizeof(this->statsBack));
+		this->jobBuildCounter = 0;
+		this->jobBuildRequested = 0;
+		this->buildPassesActive = 0;
+		this->buildLatencyNext = 0;
+		this->updatePredictedPoint = 0.0f;
+		this->prefetchPointPrev = 0.0f;
+		this->prefetchVelocity = 0.0f;
+		this->prefetchUpdateIdx = 0;
+		this->prefetchRequested = 0;
+		this->prefetchHits = 0;
+		this->prefetchMisses = 0;
+		this->meshCache.Init(desc.MeshCacheBudget);
+		this->diskCacheHash = 0;
+		this->diskCacheRequests = 0;
+		this->diskCacheHits = 0;
+		this->diskCacheJobActive = false;
+		this->diskCacheWriteCounter = 0;
+		this->dataVersion = 0;
+		#if defined(UR_GRAF)
+		this->boundVertexBuffer = ur_null;
+		this->boundIndexBuffer = ur_null;
+		this->boundIndexType = GrafIndexType::UINT32;
+		#endif
+	}
+
+	Isosurface::HybridCubes::~HybridCubes()
+	{
+		if (this->jobUpdate != ur_null)
+		{
+			this->jobUpdate->Interrupt();
+			this->jobUpdate->Wait();
+		}
+		for (auto &job : this->jobBuild)
+		{
+			job->Interrupt();
+			job->Wait();
+		}
+		this->CancelPrefetch();
+		this->FlushDiskCache();
+	}
+
+	Result Isosurface::HybridCubes::Update(const ur_float3 &refinementPoint, const ur_float4x4 &viewProj)
+	{
+		if (ur_null == this->isosurface.GetData())
+			return Result(NotInitialized);
+
+		#if defined(UR_GRAF)
+		// init mesh pool
+		if (ur_null == this->meshPool && this->isosurface.grafRenderer != ur_null)
+		{
+			const bool compact = (VertexFormat::Compact == this->desc.MeshVertexFormat);
+			this->meshPool.reset(new MeshPool(*this->isosurface.grafRenderer,
+				(compact ? sizeof(VertexCompact) : sizeof(Isosurface::Vertex)),
+				(compact ? sizeof(VertexCompactTransform) / sizeof(VertexCompact) : 1), // compact range starts with a per instance transform
+				MeshPoolPageVertices, MeshPoolPageIndices));
+		}
+		#endif
+
+		// persistent mesh cache is bound to the current data content and settings
+		if (!this->desc.DiskCachePath.empty() && 0 == this->diskCacheHash)
+		{
+			this->diskCacheHash = this->ComputeDiskCacheHash();
+		}
+
+		this->InitHierarchy();
+
+		if (this->freezeUpdate)
+			return Success;
+
+		// track refinement point velocity to predict its position for prefetching
+		if (this->desc.PrefetchTime > 0.0f)
+		{
+			ClockTime timeNow = Clock::now();
+			ur_float elapsed = std::chrono::duration<ur_float>(timeNow - this->prefetchTimePrev).count();
+			if (this->prefetchTimePrev != ClockTime() && elapsed > 0.0f)
+			{
+				ur_float3 velocity = (refinementPoint - this->prefetchPointPrev) * (1.0f / elapsed);
+				this->prefetchVelocity = ur_float3::Lerp(this->prefetchVelocity, velocity, PrefetchVelocitySmoothing);
+			}
+			this->prefetchPointPrev = refinementPoint;
+			this->prefetchTimePrev = timeNow;
+		}
+
+		Result res(Success);
+		bool updateSync = false;
+		if (updateSync)
+		{
+			memset(&this->stats, 0, sizeof(this->stats));
+
+			// update refinement tree
+			this->UpdateRefinementTree(refinementPoint, viewProj, this->refinementTree.GetRoot(), &this->stats);
+
+			// track data modifications
+			this->UpdateDirtyRegions();
+
+			// update hierarchy
+			res &= this->UpdateHierarchy(refinementPoint, false, this->stats);
+			std::shared_ptr<Hierarchy> hierarchyNext = this->hierarchyNext;
+			this->hierarchyNext.reset();
+
+			// build meshes
+			this->sampleCache.ResetCounters();
+			this->sampleCache.NextPass();
+			for (auto &request : this->buildQueue)
+			{
+				res &= this->BuildMesh(request.tetrahedron, &this->stats);
+			}
+			for (auto &tetrahedron : this->rebuildQueue)
+			{
+				res &= this->BuildMesh(tetrahedron, &this->stats);
+			}
+			this->stats.rebuildQueue = (ur_uint)this->rebuildQueue.size();
+			this->buildQueue.clear();
+			this->rebuildQueue.clear();
+			this->stats.samplesRequested = this->sampleCache.GetRequestsCount();
+			this->stats.samplesCached = this->sampleCache.GetHitsCount();
+			this->hierarchyRetired.push_back(std::atomic_exchange(&this->hierarchy, hierarchyNext));
+		}
+		else
+		{
+			auto &jobSystem = this->isosurface.GetRealm().GetJobSystem();
+
+			// do update/build job(s)
+			if ((this->jobUpdate == ur_null || this->jobUpdate->Finished()) &&
+				(this->jobBuildCounter >= this->jobBuildRequested))
+			{
+				// make visible new meshes and track their latency
+				ClockTime buildFinishTime = Clock::now();
+				ur_uint buildSkipped = 0;
+				for (auto &jobCtx : this->jobBuildCtx)
+				{
+					Tetrahedron *tetrahedron = jobCtx.tetrahedron;
+					tetrahedron->visible = true;
+					if (!tetrahedron->initialized)
+					{
+						buildSkipped += 1; // deferred by time budget, requested again by the next update
+						continue;
+					}
+					if (this->buildLatencies.size() < BuildLatencySamples)
+						this->buildLatencies.resize(BuildLatencySamples);
+					this->buildLatencies[this->buildLatencyNext % BuildLatencySamples] =
+						std::chrono::duration<ur_float, std::milli>(buildFinishTime - tetrahedron->queueTime).count();
+					this->buildLatencyNext += 1;
+				}
+
+				// reset previous build job(s) data
+				this->jobBuildCounter = 0;
+				this->jobBuildRequested = 0;
+				this->jobBuild.clear();
+				this->jobBuildCtx.clear();
+
+				// make the updated hierarchy live, the replaced one is released after the next render
+				if (this->jobUpdate != ur_null &&
+					this->jobUpdate->FinishedSuccessfully() &&
+					this->hierarchyNext != ur_null)
+				{
+					if (this->hierarchyRetired.size() >= HierarchyRetiredMax)
+					{
+						this->hierarchyRetired.erase(this->hierarchyRetired.begin()); // not rendered meanwhile
+					}
+					this->hierarchyRetired.push_back(std::atomic_exchange(&this->hierarchy, this->hierarchyNext));
+					this->statsBack.samplesRequested = this->sampleCache.GetRequestsCount();
+					this->statsBack.samplesCached = this->sampleCache.GetHitsCount();
+					this->statsBack.diskCacheRequests = this->diskCacheRequests;
+					this->statsBack.diskCacheHits = this->diskCacheHits;
+					memcpy(&this->stats, &this->statsBack, sizeof(this->stats));
+				}
+				this->hierarchyNext.reset();
+				this->stats.buildDeferred += buildSkipped;
+				this->GatherBuildLatencyStats(this->stats);
+				
+				// prepare update context
+				this->updatePoint = refinementPoint;
+				this->updateViewProj = viewProj;
+				this->updatePredictedPoint = refinementPoint + this->prefetchVelocity * this->desc.PrefetchTime;
+
+				// start a new update
+				this->jobUpdate = jobSystem.Add(JobPriority::Low, Job::DataPtr(this), [](Job::Context& ctx) -> void {
+
+					Result result = Success;
+
+					// reinterpret data ptr
+					HybridCubes *presentation = reinterpret_cast<HybridCubes*>(ctx.data);
+					auto &jobSystem = presentation->isosurface.GetRealm().GetJobSystem();
+					
+					// reset presentation
+					presentation->buildQueue.clear();
+					presentation->rebuildQueue.clear();
+					presentation->sampleCache.ResetCounters();
+					presentation->meshCache.ResetCounters();
+					presentation->diskCacheRequests = 0;
+					presentation->diskCacheHits = 0;
+					memset(&presentation->statsBack, 0, sizeof(presentation->statsBack));
+
+					// track data modifications
+					presentation->UpdateDirtyRegions();
+
+					// hint data volume about the region to be refined
+					ur_float3 prefetchExtent(presentation->desc.DetailLevelDistance * 2.0f);
+					presentation->isosurface.GetData()->Prefetch(BoundingBox(
+						presentation->updatePoint - prefetchExtent, presentation->updatePoint + prefetchExtent));
+
+					// update refinement tree
+					presentation->UpdateRefinementTree(presentation->updatePoint, presentation->updateViewProj,
+						presentation->refinementTree.GetRoot(), &presentation->statsBack);
+
+					// update hierarchy: the next one shares unchanged sub trees with the live one
+					result &= presentation->UpdateHierarchy(presentation->updatePoint, presentation->parallelUpdate, presentation->statsBack);
+					presentation->statsBack.meshCacheRequests = presentation->meshCache.GetRequestsCount();
+					presentation->statsBack.meshCacheHits = presentation->meshCache.GetHitsCount();
+					presentation->statsBack.meshCacheMemory = (ur_uint)presentation->meshCache.GetSize();
+
+					// build meshes
+					if (!presentation->buildQueue.empty() || !presentation->rebuildQueue.empty())
+					{
+						// samples of the previous build pass are kept for the current one
+						presentation->sampleCache.NextPass();
+
+						// modified tetrahedra are rebuilt at once at their current level;
+						// new ones are taken in priority order: all levels at once if skirts hide seams between neighbour LoDs,
+						// otherwise one level per update iteration (to avoid seams); the rest is deferred by job count budget
+						// and requested again by the next update
+						for (auto &tetrahedron : presentation->rebuildQueue)
+						{
+							presentation->jobBuildCtx.push_back({ presentation, tetrahedron, false });
+						}
+						auto &buildQueue = presentation->buildQueue;
+						ur_uint buildLevel = (buildQueue.empty() ? 0 : buildQueue.front().level);
+						ur_uint buildCount = 0;
+						while (!buildQueue.empty() && buildQueue.front().level == buildLevel &&
+							(0 == presentation->desc.BuildBudgetJobs || buildCount < presentation->desc.BuildBudgetJobs))
+						{
+							presentation->jobBuildCtx.push_back({ presentation, buildQueue.front().tetrahedron, true });
+							std::pop_heap(buildQueue.begin(), buildQueue.end());
+							buildQueue.pop_back();
+							buildCount += 1;
+						}
+						presentation->statsBack.buildDeferred = (ur_uint)buildQueue.size();
+
+						presentation->jobBuildStartTime = Clock::now();
+						for (auto &buildCtx : presentation->jobBuildCtx)
+						{
+							presentation->jobBuildRequested += 1;
+
+							// mesh building job
+							presentation->jobBuild.push_back(jobSystem.Add(Job::DataPtr(&buildCtx), [](Job::Context& ctx) -> void {
+
+								Result result = Success;
+
+								BuildJobContext *jobData = reinterpret_cast<BuildJobContext*>(ctx.data);
+								HybridCubes *presentation = jobData->presentation;
+								Tetrahedron *tetrahedron = jobData->tetrahedron;
+
+								// jobs are started in priority order, the ones left when time budget is exceeded are deferred
+								ur_float buildBudgetTime = presentation->desc.BuildBudgetTime;
+								if (jobData->budgeted && buildBudgetTime > 0.0f &&
+									std::chrono::duration<ur_float, std::milli>(Clock::now() - presentation->jobBuildStartTime).count() > buildBudgetTime)
+								{
+									presentation->jobBuildCounter += 1;
+									return;
+								}
+
+								tetrahedron->visible = false;
+
+								result &= presentation->BuildMesh(tetrahedron, &presentation->statsBack);
+
+								ctx.resultCode = result.Code;
+
+								presentation->jobBuildCounter += 1;
+							}));
+						}
+						presentation->statsBack.buildQueue = buildCount;
+						presentation->statsBack.rebuildQueue = (ur_uint)presentation->rebuildQueue.size();
+						presentation->buildQueue.clear();
+						presentation->rebuildQueue.clear();
+					}
+
+					// speculative builds at the predicted refinement point
+					if (presentation->desc.PrefetchTime > 0.0f)
+					{
+						presentation->UpdatePrefetch(presentation->updatePoint, presentation->updatePredictedPoint, &presentation->statsBack);
+					}
+
+					ctx.resultCode = result.Code;
+				});
+			}
+		}
+
+		return res;
+	}
+
+	Result Isosurface::HybridCubes::RefineHierarchy(const ur_float3 &refinementPoint, const ur_float4x4 &viewProj, ur_bool parallel,
+		std::vector<ur_uint64> &keys, std::vector<ur_uint64> &buildKeys)
+	{
+		if (ur_null == this->isosurface.GetData())
+			return Result(NotInitialized);
+
+		this->InitHierarchy();
+
+		Stats stats;
+		memset(&stats, 0, sizeof(stats));
+		this->UpdateRefinementTree(refinementPoint, viewProj, this->refinementTree.GetRoot(), &stats);
+		this->buildQueue.clear();
+		this->rebuildQueue.clear();
+		Result res = this->UpdateHierarchy(refinementPoint, parallel, stats);
+
+		// meshes are not built, the next hierarchy is taken as is
+		buildKeys.clear();
+		buildKeys.reserve(this->rebuildQueue.size() + this->buildQueue.size());
+		for (const auto &tetrahedron : this->rebuildQueue)
+		{
+			buildKeys.push_back(tetrahedron->key);
+		}
+		while (!this->buildQueue.empty())
+		{
+			buildKeys.push_back(this->buildQueue.front().tetrahedron->key);
+			std::pop_heap(this->buildQueue.begin(), this->buildQueue.end());
+			this->buildQueue.pop_back();
+		}
+		std::atomic_store(&this->hierarchy, this->hierarchyNext);
+		this->hierarchyNext.reset();
+		this->buildQueue.clear();
+		this->rebuildQueue.clear();
+
+		keys.clear();
+		keys.reserve(stats.tetrahedraCount);
+		std::function<void(const Node*)> gatherKeys = [&keys, &gatherKeys](const Node *node) -> void {
+			if (ur_null == node || ur_null == node->tetrahedron)
+				return;
+			keys.push_back(node->tetrahedron->key);
+			if (node->HasChildren())
+			{
+				for (const auto &child : node->children)
+				{
+					gatherKeys(child.get());
+				}
+			}
+		};
+		std::shared_ptr<Hierarchy> hierarchy = std::atomic_load(&this->hierarchy);
+		for (const auto &root : hierarchy->roots)
+		{
+			gatherKeys(root.get());
+		}
+
+		return res;
+	}
+
+	void Isosurface::HybridCubes::InitHierarchy()
+	{
+		// init roots
+		const BoundingBox &bbox = this->isosurface.GetData()->GetBound();
+		if (ur_null == std::atomic_load(&this->hierarchy))
+		{
+			const Vertex vertices[RootsCount][Tetrahedron::VerticesCount] = {
+				{ { bbox.Min.x, bbox.Min.y, bbox.Min.z }, { bbox.Min.x, bbox.Max.y, bbox.Min.z }, { bbox.Max.x, bbox.Max.y, bbox.Min.z }, { bbox.Max.x, bbox.Max.y, bbox.Max.z } },
+				{ { bbox.Min.x, bbox.Min.y, bbox.Min.z }, { bbox.Max.x, bbox.Max.y, bbox.Min.z }, { bbox.Max.x, bbox.Min.y, bbox.Min.z }, { bbox.Max.x, bbox.Max.y, bbox.Max.z } },
+				{ { bbox.Min.x, bbox.Min.y, bbox.Min.z }, { bbox.Max.x, bbox.Min.y, bbox.Min.z }, { bbox.Max.x, bbox.Min.y, bbox.Max.z }, { bbox.Max.x, bbox.Max.y, bbox.Max.z } },
+				{ { bbox.Min.x, bbox.Min.y, bbox.Min.z }, { bbox.Min.x, bbox.Max.y, bbox.Max.z }, { bbox.Min.x, bbox.Max.y, bbox.Min.z }, { bbox.Max.x, bbox.Max.y, bbox.Max.z } },
+				{ { bbox.Min.x, bbox.Min.y, bbox.Min.z }, { bbox.Min.x, bbox.Min.y, bbox.Max.z }, { bbox.Min.x, bbox.Max.y, bbox.Max.z }, { bbox.Max.x, bbox.Max.y, bbox.Max.z } },
+				{ { bbox.Min.x, bbox.Min.y, bbox.Min.z }, { bbox.Max.x, bbox.Min.y, bbox.Max.z }, { bbox.Min.x, bbox.Min.y, bbox.Max.z }, { bbox.Max.x, bbox.Max.y, bbox.Max.z } }
+			};
+			std::shared_ptr<Hierarchy> newHierarchy(new Hierarchy());
+			for (ur_uint ir = 0; ir < RootsCount; ++ir)
+			{
+				std::unique_ptr<Tetrahedron> th(new Tetrahedron());
+				for (ur_uint iv = 0; iv < Tetrahedron::VerticesCount; ++iv)
+				{
+					this->rootVertices[ir][iv] = vertices[ir][iv];
+				}
+				th->Init(vertices[ir][0], vertices[ir][1], vertices[ir][2], vertices[ir][3]);
+				th->key = Tetrahedron::RootKey(ir);
+				newHierarchy->roots[ir].reset(new Node(std::move(th)));
+			}
+			std::atomic_store(&this->hierarchy, newHierarchy);
+
+			// new hierarchy has no LoD applied yet
+			this->refinementChanges.assign(1, bbox);
+		}
+		if (ur_null == this->refinementTree.GetRoot())
+		{
+			this->refinementTree.Init(bbox);
+			this->refinementTreeFullUpdate = true;
+			this->refinementChanges.assign(1, bbox);
+			if (Failed(this->sampleCache.Init(bbox, this->desc.CellSize * SampleCachePrecision, this->desc.CellSize * SampleCacheQuantumMax)))
+			{
+				this->isosurface.GetRealm().GetLog().WriteLine("Isosurface::HybridCubes: volume bound is too large to key lattice samples, sample cache is disabled", Log::Warning);
+			}
+			ur_float nodeSize = (bbox.Max - bbox.Min).Length();
+			ur_float cellSize = (nodeSize / (this->desc.LatticeResolution.GetMaxValue() * 2));
+			ur_uint levels = 0;
+			while (cellSize > this->desc.CellSize)
+			{
+				cellSize *= 0.5;
+				++levels;
+			}
+			ur_float levelDistance = this->desc.DetailLevelDistance;
+			this->refinementDistance.resize(levels);
+			for (ur_uint i = levels; i > 0; --i)
+			{
+				this->refinementDistance[i - 1] = levelDistance;
+				levelDistance += levelDistance * 2.0f;
+			}
+		}
+	}
+
+	ur_bool Isosurface::HybridCubes::GetKeyVertices(ur_uint64 key, ur_float3 (&vertices)[4]) const
+	{
+		const ur_uint level = Tetrahedron::KeyLevel(key);
+		const ur_uint rootIdx = Tetrahedron::KeyRoot(key);
+		if (0 == key || rootIdx >= RootsCount)
+			return false;
+
+		// replay bisections from the root along the key path
+		for (ur_uint iv = 0; iv < Tetrahedron::VerticesCount; ++iv)
+		{
+			vertices[iv] = this->rootVertices[rootIdx][iv];
+		}
+		for (ur_uint ilevel = level; ilevel > 0; --ilevel)
+		{
+			Vertex parentVertices[Tetrahedron::VerticesCount];
+			std::copy(std::begin(vertices), std::end(vertices), parentVertices);
+			Tetrahedron::ChildVertices(parentVertices, ur_uint(key >> (ilevel - 1)) & 0x1, vertices);
+		}
+
+		return true;
+	}
+
+	std::shared_ptr<Isosurface::HybridCubes::Node> Isosurface::HybridCubes::FindNode(const Hierarchy &hierarchy, ur_uint64 key) const
+	{
+		const ur_uint level = Tetrahedron::KeyLevel(key);
+		const ur_uint rootIdx = Tetrahedron::KeyRoot(key);
+		if (0 == key || rootIdx >= RootsCount)
+			return ur_null;
+
+		std::shared_ptr<Node> node = hierarchy.roots[rootIdx];
+		for (ur_uint ilevel = level; ilevel > 0 && node != ur_null; --ilevel)
+		{
+			if (!node->HasChildren())
+				return ur_null;
+			node = node->children[ur_uint(key >> (ilevel - 1)) & 0x1];
+		}
+
+		return node;
+	}
+
+	// lowest barycentric coordinate of the point, negative if the point is outside of the tetrahedron
+	static ur_float TetrahedronInsideness(const ur_float3 (&vertices)[4], const ur_float3 &point)
+	{
+		auto volume = [](const ur_float3 &v0, const ur_float3 &v1, const ur_float3 &v2, const ur_float3 &v3) -> ur_float {
+			return ur_float3::Dot(ur_float3::Cross(v1 - v0, v2 - v0), v3 - v0);
+		};
+		ur_float totalVolume = volume(vertices[0], vertices[1], vertices[2], vertices[3]);
+		if (std::fabs(totalVolume) <= std::numeric_limits<ur_float>::min())
+			return -std::numeric_limits<ur_float>::max();
+		// barycentric coordinates are volume ratios, their signs do not depend on vertices order
+		ur_float insideness = volume(point, vertices[1], vertices[2], vertices[3]) / totalVolume;
+		insideness = std::min(insideness, volume(vertices[0], point, vertices[2], vertices[3]) / totalVolume);
+		insideness = std::min(insideness, volume(vertices[0], vertices[1], point, vertices[3]) / totalVolume);
+		insideness = std::min(insideness, volume(vertices[0], vertices[1], vertices[2], point) / totalVolume);
+		return insideness;
+	}
+
+	std::shared_ptr<Isosurface::HybridCubes::Node> Isosurface::HybridCubes::FindNeighbour(const Hierarchy &hierarchy, ur_uint64 key, ur_uint faceIdx) const
+	{
+		Vertex vertices[Tetrahedron::VerticesCount];
+		if (faceIdx >= Tetrahedron::FacesCount || !this->GetKeyVertices(key, vertices))
+			return ur_null;
+
+		// point just behind the face center, on the side opposite to the tetrahedron's fourth vertex
+		static const ur_float NeighbourPointOffset = 1.0e-3f;
+		const Face &face = Tetrahedron::Faces[faceIdx];
+		const ur_uint oppositeIdx = 6 - face.vid[0] - face.vid[1] - face.vid[2];
+		Vertex faceCenter = (vertices[face.vid[0]] + vertices[face.vid[1]] + vertices[face.vid[2]]) / 3.0f;
+		Vertex point = faceCenter + (faceCenter - vertices[oppositeIdx]) * NeighbourPointOffset;
+
+		// locate the point: the root containing it, then the child containing it down to a leaf
+		ur_uint rootIdx = RootsCount;
+		ur_float rootInsideness = 0.0f;
+		for (ur_uint ir = 0; ir < RootsCount; ++ir)
+		{
+			ur_float insideness = TetrahedronInsideness(this->rootVertices[ir], point);
+			if (insideness >= rootInsideness)
+			{
+				rootIdx = ir;
+				rootInsideness = insideness;
+			}
+		}
+		if (RootsCount == rootIdx)
+			return ur_null; // the face is on the volume bound
+
+		std::shared_ptr<Node> node = hierarchy.roots[rootIdx];
+		while (node != ur_null && node->HasChildren())
+		{
+			ur_float insideness0 = TetrahedronInsideness(node->children[0]->tetrahedron->vertices, point);
+			ur_float insideness1 = TetrahedronInsideness(node->children[1]->tetrahedron->vertices, point);
+			node = node->children[insideness0 >= insideness1 ? 0 : 1];
+		}
+
+		return node;
+	}
+
+	ur_uint64 Isosurface::HybridCubes::FindNeighbourKey(ur_uint64 key, ur_uint oppositeVertexIdx) const
+	{
+		std::shared_ptr<Hierarchy> hierarchy = std::atomic_load(&this->hierarchy);
+		if (ur_null == hierarchy || ur_null == this->FindNode(*hierarchy, key))
+			return 0;
+
+		for (ur_uint faceIdx = 0; faceIdx < Tetrahedron::FacesCount; ++faceIdx)
+		{
+			const Face &face = Tetrahedron::Faces[faceIdx];
+			if (6 - face.vid[0] - face.vid[1] - face.vid[2] != oppositeVertexIdx)
+				continue;
+			std::shared_ptr<Node> node = this->FindNeighbour(*hierarchy, key, faceIdx);
+			return (node != ur_null && node->tetrahedron != ur_null ? node->tetrahedron->key : 0);
+		}
+
+		return 0;
+	}
+
+	ur_float Isosurface::HybridCubes::GetRefinementDistance(const BoundingBox &bbox, const ur_float3 &refinementPoint, bool viewBias) const
+	{
+		ur_float bboxSize = (bbox.Max - bbox.Min).Length();
+		ur_float distance = bboxSize * 0.5f;
+		if (this->desc.ScreenSpaceError > 0.0f)
+		{
+			// distance at which region's lattice cell is projected to ScreenSpaceError pixels
+			const ur_uint3 &res = this->desc.LatticeResolution;
+			ur_float cellSize = bboxSize / (std::max(std::max(res.x, res.y), res.z) * 2);
+			distance = cellSize * this->refinementView.projectionScale / this->desc.ScreenSpaceError;
+		}
+
+		if (viewBias)
+		{
+			// region is behind the viewer if its bbox support point along view direction is
+			const ur_float3 &viewDir = this->refinementView.viewDirection;
+			ur_float3 supportPoint(
+				viewDir.x > 0.0f ? bbox.Max.x : bbox.Min.x,
+				viewDir.y > 0.0f ? bbox.Max.y : bbox.Min.y,
+				viewDir.z > 0.0f ? bbox.Max.z : bbox.Min.z);
+			if (ur_float3::Dot(supportPoint - refinementPoint, viewDir) < 0.0f)
+			{
+				distance *= this->desc.BackHemisphereBias;
+			}
+			else if (!bbox.Intersects(this->refinementView.frustumPlanes))
+			{
+				distance *= this->desc.OutsideFrustumBias;
+			}
+		}
+
+		return distance;
+	}
+
+	Isosurface::HybridCubes::ViewBias Isosurface::HybridCubes::GetViewBias(const BoundingBox &bbox, const ur_float3 &refinementPoint, const RefinementView &view) const
+	{
+		// back hemisphere: the bbox support point along view direction is behind the viewer,
+		// sub regions are all behind if the support point is and all in front if the opposite one is not
+		const ur_float3 &viewDir = view.viewDirection;
+		ur_float3 supportMax(
+			viewDir.x > 0.0f ? bbox.Max.x : bbox.Min.x,
+			viewDir.y > 0.0f ? bbox.Max.y : bbox.Min.y,
+			viewDir.z > 0.0f ? bbox.Max.z : bbox.Min.z);
+		if (ur_float3::Dot(supportMax - refinementPoint, viewDir) < 0.0f)
+			return ViewBias::BackHemisphere;
+		ur_float3 supportMin(
+			viewDir.x > 0.0f ? bbox.Min.x : bbox.Max.x,
+			viewDir.y > 0.0f ? bbox.Min.y : bbox.Max.y,
+			viewDir.z > 0.0f ? bbox.Min.z : bbox.Max.z);
+		if (ur_float3::Dot(supportMin - refinementPoint, viewDir) < 0.0f)
+			return ViewBias::Mixed;
+
+		// outside of the frustum: culled by a plane, so are its sub regions;
+		// inside: no corner is outside of any plane
+		if (!bbox.Intersects(view.frustumPlanes))
+			return ViewBias::OutsideFrustum;
+		for (const ur_float4 &plane : view.frustumPlanes)
+		{
+			ur_float3 corner(
+				plane.x > 0.0f ? bbox.Min.x : bbox.Max.x,
+				plane.y > 0.0f ? bbox.Min.y : bbox.Max.y,
+				plane.z > 0.0f ? bbox.Min.z : bbox.Max.z);
+			if (plane.x * corner.x + plane.y * corner.y + plane.z * corner.z + plane.w < 0.0f)
+				return ViewBias::Mixed;
+		}
+
+		return ViewBias::None;
+	}
+
+	void Isosurface::HybridCubes::UpdateRefinementTree(const ur_float3 &refinementPoint, const ur_float4x4 &viewProj, EmptyOctree::Node *root, Stats *stats)
+	{
+		if (ur_null == root)
+			return;
+
+		// view parameters: projection scale along screen Y axis and view direction from the near plane
+
+		RefinementView view;
+		ur_float3 projectionY(viewProj.r[0][1], viewProj.r[1][1], viewProj.r[2][1]);
+		view.projectionScale = projectionY.Length() * this->desc.ScreenHeight * 0.5f;
+		viewProj.FrustumPlanes(view.frustumPlanes, true);
+		view.viewDirection = ur_float3(view.frustumPlanes[4].x, view.frustumPlanes[4].y, view.frustumPlanes[4].z);
+
+		// split distances depend on the view only if screen space error or view bias is used;
+		// projection scale affects all nodes, a view bias change is limited to the nodes crossing the old or new frustum and back plane
+		bool screenSpace = (this->desc.ScreenSpaceError > 0.0f);
+		bool viewBias = (this->desc.OutsideFrustumBias != 1.0f || this->desc.BackHemisphereBias != 1.0f);
+		if (screenSpace && view.projectionScale != this->refinementView.projectionScale)
+		{
+			this->refinementTreeFullUpdate = true;
+		}
+		this->refinementViewPrev = this->refinementView;
+		this->refinementView = view;
+		this->refinementViewChanged = (viewBias && (
+			memcmp(view.frustumPlanes, this->refinementViewPrev.frustumPlanes, sizeof(view.frustumPlanes)) != 0 ||
+			refinementPoint != this->refinementPointPrev));
+
+		this->UpdateRefinementTree(refinementPoint, root, this->refinementTreeFullUpdate, stats);
+		this->refinementPointPrev = refinementPoint;
+		this->refinementTreeFullUpdate = false;
+	}
+
+	void Isosurface::HybridCubes::UpdateRefinementTree(const ur_float3 &refinementPoint, EmptyOctree::Node *node, bool fullUpdate, Stats *stats)
+	{
+		if (ur_null == node)
+			return;
+
+		if (stats != ur_null)
+		{
+			stats->refinementNodesVisited += 1;
+		}
+
+#if 1
+		ur_float nodeSize = (node->GetBBox().Max - node->GetBBox().Min).Length();
+		bool doSplit = (nodeSize / (this->desc.LatticeResolution.GetMaxValue() * 2) > this->desc.CellSize);
+		if (doSplit)
+		{
+			ur_float refinementDistance = this->GetRefinementDistance(node->GetBBox(), refinementPoint, true);
+			doSplit = (node->GetBBox().Distance(refinementPoint) < refinementDistance);
+			doSplit |= node->GetLevel() < 2; // TEMP: always split to minimal refinement level
+		}
+#else
+		bool doSplit = (node->GetLevel() < this->refinementDistance.size());
+		if (doSplit)
+		{
+			doSplit = (node->GetBBox().Distance(refinementPoint) < this->refinementDistance[node->GetLevel()]);
+		}
+#endif
+
+		if (doSplit)
+		{
+			bool splitNow = !node->HasSubNodes();
+			node->Split();
+			if (node->HasSubNodes())
+			{
+				if (splitNow)
+				{
+					this->refinementChanges.push_back(node->GetBBox());
+					if (stats != ur_null) stats->refinementChanges += 1;
+				}
+
+				// split distance of any sub tree node does not exceed the (unbiased) one of direct sub nodes,
+				// sub tree can change only if the previous or current point is closer to the node than that distance
+				BoundingBox subNodeBBox(node->GetBBox().Min, (node->GetBBox().Min + node->GetBBox().Max) * 0.5f);
+				ur_float subNodeDistance = this->GetRefinementDistance(subNodeBBox, refinementPoint, false);
+				bool subtreeAffected = fullUpdate || splitNow ||
+					node->GetBBox().Distance(refinementPoint) < subNodeDistance ||
+					node->GetBBox().Distance(this->refinementPointPrev) < subNodeDistance;
+				if (!subtreeAffected && this->refinementViewChanged)
+				{
+					ViewBias bias = this->GetViewBias(node->GetBBox(), refinementPoint, this->refinementView);
+					subtreeAffected = (ViewBias::Mixed == bias || bias != this->GetViewBias(node->GetBBox(), this->refinementPointPrev, this->refinementViewPrev));
+				}
+				if (subtreeAffected)
+				{
+					for (ur_uint i = 0; i < EmptyOctree::Node::SubNodesCount; ++i)
+					{
+						this->UpdateRefinementTree(refinementPoint, node->GetSubNode(i), fullUpdate || splitNow, stats);
+					}
+				}
+			}
+		}
+		else if (node->HasSubNodes())
+		{
+			this->refinementChanges.push_back(node->GetBBox());
+			if (stats != ur_null) stats->refinementChanges += 1;
+			node->Merge();
+		}
+	}
+
+	Result Isosurface::HybridCubes::UpdateHierarchy(const ur_float3 &refinementPoint, ur_bool parallel, Stats &stats)
+	{
+		Result res(Success);
+
+		// top levels are updated in place, deeper sub trees are collected as tasks;
+		// tasks are collected in serial mode as well, so that both modes produce the same result
+
+		std::vector<UpdateTask> tasks;
+		UpdateContext topCtx;
+		memset(&topCtx.stats, 0, sizeof(topCtx.stats));
+		topCtx.tasks = &tasks;
+		std::shared_ptr<Hierarchy> hierarchy = std::atomic_load(&this->hierarchy);
+		std::shared_ptr<Hierarchy> hierarchyNext(new Hierarchy());
+		for (ur_uint ir = 0; ir < RootsCount; ++ir)
+		{
+			res &= this->Update(refinementPoint, hierarchy->roots[ir], hierarchyNext->roots[ir], topCtx, this->refinementChanges);
+		}
+
+		// tasks are pulled from a shared counter by the calling thread and helper jobs (see RunBuildTasks)
+
+		struct TasksContext
+		{
+			HybridCubes *presentation;
+			ur_float3 refinementPoint;
+			std::vector<UpdateTask> *tasks;
+			ur_uint tasksCount;
+			std::atomic<ur_uint> nextTask;
+			std::atomic<ur_uint> finishedTasks;
+		};
+		std::shared_ptr<TasksContext> ctx(new TasksContext());
+		ctx->presentation = this;
+		ctx->refinementPoint = refinementPoint;
+		ctx->tasks = &tasks;
+		ctx->tasksCount = (ur_uint)tasks.size();
+		ctx->nextTask = 0;
+		ctx->finishedTasks = 0;
+
+		auto processTasks = [](TasksContext &ctx) -> void {
+			for (ur_uint itask = ctx.nextTask++; itask < ctx.tasksCount; itask = ctx.nextTask++)
+			{
+				UpdateTask &task = (*ctx.tasks)[itask];
+				task.result = ctx.presentation->Update(ctx.refinementPoint, task.node, task.nodeNext, task.ctx, *task.refinementChanges);
+				ctx.finishedTasks += 1;
+			}
+		};
+
+		if (parallel && ctx->tasksCount > 1)
+		{
+			auto &jobSystem = this->isosurface.GetRealm().GetJobSystem();
+			ur_uint helpersCount = std::min(ctx->tasksCount - 1, std::max(ur_uint(std::thread::hardware_concurrency()), ur_uint(1)) - 1);
+			for (ur_uint i = 0; i < helpersCount; ++i)
+			{
+				jobSystem.Add(JobPriority::Low, ur_null, [ctx, processTasks](Job::Context& jobCtx) -> void {
+					processTasks(*ctx);
+				});
+			}
+		}
+		processTasks(*ctx);
+		while (ctx->finishedTasks < ctx->tasksCount) { std::this_thread::yield(); }
+
+		// attach updated sub trees and merge tasks output in tree order
+
+		ur_uint taskIdx = 0;
+		for (ur_uint ir = 0; ir < RootsCount; ++ir)
+		{
+			hierarchyNext->roots[ir] = this->AttachUpdateTasks(hierarchyNext->roots[ir], tasks, taskIdx);
+		}
+
+		auto mergeContext = [this, &stats](UpdateContext &ctx) -> void {
+			stats.tetrahedraCount += ctx.stats.tetrahedraCount;
+			stats.treeMemory += ctx.stats.treeMemory;
+			stats.meshVideoMemory += ctx.stats.meshVideoMemory;
+			stats.meshBuffers += ctx.stats.meshBuffers;
+			stats.lodUpdates += ctx.stats.lodUpdates;
+			stats.hierarchyNodesVisited += ctx.stats.hierarchyNodesVisited;
+			this->buildQueue.insert(this->buildQueue.end(), ctx.buildQueue.begin(), ctx.buildQueue.end());
+			this->rebuildQueue.insert(this->rebuildQueue.end(), ctx.rebuildQueue.begin(), ctx.rebuildQueue.end());
+			for (auto &entry : ctx.cacheQueue)
+			{
+				this->meshCache.Put(entry.first, entry.second);
+			}
+		};
+		mergeContext(topCtx);
+		for (auto &task : tasks)
+		{
+			res &= task.result;
+			mergeContext(task.ctx);
+		}
+		std::make_heap(this->buildQueue.begin(), this->buildQueue.end());
+
+		if (Succeeded(res))
+		{
+			this->refinementChanges.clear();
+		}
+		this->hierarchyNext = hierarchyNext;
+
+		return res;
+	}
+
+	Result Isosurface::HybridCubes::Update(const ur_float3 &refinementPoint, const std::shared_ptr<Node> &node, std::shared_ptr<Node> &nodeNext,
+		UpdateContext &ctx, const std::vector<BoundingBox> &refinementChanges)
+	{
+		Result res(Success);
+		nodeNext = node;
+		if (ur_null == node ||
+			ur_null == node->tetrahedron)
+			return res;
+
+		// LoD can change only where the refinement tree has changed,
+		// sub tetrahedra are inside the parent's bbox, so unaffected sub trees are not tested further
+		static const std::vector<BoundingBox> NoRefinementChanges;
+		const std::vector<BoundingBox> *subtreeChanges = &NoRefinementChanges;
+		for (const auto &region : refinementChanges)
+		{
+			if (region.Intersects(node->tetrahedron->bbox))
+			{
+				subtreeChanges = &refinementChanges;
+				break;
+			}
+		}
+
+		// nothing to do in the sub tree: account its aggregates
+		const Node::Aggregates &aggregates = node->aggregates;
+		if (subtreeChanges == &NoRefinementChanges &&
+			aggregates.tetrahedraCount > 0 && 0 == aggregates.pendingCount &&
+			!this->IsDirty(node->tetrahedron->bbox, aggregates.dataVersionMin))
+		{
+			ctx.stats.tetrahedraCount += aggregates.tetrahedraCount;
+			ctx.stats.treeMemory += aggregates.treeMemory;
+			ctx.stats.meshVideoMemory += aggregates.meshVideoMemory;
+			ctx.stats.meshBuffers += aggregates.meshBuffers;
+			return res;
+		}
+
+		// defer sub tree to a task
+		if (ctx.tasks != ur_null && UpdateTaskLevel == node->tetrahedron->level)
+		{
+			UpdateTask task;
+			task.node = node;
+			task.refinementChanges = &refinementChanges;
+			memset(&task.ctx.stats, 0, sizeof(task.ctx.stats));
+			task.ctx.tasks = ur_null;
+			task.result = Success;
+			ctx.tasks->push_back(std::move(task));
+			return res;
+		}
+
+		// live nodes are shared, the node is copied on its first modification
+		auto modifyNode = [&node, &nodeNext]() -> Node* {
+			if (nodeNext == node)
+				nodeNext.reset(new Node(*node));
+			return nodeNext.get();
+		};
+		ctx.stats.hierarchyNodesVisited += 1;
+
+		if (subtreeChanges != &NoRefinementChanges)
+		{
+			res &= this->UpdateLoD(refinementPoint, nodeNext, ctx);
+			ctx.stats.lodUpdates += 1;
+		}
+
+		if (!nodeNext->tetrahedron->initialized)
+		{
+			Tetrahedron *tetrahedron = nodeNext->tetrahedron.get();
+			tetrahedron->dataVersion = this->dataVersion;
+			if (ClockTime() == tetrahedron->queueTime)
+			{
+				tetrahedron->queueTime = Clock::now();
+			}
+			BuildRequest request;
+			request.tetrahedron = tetrahedron;
+			request.level = (this->desc.Skirts ? 0 : tetrahedron->level);
+			request.visible = tetrahedron->bbox.Intersects(this->refinementView.frustumPlanes);
+			request.priority = tetrahedron->bbox.Distance(refinementPoint) /
+				std::max(this->GetRefinementDistance(tetrahedron->bbox, refinementPoint, true), std::numeric_limits<ur_float>::epsilon());
+			ctx.buildQueue.push_back(request);
+		}
+		else if (this->IsDirty(*nodeNext->tetrahedron.get()))
+		{
+			// live hierarchy keeps drawing the outdated mesh until the new one is built
+			const Tetrahedron &outdated = *nodeNext->tetrahedron;
+			std::shared_ptr<Tetrahedron> tetrahedron(new Tetrahedron());
+			tetrahedron->level = outdated.level;
+			tetrahedron->key = outdated.key;
+			tetrahedron->dataVersion = this->dataVersion;
+			tetrahedron->queueTime = Clock::now();
+			tetrahedron->Init(outdated.vertices[0], outdated.vertices[1], outdated.vertices[2], outdated.vertices[3]);
+			modifyNode()->tetrahedron = tetrahedron;
+			ctx.rebuildQueue.push_back(tetrahedron.get());
+		}
+
+		if (nodeNext->HasChildren())
+		{
+			for (ur_uint subIdx = 0; subIdx < Tetrahedron::ChildrenCount; ++subIdx)
+			{
+				std::shared_ptr<Node> child = nodeNext->children[subIdx];
+				std::shared_ptr<Node> childNext;
+				res &= this->Update(refinementPoint, child, childNext, ctx, *subtreeChanges);
+				if (childNext != child)
+				{
+					modifyNode()->children[subIdx] = childNext;
+				}
+			}
+		}
+
+		// update stats
+		ctx.stats.tetrahedraCount += 1;
+		ctx.stats.treeMemory += sizeof(Tetrahedron);
+		ctx.stats.treeMemory += sizeof(nodeNext->tetrahedron->hexahedra);
+		if (nodeNext->tetrahedron->initialized)
+		{
+			this->GatherMeshStats(*nodeNext->tetrahedron, ctx.stats);
+		}
+
+		// refresh aggregates, top levels with deferred sub trees are refreshed when tasks are attached
+		if (ur_null == ctx.tasks)
+		{
+			Node::Aggregates aggregatesNext = this->GatherAggregates(*nodeNext);
+			if (memcmp(&aggregatesNext, &nodeNext->aggregates, sizeof(aggregatesNext)) != 0)
+			{
+				modifyNode()->aggregates = aggregatesNext;
+			}
+		}
+
+		return res;
+	}
+
+	Isosurface::HybridCubes::Node::Aggregates Isosurface::HybridCubes::GatherAggregates(const Node &node) const
+	{
+		Node::Aggregates aggregates;
+		memset(&aggregates, 0, sizeof(aggregates));
+		if (ur_null == node.tetrahedron)
+			return aggregates;
+
+		const Tetrahedron &tetrahedron = *node.tetrahedron;
+		aggregates.tetrahedraCount = 1;
+		aggregates.pendingCount = (tetrahedron.initialized ? 0 : 1);
+		aggregates.dataVersionMin = tetrahedron.dataVersion;
+		aggregates.treeMemory = ur_uint(sizeof(Tetrahedron) + sizeof(tetrahedron.hexahedra));
+		if (tetrahedron.initialized)
+		{
+			Stats meshStats;
+			memset(&meshStats, 0, sizeof(meshStats));
+			this->GatherMeshStats(tetrahedron, meshStats);
+			aggregates.meshVideoMemory = meshStats.meshVideoMemory;
+			aggregates.meshBuffers = meshStats.meshBuffers;
+		}
+		if (node.HasChildren())
+		{
+			for (const auto &child : node.children)
+			{
+				const Node::Aggregates &childAggregates = child->aggregates;
+				aggregates.tetrahedraCount += childAggregates.tetrahedraCount;
+				aggregates.pendingCount += childAggregates.pendingCount;
+				aggregates.dataVersionMin = std::min(aggregates.dataVersionMin, childAggregates.dataVersionMin);
+				aggregates.treeMemory += childAggregates.treeMemory;
+				aggregates.meshVideoMemory += childAggregates.meshVideoMemory;
+				aggregates.meshBuffers += childAggregates.meshBuffers;
+			}
+		}
+
+		return aggregates;
+	}
+
+	std::shared_ptr<Isosurface::HybridCubes::Node> Isosurface::HybridCubes::AttachUpdateTasks(const std::shared_ptr<Node> &node,
+		std::vector<UpdateTask> &tasks, ur_uint &taskIdx)
+	{
+		// mirrors the traversal order Update collects tasks in
+		if (ur_null == node ||
+			ur_null == node->tetrahedron)
+			return node;
+
+		// sub trees skipped by the update have no task
+		if (UpdateTaskLevel == node->tetrahedron->level)
+			return (taskIdx < tasks.size() && tasks[taskIdx].node == node ? tasks[taskIdx++].nodeNext : node);
+
+		std::shared_ptr<Node> nodeNext = node;
+		if (node->HasChildren())
+		{
+			for (ur_uint subIdx = 0; subIdx < Tetrahedron::ChildrenCount; ++subIdx)
+			{
+				std::shared_ptr<Node> childNext = this->AttachUpdateTasks(node->children[subIdx], tasks, taskIdx);
+				if (childNext != node->children[subIdx])
+				{
+					if (nodeNext == node)
+						nodeNext.reset(new Node(*node));
+					nodeNext->children[subIdx] = childNext;
+				}
+			}
+		}
+
+		Node::Aggregates aggregates = this->GatherAggregates(*nodeNext);
+		if (memcmp(&aggregates, &nodeNext->aggregates, sizeof(aggregates)) != 0)
+		{
+			if (nodeNext == node)
+				nodeNext.reset(new Node(*node));
+			nodeNext->aggregates = aggregates;
+		}
+
+		return nodeNext;
+	}
+
+	Result Isosurface::HybridCubes::UpdateLoD(const ur_float3 &refinementPoint, std::shared_ptr<Node> &node, UpdateContext &ctx)
+	{
+		Result res(Success);
+		if (ur_null == node ||
+			ur_null == node->tetrahedron)
+			return res;
+
+		// update LoD by traversing refinement octree
+		// current approach produces seamless partition, but due to it's conservative nature, the resulting mesh is overdetailed
+		// todo: try doing proper LEB implementation, based on "dimonds" hierarchy or "terminal edge" bisection
+#if 1
+		bool doSplit = this->refinementIndex.Check(node->tetrahedron->bbox);
+#else
+		bool doSplit = false;
+		const ur_float3 &ev0 = node->tetrahedron->vertices[Tetrahedron::Edges[node->tetrahedron->longestEdgeIdx].vid[0]];
+		const ur_float3 &ev1 = node->tetrahedron->vertices[Tetrahedron::Edges[node->tetrahedron->longestEdgeIdx].vid[1]];
+		ur_float edgeLen = (ev0 - ev1).Length();
+		doSplit = (edgeLen / (this->desc.LatticeResolution.GetMaxValue() * 2) > this->desc.CellSize);
+		if (doSplit)
+		{
+			ur_float3 evc = (ev0 + ev1) * 0.5f;
+			doSplit = (evc - refinementPoint).Length() < edgeLen;
+		}
+#endif
+
+		// the node may be shared with the live hierarchy, so a copy is split or merged
+		if (doSplit && !node->HasChildren())
+		{
+			node.reset(new Node(*node));
+			node->Split();
+			if (this->desc.MeshCacheBudget > 0)
+			{
+				this->AdoptCached(node.get());
+			}
+			if (this->desc.PrefetchTime > 0.0f)
+			{
+				this->AdoptPrefetched(node.get());
+			}
+		}
+		else if (!doSplit && node->HasChildren())
+		{
+			if (this->desc.MeshCacheBudget > 0)
+			{
+				for (auto &child : node->children)
+				{
+					this->CacheSubtree(child.get(), ctx);
+				}
+			}
+			node.reset(new Node(*node));
+			node->Merge();
+		}
+
+		return res;
+	}
+
+	void Isosurface::HybridCubes::UpdatePrefetch(const ur_float3 &refinementPoint, const ur_float3 &predictedPoint, Stats *stats)
+	{
+		this->prefetchUpdateIdx += 1;
+
+		// predict sub trees of the hierarchy leaves, nothing to predict while the refinement point barely moves
+		if ((predictedPoint - refinementPoint).Length() > this->desc.CellSize)
+		{
+			ur_uint jobsBudget = this->desc.PrefetchJobsMax;
+			for (ur_uint ir = 0; ir < HybridCubes::RootsCount; ++ir)
+			{
+				this->Prefetch(predictedPoint, this->hierarchyNext->roots[ir].get(), jobsBudget);
+			}
+		}
+
+		// cancel entries which are no longer predicted or are built for outdated data
+		for (auto it = this->prefetchEntries.begin(); it != this->prefetchEntries.end(); )
+		{
+			PrefetchEntry *entry = it->second.get();
+			if (entry->updateIdx == this->prefetchUpdateIdx &&
+				entry->tetrahedron->dataVersion == this->dataVersion)
+			{
+				++it;
+				continue;
+			}
+			entry->cancelled = true;
+			this->prefetchMisses += 1;
+			this->prefetchRetired.push_back(std::move(it->second));
+			it = this->prefetchEntries.erase(it);
+		}
+		this->prefetchRetired.erase(std::remove_if(this->prefetchRetired.begin(), this->prefetchRetired.end(),
+			[](const std::unique_ptr<PrefetchEntry> &entry) { return entry->job->Finished(); }), this->prefetchRetired.end());
+
+		if (stats != ur_null)
+		{
+			stats->prefetchRequested = this->prefetchRequested;
+			stats->prefetchHits = this->prefetchHits;
+			stats->prefetchMisses = this->prefetchMisses;
+		}
+	}
+
+	void Isosurface::HybridCubes::Prefetch(const ur_float3 &predictedPoint, Node *node, ur_uint &jobsBudget)
+	{
+		if (ur_null == node ||
+			ur_null == node->tetrahedron ||
+			node->tetrahedron->bbox.Distance(predictedPoint) >= this->GetRefinementDistance(node->tetrahedron->bbox, predictedPoint, false))
+			return; // sub tree nodes have smaller refinement distances
+
+		if (node->HasChildren())
+		{
+			for (auto &child : node->children)
+			{
+				this->Prefetch(predictedPoint, child.get(), jobsBudget);
+			}
+		}
+		else
+		{
+			this->Prefetch(predictedPoint, *node->tetrahedron, jobsBudget);
+		}
+	}
+
+	void Isosurface::HybridCubes::Prefetch(const ur_float3 &predictedPoint, Tetrahedron &tetrahedron, ur_uint &jobsBudget)
+	{
+		// approximate refinement criterion: the tetrahedron is expected to split if the predicted point is within
+		// the refinement distance of its bbox and its lattice is coarser than the most detailed one
+		const BoundingBox &bbox = tetrahedron.bbox;
+		const ur_uint3 &res = this->desc.LatticeResolution;
+		ur_float cellSize = (bbox.Max - bbox.Min).Length() / (std::max(std::max(res.x, res.y), res.z) * 2);
+		if (0 == tetrahedron.key ||
+			cellSize <= this->desc.CellSize ||
+			bbox.Distance(predictedPoint) >= this->GetRefinementDistance(bbox, predictedPoint, false))
+			return;
+
+		std::array<std::unique_ptr<Tetrahedron>, Tetrahedron::ChildrenCount> subTetrahedra;
+		tetrahedron.Split(subTetrahedra);
+		for (auto &subTetrahedron : subTetrahedra)
+		{
+			auto it = this->prefetchEntries.find(subTetrahedron->key);
+			if (it == this->prefetchEntries.end())
+			{
+				if (0 == jobsBudget)
+					continue;
+				jobsBudget -= 1;
+
+				std::unique_ptr<PrefetchEntry> entry(new PrefetchEntry());
+				entry->presentation = this;
+				entry->tetrahedron = std::move(subTetrahedron);
+				entry->tetrahedron->dataVersion = this->dataVersion;
+				entry->tetrahedron->queueTime = Clock::now();
+				entry->cancelled = false;
+				auto &jobSystem = this->isosurface.GetRealm().GetJobSystem();
+				entry->job = jobSystem.Add(JobPriority::Low, Job::DataPtr(entry.get()), [](Job::Context& ctx) -> void {
+
+					PrefetchEntry *entry = reinterpret_cast<PrefetchEntry*>(ctx.data);
+					if (entry->cancelled)
+					{
+						ctx.resultCode = Success;
+						return;
+					}
+					// speculative build must not take threads reserved for the hierarchy builds
+					Result result = entry->presentation->BuildMesh(entry->tetrahedron.get(), ur_null, JobPriority::Low);
+					ctx.resultCode = result.Code;
+				});
+				if (ur_null == entry->job)
+					continue;
+				this->prefetchRequested += 1;
+				it = this->prefetchEntries.insert(std::make_pair(entry->tetrahedron->key, std::move(entry))).first;
+			}
+			PrefetchEntry *entry = it->second.get();
+			entry->updateIdx = this->prefetchUpdateIdx;
+			this->Prefetch(predictedPoint, *entry->tetrahedron, jobsBudget);
+		}
+	}
+
+	void Isosurface::HybridCubes::AdoptPrefetched(Node *node)
+	{
+		std::lock_guard<std::mutex> lock(this->prefetchMutex);
+		for (auto &child : node->children)
+		{
+			auto it = this->prefetchEntries.find(child->tetrahedron->key);
+			if (it == this->prefetchEntries.end())
+				continue;
+			PrefetchEntry *entry = it->second.get();
+			if (!entry->job->Finished() ||
+				!entry->tetrahedron->initialized ||
+				entry->tetrahedron->dataVersion != this->dataVersion)
+				continue; // not ready yet, the hierarchy builds its own one
+			child->tetrahedron = entry->tetrahedron;
+			this->prefetchHits += 1;
+			this->prefetchEntries.erase(it);
+		}
+	}
+
+	void Isosurface::HybridCubes::CacheSubtree(Node *node, UpdateContext &ctx)
+	{
+		if (ur_null == node)
+			return;
+
+		// deeper levels first, so that coarser tetrahedra are evicted last
+		if (node->HasChildren())
+		{
+			for (auto &child : node->children)
+			{
+				this->CacheSubtree(child.get(), ctx);
+			}
+		}
+
+		if (node->tetrahedron != ur_null && node->tetrahedron->initialized && !this->IsDirty(*node->tetrahedron))
+		{
+			Stats meshStats;
+			memset(&meshStats, 0, sizeof(meshStats));
+			this->GatherMeshStats(*node->tetrahedron, meshStats);
+			ctx.cacheQueue.push_back(std::make_pair(node->tetrahedron, ur_size(meshStats.meshVideoMemory) + sizeof(Tetrahedron)));
+		}
+	}
+
+	void Isosurface::HybridCubes::AdoptCached(Node *node)
+	{
+		for (auto &child : node->children)
+		{
+			if (child->tetrahedron->initialized)
+				continue;
+			std::shared_ptr<Tetrahedron> tetrahedron = this->meshCache.Take(child->tetrahedron->key);
+			if (tetrahedron != ur_null)
+			{
+				child->tetrahedron = tetrahedron;
+			}
+		}
+	}
+
+	void Isosurface::HybridCubes::CancelPrefetch()
+	{
+		for (auto &entry : this->prefetchEntries)
+		{
+			entry.second->cancelled = true;
+			entry.second->job->Wait();
+		}
+		for (auto &entry : this->prefetchRetired)
+		{
+			entry->job->Wait();
+		}
+		this->prefetchEntries.clear();
+		this->prefetchRetired.clear();
+	}
+
+	void Isosurface::HybridCubes::UpdateDirtyRegions()
+	{
+		std::vector<BoundingBox> regions;
+		if (Failed(this->isosurface.GetData()->FetchDirtyRegions(regions)) || regions.empty())
+			return;
+
+		this->dataVersion += 1;
+		for (const auto &region : regions)
+		{
+			this->dirtyRegions.push_back(std::pair<ur_uint, BoundingBox>(this->dataVersion, region));
+		}
+
+		// regions are kept for two versions, so that a modification is still applied if the hierarchy of the update that fetched it is discarded
+		this->dirtyRegions.erase(std::remove_if(this->dirtyRegions.begin(), this->dirtyRegions.end(),
+			[this](const std::pair<ur_uint, BoundingBox> &entry) { return (entry.first + 1 < this->dataVersion); }),
+			this->dirtyRegions.end());
+
+		this->sampleCache.Invalidate(regions);
+		this->meshCache.Invalidate(regions);
+	}
+
+	bool Isosurface::HybridCubes::IsDirty(const Tetrahedron &tetrahedron) const
+	{
+		return this->IsDirty(tetrahedron.bbox, tetrahedron.dataVersion);
+	}
+
+	bool Isosurface::HybridCubes::IsDirty(const BoundingBox &bbox, ur_uint dataVersion) const
+	{
+		for (const auto &region : this->dirtyRegions)
+		{
+			if (region.first > dataVersion &&
+				region.second.Intersects(bbox))
+				return true;
+		}
+		return false;
+	}
+
+	Result Isosurface::HybridCubes::BuildMesh(Tetrahedron *tetrahedron, Stats *stats, JobPriority helpersPriority)
+	{
+		Result res = Result(Success);
+		if (ur_null == tetrahedron)
+			return res;
+
+		// all hexahedra are merged into one mesh drawn at once or a mesh per hexahedron is used
+		std::vector<MeshExtractor::Mesh> meshes(this->desc.MergeHexahedra ? 1 : ur_array_size(tetrahedron->hexahedra));
+
+		// take meshes from the persistent cache or
+		// extract hexahedra (or their slabs) in parallel, results are merged in task order
+		if (Failed(this->LoadCachedMeshes(*tetrahedron, meshes)))
+		{
+			std::vector<BuildTask> tasks;
+			this->CreateBuildTasks(tasks, *tetrahedron);
+			res = this->RunBuildTasks(tasks, tetrahedron->level, (this->sampleCache.IsEnabled() ? &this->sampleCache : ur_null), this->parallelBuild, helpersPriority);
+			for (const auto &task : tasks)
+			{
+				MeshExtractor::Merge(meshes[this->desc.MergeHexahedra ? 0 : task.hexahedronIdx], task.mesh);
+			}
+			if (Succeeded(res))
+			{
+				this->SaveCachedMeshes(*tetrahedron, meshes);
+			}
+		}
+
+		if (this->desc.MergeHexahedra)
+		{
+			if (Succeeded(res))
+			{
+				#if defined(UR_GRAF)
+				res = this->UploadMesh(tetrahedron->grafMesh, tetrahedron->bbox, meshes[0]);
+				#else
+				res = this->UploadMesh(tetrahedron->gfxMesh, tetrahedron->bbox, meshes[0]);
+				#endif
+			}
+		}
+		else
+		{
+			for (ur_uint ih = 0; ih < ur_array_size(tetrahedron->hexahedra) && Succeeded(res); ++ih)
+			{
+				Hexahedron &hexahedron = tetrahedron->hexahedra[ih];
+				Vertex hexahedronVertices[Hexahedron::VerticesCount];
+				Tetrahedron::HexahedronVertices(tetrahedron->vertices, ih, hexahedronVertices);
+				BoundingBox bbox;
+				for (auto &v : hexahedronVertices) { bbox.Expand(v); }
+				#if defined(UR_GRAF)
+				res &= this->UploadMesh(hexahedron.grafMesh, bbox, meshes[ih]);
+				#else
+				res &= this->UploadMesh(hexahedron.gfxMesh, bbox, meshes[ih]);
+				#endif
+			}
+		}
+
+		tetrahedron->initialized = Succeeded(res);
+
+		// update stats
+		if (stats != ur_null && tetrahedron->initialized)
+		{
+			this->GatherMeshStats(*tetrahedron, *stats);
+		}
+
+		return res;
+	}
+
+	ur_uint64 Isosurface::HybridCubes::ComputeDiskCacheHash() const
+	{
+		ur_uint64 contentHash = this->isosurface.GetData()->GetContentHash();
+		if (0 == contentHash)
+			return 0;
+
+		std::vector<ur_byte> data;
+		auto append = [&data](const void *ptr, ur_size size) {
+			data.insert(data.end(), (const ur_byte*)ptr, (const ur_byte*)ptr + size);
+		};
+		const char *typeName = typeid(*this).name();
+		append(&DiskCacheVersion, sizeof(DiskCacheVersion));
+		append(&contentHash, sizeof(contentHash));
+		append(typeName, strlen(typeName));
+		append(&this->desc.CellSize, sizeof(this->desc.CellSize));
+		append(&this->desc.LatticeResolution, sizeof(this->desc.LatticeResolution));
+		append(&this->desc.MergeHexahedra, sizeof(this->desc.MergeHexahedra));
+		append(&this->desc.Skirts, sizeof(this->desc.Skirts));
+		append(this->desc.SimplifyError.data(), this->desc.SimplifyError.size() * sizeof(ur_float));
+		ur_uint64 hash = ur_uint64(ComputeHash(data.data(), data.size()));
+
+		return (0 == hash ? 1 : hash);
+	}
+
+	std::string Isosurface::HybridCubes::GetDiskCacheFileName(const Tetrahedron &tetrahedron) const
+	{
+		char name[64];
+		snprintf(name, sizeof(name), "%016llx_%016llx.urmc", (unsigned long long)this->diskCacheHash, (unsigned long long)tetrahedron.key);
+		return this->desc.DiskCachePath + name;
+	}
+
+	Result Isosurface::HybridCubes::LoadCachedMeshes(const Tetrahedron &tetrahedron, std::vector<MeshExtractor::Mesh> &meshes)
+	{
+		// modified data is not cached
+		if (0 == this->diskCacheHash || 0 == tetrahedron.key || this->dataVersion > 0)
+			return Result(NotImplemented);
+
+		this->diskCacheRequests += 1;
+		auto &storage = this->isosurface.GetRealm().GetStorage();
+		std::unique_ptr<File> file;
+		Result res = storage.Open(file, this->GetDiskCacheFileName(tetrahedron), ur_uint(StorageAccess::Binary) | ur_uint(StorageAccess::Read));
+		if (Failed(res))
+			return Result(NotFound);
+
+		// validate entry
+		DiskCacheHeader header = {};
+		ur_size fileSize = file->GetSize();
+		res = file->Read(sizeof(DiskCacheHeader), (ur_byte*)&header);
+		if (Failed(res) ||
+			header.magic != DiskCacheMagic ||
+			header.version != DiskCacheVersion ||
+			header.hash != this->diskCacheHash ||
+			header.key != tetrahedron.key ||
+			header.meshesCount != meshes.size() ||
+			header.vertexSize != sizeof(Isosurface::Vertex) ||
+			sizeof(DiskCacheHeader) + header.dataSize != fileSize)
+			return Result(Failure);
+
+		std::vector<ur_byte> data((ur_size)header.dataSize);
+		res = file->Read(data.size(), data.data());
+		if (Failed(res) || header.checksum != ur_uint64(ComputeHash(data.data(), data.size())))
+			return Result(Failure);
+
+		// read meshes
+		ur_size offset = 0;
+		auto read = [&data, &offset](void *ptr, ur_size size) -> bool {
+			if (offset + size > data.size())
+				return false;
+			if (size > 0)
+				memcpy(ptr, data.data() + offset, size);
+			offset += size;
+			return true;
+		};
+		for (auto &mesh : meshes)
+		{
+			ur_uint32 verticesCount = 0;
+			ur_uint32 indicesCount = 0;
+			if (!read(&verticesCount, sizeof(verticesCount)) ||
+				!read(&indicesCount, sizeof(indicesCount)) ||
+				offset + verticesCount * sizeof(Isosurface::Vertex) + indicesCount * sizeof(Index) > data.size())
+				return Result(Failure);
+			mesh.vertices.resize(verticesCount);
+			mesh.indices.resize(indicesCount);
+			read(mesh.vertices.data(), verticesCount * sizeof(Isosurface::Vertex));
+			read(mesh.indices.data(), indicesCount * sizeof(Index));
+		}
+
+		this->diskCacheHits += 1;
+
+		return Result(Success);
+	}
+
+	Result Isosurface::HybridCubes::SaveCachedMeshes(const Tetrahedron &tetrahedron, const std::vector<MeshExtractor::Mesh> &meshes)
+	{
+		if (0 == this->diskCacheHash || 0 == tetrahedron.key || this->dataVersion > 0)
+			return Result(NotImplemented);
+
+		std::vector<ur_byte> data;
+		auto append = [&data](const void *ptr, ur_size size) {
+			data.insert(data.end(), (const ur_byte*)ptr, (const ur_byte*)ptr + size);
+		};
+		for (const auto &mesh : meshes)
+		{
+			ur_uint32 verticesCount = (ur_uint32)mesh.vertices.size();
+			ur_uint32 indicesCount = (ur_uint32)mesh.indices.size();
+			append(&verticesCount, sizeof(verticesCount));
+			append(&indicesCount, sizeof(indicesCount));
+			append(mesh.vertices.data(), verticesCount * sizeof(Isosurface::Vertex));
+			append(mesh.indices.data(), indicesCount * sizeof(Index));
+		}
+
+		DiskCacheHeader header = {};
+		header.magic = DiskCacheMagic;
+		header.version = DiskCacheVersion;
+		header.hash = this->diskCacheHash;
+		header.key = tetrahedron.key;
+		header.meshesCount = (ur_uint32)meshes.size();
+		header.vertexSize = sizeof(Isosurface::Vertex);
+		header.dataSize = data.size();
+		header.checksum = ur_uint64(ComputeHash(data.data(), data.size()));
+
+		std::unique_ptr<DiskCacheWrite> entry(new DiskCacheWrite());
+		entry->fileName = this->GetDiskCacheFileName(tetrahedron);
+		entry->header = header;
+		entry->data = std::move(data);
+
+		// a tetrahedron can be built by prefetch and hierarchy update at the same time, its entry is written once
+		std::lock_guard<std::mutex> lock(this->diskCacheMutex);
+		if (!this->diskCacheWritesPending.insert(tetrahedron.key).second)
+			return Result(Success);
+		this->diskCacheWrites.push_back(std::move(entry));
+		if (!this->diskCacheJobActive)
+		{
+			this->ScheduleDiskCacheWrites();
+		}
+
+		return Result(Success);
+	}
+
+	void Isosurface::HybridCubes::ScheduleDiskCacheWrites()
+	{
+		auto &jobSystem = this->isosurface.GetRealm().GetJobSystem();
+		this->diskCacheJob = jobSystem.Add(JobPriority::Low, Job::DataPtr(this), [](Job::Context& ctx) -> void {
+
+			HybridCubes *presentation = reinterpret_cast<HybridCubes*>(ctx.data);
+			presentation->ProcessDiskCacheWrites();
+			ctx.resultCode = Success;
+		});
+		this->diskCacheJobActive = (this->diskCacheJob != ur_null);
+	}
+
+	void Isosurface::HybridCubes::ProcessDiskCacheWrites()
+	{
+		for (ur_uint i = 0; i < DiskCacheWritesPerJob; ++i)
+		{
+			std::unique_ptr<DiskCacheWrite> entry;
+			{
+				std::lock_guard<std::mutex> lock(this->diskCacheMutex);
+				if (this->diskCacheWrites.empty())
+				{
+					this->diskCacheJobActive = false;
+					return;
+				}
+				entry = std::move(this->diskCacheWrites.front());
+				this->diskCacheWrites.pop_front();
+			}
+			this->WriteCachedMeshes(*entry);
+			std::lock_guard<std::mutex> lock(this->diskCacheMutex);
+			this->diskCacheWritesPending.erase(entry->header.key);
+		}
+
+		// continue in a new job queued after the ones added meanwhile
+		std::lock_guard<std::mutex> lock(this->diskCacheMutex);
+		if (this->diskCacheWrites.empty())
+		{
+			this->diskCacheJobActive = false;
+			return;
+		}
+		this->ScheduleDiskCacheWrites();
+	}
+
+	Result Isosurface::HybridCubes::WriteCachedMeshes(const DiskCacheWrite &entry)
+	{
+		// write to a temporary file first, so that an incomplete entry is never visible by its final name
+		char suffix[32];
+		snprintf(suffix, sizeof(suffix), ".%u.tmp", ur_uint(this->diskCacheWriteCounter++));
+		std::string tmpFileName = entry.fileName + suffix;
+
+		auto &storage = this->isosurface.GetRealm().GetStorage();
+		std::unique_ptr<File> file;
+		Result res = storage.Open(file, tmpFileName, ur_uint(StorageAccess::Binary) | ur_uint(StorageAccess::Write));
+		if (Failed(res))
+			return res;
+		res &= file->Write(sizeof(DiskCacheHeader), (const ur_byte*)&entry.header);
+		res &= file->Write(entry.data.size(), entry.data.data());
+		res &= file->Close();
+		file.reset(ur_null);
+
+		if (Succeeded(res))
+		{
+			res = storage.Rename(tmpFileName, entry.fileName);
+		}
+		if (Failed(res))
+		{
+			storage.Remove(tmpFileName);
+		}
+
+		return res;
+	}
+
+	void Isosurface::HybridCubes::FlushDiskCache()
+	{
+		while (true)
+		{
+			std::shared_ptr<Job> job;
+			{
+				std::lock_guard<std::mutex> lock(this->diskCacheMutex);
+				if (!this->diskCacheJobActive)
+					break;
+				job = this->diskCacheJob;
+			}
+			job->Wait();
+		}
+	}
+
+	bool Isosurface::HybridCubes::HasMesh(const Tetrahedron &tetrahedron) const
+	{
+		#if defined(UR_GRAF)
+		bool hasMesh = (tetrahedron.grafMesh.indexCount > 0);
+		for (const auto &h : tetrahedron.hexahedra) { hasMesh |= (h.grafMesh.indexCount > 0); }
+		#else
+		bool hasMesh = (tetrahedron.gfxMesh.VB != ur_null);
+		for (const auto &h : tetrahedron.hexahedra) { hasMesh |= (h.gfxMesh.VB != ur_null); }
+		#endif
+		return hasMesh;
+	}
+
+	void Isosurface::HybridCubes::GatherBuildLatencyStats(Stats &stats) const
+	{
+		ur_size samplesCount = std::min(ur_size(this->buildLatencyNext), this->buildLatencies.size());
+		if (0 == samplesCount)
+			return;
+
+		std::vector<ur_float> samples(this->buildLatencies.begin(), this->buildLatencies.begin() + samplesCount);
+		auto percentile = [&samples](ur_float p) -> ur_float {
+			auto it = samples.begin() + std::min(ur_size(p * samples.size()), samples.size() - 1);
+			std::nth_element(samples.begin(), it, samples.end());
+			return *it;
+		};
+		stats.buildLatencyP50 = percentile(0.50f);
+		stats.buildLatencyP90 = percentile(0.90f);
+		stats.buildLatencyP99 = percentile(0.99f);
+	}
+
+	void Isosurface::HybridCubes::GatherMeshStats(const Tetrahedron &tetrahedron, Stats &stats) const
+	{
+		#if defined(UR_GRAF)
+		// pooled meshes own no buffers, only sub allocated ranges are accounted
+		auto gatherMesh = [&stats](const GrafMesh &grafMesh) {
+			if (ur_null == grafMesh.pool || 0 == grafMesh.indexCount) return;
+			stats.meshVideoMemory += ur_uint(grafMesh.range.vertices.Size * grafMesh.pool->GetVertexStride() +
+				grafMesh.range.indices.Size * MeshPool::IndexUnitSize);
+		};
+		gatherMesh(tetrahedron.grafMesh);
+		for (const auto &h : tetrahedron.hexahedra)
+		{
+			gatherMesh(h.grafMesh);
+		}
+		#else
+		auto gatherBuffer = [&stats](const std::unique_ptr<GfxBuffer> &buffer) {
+			if (ur_null == buffer) return;
+			stats.meshVideoMemory += buffer->GetDesc().Size;
+			stats.meshBuffers += 1;
+		};
+		gatherBuffer(tetrahedron.gfxMesh.VB);
+		gatherBuffer(tetrahedron.gfxMesh.IB);
+		for (const auto &h : tetrahedron.hexahedra)
+		{
+			gatherBuffer(h.gfxMesh.VB);
+			gatherBuffer(h.gfxMesh.IB);
+		}
+		#endif
+	}
+
+	Result Isosurface::HybridCubes::ExtractTetrahedron(MeshExtractor::Mesh &mesh, const ur_float3 (&vertices)[4], const ur_uint level, ur_bool parallel)
+	{
+		if (ur_null == this->isosurface.GetData())
+			return Result(NotInitialized);
+
+		Tetrahedron tetrahedron;
+		tetrahedron.level = level;
+		tetrahedron.Init(vertices[0], vertices[1], vertices[2], vertices[3]);
+
+		std::vector<BuildTask> tasks;
+		this->CreateBuildTasks(tasks, tetrahedron);
+		Result res = this->RunBuildTasks(tasks, level, ur_null, parallel, JobPriority::High);
+		for (const auto &task : tasks)
+		{
+			MeshExtractor::Merge(mesh, task.mesh);
+		}
+
+		return res;
+	}
+
+	void Isosurface::HybridCubes::CreateBuildTasks(std::vector<BuildTask> &tasks, const Tetrahedron &tetrahedron) const
+	{
+		// a task per hexahedron, high resolution lattices are additionally split into slabs along z axis;
+		// slab corners are interpolated from hexahedron corners, so that adjacent slabs share border lattice points
+
+		const ur_uint3 &resolution = this->desc.LatticeResolution;
+		const ur_uint cellsZ = resolution.z - 1;
+
+		// tetrahedron faces, skirts are generated along surface borders lying on them
+		ur_float4 facePlanes[Tetrahedron::FacesCount];
+		for (ur_uint ifc = 0; ifc < Tetrahedron::FacesCount; ++ifc)
+		{
+			const ur_float3 &v0 = tetrahedron.vertices[Tetrahedron::Faces[ifc].vid[0]];
+			const ur_float3 &v1 = tetrahedron.vertices[Tetrahedron::Faces[ifc].vid[1]];
+			const ur_float3 &v2 = tetrahedron.vertices[Tetrahedron::Faces[ifc].vid[2]];
+			ur_float3 n = ur_float3::Normalize(ur_float3::Cross(v1 - v0, v2 - v0));
+			facePlanes[ifc] = ur_float4(n.x, n.y, n.z, -ur_float3::Dot(n, v0));
+		}
+
+		// plane distances of vertices far from the origin are only as precise as their coordinates
+		ur_float coordMax = 0.0f;
+		for (const auto &v : tetrahedron.vertices)
+		{
+			coordMax = std::max(coordMax, std::max(std::max(std::fabs(v.x), std::fabs(v.y)), std::fabs(v.z)));
+		}
+
+		// hexahedra cell sizes differ slightly, the largest one selects the data level of detail shared by the whole tetrahedron
+		ur_float hexahedraCellSize[Tetrahedron::HexahedraCount];
+		ur_float tetrahedronCellSize = 0.0f;
+		for (ur_uint ih = 0; ih < ur_array_size(tetrahedron.hexahedra); ++ih)
+		{
+			Vertex corners[Hexahedron::VerticesCount];
+			Tetrahedron::HexahedronVertices(tetrahedron.vertices, ih, corners);
+			hexahedraCellSize[ih] = std::max(std::max(
+				(corners[1] - corners[0]).Length() / (resolution.x - 1),
+				(corners[2] - corners[0]).Length() / (resolution.y - 1)),
+				(corners[4] - corners[0]).Length() / (resolution.z - 1));
+			tetrahedronCellSize = std::max(tetrahedronCellSize, hexahedraCellSize[ih]);
+		}
+
+		const ur_uint slabsCount = std::max(ur_uint(1), (cellsZ + BuildSlabCellsMax - 1) / BuildSlabCellsMax);
+		tasks.resize(ur_array_size(tetrahedron.hexahedra) * slabsCount);
+		BuildTask *task = tasks.data();
+		for (ur_uint ih = 0; ih < ur_array_size(tetrahedron.hexahedra); ++ih)
+		{
+			Vertex corners[Hexahedron::VerticesCount];
+			Tetrahedron::HexahedronVertices(tetrahedron.vertices, ih, corners);
+			const ur_float cellSize = hexahedraCellSize[ih];
+			for (ur_uint islab = 0; islab < slabsCount; ++islab, ++task)
+			{
+				const ur_uint z0 = cellsZ * islab / slabsCount;
+				const ur_uint z1 = cellsZ * (islab + 1) / slabsCount;
+				const ur_float t0 = ur_float(z0) / cellsZ;
+				const ur_float t1 = ur_float(z1) / cellsZ;
+				for (ur_uint iv = 0; iv < 4; ++iv)
+				{
+					task->corners[iv] = ur_float3::Lerp(corners[iv], corners[iv + 4], t0);
+					task->corners[iv + 4] = ur_float3::Lerp(corners[iv], corners[iv + 4], t1);
+				}
+				task->resolution = ur_uint3(resolution.x, resolution.y, z1 - z0 + 1);
+				task->hexahedronIdx = ih;
+				task->cellSize = tetrahedronCellSize;
+				std::copy(std::begin(facePlanes), std::end(facePlanes), task->facePlanes);
+				task->skirtDepth = (this->desc.Skirts ? cellSize * SkirtDepthCells : 0.0f);
+				task->skirtTolerance = std::max(task->skirtDepth * 1.0e-3f, coordMax * SkirtToleranceUlps * std::numeric_limits<ur_float>::epsilon());
+				task->simplifyError = (tetrahedron.level < this->desc.SimplifyError.size() ? cellSize * this->desc.SimplifyError[tetrahedron.level] : 0.0f);
+				task->result = Result(Success);
+			}
+		}
+	}
+
+	Result Isosurface::HybridCubes::RunBuildTasks(std::vector<BuildTask> &tasks, const ur_uint level, SampleCache *sampleCache, ur_bool parallel,
+		JobPriority helpersPriority)
+	{
+		// tasks are pulled from a shared counter by the calling thread and helper jobs;
+		// the caller never waits for a job to start, so nested use from a build job can not stall the job system
+
+		struct BuildContext
+		{
+			HybridCubes *presentation;
+			std::vector<BuildTask> *tasks; // caller's vector, not accessed once all tasks are taken
+			ur_uint tasksCount;
+			SampleCache *sampleCache;
+			ur_uint level;
+			std::atomic<ur_uint> nextTask;
+			std::atomic<ur_uint> finishedTasks;
+		};
+		std::shared_ptr<BuildContext> ctx(new BuildContext());
+		ctx->presentation = this;
+		ctx->tasks = &tasks;
+		ctx->tasksCount = (ur_uint)tasks.size();
+		ctx->sampleCache = sampleCache;
+		ctx->level = level;
+		ctx->nextTask = 0;
+		ctx->finishedTasks = 0;
+
+		auto processTasks = [](BuildContext &ctx) -> void {
+			for (ur_uint itask = ctx.nextTask++; itask < ctx.tasksCount; itask = ctx.nextTask++)
+			{
+				BuildTask &task = (*ctx.tasks)[itask];
+				task.result = ctx.presentation->MarchCubes(task.corners, task.resolution, ctx.level, task.cellSize, ctx.sampleCache, task.mesh);
+				if (Succeeded(task.result) && task.simplifyError > 0.0f)
+				{
+					MeshExtractor::Simplify(task.mesh, task.simplifyError);
+				}
+				if (Succeeded(task.result) && task.skirtDepth > 0.0f)
+				{
+					MeshExtractor::AddSkirts(task.mesh, task.facePlanes, Tetrahedron::FacesCount, task.skirtDepth, task.skirtTolerance);
+				}
+				ctx.finishedTasks += 1;
+			}
+		};
+
+		// spare worker threads are shared by concurrent passes, passes running on all threads need no helpers
+		const ur_uint tasksCount = ctx->tasksCount;
+		const ur_uint passesCount = ++this->buildPassesActive;
+		if (parallel && tasksCount > 1)
+		{
+			auto &jobSystem = this->isosurface.GetRealm().GetJobSystem();
+			ur_uint spareThreads = std::max(ur_uint(std::thread::hardware_concurrency()), ur_uint(1)) - 1;
+			ur_uint helpersCount = std::min(tasksCount - 1, spareThreads / passesCount);
+			for (ur_uint i = 0; i < helpersCount; ++i)
+			{
+				// context is shared with jobs, which may start after all tasks have been completed
+				jobSystem.Add(helpersPriority, ur_null, [ctx, processTasks](Job::Context& jobCtx) -> void {
+					processTasks(*ctx);
+				});
+			}
+		}
+		processTasks(*ctx);
+		while (ctx->finishedTasks < tasksCount) { std::this_thread::yield(); }
+		this->buildPassesActive -= 1;
+
+		Result res(Success);
+		for (const auto &task : tasks)
+		{
+			res &= task.result;
+		}
+		return res;
+	}
+
+	Result Isosurface::HybridCubes::MarchCubes(const ur_float3 (&corners)[8], const ur_uint3 &resolution, const ur_uint level, const ur_float cellSize,
+		SampleCache *sampleCache, MeshExtractor::Mesh &mesh)
 	{
 		if (ur_null == this->isosurface.GetData())
 			return Result(NotInitialized);
@@ -1506,218 +6370,122 @@ namespace UnlimRealms
 		// early isosurface intersection test
 
 		BoundingBox bbox;
-		for (auto &v : hexahedron.vertices) { bbox.Expand(v); }
+		for (auto &v : corners) { bbox.Expand(v); }
 
-		if (this->isosurface.GetData()->Read(ur_null, ur_null, 0, bbox) == NotFound)
+		if (this->isosurface.GetData()->ReadLattice(ur_null, ur_null, 0, bbox, cellSize) == NotFound)
 			return Result(Success); // does not intersect isosurface, nothing to extract here
 
 		// compute hexahedron lattice points
-		
-		auto computeLinePoints = [](ur_float3 *points, const ur_uint count, const ur_uint step, const ur_float3 &p0, const ur_float3 &p1) {
-			ur_float s = ur_float(count - 1);
-			for (ur_uint i = 0; i < count; ++i)
-			{
-				ur_float3::Lerp(*points, p0, p1, ur_float(i) / s);
-				points += step;
-			}
-		};
 
-		ur_uint rowOfs = this->desc.LatticeResolution.x;
-		ur_uint lastRowOfs = rowOfs * (this->desc.LatticeResolution.y - 1);
-		ur_uint sliceOfs = rowOfs * this->desc.LatticeResolution.y;
-		ur_uint lastSliceOfs = sliceOfs * (this->desc.LatticeResolution.z - 1);
-		ur_uint latticeSize = sliceOfs * this->desc.LatticeResolution.z;
+		ur_uint latticeSize = resolution.x * resolution.y * resolution.z;
 		std::vector<ur_float3> lattice(latticeSize);
-		
-		computeLinePoints(lattice.data(), this->desc.LatticeResolution.x, 1, hexahedron.vertices[0], hexahedron.vertices[1]);
-		computeLinePoints(lattice.data() + lastRowOfs, this->desc.LatticeResolution.x, 1, hexahedron.vertices[2], hexahedron.vertices[3]);
-		computeLinePoints(lattice.data() + lastSliceOfs, this->desc.LatticeResolution.x, 1, hexahedron.vertices[4], hexahedron.vertices[5]);
-		computeLinePoints(lattice.data() + lastRowOfs + lastSliceOfs, this->desc.LatticeResolution.x, 1, hexahedron.vertices[6], hexahedron.vertices[7]);
-		ur_float3 *p_col0 = lattice.data();
-		ur_float3 *p_col1 = lattice.data() + lastSliceOfs;
-		for (ur_uint ix = 0; ix < this->desc.LatticeResolution.x; ++ix, ++p_col0, ++p_col1)
-		{
-			computeLinePoints(p_col0, this->desc.LatticeResolution.y, rowOfs, *p_col0, *(p_col0 + lastRowOfs));
-			computeLinePoints(p_col1, this->desc.LatticeResolution.y, rowOfs, *p_col1, *(p_col1 + lastRowOfs));
-		}
-
-		ur_float3 *p_row0 = lattice.data();
-		ur_float3 *p_row1 = lattice.data() + lastSliceOfs;
-		for (ur_uint iy = 0; iy < this->desc.LatticeResolution.y; ++iy)
-		{
-			p_col0 = p_row0;
-			p_col1 = p_row1;
-			for (ur_uint ix = 0; ix < this->desc.LatticeResolution.x; ++ix, ++p_col0, ++p_col1)
-			{
-				computeLinePoints(p_col0, this->desc.LatticeResolution.z, sliceOfs, *p_col0, *p_col1);
-			}
-			p_row0 += rowOfs;
-			p_row1 += rowOfs;
-		}
+		MeshExtractor::ComputeLattice(lattice.data(), corners, resolution);
 
 		// sample and cache values at lattice points
+		// points shared with adjacent hexahedra or parent tetrahedron are fetched from the sample cache
 
-		static const DataVolume::ValueType ScalarFieldSurfaceValue = DataVolume::ValueType(0);
 		std::vector<DataVolume::ValueType> samples(latticeSize);
-		this->isosurface.GetData()->Read(samples.data(), lattice.data(), latticeSize, bbox);
-
-		// march
-
-		static const int NoVertexId = -1;
-		std::vector<Isosurface::Vertex> vertexBuffer;
-		std::vector<Isosurface::Index> indexBuffer;
-		std::vector<ur_int3> edgeVertices(latticeSize, NoVertexId);
-		ur_int *cellEdges[12];
-		ur_float3 *cellPoints[8];
-		DataVolume::ValueType *cellValues[8];
-		ur_uint3 cellsCount = this->desc.LatticeResolution - 1;
-		ur_float3 *p_slice = lattice.data();
-		DataVolume::ValueType *p_sample_slice = samples.data();
-		for (ur_uint iz = 0; iz < cellsCount.z; ++iz)
+		if (ur_null == sampleCache)
 		{
-			ur_float3 *p_row = p_slice;
-			DataVolume::ValueType *p_sample_row = p_sample_slice;
-			for (ur_uint iy = 0; iy < cellsCount.y; ++iy)
+			this->isosurface.GetData()->ReadLattice(samples.data(), lattice.data(), latticeSize, bbox, cellSize);
+		}
+		else
+		{
+			std::vector<ur_uint64> sampleKeys(latticeSize);
+			std::vector<ur_uint> missedIds;
+			sampleCache->Fetch(samples.data(), sampleKeys.data(), lattice.data(), latticeSize, level, !this->isosurface.GetData()->HasLevels(), missedIds);
+			if (missedIds.size() == latticeSize)
 			{
-				ur_float3 *p_cell = p_row;
-				DataVolume::ValueType *p_sample = p_sample_row;
-				for (ur_uint ix = 0; ix < cellsCount.x; ++ix, ++p_cell, ++p_sample)
+				this->isosurface.GetData()->ReadLattice(samples.data(), lattice.data(), latticeSize, bbox, cellSize);
+			}
+			else if (!missedIds.empty())
+			{
+				ur_uint missedCount = (ur_uint)missedIds.size();
+				std::vector<ur_float3> missedPoints(missedCount);
+				std::vector<DataVolume::ValueType> missedSamples(missedCount);
+				for (ur_uint i = 0; i < missedCount; ++i)
 				{
-					// cell corner vertices
-					cellPoints[0] = &p_cell[0];
-					cellPoints[1] = &p_cell[1];
-					cellPoints[2] = &p_cell[rowOfs + 1];
-					cellPoints[3] = &p_cell[rowOfs];
-					cellPoints[4] = &p_cell[sliceOfs];
-					cellPoints[5] = &p_cell[sliceOfs + 1];
-					cellPoints[6] = &p_cell[sliceOfs + rowOfs + 1];
-					cellPoints[7] = &p_cell[sliceOfs + rowOfs];
-
-					// cell corner samples
-					cellValues[0] = &p_sample[0];
-					cellValues[1] = &p_sample[1];
-					cellValues[2] = &p_sample[rowOfs + 1];
-					cellValues[3] = &p_sample[rowOfs];
-					cellValues[4] = &p_sample[sliceOfs];
-					cellValues[5] = &p_sample[sliceOfs + 1];
-					cellValues[6] = &p_sample[sliceOfs + rowOfs + 1];
-					cellValues[7] = &p_sample[sliceOfs + rowOfs];
-					
-					// lookup intersected edges
-					ur_uint flagIdx = 0;
-					for (ur_uint iv = 0; iv < 8; ++iv)
-					{
-						if (*cellValues[iv] <= ScalarFieldSurfaceValue) flagIdx |= (1 << iv);
-					}
-					const ur_uint &edgeFlags = MCEdgeTable[flagIdx];
-					if (edgeFlags == 0)
-						continue; // surface does not intersect any edge
-
-					// init cell vertices refs
-					ur_int3 *p_cellEdges = edgeVertices.data() + ix + iy * rowOfs + iz * sliceOfs;
-					cellEdges[0] = &p_cellEdges[0].x;
-					cellEdges[1] = &p_cellEdges[1].y;
-					cellEdges[2] = &p_cellEdges[rowOfs].x;
-					cellEdges[3] = &p_cellEdges[0].y;
-					cellEdges[4] = &p_cellEdges[sliceOfs].x;
-					cellEdges[5] = &p_cellEdges[sliceOfs + 1].y;
-					cellEdges[6] = &p_cellEdges[sliceOfs + rowOfs].x;
-					cellEdges[7] = &p_cellEdges[sliceOfs].y;
-					cellEdges[8] = &p_cellEdges[0].z;
-					cellEdges[9] = &p_cellEdges[1].z;
-					cellEdges[10] = &p_cellEdges[rowOfs + 1].z;
-					cellEdges[11] = &p_cellEdges[rowOfs].z;
-
-					// compute intersection points
-					for (ur_uint ie = 0; ie < 12; ++ie)
-					{
-						if ((edgeFlags & (1 << ie)) &&
-							(NoVertexId == *cellEdges[ie]))
-						{
-							// compute new vertex
-							DataVolume::ValueType &cv0 = *cellValues[MCEdgeVertices[ie][0]];
-							DataVolume::ValueType &cv1 = *cellValues[MCEdgeVertices[ie][1]];
-							ur_float lfactor = (ur_float)(ScalarFieldSurfaceValue - cv0) / (cv1 - cv0);
-							ur_float3 &p0 = *cellPoints[MCEdgeVertices[ie][0]];
-							ur_float3 &p1 = *cellPoints[MCEdgeVertices[ie][1]];
-							ur_float3 p = ur_float3::Lerp(p0, p1, lfactor);
-							*cellEdges[ie] = (ur_int)vertexBuffer.size();
-							vertexBuffer.push_back({ p, 0.0f, 0xffffffff });
-							// todo: compute corresponding normal here
-							// as a gradient of adjacent samples
-						}
-					}
-
-					// add triangles
-					for (ur_uint itri = 0; itri < 5; ++itri)
-					{
-						if (MCTriangleTable[flagIdx][itri * 3] < 0)
-							break;
-
-						const ur_int &vi0 = MCTriangleTable[flagIdx][itri * 3 + 0];
-						const ur_int &vi1 = MCTriangleTable[flagIdx][itri * 3 + 1];
-						const ur_int &vi2 = MCTriangleTable[flagIdx][itri * 3 + 2];
-						indexBuffer.push_back(*cellEdges[vi0]);
-						indexBuffer.push_back(*cellEdges[vi1]);
-						indexBuffer.push_back(*cellEdges[vi2]);
-					}
+					missedPoints[i] = lattice[missedIds[i]];
+				}
+				this->isosurface.GetData()->ReadLattice(missedSamples.data(), missedPoints.data(), missedCount, bbox, cellSize);
+				for (ur_uint i = 0; i < missedCount; ++i)
+				{
+					samples[missedIds[i]] = missedSamples[i];
 				}
-				p_row += rowOfs;
-				p_sample_row += rowOfs;
 			}
-			p_slice += sliceOfs;
-			p_sample_slice += sliceOfs;
+			sampleCache->Store(samples.data(), sampleKeys.data(), missedIds);
 		}
 
-		// prepare graphics resources
+		// polygonize
+
+		return this->ExtractSurface(mesh, lattice.data(), samples.data(), resolution);
+	}
+
+	Result Isosurface::HybridCubes::ExtractSurface(MeshExtractor::Mesh &mesh, const ur_float3 *points, const DataVolume::ValueType *samples, const ur_uint3 &resolution)
+	{
+		return MeshExtractor::MarchCubes(mesh, points, samples, resolution);
+	}
 
-		if (indexBuffer.size() < 3)
+	#if defined(UR_GRAF)
+	Result Isosurface::HybridCubes::UploadMesh(GrafMesh &grafMesh, const BoundingBox &bbox, const MeshExtractor::Mesh &mesh)
+	#else
+	Result Isosurface::HybridCubes::UploadMesh(GfxMesh &gfxMesh, const BoundingBox &bbox, const MeshExtractor::Mesh &mesh)
+	#endif
+	{
+		if (mesh.indices.size() < 3)
 			return Result(Success); // no data
 
-		#if defined(UR_GRAF)
+		// vertices are already shared between adjacent cells, pack indices to 16 bit when possible
 
-		GrafRenderer *grafRenderer = this->isosurface.grafRenderer;
-		GrafSystem *grafSystem = grafRenderer->GetGrafSystem();
-		GrafDevice *grafDevice = grafRenderer->GetGrafDevice();
+		std::vector<ur_uint16> indices16;
+		const bool useIndices16 = (mesh.vertices.size() <= 0x10000 && Succeeded(MeshExtractor::PackIndices(indices16, mesh.indices)));
+		const ur_byte *indexData = (useIndices16 ? (const ur_byte*)indices16.data() : (const ur_byte*)mesh.indices.data());
+		const ur_size indexSize = (useIndices16 ? sizeof(ur_uint16) : sizeof(Isosurface::Index));
+		const ur_size indexDataSize = mesh.indices.size() * indexSize;
 
-		// create vertex Buffer
-		auto &grafVB = hexahedron.grafMesh.VB;
-		Result res = grafSystem->CreateBuffer(grafVB);
-		if (Succeeded(res))
+		#if defined(UR_GRAF)
+
+		// compact vertex buffer starts with the dequantization transform followed by the quantized vertices
+		
+		std::vector<ur_byte> compactData;
+		const ur_byte *vertexData = (const ur_byte*)mesh.vertices.data();
+		ur_size vertexSize = sizeof(Isosurface::Vertex);
+		ur_size vertexDataSize = mesh.vertices.size() * vertexSize;
+		if (VertexFormat::Compact == this->desc.MeshVertexFormat)
 		{
-			GrafBufferDesc bufferDesc = {};
-			bufferDesc.Usage = (ur_uint)GrafBufferUsageFlag::VertexBuffer | (ur_uint)GrafBufferUsageFlag::TransferDst;
-			bufferDesc.MemoryType = (ur_uint)GrafDeviceMemoryFlag::GpuLocal;
-			bufferDesc.SizeInBytes = (ur_size)vertexBuffer.size() * sizeof(Isosurface::Vertex);
-			bufferDesc.ElementSize = sizeof(Isosurface::Vertex);
-			res = grafVB->Initialize(grafDevice, { bufferDesc });
-			if (Succeeded(res))
-			{
-				grafRenderer->Upload((ur_byte*)vertexBuffer.data(), grafVB.get(), bufferDesc.SizeInBytes);
-			}
+			// quantization range covers vertices outside of the region (skirts), so that they are not clamped
+			BoundingBox packBBox = bbox;
+			for (const auto &v : mesh.vertices) { packBBox.Expand(v.pos); }
+			VertexCompactTransform transform;
+			std::vector<VertexCompact> vertices;
+			MeshExtractor::PackVertices(vertices, transform, mesh.vertices, packBBox);
+			vertexSize = sizeof(VertexCompact);
+			vertexDataSize = sizeof(VertexCompactTransform) + vertices.size() * vertexSize;
+			compactData.resize(vertexDataSize);
+			memcpy(compactData.data(), &transform, sizeof(VertexCompactTransform));
+			memcpy(compactData.data() + sizeof(VertexCompactTransform), vertices.data(), vertices.size() * vertexSize);
+			vertexData = compactData.data();
 		}
-		if (Failed(res))
-			return Result(Failure);
 
-		// create index buffer
-		auto &grafIB = hexahedron.grafMesh.IB;
-		res = grafSystem->CreateBuffer(grafIB);
-		if (Succeeded(res))
+		// sub allocate from the mesh pool
+
+		if (ur_null == this->meshPool)
+			return Result(NotInitialized);
+
+		if (grafMesh.pool != ur_null && grafMesh.indexCount > 0)
 		{
-			GrafBufferDesc bufferDesc;
-			bufferDesc.Usage = (ur_uint)GrafBufferUsageFlag::IndexBuffer | (ur_uint)GrafBufferUsageFlag::TransferDst;
-			bufferDesc.MemoryType = (ur_uint)GrafDeviceMemoryFlag::GpuLocal;
-			bufferDesc.SizeInBytes = (ur_size)indexBuffer.size() * sizeof(Isosurface::Index);
-			bufferDesc.ElementSize = sizeof(Isosurface::Index);
-			res = grafIB->Initialize(grafDevice, { bufferDesc });
-			if (Succeeded(res))
-			{
-				grafRenderer->Upload((ur_byte*)indexBuffer.data(), grafIB.get(), bufferDesc.SizeInBytes);
-			}
+			grafMesh.pool->Free(grafMesh.range);
+			grafMesh.indexCount = 0;
 		}
+
+		Result res = this->meshPool->Allocate(grafMesh.range, vertexData, vertexDataSize, indexData, indexDataSize);
 		if (Failed(res))
 			return Result(Failure);
 
+		grafMesh.pool = this->meshPool;
+		grafMesh.indexCount = (ur_uint)mesh.indices.size();
+		grafMesh.indexType = (useIndices16 ? GrafIndexType::UINT16 : GrafIndexType::UINT32);
+
 		#else
 
 		GfxSystem *gfxSystem = this->isosurface.GetRealm().GetGfxSystem();
@@ -1725,23 +6493,23 @@ namespace UnlimRealms
 			return Result(Failure);
 
 		// create vertex Buffer
-		auto &gfxVB = hexahedron.gfxMesh.VB;
+		auto &gfxVB = gfxMesh.VB;
 		Result res = gfxSystem->CreateBuffer(gfxVB);
 		if (Succeeded(res))
 		{
-			GfxResourceData gfxRes = { vertexBuffer.data(), (ur_uint)vertexBuffer.size() * sizeof(Isosurface::Vertex), 0 };
+			GfxResourceData gfxRes = { (void*)mesh.vertices.data(), (ur_uint)mesh.vertices.size() * sizeof(Isosurface::Vertex), 0 };
 			res = gfxVB->Initialize(gfxRes.RowPitch, sizeof(Isosurface::Vertex), GfxUsage::Immutable, (ur_uint)GfxBindFlag::VertexBuffer, 0, &gfxRes);
 		}
 		if (Failed(res))
 			return Result(Failure);
 
 		// create index buffer
-		auto &gfxIB = hexahedron.gfxMesh.IB;
+		auto &gfxIB = gfxMesh.IB;
 		res = gfxSystem->CreateBuffer(gfxIB);
 		if (Succeeded(res))
 		{
-			GfxResourceData gfxRes = { indexBuffer.data(), (ur_uint)indexBuffer.size() * sizeof(Isosurface::Index), 0 };
-			res = gfxIB->Initialize(gfxRes.RowPitch, sizeof(Isosurface::Index), GfxUsage::Immutable, (ur_uint)GfxBindFlag::IndexBuffer, 0, &gfxRes);
+			GfxResourceData gfxRes = { (void*)indexData, (ur_uint)indexDataSize, 0 };
+			res = gfxIB->Initialize(gfxRes.RowPitch, (ur_uint)indexSize, GfxUsage::Immutable, (ur_uint)GfxBindFlag::IndexBuffer, 0, &gfxRes);
 		}
 		if (Failed(res))
 			return Result(Failure);
@@ -1757,12 +6525,20 @@ namespace UnlimRealms
 		ur_float4 frustumPlanes[6];
 		viewProj.FrustumPlanes(frustumPlanes, true);
 		this->stats.primitivesRendered = 0;
+		this->stats.drawCalls = 0;
 
-		for (auto &node : this->root)
+		std::shared_ptr<Hierarchy> hierarchy = std::atomic_load(&this->hierarchy);
+		if (hierarchy != ur_null)
 		{
-			this->Render(gfxContext, genericRender, frustumPlanes, node.get());
+			for (auto &node : hierarchy->roots)
+			{
+				this->Render(gfxContext, genericRender, frustumPlanes, node.get());
+			}
 		}
 
+		// hierarchies replaced before this frame are no longer referenced by rendering
+		this->hierarchyRetired.clear();
+
 		if (this->drawRefinementTree)
 		{
 			this->RenderOctree(genericRender, this->refinementTree.GetRoot());
@@ -1781,11 +6557,28 @@ namespace UnlimRealms
 		ur_float4 frustumPlanes[6];
 		viewProj.FrustumPlanes(frustumPlanes, true);
 		this->stats.primitivesRendered = 0;
+		this->stats.drawCalls = 0;
 
-		for (auto &node : this->root)
+		// submit ranges freed since the previous frame and reset bound pool buffers
+		if (this->meshPool != ur_null)
 		{
-			this->Render(grafCmdList, genericRender, frustumPlanes, node.get());
+			this->meshPool->Update();
+			this->stats.meshBuffers = this->meshPool->GetPagesCount() * 2;
 		}
+		this->boundVertexBuffer = ur_null;
+		this->boundIndexBuffer = ur_null;
+
+		std::shared_ptr<Hierarchy> hierarchy = std::atomic_load(&this->hierarchy);
+		if (hierarchy != ur_null)
+		{
+			for (auto &node : hierarchy->roots)
+			{
+				this->Render(grafCmdList, genericRender, frustumPlanes, node.get());
+			}
+		}
+
+		// hierarchies replaced before this frame are no longer referenced by rendering
+		this->hierarchyRetired.clear();
 
 		if (this->drawRefinementTree)
 		{
@@ -1817,27 +6610,19 @@ namespace UnlimRealms
 		}
 		else
 		{
-			for (auto &hexahedron : node->tetrahedron->hexahedra)
+			if (!this->hideSurface)
 			{
-				const auto &gfxVB = hexahedron.gfxMesh.VB;
-				const auto &gfxIB = hexahedron.gfxMesh.IB;
-				if (gfxVB != ur_null && gfxIB != ur_null && !this->hideSurface)
+				// depending on the build mode either merged or per hexahedron meshes are present
+				this->DrawMesh(gfxContext, node->tetrahedron->gfxMesh);
+				for (auto &hexahedron : node->tetrahedron->hexahedra)
 				{
-					const ur_uint indexCount = (gfxIB.get() ? gfxIB->GetDesc().Size / sizeof(Isosurface::Index) : 0);
-					this->stats.primitivesRendered += indexCount / 3;
-					gfxContext.SetVertexBuffer(gfxVB.get(), 0);
-					gfxContext.SetIndexBuffer(gfxIB.get());
-					gfxContext.DrawIndexed(indexCount, 0, 0, 0, 0);
+					this->DrawMesh(gfxContext, hexahedron.gfxMesh);
 				}
 			}
 
 			if (this->drawTetrahedra)
 			{
-				if (!this->hideEmptyTetrahedra || node->tetrahedron->initialized && (
-					node->tetrahedron->hexahedra[0].gfxMesh.VB != ur_null ||
-					node->tetrahedron->hexahedra[1].gfxMesh.VB != ur_null ||
-					node->tetrahedron->hexahedra[2].gfxMesh.VB != ur_null ||
-					node->tetrahedron->hexahedra[3].gfxMesh.VB != ur_null))
+				if (!this->hideEmptyTetrahedra || (node->tetrahedron->initialized && this->HasMesh(*node->tetrahedron)))
 				{
 					RenderDebug(genericRender, node);
 				}
@@ -1869,27 +6654,19 @@ namespace UnlimRealms
 		}
 		else
 		{
-			for (auto &hexahedron : node->tetrahedron->hexahedra)
+			if (!this->hideSurface)
 			{
-				const auto &grafVB = hexahedron.grafMesh.VB;
-				const auto &grafIB = hexahedron.grafMesh.IB;
-				if (grafVB != ur_null && grafIB != ur_null && !this->hideSurface)
+				// depending on the build mode either merged or per hexahedron meshes are present
+				this->DrawMesh(grafCmdList, node->tetrahedron->grafMesh);
+				for (auto &hexahedron : node->tetrahedron->hexahedra)
 				{
-					const ur_uint indexCount = ur_uint(grafIB.get() ? grafIB->GetDesc().SizeInBytes / sizeof(Isosurface::Index) : 0);
-					this->stats.primitivesRendered += indexCount / 3;
-					grafCmdList.BindVertexBuffer(grafVB.get(), 0);
-					grafCmdList.BindIndexBuffer(grafIB.get(), (sizeof(Isosurface::Index) == 2 ? GrafIndexType::UINT16 : GrafIndexType::UINT32));
-					grafCmdList.DrawIndexed(indexCount, 1, 0, 0, 0);
+					this->DrawMesh(grafCmdList, hexahedron.grafMesh);
 				}
 			}
 
 			if (this->drawTetrahedra)
 			{
-				if (!this->hideEmptyTetrahedra || node->tetrahedron->initialized && (
-					node->tetrahedron->hexahedra[0].grafMesh.VB != ur_null ||
-					node->tetrahedron->hexahedra[1].grafMesh.VB != ur_null ||
-					node->tetrahedron->hexahedra[2].grafMesh.VB != ur_null ||
-					node->tetrahedron->hexahedra[3].grafMesh.VB != ur_null))
+				if (!this->hideEmptyTetrahedra || (node->tetrahedron->initialized && this->HasMesh(*node->tetrahedron)))
 				{
 					RenderDebug(genericRender, node);
 				}
@@ -1902,6 +6679,59 @@ namespace UnlimRealms
 	#endif
 	}
 
+	#if defined(UR_GRAF)
+	void Isosurface::HybridCubes::DrawMesh(GrafCommandList &grafCmdList, const GrafMesh &grafMesh)
+	{
+		if (ur_null == grafMesh.pool || 0 == grafMesh.indexCount)
+			return;
+
+		// meshes share pool pages, buffers are rebound only when the page or index type changes
+		const MeshPool::Range &range = grafMesh.range;
+		GrafBuffer *grafVB = grafMesh.pool->GetVertexBuffer(range.page);
+		GrafBuffer *grafIB = grafMesh.pool->GetIndexBuffer(range.page);
+		const bool compact = (VertexFormat::Compact == this->desc.MeshVertexFormat);
+		if (grafVB != this->boundVertexBuffer)
+		{
+			grafCmdList.BindVertexBuffer(grafVB, 0);
+			if (compact)
+			{
+				// per instance stream 1 reads dequantization transform stored at the range start
+				grafCmdList.BindVertexBuffer(grafVB, 1);
+			}
+			this->boundVertexBuffer = grafVB;
+		}
+		if (grafIB != this->boundIndexBuffer || grafMesh.indexType != this->boundIndexType)
+		{
+			grafCmdList.BindIndexBuffer(grafIB, grafMesh.indexType);
+			this->boundIndexBuffer = grafIB;
+			this->boundIndexType = grafMesh.indexType;
+		}
+
+		const ur_uint transformUnits = ur_uint(sizeof(VertexCompactTransform) / sizeof(VertexCompact));
+		const ur_uint firstVertex = ur_uint(range.vertices.Offset) + (compact ? transformUnits : 0);
+		const ur_uint firstInstance = (compact ? ur_uint(range.vertices.Offset) / transformUnits : 0);
+		const ur_uint firstIndex = ur_uint(range.indices.Offset) * (GrafIndexType::UINT16 == grafMesh.indexType ? 2 : 1);
+		grafCmdList.DrawIndexed(grafMesh.indexCount, 1, firstIndex, firstVertex, firstInstance);
+		this->stats.primitivesRendered += grafMesh.indexCount / 3;
+		this->stats.drawCalls += 1;
+	}
+	#else
+	void Isosurface::HybridCubes::DrawMesh(GfxContext &gfxContext, const GfxMesh &gfxMesh)
+	{
+		const auto &gfxVB = gfxMesh.VB;
+		const auto &gfxIB = gfxMesh.IB;
+		if (ur_null == gfxVB || ur_null == gfxIB)
+			return;
+
+		const ur_uint indexCount = gfxIB->GetDesc().Size / gfxIB->GetDesc().ElementSize;
+		this->stats.primitivesRendered += indexCount / 3;
+		this->stats.drawCalls += 1;
+		gfxContext.SetVertexBuffer(gfxVB.get(), 0);
+		gfxContext.SetIndexBuffer(gfxIB.get());
+		gfxContext.DrawIndexed(indexCount, 0, 0, 0, 0);
+	}
+	#endif
+
 	Result Isosurface::HybridCubes::RenderDebug(GenericRender *genericRender, Node *node)
 	{
 		if (ur_null == genericRender ||
@@ -1921,21 +6751,22 @@ namespace UnlimRealms
 		if (this->drawHexahedra)
 		{
 			static const ur_float4 s_hexaColor = { 0.0f, 1.0f, 0.0f, 1.0f };
-			for (ur_uint ih = 0; ih < 4; ++ih)
+			for (ur_uint ih = 0; ih < Tetrahedron::HexahedraCount; ++ih)
 			{
-				const Hexahedron &h = node->tetrahedron->hexahedra[ih];
-				genericRender->DrawLine(h.vertices[0], h.vertices[1], s_hexaColor);
-				genericRender->DrawLine(h.vertices[2], h.vertices[3], s_hexaColor);
-				genericRender->DrawLine(h.vertices[4], h.vertices[5], s_hexaColor);
-				genericRender->DrawLine(h.vertices[6], h.vertices[7], s_hexaColor);
-				genericRender->DrawLine(h.vertices[0], h.vertices[2], s_hexaColor);
-				genericRender->DrawLine(h.vertices[1], h.vertices[3], s_hexaColor);
-				genericRender->DrawLine(h.vertices[4], h.vertices[6], s_hexaColor);
-				genericRender->DrawLine(h.vertices[5], h.vertices[7], s_hexaColor);
-				genericRender->DrawLine(h.vertices[0], h.vertices[4], s_hexaColor);
-				genericRender->DrawLine(h.vertices[1], h.vertices[5], s_hexaColor);
-				genericRender->DrawLine(h.vertices[2], h.vertices[6], s_hexaColor);
-				genericRender->DrawLine(h.vertices[3], h.vertices[7], s_hexaColor);
+				Vertex hv[Hexahedron::VerticesCount];
+				Tetrahedron::HexahedronVertices(node->tetrahedron->vertices, ih, hv);
+				genericRender->DrawLine(hv[0], hv[1], s_hexaColor);
+				genericRender->DrawLine(hv[2], hv[3], s_hexaColor);
+				genericRender->DrawLine(hv[4], hv[5], s_hexaColor);
+				genericRender->DrawLine(hv[6], hv[7], s_hexaColor);
+				genericRender->DrawLine(hv[0], hv[2], s_hexaColor);
+				genericRender->DrawLine(hv[1], hv[3], s_hexaColor);
+				genericRender->DrawLine(hv[4], hv[6], s_hexaColor);
+				genericRender->DrawLine(hv[5], hv[7], s_hexaColor);
+				genericRender->DrawLine(hv[0], hv[4], s_hexaColor);
+				genericRender->DrawLine(hv[1], hv[5], s_hexaColor);
+				genericRender->DrawLine(hv[2], hv[6], s_hexaColor);
+				genericRender->DrawLine(hv[3], hv[7], s_hexaColor);
 			}
 		}
 
@@ -1973,6 +6804,8 @@ namespace UnlimRealms
 			ImGui::Checkbox("Hide empty tetrahedra", &this->hideEmptyTetrahedra);
 			ImGui::Checkbox("Draw hexahedra", &this->drawHexahedra);
 			ImGui::Checkbox("Draw refinement tree", &this->drawRefinementTree);
+			ImGui::Checkbox("Parallel build", &this->parallelBuild);
+			ImGui::Checkbox("Parallel update", &this->parallelUpdate);
 			
 			ImGui::SetNextItemOpen(true, ImGuiCond_Once);
 			if (ImGui::TreeNode("Stats"))
@@ -1981,7 +6814,37 @@ namespace UnlimRealms
 				ImGui::Text("treeMemory:            %i", (int)this->stats.treeMemory);
 				ImGui::Text("meshVideoMemory:       %i", (int)this->stats.meshVideoMemory);
 				ImGui::Text("primitivesRendered:    %i", (int)this->stats.primitivesRendered);
+				ImGui::Text("drawCalls:             %i", (int)this->stats.drawCalls);
+				ImGui::Text("meshBuffers:           %i", (int)this->stats.meshBuffers);
+				#if defined(UR_GRAF)
+				if (this->meshPool != ur_null)
+				{
+					ur_size poolUsed, poolTotal;
+					this->meshPool->GetMemoryStats(poolUsed, poolTotal);
+					ImGui::Text("meshPoolUsage:         %i / %i KB", (int)(poolUsed / 1024), (int)(poolTotal / 1024));
+				}
+				#endif
 				ImGui::Text("buildQueue:            %i", (int)this->stats.buildQueue);
+				ImGui::Text("rebuildQueue:          %i", (int)this->stats.rebuildQueue);
+				ImGui::Text("buildDeferred:         %i", (int)this->stats.buildDeferred);
+				ImGui::Text("buildLatency p50/90/99: %.1f / %.1f / %.1f ms",
+					this->stats.buildLatencyP50, this->stats.buildLatencyP90, this->stats.buildLatencyP99);
+				ImGui::Text("prefetch hits/misses:  %i / %i of %i", (int)this->stats.prefetchHits,
+					(int)this->stats.prefetchMisses, (int)this->stats.prefetchRequested);
+				ImGui::Text("meshCacheHitRate:      %.1f%%", (this->stats.meshCacheRequests > 0 ?
+					ur_float(this->stats.meshCacheHits) / this->stats.meshCacheRequests * 100.0f : 0.0f));
+				ImGui::Text("meshCacheMemory:       %i KB", (int)(this->stats.meshCacheMemory / 1024));
+				if (!this->desc.DiskCachePath.empty())
+				{
+					ImGui::Text("diskCacheHitRate:      %.1f%%", (this->stats.diskCacheRequests > 0 ?
+						ur_float(this->stats.diskCacheHits) / this->stats.diskCacheRequests * 100.0f : 0.0f));
+				}
+				ImGui::Text("refinementVisited:     %i", (int)this->stats.refinementNodesVisited);
+				ImGui::Text("refinementChanges:     %i", (int)this->stats.refinementChanges);
+				ImGui::Text("lodUpdates:            %i", (int)this->stats.lodUpdates);
+				ImGui::Text("hierarchyNodesVisited: %i", (int)this->stats.hierarchyNodesVisited);
+				ImGui::Text("sampleCacheHitRate:    %.1f%%", (this->stats.samplesRequested > 0 ?
+					ur_float(this->stats.samplesCached) / this->stats.samplesRequested * 100.0f : 0.0f));
 				ImGui::TreePop();
 			}
 			
@@ -1989,6 +6852,35 @@ namespace UnlimRealms
 		}
 	}
 
+	Isosurface::VertexFormat Isosurface::HybridCubes::GetVertexFormat() const
+	{
+	#if defined(UR_GRAF)
+		return this->desc.MeshVertexFormat;
+	#else
+		return VertexFormat::Full; // compact vertex input is not supported by GFX path
+	#endif
+	}
+
+
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// Isosurface::SurfaceNets
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	Isosurface::SurfaceNets::SurfaceNets(Isosurface &isosurface, const Desc &desc) :
+		HybridCubes(isosurface, desc)
+	{
+	}
+
+	Isosurface::SurfaceNets::~SurfaceNets()
+	{
+	}
+
+	Result Isosurface::SurfaceNets::ExtractSurface(MeshExtractor::Mesh &mesh, const ur_float3 *points, const DataVolume::ValueType *samples, const ur_uint3 &resolution)
+	{
+		return MeshExtractor::SurfaceNets(mesh, points, samples, resolution);
+	}
+
 	
 	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 	// Isosurface
@@ -2007,6 +6899,14 @@ namespace UnlimRealms
 	{
 	}
 
+	Result Isosurface::Init(std::unique_ptr<DataVolume> data)
+	{
+		this->data = std::move(data);
+		this->presentation.reset();
+
+		return Result(Success);
+	}
+
 	Result Isosurface::Init(std::unique_ptr<DataVolume> data, std::unique_ptr<Presentation> presentation)
 	{
 	#if !defined(UR_GRAF)
@@ -2076,6 +6976,11 @@ namespace UnlimRealms
 		if (Failed(res))
 			return ResultError(Failure, "Isosurface::CreateGrafObjects: failed to initialize VS");
 
+		// VS compact
+		res = GrafUtils::CreateShaderFromFile(*grafDevice, "IsosurfaceCompact_vs", GrafShaderType::Vertex, this->grafObjects.VSCompact);
+		if (Failed(res))
+			return ResultError(Failure, "Isosurface::CreateGrafObjects: failed to initialize VSCompact");
+
 		// PS
 		res = GrafUtils::CreateShaderFromFile(*grafDevice, "Isosurface_ps", GrafShaderType::Pixel, this->grafObjects.PS);
 		if (Failed(res))
@@ -2155,6 +7060,48 @@ namespace UnlimRealms
 		if (Failed(res))
 			return ResultError(Failure, "Isosurface::CreateGrafObjects: failed to initialize pipeline object");
 
+		res = grafSystem->CreatePipeline(this->grafObjects.pipelineCompact);
+		if (Succeeded(res))
+		{
+			GrafShader* shaderStages[] = {
+				this->grafObjects.VSCompact.get(),
+				this->grafObjects.PS.get()
+			};
+			GrafDescriptorTableLayout* descriptorLayouts[] = {
+				this->grafObjects.shaderDescriptorLayout.get(),
+			};
+			GrafVertexElementDesc vertexElements[] = {
+				{ GrafFormat::R16G16B16A16_UNORM, 0, "POSITION" },
+				{ GrafFormat::R16G16_SINT, 8, "NORMAL" },
+				{ GrafFormat::R8G8B8A8_UNORM, 12, "COLOR" },
+			};
+			GrafVertexElementDesc transformElements[] = {
+				{ GrafFormat::R32G32B32A32_SFLOAT, 0, "TEXCOORD0" },
+				{ GrafFormat::R32G32B32A32_SFLOAT, 16, "TEXCOORD1" },
+			};
+			GrafVertexInputDesc vertexInputs[] = {
+				{ GrafVertexInputType::PerVertex, 0, sizeof(VertexCompact), vertexElements, ur_array_size(vertexElements) },
+				{ GrafVertexInputType::PerInstance, 1, sizeof(VertexCompactTransform), transformElements, ur_array_size(transformElements) }
+			};
+			GrafPipeline::InitParams pipelineParams = GrafPipeline::InitParams::Default;
+			pipelineParams.RenderPass = grafRenderPass;
+			pipelineParams.ShaderStages = shaderStages;
+			pipelineParams.ShaderStageCount = ur_array_size(shaderStages);
+			pipelineParams.DescriptorTableLayouts = descriptorLayouts;
+			pipelineParams.DescriptorTableLayoutCount = ur_array_size(descriptorLayouts);
+			pipelineParams.VertexInputDesc = vertexInputs;
+			pipelineParams.VertexInputCount = ur_array_size(vertexInputs);
+			pipelineParams.PrimitiveTopology = GrafPrimitiveTopology::TriangleList;
+			pipelineParams.FrontFaceOrder = GrafFrontFaceOrder::Clockwise;
+			pipelineParams.CullMode = GrafCullMode::Back;
+			pipelineParams.DepthTestEnable = true;
+			pipelineParams.DepthWriteEnable = true;
+			pipelineParams.DepthCompareOp = GrafCompareOp::LessOrEqual;
+			res = this->grafObjects.pipelineCompact->Initialize(grafDevice, pipelineParams);
+		}
+		if (Failed(res))
+			return ResultError(Failure, "Isosurface::CreateGrafObjects: failed to initialize compact pipeline object");
+
 		return res;
 	}
 
@@ -2321,9 +7268,11 @@ namespace UnlimRealms
 			GrafDescriptorTable *shaderDescriptorTable = this->grafObjects.shaderDescriptorTable[frameIdx].get();
 			shaderDescriptorTable->SetConstantBuffer(0, dynamicCB, dynamicCBAlloc.Offset, dynamicCBAlloc.Size);
 
-			// bind pipeline
-			grafCmdList.BindPipeline(this->grafObjects.pipelineSolid.get());
-			grafCmdList.BindDescriptorTable(shaderDescriptorTable, this->grafObjects.pipelineSolid.get());
+			// bind pipeline matching presentation's vertex format
+			GrafPipeline *pipeline = (VertexFormat::Compact == this->presentation->GetVertexFormat() ?
+				this->grafObjects.pipelineCompact.get() : this->grafObjects.pipelineSolid.get());
+			grafCmdList.BindPipeline(pipeline);
+			grafCmdList.BindDescriptorTable(shaderDescriptorTable, pipeline);
 
 			res = this->presentation->Render(grafCmdList, viewProj);
 
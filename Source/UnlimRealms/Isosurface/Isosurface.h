@@ -9,6 +9,7 @@
 
 #include "Realm/Realm.h"
 #include "Sys/JobSystem.h"
+#include "Sys/Storage.h"
 #include "Gfx/GfxSystem.h"
 #include "GenericRender/GenericRender.h"
 #include "Atmosphere/Atmosphere.h"
@@ -29,6 +30,38 @@ namespace UnlimRealms
 		// forward declaration
 		class UR_DECL Instance;
 
+		// surface mesh vertex
+		struct Vertex
+		{
+			ur_float3 pos;
+			ur_float3 norm;
+			ur_uint32 col;
+		};
+
+		typedef ur_uint32 Index;
+
+		// quantized surface mesh vertex (16 bytes):
+		// position is stored relative to the mesh bounding box, normal is octahedral encoded
+		struct VertexCompact
+		{
+			ur_uint16 pos[4]; // unorm position inside mesh bbox, w is unused
+			ur_int16 norm[2]; // octahedral normal scaled to [-32767, 32767]
+			ur_uint32 col;
+		};
+
+		// dequantization parameters of VertexCompact: pos = offset + unorm(pos) * scale
+		struct VertexCompactTransform
+		{
+			ur_float4 offset;
+			ur_float4 scale;
+		};
+
+		enum class UR_DECL VertexFormat
+		{
+			Full, // Vertex
+			Compact // VertexCompact
+		};
+
 
 		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 		// Base isosurface sub system
@@ -77,27 +110,497 @@ namespace UnlimRealms
 
 			typedef ur_float ValueType;
 
+			struct UR_DECL EditBrush
+			{
+				enum class UR_DECL Shape
+				{
+					Sphere,
+					Box
+				};
+
+				enum class UR_DECL Operation
+				{
+					Add,
+					Subtract
+				};
+
+				Shape shape;
+				Operation operation;
+				ur_float3 center;
+				ur_float3 extent; // sphere: radius (x), box: half size
+			};
+
 			DataVolume(Isosurface &isosurface);
 
 			~DataVolume();
 
 			virtual Result Read(ValueType *values, const ur_float3 *points, const ur_uint count, const BoundingBox &bbox);
 
-			// todo: support data modification
-			//virtual Result Write(const ValueType &value);
+			// reads samples of a lattice of the given cell size; volumes storing several levels of detail select the level by it,
+			// so that any subset of the lattice is sampled from the same level (cellSize <= 0: estimated from count like Read does)
+			virtual Result ReadLattice(ValueType *values, const ur_float3 *points, const ur_uint count, const BoundingBox &bbox, const ur_float cellSize);
+
+			virtual Result Write(const EditBrush &brush);
+
+			// retrieves regions modified since the previous call
+			virtual Result FetchDirtyRegions(std::vector<BoundingBox> &regions);
 
 			virtual Result Save(const std::string &fileName);
 
 			virtual Result Save(const std::string &fileName, ur_float cellSize, ur_uint3 blockResolution);
 
+			// hints that data around given region is going to be requested soon
+			virtual Result Prefetch(const BoundingBox &bbox);
+
+			// identifies the volume content for persistent caches, zero if content can not be identified
+			virtual ur_uint64 GetContentHash() const;
+
+			// true if sampled values depend on the lattice cell size (volume stores several levels of detail)
+			virtual ur_bool HasLevels() const;
+
 			inline const BoundingBox& GetBound() const { return this->bound; }
 
 		protected:
 
+			// volume file layout:
+			// [FileHeader][FileLevel x levelsCount][blocks data][FileBlock x blocksCount]
+			// levels are stored from the coarsest (single block) to the most detailed one,
+			// block samples are stored in x-y-z order and include border samples on each side,
+			// blocks that do not intersect isosurface are stored as constant tiles without samples data
+			static const ur_uint32 FileMagic = 0x46565255; // "URVF"
+			static const ur_uint32 FileVersion = 1;
+			static const ur_uint FileBlockBorder = 1;
+			static const ur_uint32 FileBlockConstant = (1 << 0);
+
+			struct UR_DECL FileHeader
+			{
+				ur_uint32 magic;
+				ur_uint32 version;
+				ur_float3 boundMin;
+				ur_float3 boundMax;
+				ur_uint3 blockResolution; // cells per block
+				ur_uint32 blockBorder; // extra samples on each block side
+				ur_uint32 levelsCount;
+				ur_uint32 blocksCount;
+				ur_uint64 indexOffset;
+			};
+
+			struct UR_DECL FileLevel
+			{
+				ur_float3 cellSize;
+				ur_uint3 blocksCount;
+				ur_uint32 firstBlock;
+			};
+
+			struct UR_DECL FileBlock
+			{
+				ur_uint64 offset;
+				ValueType constValue;
+				ur_uint32 flags;
+			};
+
+			static inline ur_uint3 GetFileBlockSize(const FileHeader &header)
+			{
+				return (header.blockResolution + 1 + header.blockBorder * 2);
+			}
+
+			// sampling interval of count points evenly spread over bbox, zero if it can not be estimated
+			static ur_float EstimateSpacing(const BoundingBox &bbox, const ur_uint count);
+
+			static ur_uint SelectFileLevel(const FileHeader &header, const FileLevel *levels, const ur_float spacing);
+
+			static ur_uint3 GetFileBlockPos(const FileHeader &header, const FileLevel &level, const ur_float3 &point);
+
+			static inline ur_uint GetFileBlockId(const FileLevel &level, const ur_uint3 &blockPos)
+			{
+				return level.firstBlock + blockPos.x + (blockPos.y + blockPos.z * level.blocksCount.y) * level.blocksCount.x;
+			}
+
+			static Result TestFileBlocks(const FileHeader &header, const FileLevel &level, const FileBlock *blocks, const BoundingBox &bbox);
+
+			static ValueType SampleFileBlock(const ValueType *samples, const ur_uint3 &blockSize, const ur_float3 &pos);
+
 			BoundingBox bound;
 		};
 
 
+		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		// Volume data stored in a file produced by DataVolume::Save
+		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		class UR_DECL FileVolume : public DataVolume
+		{
+		public:
+
+			FileVolume(Isosurface &isosurface);
+
+			~FileVolume();
+
+			Result Open(const std::string &fileName);
+
+			virtual Result Read(ValueType *values, const ur_float3 *points, const ur_uint count, const BoundingBox &bbox);
+
+			virtual Result ReadLattice(ValueType *values, const ur_float3 *points, const ur_uint count, const BoundingBox &bbox, const ur_float cellSize);
+
+			virtual ur_bool HasLevels() const;
+
+		private:
+
+			static const ur_uint BlockCacheSize = 1024;
+
+			Result FetchBlock(std::shared_ptr<std::vector<ValueType>> &samples, const ur_uint blockId);
+
+			std::unique_ptr<File> file;
+			FileHeader header;
+			std::vector<FileLevel> levels;
+			std::vector<FileBlock> blocks;
+			std::unordered_map<ur_uint, std::shared_ptr<std::vector<ValueType>>> blockCache;
+			std::list<ur_uint> blockCacheOrder;
+			std::mutex mutex;
+		};
+
+
+		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		// Memory mapped volume file produced by DataVolume::Save
+		// Blocks are accessed directly in the mapped view, recently used blocks are tracked
+		// in a residency set and prefetched/released using OS paging hints
+		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		class UR_DECL MappedVolume : public DataVolume
+		{
+		public:
+
+			MappedVolume(Isosurface &isosurface);
+
+			~MappedVolume();
+
+			Result Open(const std::string &fileName);
+
+			Result Close();
+
+			virtual Result Read(ValueType *values, const ur_float3 *points, const ur_uint count, const BoundingBox &bbox);
+
+			virtual Result ReadLattice(ValueType *values, const ur_float3 *points, const ur_uint count, const BoundingBox &bbox, const ur_float cellSize);
+
+			virtual Result Prefetch(const BoundingBox &bbox);
+
+			virtual ur_bool HasLevels() const;
+
+			inline ur_uint GetResidentBlocksCount() const { return (ur_uint)this->residentBlocks.size(); }
+
+		private:
+
+			static const ur_uint ResidentBlocksMax = 4096;
+
+			inline const ValueType* GetBlockSamples(const FileBlock &block) const { return (const ValueType*)(this->mappedData + block.offset); }
+
+			void AdviseBlock(const FileBlock &block, bool willNeed);
+
+			void TouchBlock(const ur_uint blockId);
+
+			#if defined(_WINDOWS)
+			HANDLE fileHandle;
+			HANDLE mappingHandle;
+			#else
+			int fileDesc;
+			#endif
+			const ur_byte *mappedData;
+			ur_size mappedSize;
+			ur_size pageSize;
+			const FileHeader *header;
+			const FileLevel *levels;
+			const FileBlock *blocks;
+			std::list<ur_uint> residentOrder;
+			std::unordered_map<ur_uint, std::list<ur_uint>::iterator> residentBlocks;
+			std::mutex mutex;
+		};
+
+
+		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		// Sparse hierarchical volume
+		// Values are stored in quantized 8x8x8 leaf bricks organized in a shallow tree of bit masked internal nodes,
+		// regions outside of the isosurface narrow band are stored as constant tiles
+		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		class UR_DECL SparseVolume : public DataVolume
+		{
+		public:
+
+			struct UR_DECL Desc
+			{
+				ur_float VoxelSize; // distance between neighbour samples
+				ur_float NarrowBand; // values are clamped to [-NarrowBand, NarrowBand], leaves beyond the band become tiles
+				ur_uint QuantizationBits; // leaf sample precision: 8 or 16 bits
+			};
+
+			struct UR_DECL Stats
+			{
+				ur_uint upperNodesCount;
+				ur_uint lowerNodesCount;
+				ur_uint leavesCount;
+				ur_uint tilesCount;
+				ur_size memoryUsed;
+			};
+
+			SparseVolume(Isosurface &isosurface);
+
+			~SparseVolume();
+
+			Result Build(DataVolume &source, const Desc &desc);
+
+			virtual Result Read(ValueType *values, const ur_float3 *points, const ur_uint count, const BoundingBox &bbox);
+
+			inline const Desc& GetDesc() const { return this->desc; }
+
+			inline const Stats& GetStats() const { return this->stats; }
+
+		private:
+
+			struct UR_DECL Leaf
+			{
+				static const ur_uint Log2Dim = 3;
+				static const ur_uint TotalLog2Dim = Log2Dim;
+				static const ur_uint Dim = (1 << Log2Dim);
+				static const ur_uint ValuesCount = Dim * Dim * Dim;
+
+				ValueType offset;
+				ValueType scale;
+				ur_uint bytesPerValue;
+				std::unique_ptr<ur_byte[]> data;
+
+				inline ValueType GetValue(const ur_uint idx) const
+				{
+					ur_uint q = (2 == this->bytesPerValue ? (ur_uint)((const ur_uint16*)this->data.get())[idx] : (ur_uint)this->data[idx]);
+					return this->offset + this->scale * ValueType(q);
+				}
+
+				inline ValueType GetValueMin() const { return this->offset; }
+
+				inline ValueType GetValueMax() const { return this->offset + this->scale * ValueType((1 << (this->bytesPerValue * 8)) - 1); }
+			};
+
+			template <class TChild, ur_uint TLog2Dim>
+			struct UR_DECL InternalNode
+			{
+				static const ur_uint Log2Dim = TLog2Dim;
+				static const ur_uint TotalLog2Dim = TLog2Dim + TChild::TotalLog2Dim;
+				static const ur_uint Dim = (1 << Log2Dim);
+				static const ur_uint ChildrenCount = Dim * Dim * Dim;
+
+				ur_uint64 childMask[ChildrenCount / 64];
+				ValueType tiles[ChildrenCount];
+				std::unique_ptr<TChild> children[ChildrenCount];
+
+				InternalNode(const ValueType tileValue);
+
+				inline bool HasChild(const ur_uint idx) const { return (this->childMask[idx >> 6] & (ur_uint64(1) << (idx & 63))) != 0; }
+
+				void SetChild(const ur_uint idx, std::unique_ptr<TChild> child);
+
+				static inline ur_uint ChildIndex(const ur_int3 &voxel)
+				{
+					return (((voxel.x >> TChild::TotalLog2Dim) & (Dim - 1))) |
+						(((voxel.y >> TChild::TotalLog2Dim) & (Dim - 1)) << Log2Dim) |
+						(((voxel.z >> TChild::TotalLog2Dim) & (Dim - 1)) << (Log2Dim * 2));
+				}
+			};
+
+			typedef InternalNode<Leaf, 4> LowerNode;
+			typedef InternalNode<LowerNode, 4> UpperNode;
+
+			// cached tree traversal used for coherent lookups
+			class UR_DECL Accessor
+			{
+			public:
+
+				explicit Accessor(const SparseVolume &volume);
+
+				ValueType GetValue(const ur_int3 &voxel);
+
+			private:
+
+				const SparseVolume &volume;
+				ur_int3 cachedOrigin;
+				ur_int cachedSize;
+				const Leaf *cachedLeaf;
+				ValueType cachedValue;
+			};
+
+			static inline ur_uint64 RootKey(const ur_int3 &voxel)
+			{
+				return ur_uint64(voxel.x >> UpperNode::TotalLog2Dim) |
+					(ur_uint64(voxel.y >> UpperNode::TotalLog2Dim) << 21) |
+					(ur_uint64(voxel.z >> UpperNode::TotalLog2Dim) << 42);
+			}
+
+			BoundingBox GetVoxelsBound(const ur_int3 &origin, const ur_int size) const;
+
+			Result BuildLowerNode(DataVolume &source, const ur_int3 &origin, std::unique_ptr<LowerNode> &node, ValueType &tileValue) const;
+
+			ValueType ComputeTileValue(DataVolume &source, const BoundingBox &bbox) const;
+
+			Result TestIntersection(const BoundingBox &bbox) const;
+
+			Desc desc;
+			Stats stats;
+			ur_int3 voxelsCount;
+			std::unordered_map<ur_uint64, std::unique_ptr<UpperNode>> root;
+		};
+
+
+		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		// Editable volume
+		// Applies edit brushes on top of any source volume; brushes are kept as a sparse overlay
+		// hashed by fixed size bricks, so only brushes affecting sampled region are evaluated;
+		// a brick affected by too many brushes bakes them into a lattice of samples, brushes no longer referenced by any brick are released
+		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		class UR_DECL EditableVolume : public DataVolume
+		{
+		public:
+
+			static const ur_uint BakeResolution = 16; // baked lattice cells per brick side
+
+			// bakeBrushesMax: brushes count at which a brick is baked (zero - never baked)
+			EditableVolume(Isosurface &isosurface, std::unique_ptr<DataVolume> source, ur_float brickSize, ur_uint bakeBrushesMax = 16);
+
+			~EditableVolume();
+
+			virtual Result Read(ValueType *values, const ur_float3 *points, const ur_uint count, const BoundingBox &bbox);
+
+			virtual Result ReadLattice(ValueType *values, const ur_float3 *points, const ur_uint count, const BoundingBox &bbox, const ur_float cellSize);
+
+			virtual Result Write(const EditBrush &brush);
+
+			virtual Result FetchDirtyRegions(std::vector<BoundingBox> &regions);
+
+			virtual Result Prefetch(const BoundingBox &bbox);
+
+			virtual ur_bool HasLevels() const;
+
+			inline DataVolume* GetSource() const { return this->source.get(); }
+
+			inline ur_uint GetBrushesCount() const { return (ur_uint)this->brushes.size(); }
+
+			inline ur_uint GetBakedBricksCount() const { return this->bakedBricksCount; }
+
+		private:
+
+			static const ur_uint BakeLatticeSize = (BakeResolution + 1) * (BakeResolution + 1) * (BakeResolution + 1);
+
+			struct UR_DECL Brush
+			{
+				EditBrush brush;
+				BoundingBox bound;
+				ur_uint bricksCount; // bricks referencing the brush
+			};
+
+			struct UR_DECL Brick
+			{
+				ur_int3 pos;
+				std::vector<ur_uint> brushIds; // brushes not baked yet, in the order they were written
+				std::shared_ptr<const std::vector<ValueType>> baked; // samples of the source and baked brushes, null if not baked
+			};
+
+			static ValueType EvaluateBrush(const EditBrush &brush, const ur_float3 &point);
+
+			ur_int3 GetBrickPos(const ur_float3 &point) const;
+
+			static inline ur_uint64 GetBrickKey(const ur_int3 &pos)
+			{
+				return (ur_uint64(pos.x & 0x1fffff) | (ur_uint64(pos.y & 0x1fffff) << 21) | (ur_uint64(pos.z & 0x1fffff) << 42));
+			}
+
+			ValueType SampleBaked(const std::vector<ValueType> &baked, const ur_int3 &brickPos, const ur_float3 &point) const;
+
+			// must be called with the mutex locked
+			Result BakeBrick(const ur_int3 &brickPos, Brick &brick);
+
+			std::unique_ptr<DataVolume> source;
+			ur_float brickSize;
+			ur_uint bakeBrushesMax;
+			ur_uint bakedBricksCount;
+			ur_uint brushIdNext;
+			std::unordered_map<ur_uint, Brush> brushes;
+			std::unordered_map<ur_uint64, Brick> bricks;
+			std::vector<BoundingBox> dirtyRegions;
+			std::mutex mutex;
+		};
+
+
+		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		// CSG volume
+		// Combines signed distance primitives in order of their declaration; primitives are kept in a BVH,
+		// so a read evaluates only those whose influence bound overlaps the requested region
+		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		class UR_DECL CsgVolume : public DataVolume
+		{
+		public:
+
+			struct UR_DECL Primitive
+			{
+				enum class UR_DECL Shape
+				{
+					Sphere,
+					Box,
+					Capsule
+				};
+
+				enum class UR_DECL Operation
+				{
+					Union,
+					Subtract,
+					SmoothUnion,
+					SmoothSubtract
+				};
+
+				Shape shape;
+				Operation operation;
+				ur_float3 center;
+				ur_float3 extent; // sphere: radius (x), box: half size, capsule: radius (x)
+				ur_float3 axis; // capsule: segment half vector
+				ur_float blend; // smooth operations blending distance
+			};
+
+			struct UR_DECL Desc
+			{
+				ur_float Margin; // distance to primitives surface where field is evaluated, values are clamped to [-Margin, Margin]
+				ur_uint LeafSize; // max primitives per BVH leaf
+			};
+
+			CsgVolume(Isosurface &isosurface);
+
+			~CsgVolume();
+
+			Result Build(const std::vector<Primitive> &primitives, const Desc &desc);
+
+			virtual Result Read(ValueType *values, const ur_float3 *points, const ur_uint count, const BoundingBox &bbox);
+
+			inline const Desc& GetDesc() const { return this->desc; }
+
+			inline ur_uint GetPrimitivesCount() const { return (ur_uint)this->primitives.size(); }
+
+			inline ur_uint GetNodesCount() const { return (ur_uint)this->nodes.size(); }
+
+		private:
+
+			struct UR_DECL Node
+			{
+				BoundingBox bbox;
+				ur_uint first; // leaf: first primitive reference, internal: right child index (left child follows the node)
+				ur_uint count; // leaf: primitives count, internal: 0
+			};
+
+			static ValueType EvaluatePrimitive(const Primitive &primitive, const ur_float3 &point);
+
+			BoundingBox GetInfluenceBound(const Primitive &primitive) const;
+
+			void Query(const BoundingBox &bbox, std::vector<ur_uint> &primitiveIds) const;
+
+			Desc desc;
+			std::vector<Primitive> primitives;
+			std::vector<BoundingBox> primitiveBounds;
+			std::vector<ur_uint> primitiveRefs;
+			std::vector<Node> nodes;
+		};
+
+
 		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 		// Procedural volume data generator
 		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -143,7 +646,7 @@ namespace UnlimRealms
 
 			virtual Result Read(ValueType *values, const ur_float3 *points, const ur_uint count, const BoundingBox &bbox);
 
-			virtual Result Save(const std::string &fileName, ur_float cellSize, ur_uint3 blockResolution);
+			virtual ur_uint64 GetContentHash() const;
 
 		private:
 
@@ -158,6 +661,80 @@ namespace UnlimRealms
 		};
 
 
+		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		// CPU mesh extraction
+		// Produces vertex/index arrays only, uploading to GPU is up to the consumer
+		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		class UR_DECL MeshExtractor
+		{
+		public:
+
+			struct UR_DECL Mesh
+			{
+				std::vector<Vertex> vertices;
+				std::vector<Index> indices;
+			};
+
+			// max cells per axis extracted at once by Extract, larger regions are processed block by block
+			static const ur_uint BlockCells = 32;
+
+			// computes lattice points of a hexahedron, points are stored x first, then y, then z
+			static void ComputeLattice(ur_float3 *points, const ur_float3 (&corners)[8], const ur_uint3 &resolution);
+
+			enum class UR_DECL Kernel
+			{
+				Scalar, // reference cell by cell implementation
+				Simd // row wise classification, active cells compaction and bulk edge interpolation
+			};
+
+			static bool IsKernelSupported(Kernel kernel);
+
+			// appends surface extracted from lattice of resolution points with corresponding samples
+			static Result MarchCubes(Mesh &mesh, const ur_float3 *points, const DataVolume::ValueType *samples, const ur_uint3 &resolution,
+				Kernel kernel = Kernel::Simd);
+
+			// appends surface nets mesh: a vertex per intersected cell placed at the mean of its edge crossings, a quad per crossed edge;
+			// cells along the lattice border are collapsed onto it, so the surface reaches border faces like marching cubes does
+			static Result SurfaceNets(Mesh &mesh, const ur_float3 *points, const DataVolume::ValueType *samples, const ur_uint3 &resolution);
+
+			// appends surface sampled from volume inside bbox with given cells count per axis;
+			// vertices on blocks borders are not shared
+			static Result Extract(Mesh &mesh, DataVolume &volume, const BoundingBox &bbox, const ur_uint3 &resolution,
+				Kernel kernel = Kernel::Simd);
+
+			static Result SaveObj(Realm &realm, const Mesh &mesh, const std::string &fileName);
+
+			// appends part's vertices and indices to the mesh
+			static void Merge(Mesh &mesh, const Mesh &part);
+
+			// appends skirts along mesh borders lying on any of the planes (within tolerance):
+			// border edges are extruded to depth against vertex normals to hide cracks between adjacent meshes
+			static void AddSkirts(Mesh &mesh, const ur_float4 *planes, const ur_uint planesCount, const ur_float depth, const ur_float tolerance);
+
+			// reduces triangles count by quadric error metrics driven edge collapses, error is measured as distance to original surface;
+			// mesh border vertices are locked
+			static void Simplify(Mesh &mesh, const ur_float maxError);
+
+			// quantizes vertices to compact format relative to bbox
+			static void PackVertices(std::vector<VertexCompact> &packed, VertexCompactTransform &transform,
+				const std::vector<Vertex> &vertices, const BoundingBox &bbox);
+
+			// converts indices to 16 bit, fails if any index exceeds 16 bit range
+			static Result PackIndices(std::vector<ur_uint16> &packed, const std::vector<Index> &indices);
+
+		private:
+
+			// surface normal at the point interpolated between lattice points i0 and i1,
+			// computed from central differences of adjacent samples
+			static ur_float3 ComputeNormal(const ur_float3 *points, const DataVolume::ValueType *samples, const ur_uint3 &resolution,
+				const ur_uint i0, const ur_uint i1, const ur_float lfactor);
+
+			static Result MarchCubesScalar(Mesh &mesh, const ur_float3 *points, const DataVolume::ValueType *samples, const ur_uint3 &resolution);
+
+			static Result MarchCubesSimd(Mesh &mesh, const ur_float3 *points, const DataVolume::ValueType *samples, const ur_uint3 &resolution);
+		};
+
+
 		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 		// Abstract isosurface presentation
 		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -176,6 +753,8 @@ namespace UnlimRealms
 			virtual Result Render(GrafCommandList &grafCmdList, const ur_float4x4 &viewProj);
 
 			virtual void DisplayImgui();
+
+			virtual VertexFormat GetVertexFormat() const;
 		};
 
 
@@ -194,6 +773,62 @@ namespace UnlimRealms
 				ur_float CellSize; // expected lattice cell size at the highest LoD
 				ur_uint3 LatticeResolution; // hexahedron lattice dimensions (min 2x2x2)
 				ur_float DetailLevelDistance; // distance at which most detailed lattice is expected
+				VertexFormat MeshVertexFormat = VertexFormat::Full; // compact format is supported by GRAF path only
+				ur_bool MergeHexahedra = false; // build one mesh per tetrahedron instead of one per hexahedron (single draw call)
+				ur_bool Skirts = true; // hide seams between neighbour LoDs with skirts, allows refining several levels per update
+				std::vector<ur_float> SimplifyError; // max mesh simplification error per tree level (in level's lattice cells), deeper levels are not simplified
+				ur_float ScreenSpaceError = 0.0f; // max projected lattice cell size in pixels; zero keeps refinement distance proportional to region size
+				ur_float ScreenHeight = 1080.0f; // viewport height in pixels used to project lattice cell size
+				ur_float OutsideFrustumBias = 1.0f; // refinement distance scale for regions outside the view frustum, lower values refine them less
+				ur_float BackHemisphereBias = 1.0f; // refinement distance scale for regions behind the viewer
+				ur_uint BuildBudgetJobs = 0; // max new tetrahedra built per update iteration (0 - unlimited), the rest are deferred in priority order
+				ur_float BuildBudgetTime = 0.0f; // time in milliseconds after which new tetrahedra builds of an update iteration are deferred (0 - unlimited)
+				ur_float PrefetchTime = 0.0f; // seconds of refinement point movement to predict and pre-build detail for (0 - disabled)
+				ur_uint PrefetchJobsMax = 64; // max speculative tetrahedra builds started per update iteration
+				ur_size MeshCacheBudget = 64 * 1024 * 1024; // max mesh memory in bytes of merged tetrahedra kept for reuse (0 - disabled)
+				std::string DiskCachePath; // file name prefix of the persistent mesh cache (empty - disabled), requires data volume content hash
+			};
+
+			// spatial index of refinement octree nodes: nodes hashed by Morton key of their cell, a hash per tree level,
+			// rebuilt once per update to answer refinement queries without walking the tree
+			class UR_DECL RefinementIndex
+			{
+			public:
+
+				// Morton key holds 21 bits per axis, deeper levels are checked by walking the tree
+				static const ur_uint MaxLevels = 21;
+
+				RefinementIndex();
+
+				~RefinementIndex();
+
+				void Build(const EmptyOctree &tree);
+
+				// incremental update of a single node, see EmptyOctree::Handler
+				void AddNode(const EmptyOctree::Node *node);
+
+				void RemoveNode(const EmptyOctree::Node *node);
+
+				// true if the tree has a node intersecting bbox, which is smaller than bbox; O(depth)
+				bool Check(const BoundingBox &bbox) const;
+
+				// reference implementation: recursive tree walk
+				static bool CheckTree(const BoundingBox &bbox, const EmptyOctree::Node *node);
+
+				inline ur_uint GetNodesCount() const { return this->nodesCount; }
+
+			private:
+
+				static ur_uint64 MortonKey(ur_uint x, ur_uint y, ur_uint z);
+
+				ur_uint64 NodeKey(const EmptyOctree::Node *node) const;
+
+				void AddSubtree(const EmptyOctree::Node *node);
+
+				const EmptyOctree::Node *root;
+				ur_float3 rootSize;
+				ur_uint nodesCount;
+				std::vector<std::unordered_map<ur_uint64, const EmptyOctree::Node*>> levels;
 			};
 
 			HybridCubes(Isosurface &isosurface, const Desc &desc);
@@ -208,6 +843,32 @@ namespace UnlimRealms
 
 			virtual void DisplayImgui();
 
+			virtual VertexFormat GetVertexFormat() const;
+
+			// extracts surface of a single tetrahedron without presenting it and bypassing the sample cache;
+			// used to profile mesh building
+			Result ExtractTetrahedron(MeshExtractor::Mesh &mesh, const ur_float3 (&vertices)[4], const ur_uint level, ur_bool parallel);
+
+			// refines the hierarchy for the given refinement point without building meshes;
+			// used to profile and check hierarchy update, must not be mixed with Update
+			// keys: resulting hierarchy tetrahedra keys in tree order
+			// buildKeys: keys of tetrahedra the update would build, in build order
+			Result RefineHierarchy(const ur_float3 &refinementPoint, const ur_float4x4 &viewProj, ur_bool parallel,
+				std::vector<ur_uint64> &keys, std::vector<ur_uint64> &buildKeys);
+
+			// implicit addressing of the hierarchy tetrahedra by their keys (see RefineHierarchy):
+			// vertices are derived from the root ones without touching the hierarchy, false if the key is not valid
+			ur_bool GetKeyVertices(ur_uint64 key, ur_float3 (&vertices)[4]) const;
+
+			// key of the current hierarchy leaf adjacent to the center of the tetrahedron's face opposite to the given vertex;
+			// zero if the face is on the volume bound or the key is not in the hierarchy
+			ur_uint64 FindNeighbourKey(ur_uint64 key, ur_uint oppositeVertexIdx) const;
+
+		protected:
+
+			// polygonizes sampled hexahedron lattice, marching cubes by default
+			virtual Result ExtractSurface(MeshExtractor::Mesh &mesh, const ur_float3 *points, const DataVolume::ValueType *samples, const ur_uint3 &resolution);
+
 		private:
 
 			typedef ur_float3 Vertex;
@@ -224,13 +885,81 @@ namespace UnlimRealms
 			};
 
 			#if defined(UR_GRAF)
+			// a few large persistent GPU buffers (pages) meshes vertices and indices are sub allocated from;
+			// freed ranges are returned to the page allocators only after GPU has finished using them
+			class UR_DECL MeshPool : public std::enable_shared_from_this<MeshPool>
+			{
+			public:
+
+				struct UR_DECL Range
+				{
+					ur_uint page;
+					Allocation vertices; // in vertex stride units
+					Allocation indices; // in 32 bit units
+				};
+
+				static const ur_uint IndexUnitSize = sizeof(ur_uint32);
+
+				MeshPool(GrafRenderer &grafRenderer, ur_size vertexStride, ur_size vertexAlignment, ur_size pageVertices, ur_size pageIndices);
+
+				~MeshPool();
+
+				// sub allocates ranges and uploads data, vertex data size must be a multiple of vertex stride
+				Result Allocate(Range &range, const ur_byte *vertexData, ur_size vertexDataSize, const ur_byte *indexData, ur_size indexDataSize);
+
+				// range is released when the GPU work submitted so far has been completed
+				void Free(const Range &range);
+
+				// submits deferred frees, expected to be called once per frame
+				void Update();
+
+				GrafBuffer* GetVertexBuffer(ur_uint page) const;
+
+				GrafBuffer* GetIndexBuffer(ur_uint page) const;
+
+				ur_uint GetPagesCount() const;
+
+				void GetMemoryStats(ur_size &usedSize, ur_size &totalSize) const;
+
+				inline ur_size GetVertexStride() const { return this->vertexStride; }
+
+			private:
+
+				struct UR_DECL Page
+				{
+					std::unique_ptr<GrafBuffer> VB;
+					std::unique_ptr<GrafBuffer> IB;
+					FreeListAllocator vertexAllocator;
+					FreeListAllocator indexAllocator;
+				};
+
+				Result AddPage(ur_size vertexCount, ur_size indexCount);
+
+				void Release(const std::vector<Range> &ranges);
+
+				GrafRenderer &grafRenderer;
+				ur_size vertexStride;
+				ur_size vertexAlignment;
+				ur_size pageVertices;
+				ur_size pageIndices;
+				std::vector<std::unique_ptr<Page>> pages;
+				std::vector<Range> pendingFrees;
+				mutable std::mutex mutex;
+			};
+
 			struct UR_DECL GrafMesh
 			{
-				std::unique_ptr<GrafBuffer> VB;
-				std::unique_ptr<GrafBuffer> IB;
+				std::shared_ptr<MeshPool> pool;
+				MeshPool::Range range;
+				ur_uint indexCount;
+				GrafIndexType indexType;
 				
 				GrafMesh();
 				~GrafMesh();
+
+				// owns its pool range, which is freed on destruction
+				GrafMesh(const GrafMesh&) = delete;
+				GrafMesh& operator=(const GrafMesh&) = delete;
 			};
 			#else
 			struct UR_DECL GfxMesh
@@ -240,10 +969,10 @@ namespace UnlimRealms
 			};
 			#endif
 
+			// hexahedron corners are not stored, they are derived from the tetrahedron vertices (see Tetrahedron::HexahedronVertices)
 			struct UR_DECL Hexahedron
 			{
 				static const ur_uint VerticesCount = 8;
-				Vertex vertices[VerticesCount];
 				#if defined(UR_GRAF)
 				GrafMesh grafMesh;
 				#else
@@ -269,13 +998,49 @@ namespace UnlimRealms
 				};
 				static const SplitInfo EdgeSplitInfo[EdgesCount];
 
+				static const ur_uint HexahedraCount = 4;
+
+				// implicit hierarchy: a key is the leading one bit, root index bits and a bit per bisection (child index);
+				// parent, children, root and level are computed from the key in O(1), vertices of a child are computed from the parent ones
+				// in O(1), so any key's vertices are derived from its root in O(depth)
+				static const ur_uint KeyRootBits = 3;
+
+				static inline ur_uint64 RootKey(ur_uint rootIdx) { return ((ur_uint64(1) << KeyRootBits) | rootIdx); }
+
+				// a path deeper than the key bits is not expected, its key is zero (not cached) in release
+				static inline ur_uint64 ChildKey(ur_uint64 key, ur_uint childIdx)
+				{
+					ur_assert(0 == (key >> 63));
+					return ((0 == key || (key >> 63)) ? 0 : ((key << 1) | childIdx));
+				}
+
+				static inline ur_uint64 ParentKey(ur_uint64 key) { return (KeyLevel(key) > 0 ? (key >> 1) : 0); }
+
+				static inline ur_uint KeyRoot(ur_uint64 key) { return ur_uint(key >> KeyLevel(key)) & ((1u << KeyRootBits) - 1); }
+
+				static ur_uint KeyLevel(ur_uint64 key);
+
+				static ur_byte LongestEdge(const Vertex (&vertices)[VerticesCount]);
+
+				static void ChildVertices(const Vertex (&vertices)[VerticesCount], ur_uint childIdx, Vertex (&childVertices)[VerticesCount]);
+
+				static void HexahedronVertices(const Vertex (&vertices)[VerticesCount], ur_uint hexahedronIdx, Vertex (&hexahedronVertices)[Hexahedron::VerticesCount]);
+
 				ur_uint level;
+				ur_uint dataVersion; // data modifications version the mesh is built for
 				Vertex vertices[VerticesCount];
 				ur_byte longestEdgeIdx;
 				BoundingBox bbox;
-				Hexahedron hexahedra[4];
+				Hexahedron hexahedra[HexahedraCount];
+				#if defined(UR_GRAF)
+				GrafMesh grafMesh; // merged hexahedra mesh (Desc::MergeHexahedra)
+				#else
+				GfxMesh gfxMesh; // merged hexahedra mesh (Desc::MergeHexahedra)
+				#endif
 				ur_bool initialized;
 				ur_bool visible;
+				ClockTime queueTime; // time of the first build request, used to measure build latency
+				ur_uint64 key; // tree path: leading one bit, root index bits and a bit per bisection (zero if the path does not fit)
 
 				Tetrahedron();
 
@@ -286,10 +1051,25 @@ namespace UnlimRealms
 				void Split(std::array<std::unique_ptr<Tetrahedron>, ChildrenCount> &subTetrahedra);
 			};
 
+			// hierarchy node, persistent: nodes of the live hierarchy are never modified,
+			// an update copies nodes along changed paths only and shares unchanged sub trees
 			struct UR_DECL Node
 			{
+				// sub tree totals refreshed by the update traversing the node;
+				// a sub tree without refinement changes, pending builds and modified data is accounted by them and not traversed
+				struct UR_DECL Aggregates
+				{
+					ur_uint tetrahedraCount; // zero if not gathered yet
+					ur_uint pendingCount; // tetrahedra waiting for their meshes
+					ur_uint dataVersionMin; // oldest data version meshes are built for
+					ur_uint treeMemory;
+					ur_uint meshVideoMemory;
+					ur_uint meshBuffers;
+				};
+
 				std::shared_ptr<Tetrahedron> tetrahedron;
-				std::unique_ptr<Node> children[Tetrahedron::ChildrenCount];
+				std::shared_ptr<Node> children[Tetrahedron::ChildrenCount];
+				Aggregates aggregates;
 
 				Node();
 
@@ -297,33 +1077,405 @@ namespace UnlimRealms
 
 				~Node();
 
-				void Split(Node *cachedNode);
+				void Split();
 
 				void Merge();
 
 				inline bool HasChildren() const { return (this->children[0] != ur_null); }
 			};
 
+			static const ur_uint RootsCount = 6;
+
+			struct UR_DECL Hierarchy
+			{
+				std::shared_ptr<Node> roots[RootsCount];
+			};
+
 			struct Stats
 			{
 				ur_uint tetrahedraCount;
 				ur_uint treeMemory;
 				ur_uint meshVideoMemory;
 				ur_uint primitivesRendered;
+				ur_uint drawCalls;
+				ur_uint meshBuffers;
 				ur_uint buildQueue;
+				ur_uint rebuildQueue;
+				ur_uint samplesRequested;
+				ur_uint samplesCached;
+				ur_uint refinementNodesVisited;
+				ur_uint refinementChanges;
+				ur_uint lodUpdates;
+				ur_uint hierarchyNodesVisited;
+				ur_uint buildDeferred;
+				ur_float buildLatencyP50; // milliseconds from build request to visible mesh
+				ur_float buildLatencyP90;
+				ur_float buildLatencyP99;
+				ur_uint prefetchRequested; // speculative builds started so far
+				ur_uint prefetchHits; // speculative builds taken over by the hierarchy
+				ur_uint prefetchMisses; // speculative builds cancelled or discarded due to a wrong prediction
+				ur_uint meshCacheRequests;
+				ur_uint meshCacheHits;
+				ur_uint meshCacheMemory;
+				ur_uint diskCacheRequests;
+				ur_uint diskCacheHits;
+			};
+
+			// new tetrahedron build request;
+			// requests are ordered by level (unless all levels are built at once), visibility and normalized distance to the refinement point
+			struct BuildRequest
+			{
+				Tetrahedron *tetrahedron;
+				ur_uint level; // build order level: tetrahedron's level or zero if all levels are built at once
+				ur_bool visible;
+				ur_float priority; // distance to the refinement point relative to the refinement distance, lower is built first
+
+				// heap ordering: true if this request is built after the other one
+				inline bool operator<(const BuildRequest &other) const
+				{
+					if (this->level != other.level)
+						return (this->level > other.level);
+					if (this->visible != other.visible)
+						return !this->visible;
+					if (this->priority != other.priority)
+						return (this->priority > other.priority);
+					return (this->tetrahedron->key > other.tetrahedron->key); // same order regardless of requests gathering order
+				}
 			};
 
-			void UpdateRefinementTree(const ur_float3 &refinementPoint, EmptyOctree::Node *node);
+			struct BuildJobContext
+			{
+				HybridCubes *presentation;
+				Tetrahedron *tetrahedron;
+				ur_bool budgeted; // deferrable build, modified tetrahedra are always rebuilt
+			};
+
+			// speculative build of a tetrahedron expected to appear at the predicted refinement point
+			struct PrefetchEntry
+			{
+				HybridCubes *presentation;
+				std::shared_ptr<Tetrahedron> tetrahedron;
+				std::shared_ptr<Job> job;
+				std::atomic<ur_bool> cancelled;
+				ur_uint updateIdx; // last update iteration the entry was predicted by
+			};
+
+			// lattice samples cache shared by all hexahedra built within an update pass;
+			// values are keyed by quantized lattice point position and LoD level,
+			// previous pass samples are kept to let split tetrahedra reuse parent's values
+			class UR_DECL SampleCache
+			{
+			public:
+
+				SampleCache();
+
+				~SampleCache();
+
+				// quantumMax: coarsest quantization keeping distinct lattice points apart,
+				// cache is disabled if the bound can not be keyed with it
+				Result Init(const BoundingBox &bound, ur_float precision, ur_float quantumMax);
 
-			bool CheckRefinementTree(const BoundingBox &bbox, EmptyOctree::Node *node);
+				void NextPass();
 
-			Result Update(const ur_float3 &refinementPoint, Node *node, Node *cachedNode = ur_null, Stats *stats = ur_null);
+				void ResetCounters();
 
-			Result UpdateLoD(const ur_float3 &refinementPoint, Node *node, Node *cachedNode = ur_null);
+				// parentLevel: coincident parent level samples can be reused (data does not depend on the level of detail)
+				void Fetch(DataVolume::ValueType *values, ur_uint64 *keys, const ur_float3 *points, const ur_uint count, const ur_uint level,
+					const ur_bool parentLevel, std::vector<ur_uint> &missedIds);
 
-			Result BuildMesh(Tetrahedron *tetrahedron, Stats *stats = ur_null);
+				void Store(const DataVolume::ValueType *values, const ur_uint64 *keys, const std::vector<ur_uint> &ids);
 
-			Result MarchCubes(Hexahedron &hexahedron);
+				void Invalidate(const std::vector<BoundingBox> &regions);
+
+				inline ur_uint GetRequestsCount() const { return this->requestsCount; }
+
+				inline ur_uint GetHitsCount() const { return this->hitsCount; }
+
+				inline ur_bool IsEnabled() const { return (this->quantumInv > 0.0f); }
+
+			private:
+
+				static const ur_uint KeyAxisBits = 19;
+				static const ur_uint KeyLevelOfs = KeyAxisBits * 3;
+				static const ur_uint64 KeyAxisMask = (ur_uint64(1) << KeyAxisBits) - 1;
+				static const ur_uint64 KeyPositionMask = (ur_uint64(1) << KeyLevelOfs) - 1;
+
+				// samples are spread over separately locked shards by position, so that concurrent builds rarely contend;
+				// keys of all levels at a point share the shard; per pass samples count is capped, further samples are not cached
+				static const ur_uint ShardsLog2 = 4;
+				static const ur_uint ShardsCount = (1 << ShardsLog2);
+				static const ur_size ShardSamplesMax = (ur_size(1) << 20) / ShardsCount;
+
+				struct UR_DECL Shard
+				{
+					std::unordered_map<ur_uint64, DataVolume::ValueType> samples;
+					std::unordered_map<ur_uint64, DataVolume::ValueType> samplesPrev;
+					std::mutex mutex;
+				};
+
+				static inline ur_uint ShardIdx(const ur_uint64 key)
+				{
+					return ur_uint(((key & KeyPositionMask) * 0x9e3779b97f4a7c15ull) >> (64 - ShardsLog2));
+				}
+
+				ur_uint64 ComputeKey(const ur_float3 &point, const ur_uint level) const;
+
+				// orders ids by shard, shardFirst[i]..shardFirst[i + 1] is the range of shard i
+				static void SortByShard(std::vector<ur_uint> &sortedIds, ur_uint (&shardFirst)[ShardsCount + 1],
+					const ur_uint64 *keys, const ur_uint *ids, const ur_uint count);
+
+				BoundingBox bound;
+				ur_float quantumInv;
+				Shard shards[ShardsCount];
+				std::atomic<ur_uint> requestsCount;
+				std::atomic<ur_uint> hitsCount;
+			};
+
+			// LRU cache of tetrahedra removed from the hierarchy by merge;
+			// entries are keyed by tetrahedron tree path, split nodes take cached tetrahedra over instead of building new ones,
+			// entries built for modified data are invalidated
+			class UR_DECL MeshCache
+			{
+			public:
+
+				MeshCache();
+
+				~MeshCache();
+
+				void Init(ur_size budget);
+
+				void Put(const std::shared_ptr<Tetrahedron> &tetrahedron, ur_size size);
+
+				std::shared_ptr<Tetrahedron> Take(ur_uint64 key);
+
+				void Invalidate(const std::vector<BoundingBox> &regions);
+
+				void ResetCounters();
+
+				inline ur_size GetSize() const { return this->size; }
+
+				inline ur_uint GetRequestsCount() const { return this->requestsCount; }
+
+				inline ur_uint GetHitsCount() const { return this->hitsCount; }
+
+			private:
+
+				struct Entry
+				{
+					std::shared_ptr<Tetrahedron> tetrahedron;
+					ur_size size;
+				};
+
+				void Evict(std::list<Entry>::iterator it);
+
+				ur_size budget;
+				ur_size size;
+				std::list<Entry> entries; // most recently used first
+				std::unordered_map<ur_uint64, std::list<Entry>::iterator> entriesMap;
+				std::mutex mutex;
+				ur_uint requestsCount;
+				ur_uint hitsCount;
+			};
+
+			// view parameters used by refinement criterion
+			struct RefinementView
+			{
+				ur_float projectionScale; // projected size in pixels of a unit size at unit distance
+				ur_float4 frustumPlanes[6];
+				ur_float3 viewDirection;
+			};
+
+			// distance to the refinement point at which region of the given bbox is split
+			ur_float GetRefinementDistance(const BoundingBox &bbox, const ur_float3 &refinementPoint, bool viewBias) const;
+
+			// view bias applied by GetRefinementDistance to all sub regions of the bbox, Mixed if it may differ between them
+			enum class ViewBias
+			{
+				None,
+				OutsideFrustum,
+				BackHemisphere,
+				Mixed
+			};
+
+			ViewBias GetViewBias(const BoundingBox &bbox, const ur_float3 &refinementPoint, const RefinementView &view) const;
+
+			// refinement tree is updated incrementally: only sub trees near the previous or current refinement point are visited;
+			// when the view changes, sub trees whose view bias may have changed are visited as well
+			void UpdateRefinementTree(const ur_float3 &refinementPoint, const ur_float4x4 &viewProj, EmptyOctree::Node *root, Stats *stats);
+
+			void UpdateRefinementTree(const ur_float3 &refinementPoint, EmptyOctree::Node *node, bool fullUpdate, Stats *stats);
+
+			// creates hierarchy roots and refinement tree for the data bound if not created yet
+			void InitHierarchy();
+
+			// key lookups: a node is found by descending the hierarchy along the key path, a face neighbour (the leaf adjacent to the face center)
+			// by locating a point just behind the face, both in O(depth)
+			std::shared_ptr<Node> FindNode(const Hierarchy &hierarchy, ur_uint64 key) const;
+
+			std::shared_ptr<Node> FindNeighbour(const Hierarchy &hierarchy, ur_uint64 key, ur_uint faceIdx) const;
+
+			struct UpdateTask;
+
+			// hierarchy update output of a sub tree; sub trees are updated in parallel and their outputs are merged in tree order,
+			// so that the resulting hierarchy and build order do not depend on scheduling
+			struct UpdateContext
+			{
+				Stats stats;
+				std::vector<BuildRequest> buildQueue; // tree order, the heap is made after merge
+				std::vector<Tetrahedron*> rebuildQueue;
+				std::vector<std::pair<std::shared_ptr<Tetrahedron>, ur_size>> cacheQueue; // merged tetrahedra, put to the mesh cache after update
+				std::vector<UpdateTask> *tasks; // sub trees at UpdateTaskLevel are deferred to these tasks (null - updated in place)
+			};
+
+			struct UpdateTask
+			{
+				std::shared_ptr<Node> node;
+				std::shared_ptr<Node> nodeNext;
+				const std::vector<BoundingBox> *refinementChanges;
+				UpdateContext ctx;
+				Result result;
+			};
+
+			// hierarchy levels above are updated by the calling thread, sub trees of this level are the parallel tasks
+			static const ur_uint UpdateTaskLevel = 4;
+
+			// produces the next hierarchy, build queues and mesh cache entries of the update
+			Result UpdateHierarchy(const ur_float3 &refinementPoint, ur_bool parallel, Stats &stats);
+
+			// produces the node of the next hierarchy: the given node if neither it nor its sub tree has changed, a modified copy otherwise;
+			// refinementChanges: regions where refinement tree changed since the previous update of the hierarchy, LoD is not updated elsewhere
+			Result Update(const ur_float3 &refinementPoint, const std::shared_ptr<Node> &node, std::shared_ptr<Node> &nodeNext, UpdateContext &ctx,
+				const std::vector<BoundingBox> &refinementChanges);
+
+			// replaces deferred sub trees of the updated top levels by the tasks results, copies the paths to changed ones
+			std::shared_ptr<Node> AttachUpdateTasks(const std::shared_ptr<Node> &node, std::vector<UpdateTask> &tasks, ur_uint &taskIdx);
+
+			// splits or merges a copy of the node if its LoD has changed
+			Result UpdateLoD(const ur_float3 &refinementPoint, std::shared_ptr<Node> &node, UpdateContext &ctx);
+
+			// speculative builds: sub trees of the hierarchy leaves are pre-built around the refinement point predicted from its velocity;
+			// entries no longer predicted are cancelled, built ones are taken over when the hierarchy splits into them
+			void UpdatePrefetch(const ur_float3 &refinementPoint, const ur_float3 &predictedPoint, Stats *stats);
+
+			void Prefetch(const ur_float3 &predictedPoint, Node *node, ur_uint &jobsBudget);
+
+			void Prefetch(const ur_float3 &predictedPoint, Tetrahedron &tetrahedron, ur_uint &jobsBudget);
+
+			void AdoptPrefetched(Node *node);
+
+			// queues initialized tetrahedra of the node's sub tree for the mesh cache (before merge)
+			void CacheSubtree(Node *node, UpdateContext &ctx);
+
+			void AdoptCached(Node *node);
+
+			void CancelPrefetch();
+
+			void UpdateDirtyRegions();
+
+			bool IsDirty(const Tetrahedron &tetrahedron) const;
+
+			bool IsDirty(const BoundingBox &bbox, ur_uint dataVersion) const;
+
+			// helpersPriority: priority of the jobs helping with the tetrahedron's build tasks
+			Result BuildMesh(Tetrahedron *tetrahedron, Stats *stats = ur_null, JobPriority helpersPriority = JobPriority::High);
+
+			// persistent mesh cache file layout:
+			// [DiskCacheHeader][per mesh: ur_uint32 verticesCount, ur_uint32 indicesCount, vertices, indices]
+			// a file per tetrahedron, named by the cache hash and the tetrahedron key; the cache hash combines data volume content hash,
+			// presentation type and mesh affecting desc parameters, so that a file of different settings is never matched
+			static const ur_uint32 DiskCacheMagic = 0x434d5255; // "URMC"
+			static const ur_uint32 DiskCacheVersion = 1;
+
+			struct UR_DECL DiskCacheHeader
+			{
+				ur_uint32 magic;
+				ur_uint32 version;
+				ur_uint64 hash;
+				ur_uint64 key;
+				ur_uint32 meshesCount;
+				ur_uint32 vertexSize;
+				ur_uint64 dataSize;
+				ur_uint64 checksum; // hash of meshes data
+			};
+
+			// serialized entry waiting for the low priority writer job, so that file IO does not delay the build
+			struct DiskCacheWrite
+			{
+				std::string fileName;
+				DiskCacheHeader header;
+				std::vector<ur_byte> data;
+			};
+
+			// entries written per writer job, so that a long queue does not delay other low priority jobs
+			static const ur_uint DiskCacheWritesPerJob = 16;
+
+			ur_uint64 ComputeDiskCacheHash() const;
+
+			std::string GetDiskCacheFileName(const Tetrahedron &tetrahedron) const;
+
+			Result LoadCachedMeshes(const Tetrahedron &tetrahedron, std::vector<MeshExtractor::Mesh> &meshes);
+
+			Result SaveCachedMeshes(const Tetrahedron &tetrahedron, const std::vector<MeshExtractor::Mesh> &meshes);
+
+			Result WriteCachedMeshes(const DiskCacheWrite &entry);
+
+			// must be called with disk cache mutex locked
+			void ScheduleDiskCacheWrites();
+
+			void ProcessDiskCacheWrites();
+
+			// waits until all queued entries are written
+			void FlushDiskCache();
+
+			// part of a tetrahedron build: a hexahedron or a slab of its lattice
+			struct UR_DECL BuildTask
+			{
+				ur_uint hexahedronIdx;
+				ur_float3 corners[Hexahedron::VerticesCount];
+				ur_uint3 resolution;
+				ur_float4 facePlanes[Tetrahedron::FacesCount];
+				ur_float cellSize; // tetrahedron lattice cell size
+				ur_float skirtDepth; // zero if skirts are disabled
+				ur_float skirtTolerance; // max distance of a border vertex to a face plane, covers float precision at the coordinates magnitude
+				ur_float simplifyError; // zero if simplification is disabled
+				MeshExtractor::Mesh mesh;
+				Result result;
+			};
+
+			// lattices with more cells along z are split into slabs built in parallel
+			static const ur_uint BuildSlabCellsMax = 32;
+
+			void CreateBuildTasks(std::vector<BuildTask> &tasks, const Tetrahedron &tetrahedron) const;
+
+			// helpersPriority: priority of the jobs helping the caller with its tasks
+			Result RunBuildTasks(std::vector<BuildTask> &tasks, const ur_uint level, SampleCache *sampleCache, ur_bool parallel,
+				JobPriority helpersPriority);
+
+			// cellSize: lattice cell size of the tetrahedron, all its lattices are sampled at the same data level of detail
+			Result MarchCubes(const ur_float3 (&corners)[8], const ur_uint3 &resolution, const ur_uint level, const ur_float cellSize,
+				SampleCache *sampleCache, MeshExtractor::Mesh &mesh);
+
+			bool HasMesh(const Tetrahedron &tetrahedron) const;
+
+			void GatherMeshStats(const Tetrahedron &tetrahedron, Stats &stats) const;
+
+			// node's own totals combined with its children aggregates
+			Node::Aggregates GatherAggregates(const Node &node) const;
+
+			void GatherBuildLatencyStats(Stats &stats) const;
+
+			#if defined(UR_GRAF)
+			static const ur_uint MeshPoolPageVertices = (1 << 18);
+			static const ur_uint MeshPoolPageIndices = (1 << 20);
+
+			Result UploadMesh(GrafMesh &grafMesh, const BoundingBox &bbox, const MeshExtractor::Mesh &mesh);
+
+			void DrawMesh(GrafCommandList &grafCmdList, const GrafMesh &grafMesh);
+			#else
+			Result UploadMesh(GfxMesh &gfxMesh, const BoundingBox &bbox, const MeshExtractor::Mesh &mesh);
+
+			void DrawMesh(GfxContext &gfxContext, const GfxMesh &gfxMesh);
+			#endif
 
 			Result Render(GfxContext &gfxContext, GenericRender *genericRender, const ur_float4(&frustumPlanes)[6], Node *node);
 
@@ -335,20 +1487,66 @@ namespace UnlimRealms
 
 			// common data
 			ur_float3 updatePoint;
-			std::multimap<ur_uint, Tetrahedron*> buildQueue;
+			ur_float4x4 updateViewProj;
+			ur_float3 updatePredictedPoint;
+			std::vector<BuildRequest> buildQueue; // binary heap
+			std::vector<Tetrahedron*> rebuildQueue;
+			std::vector<std::pair<ur_uint, BoundingBox>> dirtyRegions;
+			ur_uint dataVersion;
 			std::shared_ptr<Job> jobUpdate;
 			std::list<std::shared_ptr<Job>> jobBuild;
-			std::list<std::pair<HybridCubes*, Tetrahedron*>> jobBuildCtx;
+			std::list<BuildJobContext> jobBuildCtx;
 			std::atomic<ur_uint> jobBuildCounter;
 			std::atomic<ur_uint> jobBuildRequested;
+			std::atomic<ur_uint> buildPassesActive; // RunBuildTasks calls in progress, spare threads are split between them
+			ClockTime jobBuildStartTime;
+			static const ur_uint BuildLatencySamples = 1024;
+			std::vector<ur_float> buildLatencies; // ring buffer of recent build latencies (milliseconds)
+			ur_uint buildLatencyNext;
+			ur_float3 prefetchPointPrev;
+			ClockTime prefetchTimePrev;
+			ur_float3 prefetchVelocity;
+			ur_uint prefetchUpdateIdx;
+			ur_uint prefetchRequested;
+			ur_uint prefetchHits;
+			ur_uint prefetchMisses;
+			std::unordered_map<ur_uint64, std::unique_ptr<PrefetchEntry>> prefetchEntries; // by tetrahedron key
+			std::vector<std::unique_ptr<PrefetchEntry>> prefetchRetired; // cancelled entries waiting for their jobs to finish
+			std::mutex prefetchMutex; // guards entries taken over by parallel hierarchy update
 
 			// todo: per instance data
 			Desc desc;
+			SampleCache sampleCache;
+			MeshCache meshCache;
+			ur_uint64 diskCacheHash; // zero if disk cache is not used
+			std::atomic<ur_uint> diskCacheRequests;
+			std::atomic<ur_uint> diskCacheHits;
+			std::list<std::unique_ptr<DiskCacheWrite>> diskCacheWrites; // queued entries
+			std::unordered_set<ur_uint64> diskCacheWritesPending; // keys of queued or being written entries
+			std::shared_ptr<Job> diskCacheJob;
+			ur_bool diskCacheJobActive;
+			std::atomic<ur_uint> diskCacheWriteCounter; // makes temporary file names unique
+			std::mutex diskCacheMutex; // guards writes queue shared by parallel builds and the writer job
+			#if defined(UR_GRAF)
+			std::shared_ptr<MeshPool> meshPool; // shared with meshes allocated from it
+			GrafBuffer *boundVertexBuffer;
+			GrafBuffer *boundIndexBuffer;
+			GrafIndexType boundIndexType;
+			#endif
+			RefinementIndex refinementIndex; // kept in sync by refinement tree handler, so it is declared (and destroyed) before the tree
 			EmptyOctree refinementTree;
+			ur_float3 refinementPointPrev;
+			RefinementView refinementViewPrev;
+			RefinementView refinementView;
+			bool refinementViewChanged; // view bias of the current update may differ from the previous one
+			bool refinementTreeFullUpdate; // next update visits all refinement tree nodes
+			std::vector<BoundingBox> refinementChanges; // changed regions not yet applied to the hierarchy
 			std::vector<ur_float> refinementDistance;
-			static const ur_uint RootsCount = 6;
-			std::unique_ptr<Node> root[RootsCount];
-			std::unique_ptr<Node> rootBack[RootsCount];
+			Vertex rootVertices[RootsCount][Tetrahedron::VerticesCount];
+			std::shared_ptr<Hierarchy> hierarchy; // live hierarchy, accessed atomically
+			std::shared_ptr<Hierarchy> hierarchyNext; // produced by the update job, becomes live when its meshes are built
+			std::vector<std::shared_ptr<Hierarchy>> hierarchyRetired; // replaced hierarchies, released after the next render
+			static const ur_uint HierarchyRetiredMax = 2; // retired hierarchies kept while nothing is rendered
 			
 			// debug info
 			bool freezeUpdate;
@@ -357,11 +1555,31 @@ namespace UnlimRealms
 			bool hideEmptyTetrahedra;
 			bool drawHexahedra;
 			bool drawRefinementTree;
+			bool parallelBuild;
+			bool parallelUpdate;
 			Stats stats;
 			Stats statsBack; // async update structure
 		};
 
 
+		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		// Surface nets presentation
+		// same tetrahedral hierarchy as HybridCubes, hexahedra lattices are polygonized with surface nets
+		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		class UR_DECL SurfaceNets : public HybridCubes
+		{
+		public:
+
+			SurfaceNets(Isosurface &isosurface, const Desc &desc);
+
+			~SurfaceNets();
+
+		protected:
+
+			virtual Result ExtractSurface(MeshExtractor::Mesh &mesh, const ur_float3 *points, const DataVolume::ValueType *samples, const ur_uint3 &resolution);
+		};
+
+
 		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 		// Isosurface instance
 		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -384,6 +1602,9 @@ namespace UnlimRealms
 
 		virtual ~Isosurface();
 
+		// headless initialization: data only, no presentation and graphics objects
+		Result Init(std::unique_ptr<DataVolume> data);
+
 		Result Init(std::unique_ptr<DataVolume> data, std::unique_ptr<Presentation> presentation);
 
 		Result Init(std::unique_ptr<DataVolume> data, std::unique_ptr<Presentation> presentation, GrafRenderPass* grafRenderPass);
@@ -413,7 +1634,9 @@ namespace UnlimRealms
 			std::unique_ptr<GrafShader> PSDbg;
 			std::unique_ptr<GrafDescriptorTableLayout> shaderDescriptorLayout;
 			std::vector<std::unique_ptr<GrafDescriptorTable>> shaderDescriptorTable;
+			std::unique_ptr<GrafShader> VSCompact;
 			std::unique_ptr<GrafPipeline> pipelineSolid;
+			std::unique_ptr<GrafPipeline> pipelineCompact;
 			std::unique_ptr<GrafPipeline> pipelineDebug;
 		} grafObjects;
 		GrafRenderer *grafRenderer;
@@ -445,15 +1668,6 @@ namespace UnlimRealms
 			LightDesc LightParams;
 		};
 
-		struct Vertex
-		{
-			ur_float3 pos;
-			ur_float3 norm;
-			ur_uint32 col;
-		};
-
-		typedef ur_uint32 Index;
-
 		std::unique_ptr<DataVolume> data;
 		std::unique_ptr<Presentation> presentation;
 		std::list<std::unique_ptr<Instance>> instances;
@@ -0,0 +1,42 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//	UnlimRealms
+//	Author: Anatole Kuzub
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "LogDepth.hlsli"
+#include "Isosurface.hlsli"
+
+struct VS_INPUT_COMPACT
+{
+	float4 pos		: POSITION; // unorm position inside mesh bbox
+	int2 norm		: NORMAL; // octahedral normal
+	float4 col		: COLOR0;
+	float4 offset	: TEXCOORD0; // per mesh dequantization transform
+	float4 scale	: TEXCOORD1;
+};
+
+float3 OctahedronDecode(float2 oct)
+{
+	float3 n = float3(oct.xy, 1.0 - abs(oct.x) - abs(oct.y));
+	if (n.z < 0.0)
+	{
+		n.xy = (1.0 - abs(n.yx)) * float2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+	}
+	return normalize(n);
+}
+
+PS_INPUT main(VS_INPUT_COMPACT input)
+{
+	PS_INPUT output;
+
+	float3 pos = input.offset.xyz + input.pos.xyz * input.scale.xyz;
+	output.pos = LogDepthPos(mul(ViewProj, float4(pos, 1.0f)));
+	output.norm = OctahedronDecode(float2(input.norm) / 32767.0);
+	output.col = input.col;
+	output.wpos.xyz = pos;
+	output.wpos.w = output.pos.w;
+
+	return output;
+}
\ No newline at end of file
@@ -42,6 +42,27 @@ namespace UnlimRealms
 		return result;
 	}
 
+	Result StdStorage::Rename(const std::string &name, const std::string &newName)
+	{
+		if (0 == std::rename(name.c_str(), newName.c_str()))
+			return Result(Success);
+
+		// std::rename does not replace existing file on some platforms
+		std::remove(newName.c_str());
+		if (std::rename(name.c_str(), newName.c_str()) != 0)
+			return Result(Failure);
+
+		return Result(Success);
+	}
+
+	Result StdStorage::Remove(const std::string &name)
+	{
+		if (std::remove(name.c_str()) != 0)
+			return Result(Failure);
+
+		return Result(Success);
+	}
+
 
 	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 	// StdFile
@@ -102,6 +123,21 @@ namespace UnlimRealms
 		return (ur_size)size;
 	}
 
+	Result StdFile::Seek(const ur_size offset)
+	{
+		if (ur_null == this->stream)
+			return Result(NotInitialized);
+
+		// keep both get and put positions in sync
+		this->stream->clear();
+		this->stream->seekg((std::streamoff)offset);
+		this->stream->seekp((std::streamoff)offset);
+		if (this->stream->fail())
+			return Result(Failure);
+
+		return Result(Success);
+	}
+
 	Result StdFile::Read(const ur_size size, ur_byte *buffer)
 	{
 		if (ur_null == this->stream)
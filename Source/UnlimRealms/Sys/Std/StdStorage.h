@@ -25,6 +25,10 @@ namespace UnlimRealms
 
 		virtual Result Open(std::unique_ptr<File> &file, const std::string &name, const ur_uint accessFlags);
 
+		virtual Result Rename(const std::string &name, const std::string &newName);
+
+		virtual Result Remove(const std::string &name);
+
 	protected:
 
 		virtual Result OnInitialize();
@@ -48,6 +52,8 @@ namespace UnlimRealms
 
 		virtual ur_size GetSize();
 
+		virtual Result Seek(const ur_size offset);
+
 		virtual Result Read(const ur_size size, ur_byte *buffer);
 
 		virtual Result Write(const ur_size size, const ur_byte *buffer);
@@ -41,6 +41,16 @@ namespace UnlimRealms
 		return Result(Success);
 	}
 
+	Result Storage::Rename(const std::string &name, const std::string &newName)
+	{
+		return Result(NotImplemented);
+	}
+
+	Result Storage::Remove(const std::string &name)
+	{
+		return Result(NotImplemented);
+	}
+
 
 	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 	// File
@@ -71,6 +81,11 @@ namespace UnlimRealms
 		return 0;
 	}
 
+	Result File::Seek(const ur_size offset)
+	{
+		return Result(NotImplemented);
+	}
+
 	Result File::Read(const ur_size size, ur_byte *buffer)
 	{
 		return Result(NotImplemented);
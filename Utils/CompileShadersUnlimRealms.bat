@@ -14,6 +14,7 @@ call:CompileShader "Source\UnlimRealms\GenericRender" "Generic" "ps" "%SHADER_MO
 call:CompileShader "Source\UnlimRealms\GenericRender" "FullScreenQuad" "vs" "%SHADER_MODEL%" "%SHADER_ENTRYPOINT%"
 
 call:CompileShader "Source\UnlimRealms\Isosurface" "Isosurface" "vs" "%SHADER_MODEL%" "%SHADER_ENTRYPOINT%"
+call:CompileShader "Source\UnlimRealms\Isosurface" "IsosurfaceCompact" "vs" "%SHADER_MODEL%" "%SHADER_ENTRYPOINT%"
 call:CompileShader "Source\UnlimRealms\Isosurface" "Isosurface" "ps" "%SHADER_MODEL%" "%SHADER_ENTRYPOINT%"
 
 call:CompileShader "Source\UnlimRealms\Atmosphere" "Atmosphere" "vs" "%SHADER_MODEL%" "%SHADER_ENTRYPOINT%"